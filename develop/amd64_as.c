@@ -0,0 +1,3234 @@
+/*
+ * Copyright (c) 2026, Nils R. Weller
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Integrated assembler for AMD64 ELF
+ *
+ * 10/17/26: This reads the gas syntax written by amd64_emit_gas.c and
+ * encodes it directly into an ELF64 relocatable object, such that the
+ * common case of compiling a file doesn't have to start an external
+ * assembler and have it parse the whole output again. Only the subset
+ * of gas that nwcc generates (plus a few neighbouring forms) is
+ * supported; anything else makes amd64_as_assemble() return -1 without
+ * writing output, so that the driver can hand the file to the system
+ * assembler instead. The encodings, relaxation decisions and relocation
+ * choices follow GNU as, such that the output can be compared to that
+ * of gas directly (see astest.sh)
+ *
+ * Design: Every section is a list of frags, each of which consists of
+ * a fixed part (plain bytes) and an optional variable part - a jump
+ * whose size depends on the distance to its target, or alignment
+ * padding. Labels are recorded as frag/offset pairs. Once the whole
+ * input has been read, all sections are laid out (short jumps are
+ * grown to long jumps until nothing changes), then fixups are resolved
+ * or turned into relocations, and the object file is written
+ */
+#include "amd64_as.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <setjmp.h>
+#include "n_libc.h"
+
+#define SHT_PROGBITS	1
+#define SHT_SYMTAB	2
+#define SHT_STRTAB	3
+#define SHT_RELA	4
+#define SHT_NOBITS	8
+
+#define SHF_WRITE	0x1
+#define SHF_ALLOC	0x2
+#define SHF_EXECINSTR	0x4
+#define SHF_MERGE	0x10
+#define SHF_STRINGS	0x20
+#define SHF_INFO_LINK	0x40
+
+#define STB_LOCAL	0
+#define STB_GLOBAL	1
+#define STB_WEAK	2
+
+#define STT_NOTYPE	0
+#define STT_OBJECT	1
+#define STT_FUNC	2
+#define STT_SECTION	3
+
+#define SHN_COMMON	0xfff2
+
+#define R_X86_64_64	1
+#define R_X86_64_PC32	2
+#define R_X86_64_PLT32	4
+#define R_X86_64_32	10
+#define R_X86_64_32S	11
+#define R_X86_64_16	12
+#define R_X86_64_PC16	13
+#define R_X86_64_8	14
+#define R_X86_64_PC8	15
+#define R_X86_64_PC64	24
+
+struct as_section;
+
+/*
+ * An expression is at most ``add - sub + val''
+ */
+struct as_expr {
+	struct as_sym	*add;
+	struct as_sym	*sub;
+	long		val;
+};
+
+#define SYM_DEFINED	1
+#define SYM_GLOBAL	2
+#define SYM_WEAK	4
+#define SYM_COMMON	8
+#define SYM_SET		16	/* defined by .set */
+#define SYM_TEMP	32	/* `.' in an expression; never emitted */
+#define SYM_RELOC	64	/* referenced by a relocation */
+#define SYM_NOEMIT	128	/* .L label */
+
+struct as_sym {
+	char			*name;
+	int			flags;
+	int			type;
+	struct as_section	*sect;
+	int			frag;
+	unsigned long		off;
+	unsigned long		size;
+	struct as_expr		sizeexpr;
+	int			has_sizeexpr;
+	struct as_expr		setexpr;
+	unsigned long		align;	/* .comm alignment */
+	unsigned long		name_off;
+	int			index;
+	struct as_sym		*next;
+	struct as_sym		*hash_next;
+};
+
+#define FRAG_NONE	0
+#define FRAG_JUMP	1
+#define FRAG_ALIGN	2
+
+struct as_frag {
+	size_t		start;	/* offset of fixed part in section buffer */
+	size_t		len;	/* length of fixed part */
+	int		kind;
+	int		cc;	/* FRAG_JUMP: condition code, -1 for jmp */
+	int		is_long;
+	struct as_expr	target;
+	unsigned long	align;
+	int		fill;	/* FRAG_ALIGN: fill byte, -1 for nops */
+	unsigned long	addr;
+	unsigned long	varlen;
+};
+
+#define FIX_ABS		1	/* absolute, zero-extended */
+#define FIX_ABS_S	2	/* absolute, sign-extended */
+#define FIX_PC		3	/* pc-relative data reference */
+#define FIX_PLT		4	/* call target */
+#define FIX_JUMP	5	/* long jump target */
+#define FIX_PC8		6	/* loop/jrcxz target */
+
+struct as_fixup {
+	int		frag;
+	unsigned long	off;
+	int		size;
+	int		kind;
+	int		line;
+	struct as_expr	e;
+};
+
+struct as_reloc {
+	unsigned long		off;
+	struct as_sym		*sym;	/* NULL: section symbol of sect */
+	struct as_section	*sect;
+	int			type;
+	long			addend;
+};
+
+struct as_buf {
+	unsigned char	*data;
+	size_t		len;
+	size_t		alloc;
+};
+
+struct as_section {
+	char			*name;
+	int			type;
+	unsigned long		flags;
+	unsigned long		align;
+	unsigned long		entsize;
+	struct as_buf		buf;
+	struct as_frag		*frags;
+	int			nfrags;
+	int			fragalloc;
+	struct as_fixup		*fixups;
+	int			nfixups;
+	int			fixalloc;
+	struct as_reloc		*relocs;
+	int			nrelocs;
+	int			relocalloc;
+	unsigned char		*image;
+	unsigned long		size;
+	int			need_secsym;
+	struct as_sym		*sym_before;
+	int			symndx;
+	int			shndx;
+	int			relndx;
+	unsigned long		fileoff;
+	unsigned long		relfileoff;
+	struct as_section	*next;
+};
+
+#define OP_REG	1
+#define OP_IMM	2
+#define OP_MEM	3
+
+#define RC_GPR	1
+#define RC_XMM	2
+#define RC_ST	3
+#define RC_RIP	4
+
+struct as_operand {
+	int		type;
+	int		indirect;	/* `*' prefix */
+	int		reg;
+	int		regclass;
+	int		size;		/* GPR size */
+	int		rex8;		/* %spl, %bpl, %sil, %dil */
+	int		high8;		/* %ah, %ch, %dh, %bh */
+	struct as_expr	disp;		/* immediate or displacement */
+	int		base;
+	int		index;
+	int		scale;
+	int		rip;
+};
+
+struct as_insn {
+	unsigned char	b[32];
+	int		len;
+	int		nfix;
+	struct {
+		int		pos;
+		int		size;
+		int		kind;
+		struct as_expr	e;
+	} fix[2];
+};
+
+struct as_chunk {
+	struct as_chunk	*next;
+	size_t		used;
+	size_t		size;
+	union {
+		long	l;
+		double	d;
+		void	*p;
+	} data[1];
+};
+
+#define AS_SYMTAB_SIZE	4096
+
+static jmp_buf			fail_env;
+static const char		*fail_reason;
+static int			lineno;
+static struct as_chunk		*chunks;
+static struct as_sym		*sym_hash[AS_SYMTAB_SIZE];
+static struct as_sym		*syms;
+static struct as_sym		*syms_tail;
+static struct as_section	*sections;
+static struct as_section	*cur_sect;
+static int			temp_syms;
+
+static void
+fail(const char *reason) {
+	fail_reason = reason;
+	longjmp(fail_env, 1);
+}
+
+static void *
+as_alloc(size_t size) {
+	struct as_chunk	*c = chunks;
+	void		*ret;
+
+	size = (size + sizeof(c->data[0]) - 1) & ~(sizeof(c->data[0]) - 1);
+	if (c == NULL || c->size - c->used < size) {
+		size_t	chunksize = size > 65536? size: 65536;
+
+		c = n_xmalloc(sizeof *c + chunksize);
+		c->next = chunks;
+		c->used = 0;
+		c->size = chunksize;
+		chunks = c;
+	}
+	ret = (char *)c->data + c->used;
+	c->used += size;
+	return ret;
+}
+
+static void
+buf_grow(struct as_buf *b, size_t n) {
+	if (b->len + n > b->alloc) {
+		b->alloc = (b->len + n) * 2 + 64;
+		b->data = n_xrealloc(b->data, b->alloc);
+	}
+}
+
+static void
+buf_put(struct as_buf *b, const void *data, size_t n) {
+	buf_grow(b, n);
+	memcpy(b->data + b->len, data, n);
+	b->len += n;
+}
+
+static unsigned
+hash_name(const char *name, size_t len) {
+	unsigned	key = 0;
+
+	while (len-- > 0) {
+		key = key * 33 + (unsigned char)*name++;
+	}
+	return key & (AS_SYMTAB_SIZE - 1);
+}
+
+static struct as_sym *
+lookup_sym(const char *name, size_t len) {
+	unsigned	key = hash_name(name, len);
+	struct as_sym	*s;
+
+	for (s = sym_hash[key]; s != NULL; s = s->hash_next) {
+		if (strncmp(s->name, name, len) == 0 && s->name[len] == 0) {
+			return s;
+		}
+	}
+	s = as_alloc(sizeof *s);
+	memset(s, 0, sizeof *s);
+	s->name = as_alloc(len + 1);
+	memcpy(s->name, name, len);
+	s->name[len] = 0;
+	if (len > 2 && name[0] == '.' && name[1] == 'L') {
+		s->flags = SYM_NOEMIT;
+	}
+	s->hash_next = sym_hash[key];
+	sym_hash[key] = s;
+	if (syms_tail != NULL) {
+		syms_tail->next = s;
+	} else {
+		syms = s;
+	}
+	syms_tail = s;
+	return s;
+}
+
+static struct as_frag *
+cur_frag(struct as_section *s) {
+	return &s->frags[s->nfrags - 1];
+}
+
+static void
+new_frag(struct as_section *s) {
+	struct as_frag	*f;
+
+	if (s->nfrags == s->fragalloc) {
+		s->fragalloc = s->fragalloc * 2 + 16;
+		s->frags = n_xrealloc(s->frags,
+			s->fragalloc * sizeof *s->frags);
+	}
+	f = &s->frags[s->nfrags++];
+	memset(f, 0, sizeof *f);
+	f->start = s->buf.len;
+}
+
+/*
+ * Ends the fixed part of the current frag and returns it, so the caller
+ * can fill in the variable part. The frag pointer is only valid until
+ * the next new_frag()
+ */
+static struct as_frag *
+close_frag(struct as_section *s, int kind) {
+	struct as_frag	*f = cur_frag(s);
+
+	f->len = s->buf.len - f->start;
+	f->kind = kind;
+	return f;
+}
+
+static struct as_section *
+new_section(const char *name, int type, unsigned long flags) {
+	struct as_section	*s;
+	struct as_section	*tail;
+
+	s = as_alloc(sizeof *s);
+	memset(s, 0, sizeof *s);
+	s->name = as_alloc(strlen(name) + 1);
+	strcpy(s->name, name);
+	s->type = type;
+	s->flags = flags;
+	s->align = 1;
+	s->sym_before = syms_tail;
+	new_frag(s);
+	if (sections == NULL) {
+		sections = s;
+	} else {
+		for (tail = sections; tail->next != NULL; tail = tail->next)
+			;
+		tail->next = s;
+	}
+	return s;
+}
+
+static unsigned long
+frag_offset(struct as_section *s) {
+	return s->buf.len - cur_frag(s)->start;
+}
+
+static void
+define_label(struct as_sym *s) {
+	if (s->flags & (SYM_DEFINED | SYM_COMMON)) {
+		fail("symbol redefined");
+	}
+	s->flags |= SYM_DEFINED;
+	s->sect = cur_sect;
+	s->frag = cur_sect->nfrags - 1;
+	s->off = frag_offset(cur_sect);
+}
+
+static void
+put_bytes(const void *data, size_t n) {
+	if (cur_sect->type == SHT_NOBITS) {
+		const unsigned char	*p = data;
+		size_t			i;
+
+		for (i = 0; i < n; ++i) {
+			if (p[i] != 0) {
+				fail("nonzero data in nobits section");
+			}
+		}
+		/*
+		 * The buffer is only used to keep track of offsets
+		 */
+		buf_grow(&cur_sect->buf, n);
+		memset(cur_sect->buf.data + cur_sect->buf.len, 0, n);
+		cur_sect->buf.len += n;
+		return;
+	}
+	buf_put(&cur_sect->buf, data, n);
+}
+
+static void
+add_fixup(struct as_section *s, int frag, unsigned long off, int size,
+	int kind, struct as_expr *e) {
+	struct as_fixup	*fx;
+
+	if (s->nfixups == s->fixalloc) {
+		s->fixalloc = s->fixalloc * 2 + 16;
+		s->fixups = n_xrealloc(s->fixups,
+			s->fixalloc * sizeof *s->fixups);
+	}
+	fx = &s->fixups[s->nfixups++];
+	fx->frag = frag;
+	fx->off = off;
+	fx->size = size;
+	fx->kind = kind;
+	fx->line = lineno;
+	fx->e = *e;
+}
+
+static void
+put_le(unsigned char *p, unsigned long val, int size) {
+	int	i;
+
+	for (i = 0; i < size; ++i) {
+		p[i] = (unsigned char)(val >> (i * 8));
+	}
+}
+
+static int
+fits_signed(long val, int size) {
+	if (size == 8) {
+		return 1;
+	}
+	return val >= -(1L << (size * 8 - 1))
+		&& val < (1L << (size * 8 - 1));
+}
+
+/*
+ * Checks whether val can be stored in a field of the given size, which
+ * may hold a signed or unsigned quantity. Values are normalized to
+ * their signed equivalent, such that 0xffffffff can use an 8bit
+ * immediate in a 32bit operation
+ */
+static long
+fit_value(long val, int size) {
+	if (size == 8) {
+		return val;
+	}
+	if (val >= (1L << (size * 8)) || val < -(1L << (size * 8 - 1))) {
+		fail("value out of range");
+	}
+	if (val >= (1L << (size * 8 - 1))) {
+		val -= 1L << (size * 8);
+	}
+	return val;
+}
+
+struct as_reg {
+	const char	*name;
+	int		num;
+	int		regclass;
+	int		size;
+	int		rex8;
+	int		high8;
+	struct as_reg	*next;
+};
+
+static const char *const gpr_names[4][16] = {
+	{ "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+	  "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b" },
+	{ "ax", "cx", "dx", "bx", "sp", "bp", "si", "di",
+	  "r8w", "r9w", "r10w", "r11w", "r12w", "r13w", "r14w", "r15w" },
+	{ "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+	  "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d" },
+	{ "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+	  "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15" }
+};
+
+static const char *const high8_names[] = { "ah", "ch", "dh", "bh" };
+
+static const char *const xmm_names[] = {
+	"xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7",
+	"xmm8", "xmm9", "xmm10", "xmm11", "xmm12", "xmm13", "xmm14", "xmm15"
+};
+
+#define AS_REGTAB_SIZE	256
+
+static struct as_reg	*reg_hash[AS_REGTAB_SIZE];
+static struct as_reg	reg_table[16 * 4 + 4 + 16 + 2];
+
+static void
+add_reg(struct as_reg *r, const char *name, int num, int regclass, int size) {
+	unsigned	key = hash_name(name, strlen(name)) % AS_REGTAB_SIZE;
+
+	r->name = name;
+	r->num = num;
+	r->regclass = regclass;
+	r->size = size;
+	r->next = reg_hash[key];
+	reg_hash[key] = r;
+}
+
+static void
+init_regs(void) {
+	struct as_reg	*r = reg_table;
+	int		i;
+	int		j;
+
+	if (reg_table[0].name != NULL) {
+		return;
+	}
+	for (i = 0; i < 4; ++i) {
+		for (j = 0; j < 16; ++j) {
+			add_reg(r, gpr_names[i][j], j, RC_GPR, 1 << i);
+			if (i == 0 && j >= 4 && j < 8) {
+				r->rex8 = 1;
+			}
+			++r;
+		}
+	}
+	for (i = 0; i < 4; ++i) {
+		add_reg(r, high8_names[i], i + 4, RC_GPR, 1);
+		r->high8 = 1;
+		++r;
+	}
+	for (i = 0; i < 16; ++i) {
+		add_reg(r++, xmm_names[i], i, RC_XMM, 16);
+	}
+	add_reg(r++, "st", 0, RC_ST, 10);
+	add_reg(r++, "rip", 0, RC_RIP, 8);
+}
+
+static struct as_reg *
+lookup_reg(const char *name, size_t len) {
+	struct as_reg	*r;
+
+	r = reg_hash[hash_name(name, len) % AS_REGTAB_SIZE];
+	for (; r != NULL; r = r->next) {
+		if (strncmp(r->name, name, len) == 0 && r->name[len] == 0) {
+			return r;
+		}
+	}
+	return NULL;
+}
+
+#define IS_IDENT_START(ch) \
+	(isalpha((unsigned char)(ch)) || (ch) == '_' || (ch) == '.')
+#define IS_IDENT(ch) \
+	(isalnum((unsigned char)(ch)) || (ch) == '_' || (ch) == '.' \
+	 || (ch) == '$')
+
+static char *
+skip_ws(char *p) {
+	while (*p == ' ' || *p == '\t' || *p == '\r') {
+		++p;
+	}
+	return p;
+}
+
+/*
+ * Parses a register name following `%'
+ */
+static char *
+parse_reg(char *p, struct as_operand *op) {
+	char		*start = p;
+	struct as_reg	*r;
+
+	while (isalnum((unsigned char)*p)) {
+		++p;
+	}
+	if ((r = lookup_reg(start, p - start)) == NULL) {
+		fail("unknown register");
+	}
+	op->type = OP_REG;
+	op->reg = r->num;
+	op->regclass = r->regclass;
+	op->size = r->size;
+	op->rex8 = r->rex8;
+	op->high8 = r->high8;
+	if (r->regclass == RC_ST && *p == '(') {
+		if (!isdigit((unsigned char)p[1]) || p[1] > '7'
+			|| p[2] != ')') {
+			fail("bad x87 register");
+		}
+		op->reg = p[1] - '0';
+		p += 3;
+	}
+	return p;
+}
+
+static struct as_sym *
+dot_sym(void) {
+	struct as_sym	*s;
+
+	s = as_alloc(sizeof *s);
+	memset(s, 0, sizeof *s);
+	s->name = ".";
+	s->flags = SYM_TEMP | SYM_NOEMIT;
+	++temp_syms;
+	define_label(s);
+	return s;
+}
+
+static void
+expr_combine(struct as_expr *a, struct as_expr *b, int negate) {
+	struct as_sym	*badd = negate? b->sub: b->add;
+	struct as_sym	*bsub = negate? b->add: b->sub;
+
+	if (badd != NULL) {
+		if (a->add != NULL) {
+			fail("expression too complex");
+		}
+		a->add = badd;
+	}
+	if (bsub != NULL) {
+		if (a->sub != NULL) {
+			fail("expression too complex");
+		}
+		a->sub = bsub;
+	}
+	a->val += negate? -b->val: b->val;
+	if (a->add != NULL && a->add == a->sub) {
+		a->add = a->sub = NULL;
+	}
+}
+
+static char	*parse_expr(char *p, struct as_expr *e);
+
+static char *
+parse_term(char *p, struct as_expr *e) {
+	char		*start;
+	struct as_expr	tmp;
+
+	p = skip_ws(p);
+	e->add = e->sub = NULL;
+	e->val = 0;
+	if (*p == '-' || *p == '~' || *p == '+') {
+		int	ch = *p;
+
+		p = parse_term(p + 1, &tmp);
+		if (ch == '+') {
+			*e = tmp;
+		} else if (tmp.add != NULL || tmp.sub != NULL) {
+			if (ch == '~') {
+				fail("expression too complex");
+			}
+			expr_combine(e, &tmp, 1);
+		} else {
+			e->val = ch == '-'? -tmp.val: ~tmp.val;
+		}
+		return p;
+	} else if (*p == '(') {
+		p = parse_expr(p + 1, e);
+		p = skip_ws(p);
+		if (*p != ')') {
+			fail("missing `)'");
+		}
+		return p + 1;
+	} else if (isdigit((unsigned char)*p)) {
+		if (p[0] == '0' && (p[1] == 'b' || p[1] == 'B')) {
+			e->val = (long)strtoul(p + 2, &p, 2);
+		} else {
+			e->val = (long)strtoul(p, &p, 0);
+		}
+		if (IS_IDENT(*p)) {
+			/* 1f, 1b, etc */
+			fail("local numeric label");
+		}
+		return p;
+	} else if (*p == '\'') {
+		if (p[1] == '\\' || p[1] == 0) {
+			fail("escaped character constant");
+		}
+		e->val = (unsigned char)p[1];
+		p += 2;
+		if (*p == '\'') {
+			++p;
+		}
+		return p;
+	} else if (*p == '.' && !IS_IDENT(p[1])) {
+		e->add = dot_sym();
+		return p + 1;
+	} else if (IS_IDENT_START(*p)) {
+		start = p;
+		while (IS_IDENT(*p)) {
+			++p;
+		}
+		e->add = lookup_sym(start, p - start);
+		if (e->add->flags & SYM_SET) {
+			/* Aliases are only supported as definitions */
+			fail("reference to .set symbol");
+		}
+		return p;
+	}
+	fail("syntax error in expression");
+	/* NOTREACHED */
+	return p;
+}
+
+static char *
+parse_expr(char *p, struct as_expr *e) {
+	struct as_expr	tmp;
+
+	p = parse_term(p, e);
+	for (;;) {
+		int	op;
+
+		p = skip_ws(p);
+		if (*p != '+' && *p != '-') {
+			break;
+		}
+		op = *p;
+		p = parse_term(p + 1, &tmp);
+		expr_combine(e, &tmp, op == '-');
+	}
+	return p;
+}
+
+/*
+ * Parses one AT&T operand: %reg, $imm, or disp(base,index,scale),
+ * optionally prefixed with `*' for indirect jumps and calls
+ */
+static void
+parse_operand(char *p, struct as_operand *op) {
+	memset(op, 0, sizeof *op);
+	op->base = op->index = -1;
+	p = skip_ws(p);
+	if (*p == '*') {
+		op->indirect = 1;
+		p = skip_ws(p + 1);
+	}
+	if (*p == '%') {
+		p = parse_reg(p + 1, op);
+		if (op->regclass == RC_RIP) {
+			fail("bad use of %rip");
+		}
+	} else if (*p == '$') {
+		op->type = OP_IMM;
+		p = parse_expr(p + 1, &op->disp);
+	} else {
+		op->type = OP_MEM;
+		if (*p != '(' || (*skip_ws(p + 1) != '%'
+			&& *skip_ws(p + 1) != ',')) {
+			/* Displacement, possibly parenthesized like (sym) */
+			p = parse_expr(p, &op->disp);
+			p = skip_ws(p);
+		}
+		if (*p == '(') {
+			struct as_operand	r;
+
+			p = skip_ws(p + 1);
+			if (*p == '%') {
+				p = parse_reg(p + 1, &r);
+				if (r.regclass == RC_RIP) {
+					op->rip = 1;
+				} else if (r.regclass != RC_GPR || r.size != 8) {
+					fail("bad base register");
+				} else {
+					op->base = r.reg;
+				}
+				p = skip_ws(p);
+			}
+			if (*p == ',') {
+				p = skip_ws(p + 1);
+				if (*p != '%') {
+					fail("bad index register");
+				}
+				p = parse_reg(p + 1, &r);
+				if (r.regclass != RC_GPR || r.size != 8
+					|| r.reg == 4 || op->rip) {
+					fail("bad index register");
+				}
+				op->index = r.reg;
+				op->scale = 1;
+				p = skip_ws(p);
+				if (*p == ',') {
+					p = skip_ws(p + 1);
+					op->scale = (int)strtol(p, &p, 10);
+					if (op->scale != 1 && op->scale != 2
+						&& op->scale != 4
+						&& op->scale != 8) {
+						fail("bad scale factor");
+					}
+					p = skip_ws(p);
+				}
+			}
+			if (*p != ')') {
+				fail("missing `)'");
+			}
+			++p;
+		}
+	}
+	p = skip_ws(p);
+	if (*p != 0) {
+		fail("junk after operand");
+	}
+}
+
+static void
+put(struct as_insn *in, int byte) {
+	in->b[in->len++] = (unsigned char)byte;
+}
+
+/*
+ * Appends an immediate or displacement field of the given size. If
+ * the value is not a constant, a fixup is recorded for it. The adjust
+ * value is added to the fixup addend (for %rip-relative operands, the
+ * distance to the end of the instruction)
+ */
+static void
+put_field(struct as_insn *in, struct as_expr *e, int size, int kind,
+	long adjust) {
+	if (e->add == NULL && e->sub == NULL) {
+		long	val = e->val;
+
+		if (kind == FIX_ABS_S) {
+			if (!fits_signed(val, size)) {
+				fail("value out of range");
+			}
+		} else {
+			val = fit_value(val, size);
+		}
+		put_le(in->b + in->len, (unsigned long)val, size);
+	} else {
+		if (in->nfix == 2) {
+			fail("too many fixups");
+		}
+		in->fix[in->nfix].pos = in->len;
+		in->fix[in->nfix].size = size;
+		in->fix[in->nfix].kind = kind;
+		in->fix[in->nfix].e = *e;
+		in->fix[in->nfix].e.val += adjust;
+		++in->nfix;
+		memset(in->b + in->len, 0, size);
+	}
+	in->len += size;
+}
+
+static int
+is_const(struct as_expr *e) {
+	return e->add == NULL && e->sub == NULL;
+}
+
+static void
+put_modrm(struct as_insn *in, int reg, struct as_operand *rm, int immsize) {
+	int	mod;
+	int	ss;
+
+	reg = (reg & 7) << 3;
+	if (rm->type == OP_REG) {
+		put(in, 0xc0 | reg | (rm->reg & 7));
+		return;
+	}
+	if (rm->rip) {
+		put(in, 0x05 | reg);
+		put_field(in, &rm->disp, 4, FIX_PC, -4 - immsize);
+		return;
+	}
+	ss = rm->scale == 8? 3: rm->scale == 4? 2: rm->scale == 2? 1: 0;
+	if (rm->base == -1) {
+		put(in, 0x04 | reg);
+		if (rm->index == -1) {
+			put(in, 0x25);
+		} else {
+			put(in, (ss << 6) | ((rm->index & 7) << 3) | 5);
+		}
+		put_field(in, &rm->disp, 4, FIX_ABS_S, 0);
+		return;
+	}
+	if (!is_const(&rm->disp)) {
+		mod = 2;
+	} else if (rm->disp.val == 0 && (rm->base & 7) != 5) {
+		mod = 0;
+	} else if (fits_signed(rm->disp.val, 1)) {
+		mod = 1;
+	} else {
+		mod = 2;
+	}
+	if (rm->index == -1 && (rm->base & 7) != 4) {
+		put(in, (mod << 6) | reg | (rm->base & 7));
+	} else {
+		put(in, (mod << 6) | reg | 4);
+		put(in, (ss << 6)
+			| ((rm->index == -1? 4: rm->index & 7) << 3)
+			| (rm->base & 7));
+	}
+	if (mod == 1) {
+		put(in, (int)rm->disp.val);
+	} else if (mod == 2) {
+		put_field(in, &rm->disp, 4, FIX_ABS_S, 0);
+	}
+}
+
+/*
+ * Computes the REX prefix for an instruction whose ModRM reg field is
+ * given by r (or the opcode extension if r is NULL) and whose r/m
+ * field is given by rm
+ */
+static int
+get_rex(int size, struct as_operand *r, int ext, struct as_operand *rm) {
+	int	rex = 0;
+	int	high = 0;
+	int	reg = r != NULL? r->reg: ext;
+
+	if (size == 8) {
+		rex |= 0x48;
+	}
+	if (reg & 8) {
+		rex |= 0x44;
+	}
+	if (r != NULL) {
+		if (r->rex8) {
+			rex |= 0x40;
+		}
+		high |= r->high8;
+	}
+	if (rm != NULL) {
+		if (rm->type == OP_REG) {
+			if (rm->reg & 8) {
+				rex |= 0x41;
+			}
+			if (rm->rex8) {
+				rex |= 0x40;
+			}
+			high |= rm->high8;
+		} else {
+			if (rm->index != -1 && (rm->index & 8)) {
+				rex |= 0x42;
+			}
+			if (rm->base != -1 && (rm->base & 8)) {
+				rex |= 0x41;
+			}
+		}
+	}
+	if (rex && high) {
+		fail("high byte register used with REX prefix");
+	}
+	return rex;
+}
+
+/*
+ * Encodes an instruction using a ModRM byte. pfx is a mandatory prefix
+ * (0x66, 0xf2, 0xf3) or 0, size is the operand size (2 gets an operand
+ * size prefix, 8 sets REX.W), and opc is a one byte opcode or a two
+ * byte opcode with 0x0f as first byte. immsize is the size of an
+ * immediate following the ModRM operand, which %rip-relative
+ * displacements have to account for
+ */
+static void
+encode_rm(struct as_insn *in, int pfx, int size, int opc,
+	struct as_operand *r, int ext, struct as_operand *rm, int immsize) {
+	int	rex = get_rex(size, r, ext, rm);
+
+	if (size == 2) {
+		put(in, 0x66);
+	}
+	if (pfx) {
+		put(in, pfx);
+	}
+	if (rex) {
+		put(in, rex);
+	}
+	if (opc > 0xff) {
+		put(in, opc >> 8);
+	}
+	put(in, opc & 0xff);
+	put_modrm(in, r != NULL? r->reg: ext, rm, immsize);
+}
+
+/*
+ * Encodes an instruction with the register in the low opcode bits, such
+ * as push %reg or mov $imm, %reg
+ */
+static void
+encode_opreg(struct as_insn *in, int size, int opc, struct as_operand *reg) {
+	int	rex = get_rex(size, NULL, 0, reg);
+
+	if (size == 2) {
+		put(in, 0x66);
+	}
+	if (rex) {
+		put(in, rex);
+	}
+	put(in, opc + (reg->reg & 7));
+}
+
+/*
+ * Copies the instruction to the current section and records its fixups
+ */
+static void
+commit_insn(struct as_insn *in) {
+	unsigned long	off = frag_offset(cur_sect);
+	int		frag = cur_sect->nfrags - 1;
+	int		i;
+
+	if (cur_sect->type == SHT_NOBITS) {
+		fail("instruction in nobits section");
+	}
+	buf_put(&cur_sect->buf, in->b, in->len);
+	for (i = 0; i < in->nfix; ++i) {
+		add_fixup(cur_sect, frag, off + in->fix[i].pos,
+			in->fix[i].size, in->fix[i].kind, &in->fix[i].e);
+	}
+}
+
+/*
+ * Instruction classes
+ */
+#define I_ALU		1	/* add, or, adc, sbb, and, sub, xor, cmp */
+#define I_MOV		2
+#define I_MOVABS	3
+#define I_TEST		4
+#define I_XCHG		5
+#define I_LEA		6
+#define I_UNARY		7	/* inc, dec, not, neg, mul, div, idiv */
+#define I_IMUL		8
+#define I_SHIFT		9
+#define I_PUSH		10
+#define I_POP		11
+#define I_MOVX		12	/* movsx, movzx and suffixed variants */
+#define I_MOVSXD	13
+#define I_FIXED		14	/* no operands */
+#define I_JMP		15
+#define I_JCC		16
+#define I_CALL		17
+#define I_LOOP		18
+#define I_SETCC		19
+#define I_CMOV		20
+#define I_SSE		21	/* xmm/mem -> xmm */
+#define I_SSEMOV	22	/* movsd, movss, movaps, ... */
+#define I_CVTI2F	23	/* cvtsi2sd, cvtsi2ss */
+#define I_CVTF2I	24	/* cvttsd2si, cvtsd2si, ... */
+#define I_MOVQ		25
+#define I_MOVD		26
+#define I_X87M		27	/* x87 memory operand */
+#define I_X87R		28	/* x87 %st(i) operand */
+#define I_PREFIX	29
+
+#define SUF_B	1
+#define SUF_W	2
+#define SUF_L	4
+#define SUF_Q	8
+#define SUF_ALL	(SUF_B | SUF_W | SUF_L | SUF_Q)
+
+struct as_mnemonic {
+	const char		*name;
+	int			cls;
+	int			op;	/* opcode, extension or condition */
+	int			op2;	/* second opcode or extension */
+	int			pfx;	/* mandatory prefix */
+	int			size;	/* implied operand size */
+	int			suffixes;
+	const char		*bytes;	/* I_FIXED */
+	struct as_mnemonic	*next;
+};
+
+static struct as_mnemonic mnemonics[] = {
+	{ "add", I_ALU, 0, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "or", I_ALU, 1, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "adc", I_ALU, 2, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "sbb", I_ALU, 3, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "and", I_ALU, 4, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "sub", I_ALU, 5, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "xor", I_ALU, 6, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "cmp", I_ALU, 7, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "mov", I_MOV, 0, 0, 0, 0, SUF_B | SUF_W | SUF_L, NULL, NULL },
+	{ "movabs", I_MOVABS, 0, 0, 0, 0, SUF_Q, NULL, NULL },
+	{ "test", I_TEST, 0, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "xchg", I_XCHG, 0, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "lea", I_LEA, 0, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "inc", I_UNARY, 0, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "dec", I_UNARY, 1, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "not", I_UNARY, 2, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "neg", I_UNARY, 3, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "mul", I_UNARY, 4, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "div", I_UNARY, 6, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "idiv", I_UNARY, 7, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "imul", I_IMUL, 5, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "rol", I_SHIFT, 0, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "ror", I_SHIFT, 1, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "rcl", I_SHIFT, 2, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "rcr", I_SHIFT, 3, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "shl", I_SHIFT, 4, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "sal", I_SHIFT, 4, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "shr", I_SHIFT, 5, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "sar", I_SHIFT, 7, 0, 0, 0, SUF_ALL, NULL, NULL },
+	{ "push", I_PUSH, 0, 0, 0, 0, SUF_W | SUF_Q, NULL, NULL },
+	{ "pop", I_POP, 0, 0, 0, 0, SUF_W | SUF_Q, NULL, NULL },
+	{ "movsx", I_MOVX, 0x0fbe, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "movzx", I_MOVX, 0x0fb6, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "movsbw", I_MOVX, 0x0fbe, 1, 0, 2, 0, NULL, NULL },
+	{ "movsbl", I_MOVX, 0x0fbe, 1, 0, 4, 0, NULL, NULL },
+	{ "movsbq", I_MOVX, 0x0fbe, 1, 0, 8, 0, NULL, NULL },
+	{ "movswl", I_MOVX, 0x0fbe, 2, 0, 4, 0, NULL, NULL },
+	{ "movswq", I_MOVX, 0x0fbe, 2, 0, 8, 0, NULL, NULL },
+	{ "movzbw", I_MOVX, 0x0fb6, 1, 0, 2, 0, NULL, NULL },
+	{ "movzbl", I_MOVX, 0x0fb6, 1, 0, 4, 0, NULL, NULL },
+	{ "movzbq", I_MOVX, 0x0fb6, 1, 0, 8, 0, NULL, NULL },
+	{ "movzwl", I_MOVX, 0x0fb6, 2, 0, 4, 0, NULL, NULL },
+	{ "movzwq", I_MOVX, 0x0fb6, 2, 0, 8, 0, NULL, NULL },
+	{ "movslq", I_MOVSXD, 0x63, 4, 0, 8, 0, NULL, NULL },
+	{ "movsxd", I_MOVSXD, 0x63, 0, 0, 8, 0, NULL, NULL },
+	{ "ret", I_FIXED, 0, 0, 0, 0, SUF_Q, "\xc3", NULL },
+	{ "leave", I_FIXED, 0, 0, 0, 0, SUF_Q, "\xc9", NULL },
+	{ "nop", I_FIXED, 0, 0, 0, 0, 0, "\x90", NULL },
+	{ "hlt", I_FIXED, 0, 0, 0, 0, 0, "\xf4", NULL },
+	{ "cltd", I_FIXED, 0, 0, 0, 0, 0, "\x99", NULL },
+	{ "cqto", I_FIXED, 0, 0, 0, 0, 0, "\x48\x99", NULL },
+	{ "cwtl", I_FIXED, 0, 0, 0, 0, 0, "\x98", NULL },
+	{ "cltq", I_FIXED, 0, 0, 0, 0, 0, "\x48\x98", NULL },
+	{ "cld", I_FIXED, 0, 0, 0, 0, 0, "\xfc", NULL },
+	{ "std", I_FIXED, 0, 0, 0, 0, 0, "\xfd", NULL },
+	{ "ud2", I_FIXED, 0, 0, 0, 0, 0, "\x0f\x0b", NULL },
+	{ "int3", I_FIXED, 0, 0, 0, 0, 0, "\xcc", NULL },
+	{ "lodsb", I_FIXED, 0, 0, 0, 0, 0, "\xac", NULL },
+	{ "lodsw", I_FIXED, 0, 0, 0, 0, 0, "\x66\xad", NULL },
+	{ "lodsl", I_FIXED, 0, 0, 0, 0, 0, "\xad", NULL },
+	{ "lodsq", I_FIXED, 0, 0, 0, 0, 0, "\x48\xad", NULL },
+	{ "stosb", I_FIXED, 0, 0, 0, 0, 0, "\xaa", NULL },
+	{ "stosw", I_FIXED, 0, 0, 0, 0, 0, "\x66\xab", NULL },
+	{ "stosl", I_FIXED, 0, 0, 0, 0, 0, "\xab", NULL },
+	{ "stosq", I_FIXED, 0, 0, 0, 0, 0, "\x48\xab", NULL },
+	{ "movsb", I_FIXED, 0, 0, 0, 0, 0, "\xa4", NULL },
+	{ "movsw", I_FIXED, 0, 0, 0, 0, 0, "\x66\xa5", NULL },
+	{ "movsl", I_FIXED, 0, 0, 0, 0, 0, "\xa5", NULL },
+	{ "movsq", I_FIXED, 0, 0, 0, 0, 0, "\x48\xa5", NULL },
+	{ "jmp", I_JMP, 0, 0, 0, 0, SUF_Q, NULL, NULL },
+	{ "call", I_CALL, 0, 0, 0, 0, SUF_Q, NULL, NULL },
+	{ "jo", I_JCC, 0, 0, 0, 0, 0, NULL, NULL },
+	{ "jno", I_JCC, 1, 0, 0, 0, 0, NULL, NULL },
+	{ "jb", I_JCC, 2, 0, 0, 0, 0, NULL, NULL },
+	{ "jc", I_JCC, 2, 0, 0, 0, 0, NULL, NULL },
+	{ "jnae", I_JCC, 2, 0, 0, 0, 0, NULL, NULL },
+	{ "jae", I_JCC, 3, 0, 0, 0, 0, NULL, NULL },
+	{ "jnb", I_JCC, 3, 0, 0, 0, 0, NULL, NULL },
+	{ "jnc", I_JCC, 3, 0, 0, 0, 0, NULL, NULL },
+	{ "je", I_JCC, 4, 0, 0, 0, 0, NULL, NULL },
+	{ "jz", I_JCC, 4, 0, 0, 0, 0, NULL, NULL },
+	{ "jne", I_JCC, 5, 0, 0, 0, 0, NULL, NULL },
+	{ "jnz", I_JCC, 5, 0, 0, 0, 0, NULL, NULL },
+	{ "jbe", I_JCC, 6, 0, 0, 0, 0, NULL, NULL },
+	{ "jna", I_JCC, 6, 0, 0, 0, 0, NULL, NULL },
+	{ "ja", I_JCC, 7, 0, 0, 0, 0, NULL, NULL },
+	{ "jnbe", I_JCC, 7, 0, 0, 0, 0, NULL, NULL },
+	{ "js", I_JCC, 8, 0, 0, 0, 0, NULL, NULL },
+	{ "jns", I_JCC, 9, 0, 0, 0, 0, NULL, NULL },
+	{ "jp", I_JCC, 10, 0, 0, 0, 0, NULL, NULL },
+	{ "jpe", I_JCC, 10, 0, 0, 0, 0, NULL, NULL },
+	{ "jnp", I_JCC, 11, 0, 0, 0, 0, NULL, NULL },
+	{ "jpo", I_JCC, 11, 0, 0, 0, 0, NULL, NULL },
+	{ "jl", I_JCC, 12, 0, 0, 0, 0, NULL, NULL },
+	{ "jnge", I_JCC, 12, 0, 0, 0, 0, NULL, NULL },
+	{ "jge", I_JCC, 13, 0, 0, 0, 0, NULL, NULL },
+	{ "jnl", I_JCC, 13, 0, 0, 0, 0, NULL, NULL },
+	{ "jle", I_JCC, 14, 0, 0, 0, 0, NULL, NULL },
+	{ "jng", I_JCC, 14, 0, 0, 0, 0, NULL, NULL },
+	{ "jg", I_JCC, 15, 0, 0, 0, 0, NULL, NULL },
+	{ "jnle", I_JCC, 15, 0, 0, 0, 0, NULL, NULL },
+	{ "loop", I_LOOP, 0xe2, 0, 0, 0, 0, NULL, NULL },
+	{ "loope", I_LOOP, 0xe1, 0, 0, 0, 0, NULL, NULL },
+	{ "loopz", I_LOOP, 0xe1, 0, 0, 0, 0, NULL, NULL },
+	{ "loopne", I_LOOP, 0xe0, 0, 0, 0, 0, NULL, NULL },
+	{ "loopnz", I_LOOP, 0xe0, 0, 0, 0, 0, NULL, NULL },
+	{ "jrcxz", I_LOOP, 0xe3, 0, 0, 0, 0, NULL, NULL },
+	{ "seto", I_SETCC, 0, 0, 0, 0, 0, NULL, NULL },
+	{ "setno", I_SETCC, 1, 0, 0, 0, 0, NULL, NULL },
+	{ "setb", I_SETCC, 2, 0, 0, 0, 0, NULL, NULL },
+	{ "setc", I_SETCC, 2, 0, 0, 0, 0, NULL, NULL },
+	{ "setnae", I_SETCC, 2, 0, 0, 0, 0, NULL, NULL },
+	{ "setae", I_SETCC, 3, 0, 0, 0, 0, NULL, NULL },
+	{ "setnb", I_SETCC, 3, 0, 0, 0, 0, NULL, NULL },
+	{ "setnc", I_SETCC, 3, 0, 0, 0, 0, NULL, NULL },
+	{ "sete", I_SETCC, 4, 0, 0, 0, 0, NULL, NULL },
+	{ "setz", I_SETCC, 4, 0, 0, 0, 0, NULL, NULL },
+	{ "setne", I_SETCC, 5, 0, 0, 0, 0, NULL, NULL },
+	{ "setnz", I_SETCC, 5, 0, 0, 0, 0, NULL, NULL },
+	{ "setbe", I_SETCC, 6, 0, 0, 0, 0, NULL, NULL },
+	{ "setna", I_SETCC, 6, 0, 0, 0, 0, NULL, NULL },
+	{ "seta", I_SETCC, 7, 0, 0, 0, 0, NULL, NULL },
+	{ "setnbe", I_SETCC, 7, 0, 0, 0, 0, NULL, NULL },
+	{ "sets", I_SETCC, 8, 0, 0, 0, 0, NULL, NULL },
+	{ "setns", I_SETCC, 9, 0, 0, 0, 0, NULL, NULL },
+	{ "setp", I_SETCC, 10, 0, 0, 0, 0, NULL, NULL },
+	{ "setpe", I_SETCC, 10, 0, 0, 0, 0, NULL, NULL },
+	{ "setnp", I_SETCC, 11, 0, 0, 0, 0, NULL, NULL },
+	{ "setpo", I_SETCC, 11, 0, 0, 0, 0, NULL, NULL },
+	{ "setl", I_SETCC, 12, 0, 0, 0, 0, NULL, NULL },
+	{ "setnge", I_SETCC, 12, 0, 0, 0, 0, NULL, NULL },
+	{ "setge", I_SETCC, 13, 0, 0, 0, 0, NULL, NULL },
+	{ "setnl", I_SETCC, 13, 0, 0, 0, 0, NULL, NULL },
+	{ "setle", I_SETCC, 14, 0, 0, 0, 0, NULL, NULL },
+	{ "setng", I_SETCC, 14, 0, 0, 0, 0, NULL, NULL },
+	{ "setg", I_SETCC, 15, 0, 0, 0, 0, NULL, NULL },
+	{ "setnle", I_SETCC, 15, 0, 0, 0, 0, NULL, NULL },
+	{ "cmovo", I_CMOV, 0, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmovno", I_CMOV, 1, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmovb", I_CMOV, 2, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmovae", I_CMOV, 3, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmove", I_CMOV, 4, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmovz", I_CMOV, 4, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmovne", I_CMOV, 5, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmovnz", I_CMOV, 5, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmovbe", I_CMOV, 6, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmova", I_CMOV, 7, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmovs", I_CMOV, 8, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmovns", I_CMOV, 9, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmovp", I_CMOV, 10, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmovnp", I_CMOV, 11, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmovl", I_CMOV, 12, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmovge", I_CMOV, 13, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmovle", I_CMOV, 14, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "cmovg", I_CMOV, 15, 0, 0, 0, SUF_W | SUF_L | SUF_Q, NULL, NULL },
+	{ "movsd", I_SSEMOV, 0x10, 0x11, 0xf2, 0, 0, NULL, NULL },
+	{ "movss", I_SSEMOV, 0x10, 0x11, 0xf3, 0, 0, NULL, NULL },
+	{ "movaps", I_SSEMOV, 0x28, 0x29, 0, 0, 0, NULL, NULL },
+	{ "movapd", I_SSEMOV, 0x28, 0x29, 0x66, 0, 0, NULL, NULL },
+	{ "movups", I_SSEMOV, 0x10, 0x11, 0, 0, 0, NULL, NULL },
+	{ "movupd", I_SSEMOV, 0x10, 0x11, 0x66, 0, 0, NULL, NULL },
+	{ "movdqa", I_SSEMOV, 0x6f, 0x7f, 0x66, 0, 0, NULL, NULL },
+	{ "movdqu", I_SSEMOV, 0x6f, 0x7f, 0xf3, 0, 0, NULL, NULL },
+	{ "addsd", I_SSE, 0x58, 0, 0xf2, 0, 0, NULL, NULL },
+	{ "addss", I_SSE, 0x58, 0, 0xf3, 0, 0, NULL, NULL },
+	{ "mulsd", I_SSE, 0x59, 0, 0xf2, 0, 0, NULL, NULL },
+	{ "mulss", I_SSE, 0x59, 0, 0xf3, 0, 0, NULL, NULL },
+	{ "subsd", I_SSE, 0x5c, 0, 0xf2, 0, 0, NULL, NULL },
+	{ "subss", I_SSE, 0x5c, 0, 0xf3, 0, 0, NULL, NULL },
+	{ "divsd", I_SSE, 0x5e, 0, 0xf2, 0, 0, NULL, NULL },
+	{ "divss", I_SSE, 0x5e, 0, 0xf3, 0, 0, NULL, NULL },
+	{ "minsd", I_SSE, 0x5d, 0, 0xf2, 0, 0, NULL, NULL },
+	{ "minss", I_SSE, 0x5d, 0, 0xf3, 0, 0, NULL, NULL },
+	{ "maxsd", I_SSE, 0x5f, 0, 0xf2, 0, 0, NULL, NULL },
+	{ "maxss", I_SSE, 0x5f, 0, 0xf3, 0, 0, NULL, NULL },
+	{ "sqrtsd", I_SSE, 0x51, 0, 0xf2, 0, 0, NULL, NULL },
+	{ "sqrtss", I_SSE, 0x51, 0, 0xf3, 0, 0, NULL, NULL },
+	{ "ucomisd", I_SSE, 0x2e, 0, 0x66, 0, 0, NULL, NULL },
+	{ "ucomiss", I_SSE, 0x2e, 0, 0, 0, 0, NULL, NULL },
+	{ "comisd", I_SSE, 0x2f, 0, 0x66, 0, 0, NULL, NULL },
+	{ "comiss", I_SSE, 0x2f, 0, 0, 0, 0, NULL, NULL },
+	{ "andpd", I_SSE, 0x54, 0, 0x66, 0, 0, NULL, NULL },
+	{ "andps", I_SSE, 0x54, 0, 0, 0, 0, NULL, NULL },
+	{ "andnpd", I_SSE, 0x55, 0, 0x66, 0, 0, NULL, NULL },
+	{ "andnps", I_SSE, 0x55, 0, 0, 0, 0, NULL, NULL },
+	{ "orpd", I_SSE, 0x56, 0, 0x66, 0, 0, NULL, NULL },
+	{ "orps", I_SSE, 0x56, 0, 0, 0, 0, NULL, NULL },
+	{ "xorpd", I_SSE, 0x57, 0, 0x66, 0, 0, NULL, NULL },
+	{ "xorps", I_SSE, 0x57, 0, 0, 0, 0, NULL, NULL },
+	{ "pxor", I_SSE, 0xef, 0, 0x66, 0, 0, NULL, NULL },
+	{ "punpckldq", I_SSE, 0x62, 0, 0x66, 0, 0, NULL, NULL },
+	{ "punpcklqdq", I_SSE, 0x6c, 0, 0x66, 0, 0, NULL, NULL },
+	{ "cvtss2sd", I_SSE, 0x5a, 0, 0xf3, 0, 0, NULL, NULL },
+	{ "cvtsd2ss", I_SSE, 0x5a, 0, 0xf2, 0, 0, NULL, NULL },
+	{ "cvtsi2sd", I_CVTI2F, 0x2a, 0, 0xf2, 0, SUF_L | SUF_Q, NULL, NULL },
+	{ "cvtsi2ss", I_CVTI2F, 0x2a, 0, 0xf3, 0, SUF_L | SUF_Q, NULL, NULL },
+	{ "cvttsd2si", I_CVTF2I, 0x2c, 0, 0xf2, 0, SUF_L | SUF_Q, NULL, NULL },
+	{ "cvttss2si", I_CVTF2I, 0x2c, 0, 0xf3, 0, SUF_L | SUF_Q, NULL, NULL },
+	{ "cvtsd2si", I_CVTF2I, 0x2d, 0, 0xf2, 0, SUF_L | SUF_Q, NULL, NULL },
+	{ "cvtss2si", I_CVTF2I, 0x2d, 0, 0xf3, 0, SUF_L | SUF_Q, NULL, NULL },
+	{ "movq", I_MOVQ, 0, 0, 0, 8, 0, NULL, NULL },
+	{ "movd", I_MOVD, 0, 0, 0, 4, 0, NULL, NULL },
+	{ "flds", I_X87M, 0xd9, 0, 0, 0, 0, NULL, NULL },
+	{ "fldl", I_X87M, 0xdd, 0, 0, 0, 0, NULL, NULL },
+	{ "fldt", I_X87M, 0xdb, 5, 0, 0, 0, NULL, NULL },
+	{ "fsts", I_X87M, 0xd9, 2, 0, 0, 0, NULL, NULL },
+	{ "fstl", I_X87M, 0xdd, 2, 0, 0, 0, NULL, NULL },
+	{ "fstps", I_X87M, 0xd9, 3, 0, 0, 0, NULL, NULL },
+	{ "fstpl", I_X87M, 0xdd, 3, 0, 0, 0, NULL, NULL },
+	{ "fstpt", I_X87M, 0xdb, 7, 0, 0, 0, NULL, NULL },
+	{ "filds", I_X87M, 0xdf, 0, 0, 0, 0, NULL, NULL },
+	{ "fildl", I_X87M, 0xdb, 0, 0, 0, 0, NULL, NULL },
+	{ "fildq", I_X87M, 0xdf, 5, 0, 0, 0, NULL, NULL },
+	{ "fildll", I_X87M, 0xdf, 5, 0, 0, 0, NULL, NULL },
+	{ "fistps", I_X87M, 0xdf, 3, 0, 0, 0, NULL, NULL },
+	{ "fistpl", I_X87M, 0xdb, 3, 0, 0, 0, NULL, NULL },
+	{ "fistpq", I_X87M, 0xdf, 7, 0, 0, 0, NULL, NULL },
+	{ "fistpll", I_X87M, 0xdf, 7, 0, 0, 0, NULL, NULL },
+	{ "fisttpl", I_X87M, 0xdb, 1, 0, 0, 0, NULL, NULL },
+	{ "fisttpll", I_X87M, 0xdd, 1, 0, 0, 0, NULL, NULL },
+	{ "fnstcw", I_X87M, 0xd9, 7, 0, 0, 0, NULL, NULL },
+	{ "fldcw", I_X87M, 0xd9, 5, 0, 0, 0, NULL, NULL },
+	/* op is the opcode for %st(0), op2 the default register */
+	{ "fld", I_X87R, 0xd9c0, -1, 0, 0, 0, NULL, NULL },
+	{ "fst", I_X87R, 0xddd0, -1, 0, 0, 0, NULL, NULL },
+	{ "fstp", I_X87R, 0xddd8, -1, 0, 0, 0, NULL, NULL },
+	{ "fxch", I_X87R, 0xd9c8, 1, 0, 0, 0, NULL, NULL },
+	{ "ffree", I_X87R, 0xddc0, -1, 0, 0, 0, NULL, NULL },
+	{ "faddp", I_X87R, 0xdec0, 1, 0, 0, 0, NULL, NULL },
+	{ "fmulp", I_X87R, 0xdec8, 1, 0, 0, 0, NULL, NULL },
+	/* AT&T fsubp/fdivp are Intel fsubrp/fdivrp and vice versa */
+	{ "fsubp", I_X87R, 0xdee0, 1, 0, 0, 0, NULL, NULL },
+	{ "fsubrp", I_X87R, 0xdee8, 1, 0, 0, 0, NULL, NULL },
+	{ "fdivp", I_X87R, 0xdef0, 1, 0, 0, 0, NULL, NULL },
+	{ "fdivrp", I_X87R, 0xdef8, 1, 0, 0, 0, NULL, NULL },
+	{ "fucomi", I_X87R, 0xdbe8, 1, 0, 0, 0, NULL, NULL },
+	{ "fucomip", I_X87R, 0xdfe8, 1, 0, 0, 0, NULL, NULL },
+	{ "fcomi", I_X87R, 0xdbf0, 1, 0, 0, 0, NULL, NULL },
+	{ "fcomip", I_X87R, 0xdff0, 1, 0, 0, 0, NULL, NULL },
+	{ "fchs", I_FIXED, 0, 0, 0, 0, 0, "\xd9\xe0", NULL },
+	{ "fabs", I_FIXED, 0, 0, 0, 0, 0, "\xd9\xe1", NULL },
+	{ "fld1", I_FIXED, 0, 0, 0, 0, 0, "\xd9\xe8", NULL },
+	{ "fldz", I_FIXED, 0, 0, 0, 0, 0, "\xd9\xee", NULL },
+	{ "fsqrt", I_FIXED, 0, 0, 0, 0, 0, "\xd9\xfa", NULL },
+	{ "frndint", I_FIXED, 0, 0, 0, 0, 0, "\xd9\xfc", NULL },
+	{ "fwait", I_FIXED, 0, 0, 0, 0, 0, "\x9b", NULL },
+	{ "rep", I_PREFIX, 0xf3, 0, 0, 0, 0, NULL, NULL },
+	{ "repe", I_PREFIX, 0xf3, 0, 0, 0, 0, NULL, NULL },
+	{ "repz", I_PREFIX, 0xf3, 0, 0, 0, 0, NULL, NULL },
+	{ "repne", I_PREFIX, 0xf2, 0, 0, 0, 0, NULL, NULL },
+	{ "repnz", I_PREFIX, 0xf2, 0, 0, 0, 0, NULL, NULL },
+	{ "lock", I_PREFIX, 0xf0, 0, 0, 0, 0, NULL, NULL },
+	{ NULL, 0, 0, 0, 0, 0, 0, NULL, NULL }
+};
+
+#define AS_MNTAB_SIZE	512
+
+static struct as_mnemonic	*mn_hash[AS_MNTAB_SIZE];
+
+static void
+init_mnemonics(void) {
+	struct as_mnemonic	*m;
+	unsigned		key;
+
+	if (mn_hash[hash_name("mov", 3) % AS_MNTAB_SIZE] != NULL) {
+		return;
+	}
+	for (m = mnemonics; m->name != NULL; ++m) {
+		key = hash_name(m->name, strlen(m->name)) % AS_MNTAB_SIZE;
+		m->next = mn_hash[key];
+		mn_hash[key] = m;
+	}
+}
+
+static struct as_mnemonic *
+lookup_mnemonic(const char *name, size_t len) {
+	struct as_mnemonic	*m;
+
+	m = mn_hash[hash_name(name, len) % AS_MNTAB_SIZE];
+	for (; m != NULL; m = m->next) {
+		if (strncmp(m->name, name, len) == 0 && m->name[len] == 0) {
+			return m;
+		}
+	}
+	return NULL;
+}
+
+static int
+is_gpr(struct as_operand *op) {
+	return op->type == OP_REG && op->regclass == RC_GPR;
+}
+
+static int
+is_xmm(struct as_operand *op) {
+	return op->type == OP_REG && op->regclass == RC_XMM;
+}
+
+static int
+op_size(int size, struct as_operand *op) {
+	if (op->type != OP_REG) {
+		return size;
+	}
+	if (op->regclass != RC_GPR) {
+		fail("bad register operand");
+	}
+	if (size != 0 && op->size != size) {
+		fail("operand size mismatch");
+	}
+	return op->size;
+}
+
+/*
+ * Determines the operand size from the mnemonic suffix (if any) and the
+ * general purpose register operands, which must all agree
+ */
+static int
+get_size(int size, struct as_operand *ops, int nops) {
+	int	i;
+
+	for (i = 0; i < nops; ++i) {
+		size = op_size(size, &ops[i]);
+	}
+	if (size == 0) {
+		fail("operand size unknown");
+	}
+	return size;
+}
+
+static int
+get_size2(int size, struct as_operand *a, struct as_operand *b) {
+	return get_size(op_size(size, a), b, 1);
+}
+
+static int
+imm_size(int size) {
+	return size == 1? 1: size == 2? 2: 4;
+}
+
+static int
+imm_kind(int size) {
+	return size == 8? FIX_ABS_S: FIX_ABS;
+}
+
+static void
+do_alu(struct as_insn *in, int n, int size, struct as_operand *src,
+	struct as_operand *dst) {
+	if (dst->type == OP_IMM
+		|| (src->type == OP_MEM && dst->type == OP_MEM)) {
+		fail("bad operands");
+	}
+	size = get_size2(size, src, dst);
+	if (src->type == OP_IMM) {
+		int	immsize = imm_size(size);
+
+		if (is_const(&src->disp) && size != 8) {
+			src->disp.val = fit_value(src->disp.val, size);
+		}
+		if (size == 1) {
+			if (dst->type == OP_REG && dst->reg == 0) {
+				put(in, 0x04 + n * 8);
+			} else {
+				encode_rm(in, 0, 1, 0x80, NULL, n, dst, 1);
+			}
+		} else if (is_const(&src->disp)
+			&& fits_signed(src->disp.val, 1)) {
+			immsize = 1;
+			encode_rm(in, 0, size, 0x83, NULL, n, dst, 1);
+		} else if (dst->type == OP_REG && dst->reg == 0) {
+			if (size == 2) {
+				put(in, 0x66);
+			} else if (size == 8) {
+				put(in, 0x48);
+			}
+			put(in, 0x05 + n * 8);
+		} else {
+			encode_rm(in, 0, size, 0x81, NULL, n, dst, immsize);
+		}
+		put_field(in, &src->disp, immsize, imm_kind(size), 0);
+	} else if (src->type == OP_REG) {
+		encode_rm(in, 0, size, n * 8 + (size == 1? 0: 1),
+			src, 0, dst, 0);
+	} else {
+		encode_rm(in, 0, size, n * 8 + (size == 1? 2: 3),
+			dst, 0, src, 0);
+	}
+}
+
+static void
+do_mov(struct as_insn *in, int size, struct as_operand *src,
+	struct as_operand *dst) {
+	if (dst->type == OP_IMM
+		|| (src->type == OP_MEM && dst->type == OP_MEM)) {
+		fail("bad operands");
+	}
+	size = get_size2(size, src, dst);
+	if (src->type == OP_IMM) {
+		if (dst->type == OP_MEM) {
+			encode_rm(in, 0, size, size == 1? 0xc6: 0xc7,
+				NULL, 0, dst, imm_size(size));
+			put_field(in, &src->disp, imm_size(size),
+				imm_kind(size), 0);
+		} else if (size == 8) {
+			if (!is_const(&src->disp)
+				|| fits_signed(src->disp.val, 4)) {
+				encode_rm(in, 0, 8, 0xc7, NULL, 0, dst, 4);
+				put_field(in, &src->disp, 4, FIX_ABS_S, 0);
+			} else {
+				encode_opreg(in, 8, 0xb8, dst);
+				put_field(in, &src->disp, 8, FIX_ABS, 0);
+			}
+		} else {
+			encode_opreg(in, size, size == 1? 0xb0: 0xb8, dst);
+			put_field(in, &src->disp, size, FIX_ABS, 0);
+		}
+	} else if (src->type == OP_REG) {
+		encode_rm(in, 0, size, size == 1? 0x88: 0x89, src, 0, dst, 0);
+	} else {
+		encode_rm(in, 0, size, size == 1? 0x8a: 0x8b, dst, 0, src, 0);
+	}
+}
+
+static void
+do_test(struct as_insn *in, int size, struct as_operand *src,
+	struct as_operand *dst) {
+	if (dst->type == OP_IMM
+		|| (src->type == OP_MEM && dst->type == OP_MEM)) {
+		fail("bad operands");
+	}
+	size = get_size2(size, src, dst);
+	if (src->type == OP_IMM) {
+		if (dst->type == OP_REG && dst->reg == 0) {
+			if (size == 2) {
+				put(in, 0x66);
+			} else if (size == 8) {
+				put(in, 0x48);
+			}
+			put(in, size == 1? 0xa8: 0xa9);
+		} else {
+			encode_rm(in, 0, size, size == 1? 0xf6: 0xf7,
+				NULL, 0, dst, imm_size(size));
+		}
+		put_field(in, &src->disp, imm_size(size), imm_kind(size), 0);
+	} else if (src->type == OP_REG) {
+		encode_rm(in, 0, size, size == 1? 0x84: 0x85, src, 0, dst, 0);
+	} else {
+		encode_rm(in, 0, size, size == 1? 0x84: 0x85, dst, 0, src, 0);
+	}
+}
+
+static void
+do_xchg(struct as_insn *in, int size, struct as_operand *src,
+	struct as_operand *dst) {
+	if (src->type == OP_IMM || dst->type == OP_IMM
+		|| (src->type == OP_MEM && dst->type == OP_MEM)) {
+		fail("bad operands");
+	}
+	size = get_size2(size, src, dst);
+	if (src->type == OP_REG && dst->type == OP_REG && size != 1
+		&& (src->reg == 0 || dst->reg == 0)
+		&& !(size == 4 && src->reg == 0 && dst->reg == 0)) {
+		encode_opreg(in, size, 0x90, dst->reg == 0? src: dst);
+	} else if (src->type == OP_REG) {
+		encode_rm(in, 0, size, size == 1? 0x86: 0x87, src, 0, dst, 0);
+	} else {
+		encode_rm(in, 0, size, size == 1? 0x86: 0x87, dst, 0, src, 0);
+	}
+}
+
+static void
+do_shift(struct as_insn *in, int n, int size, struct as_operand *ops,
+	int nops) {
+	struct as_operand	*dst;
+
+	if (nops < 1 || nops > 2 || ops[nops - 1].type == OP_IMM) {
+		fail("bad operands");
+	}
+	dst = &ops[nops - 1];
+	size = get_size(size, dst, 1);
+	if (nops == 1) {
+		encode_rm(in, 0, size, size == 1? 0xd0: 0xd1, NULL, n, dst, 0);
+	} else if (ops[0].type == OP_REG) {
+		if (!is_gpr(&ops[0]) || ops[0].reg != 1 || ops[0].size != 1) {
+			fail("bad shift count");
+		}
+		encode_rm(in, 0, size, size == 1? 0xd2: 0xd3, NULL, n, dst, 0);
+	} else if (ops[0].type == OP_IMM && is_const(&ops[0].disp)) {
+		if (ops[0].disp.val == 1) {
+			encode_rm(in, 0, size, size == 1? 0xd0: 0xd1,
+				NULL, n, dst, 0);
+		} else {
+			encode_rm(in, 0, size, size == 1? 0xc0: 0xc1,
+				NULL, n, dst, 1);
+			put_field(in, &ops[0].disp, 1, FIX_ABS, 0);
+		}
+	} else {
+		fail("bad shift count");
+	}
+}
+
+static void
+do_imul(struct as_insn *in, int size, struct as_operand *ops, int nops) {
+	struct as_operand	*imm = NULL;
+	struct as_operand	*src;
+	struct as_operand	*dst;
+
+	if (nops == 1) {
+		if (ops[0].type == OP_IMM) {
+			fail("bad operands");
+		}
+		size = get_size(size, ops, 1);
+		encode_rm(in, 0, size, size == 1? 0xf6: 0xf7, NULL, 5, ops, 0);
+		return;
+	} else if (nops == 2 && ops[0].type == OP_IMM) {
+		imm = &ops[0];
+		src = dst = &ops[1];
+	} else if (nops == 2) {
+		src = &ops[0];
+		dst = &ops[1];
+	} else if (nops == 3 && ops[0].type == OP_IMM) {
+		imm = &ops[0];
+		src = &ops[1];
+		dst = &ops[2];
+	} else {
+		fail("bad operands");
+		return;
+	}
+	if (!is_gpr(dst) || src->type == OP_IMM) {
+		fail("bad operands");
+	}
+	size = get_size2(size, src, dst);
+	if (size == 1) {
+		fail("bad operand size");
+	}
+	if (imm == NULL) {
+		encode_rm(in, 0, size, 0x0faf, dst, 0, src, 0);
+	} else {
+		if (is_const(&imm->disp) && size != 8) {
+			imm->disp.val = fit_value(imm->disp.val, size);
+		}
+		if (is_const(&imm->disp) && fits_signed(imm->disp.val, 1)) {
+			encode_rm(in, 0, size, 0x6b, dst, 0, src, 1);
+			put_field(in, &imm->disp, 1, FIX_ABS, 0);
+		} else {
+			encode_rm(in, 0, size, 0x69, dst, 0, src,
+				imm_size(size));
+			put_field(in, &imm->disp, imm_size(size),
+				imm_kind(size), 0);
+		}
+	}
+}
+
+static void
+do_push_pop(struct as_insn *in, int is_push, int size, struct as_operand *op) {
+	if (size == 0) {
+		size = op->type == OP_REG? op->size: 8;
+	}
+	if (size != 8 && size != 2) {
+		fail("bad operand size");
+	}
+	if (op->type == OP_REG) {
+		if (!is_gpr(op) || op->size != size) {
+			fail("bad operands");
+		}
+		encode_opreg(in, size == 2? 2: 0, is_push? 0x50: 0x58, op);
+	} else if (op->type == OP_MEM) {
+		encode_rm(in, 0, size == 2? 2: 0, is_push? 0xff: 0x8f,
+			NULL, is_push? 6: 0, op, 0);
+	} else if (is_push) {
+		if (size == 2) {
+			fail("bad operand size");
+		}
+		if (is_const(&op->disp) && fits_signed(op->disp.val, 1)) {
+			put(in, 0x6a);
+			put_field(in, &op->disp, 1, FIX_ABS, 0);
+		} else {
+			put(in, 0x68);
+			put_field(in, &op->disp, 4, FIX_ABS_S, 0);
+		}
+	} else {
+		fail("bad operands");
+	}
+}
+
+static void
+do_movx(struct as_insn *in, struct as_mnemonic *m, int size,
+	struct as_operand *src, struct as_operand *dst) {
+	int	srcsize = m->op2;
+	int	dstsize = m->size? m->size: size;
+
+	if (!is_gpr(dst) || src->type == OP_IMM) {
+		fail("bad operands");
+	}
+	if (src->type == OP_REG) {
+		if (!is_gpr(src) || (srcsize != 0 && src->size != srcsize)) {
+			fail("bad operands");
+		}
+		srcsize = src->size;
+	}
+	if (dstsize == 0) {
+		dstsize = dst->size;
+	}
+	if (dst->size != dstsize || dstsize <= srcsize
+		|| (srcsize != 1 && srcsize != 2)) {
+		fail("bad operand size");
+	}
+	encode_rm(in, 0, dstsize, m->op + (srcsize == 2), dst, 0, src, 0);
+}
+
+/*
+ * Starts a new frag for a relaxable jmp or jcc instruction
+ */
+static void
+emit_jump(int cc, struct as_operand *op) {
+	struct as_frag	*f;
+
+	if (op->type != OP_MEM || op->base != -1 || op->index != -1
+		|| op->rip || op->disp.add == NULL || op->disp.sub != NULL) {
+		fail("bad jump target");
+	}
+	f = close_frag(cur_sect, FRAG_JUMP);
+	f->cc = cc;
+	f->target = op->disp;
+	new_frag(cur_sect);
+}
+
+static void
+do_sse(struct as_insn *in, struct as_mnemonic *m, int size,
+	struct as_operand *src, struct as_operand *dst) {
+	switch (m->cls) {
+	case I_SSE:
+		if (!is_xmm(dst) || !(is_xmm(src) || src->type == OP_MEM)) {
+			fail("bad operands");
+		}
+		encode_rm(in, m->pfx, 0, 0x0f00 | m->op, dst, 0, src, 0);
+		break;
+	case I_SSEMOV:
+		if (dst->type == OP_MEM && is_xmm(src)) {
+			encode_rm(in, m->pfx, 0, 0x0f00 | m->op2, src, 0, dst, 0);
+		} else if (is_xmm(dst) && (is_xmm(src) || src->type == OP_MEM)) {
+			encode_rm(in, m->pfx, 0, 0x0f00 | m->op, dst, 0, src, 0);
+		} else {
+			fail("bad operands");
+		}
+		break;
+	case I_CVTI2F:
+		if (!is_xmm(dst) || !(is_gpr(src) || src->type == OP_MEM)) {
+			fail("bad operands");
+		}
+		size = get_size(size, src, 1);
+		if (size != 4 && size != 8) {
+			fail("bad operand size");
+		}
+		encode_rm(in, m->pfx, size == 8? 8: 0, 0x0f00 | m->op,
+			dst, 0, src, 0);
+		break;
+	case I_CVTF2I:
+		if (!is_gpr(dst) || !(is_xmm(src) || src->type == OP_MEM)) {
+			fail("bad operands");
+		}
+		size = get_size(size, dst, 1);
+		if (size != 4 && size != 8) {
+			fail("bad operand size");
+		}
+		encode_rm(in, m->pfx, size == 8? 8: 0, 0x0f00 | m->op,
+			dst, 0, src, 0);
+		break;
+	case I_MOVQ:
+		if (is_xmm(src) && is_gpr(dst) && dst->size == 8) {
+			encode_rm(in, 0x66, 8, 0x0f7e, src, 0, dst, 0);
+		} else if (is_gpr(src) && src->size == 8 && is_xmm(dst)) {
+			encode_rm(in, 0x66, 8, 0x0f6e, dst, 0, src, 0);
+		} else if (is_xmm(dst) && (is_xmm(src) || src->type == OP_MEM)) {
+			encode_rm(in, 0xf3, 0, 0x0f7e, dst, 0, src, 0);
+		} else if (is_xmm(src) && dst->type == OP_MEM) {
+			encode_rm(in, 0x66, 0, 0x0fd6, src, 0, dst, 0);
+		} else {
+			fail("bad operands");
+		}
+		break;
+	case I_MOVD:
+		if (is_xmm(dst) && ((is_gpr(src) && src->size == 4)
+			|| src->type == OP_MEM)) {
+			encode_rm(in, 0x66, 0, 0x0f6e, dst, 0, src, 0);
+		} else if (is_xmm(src) && ((is_gpr(dst) && dst->size == 4)
+			|| dst->type == OP_MEM)) {
+			encode_rm(in, 0x66, 0, 0x0f7e, src, 0, dst, 0);
+		} else {
+			fail("bad operands");
+		}
+		break;
+	}
+}
+
+static void
+do_x87(struct as_insn *in, struct as_mnemonic *m, struct as_operand *ops,
+	int nops) {
+	int	i;
+
+	if (m->cls == I_X87M) {
+		if (nops != 1 || ops[0].type != OP_MEM) {
+			fail("bad operands");
+		}
+		encode_rm(in, 0, 0, m->op, NULL, m->op2, &ops[0], 0);
+		return;
+	}
+	for (i = 0; i < nops; ++i) {
+		if (ops[i].type != OP_REG || ops[i].regclass != RC_ST) {
+			fail("bad operands");
+		}
+	}
+	if (nops == 0) {
+		if ((i = m->op2) == -1) {
+			fail("missing operand");
+		}
+	} else if (nops == 1) {
+		i = ops[0].reg;
+	} else if (nops == 2 && ops[0].reg == 0) {
+		i = ops[1].reg;
+	} else if (nops == 2 && ops[1].reg == 0) {
+		i = ops[0].reg;
+	} else {
+		fail("bad operands");
+		return;
+	}
+	put(in, m->op >> 8);
+	put(in, (m->op & 0xff) + i);
+}
+
+static int
+split_operands(char *p, struct as_operand *ops) {
+	char	*start;
+	int	nops = 0;
+	int	depth = 0;
+
+	p = skip_ws(p);
+	if (*p == 0) {
+		return 0;
+	}
+	for (start = p; ; ++p) {
+		if (*p == '(') {
+			++depth;
+		} else if (*p == ')') {
+			--depth;
+		} else if ((*p == ',' && depth == 0) || *p == 0) {
+			int	last = *p == 0;
+
+			if (nops == 3) {
+				fail("too many operands");
+			}
+			*p = 0;
+			parse_operand(start, &ops[nops++]);
+			if (last) {
+				break;
+			}
+			start = p + 1;
+		}
+	}
+	return nops;
+}
+
+static struct as_mnemonic *
+get_mnemonic(const char *name, size_t len, int *size) {
+	struct as_mnemonic	*m;
+	int			suf;
+
+	*size = 0;
+	if ((m = lookup_mnemonic(name, len)) != NULL) {
+		return m;
+	}
+	if (len < 2) {
+		fail("unknown instruction");
+	}
+	switch (name[len - 1]) {
+	case 'b': suf = SUF_B; *size = 1; break;
+	case 'w': suf = SUF_W; *size = 2; break;
+	case 'l': suf = SUF_L; *size = 4; break;
+	case 'q': suf = SUF_Q; *size = 8; break;
+	default:
+		suf = 0;
+		fail("unknown instruction");
+	}
+	m = lookup_mnemonic(name, len - 1);
+	if (m == NULL || !(m->suffixes & suf)) {
+		fail("unknown instruction");
+	}
+	return m;
+}
+
+static void
+do_insn(char *name, size_t len, char *args) {
+	struct as_mnemonic	*m;
+	struct as_operand	ops[3];
+	struct as_insn		in;
+	const char		*bp;
+	int			nops;
+	int			size;
+
+	in.len = in.nfix = 0;
+	m = get_mnemonic(name, len, &size);
+	if (m->cls == I_PREFIX) {
+		put(&in, m->op);
+		name = args = skip_ws(args);
+		while (isalnum((unsigned char)*args)) {
+			++args;
+		}
+		m = get_mnemonic(name, args - name, &size);
+		if (m->cls == I_PREFIX || m->cls == I_JMP || m->cls == I_JCC) {
+			fail("bad use of prefix");
+		}
+	}
+	nops = split_operands(args, ops);
+	switch (m->cls) {
+	case I_ALU:
+		if (nops != 2) {
+			fail("bad operands");
+		}
+		do_alu(&in, m->op, size, &ops[0], &ops[1]);
+		break;
+	case I_MOV:
+		if (nops != 2) {
+			fail("bad operands");
+		}
+		do_mov(&in, size, &ops[0], &ops[1]);
+		break;
+	case I_MOVABS:
+		if (nops != 2 || ops[0].type != OP_IMM || !is_gpr(&ops[1])
+			|| ops[1].size != 8) {
+			fail("bad operands");
+		}
+		encode_opreg(&in, 8, 0xb8, &ops[1]);
+		put_field(&in, &ops[0].disp, 8, FIX_ABS, 0);
+		break;
+	case I_TEST:
+		if (nops != 2) {
+			fail("bad operands");
+		}
+		do_test(&in, size, &ops[0], &ops[1]);
+		break;
+	case I_XCHG:
+		if (nops != 2) {
+			fail("bad operands");
+		}
+		do_xchg(&in, size, &ops[0], &ops[1]);
+		break;
+	case I_LEA:
+		if (nops != 2 || ops[0].type != OP_MEM || !is_gpr(&ops[1])) {
+			fail("bad operands");
+		}
+		size = get_size(size, &ops[1], 1);
+		encode_rm(&in, 0, size, 0x8d, &ops[1], 0, &ops[0], 0);
+		break;
+	case I_UNARY:
+		if (nops != 1 || ops[0].type == OP_IMM) {
+			fail("bad operands");
+		}
+		size = get_size(size, ops, 1);
+		if (m->op < 2) {
+			encode_rm(&in, 0, size, size == 1? 0xfe: 0xff,
+				NULL, m->op, ops, 0);
+		} else {
+			encode_rm(&in, 0, size, size == 1? 0xf6: 0xf7,
+				NULL, m->op, ops, 0);
+		}
+		break;
+	case I_IMUL:
+		do_imul(&in, size, ops, nops);
+		break;
+	case I_SHIFT:
+		do_shift(&in, m->op, size, ops, nops);
+		break;
+	case I_PUSH:
+	case I_POP:
+		if (nops != 1) {
+			fail("bad operands");
+		}
+		do_push_pop(&in, m->cls == I_PUSH, size, ops);
+		break;
+	case I_MOVX:
+		if (nops != 2) {
+			fail("bad operands");
+		}
+		do_movx(&in, m, size, &ops[0], &ops[1]);
+		break;
+	case I_MOVSXD:
+		if (nops != 2 || !is_gpr(&ops[1]) || ops[1].size != 8
+			|| ops[0].type == OP_IMM
+			|| (ops[0].type == OP_REG
+				&& (!is_gpr(&ops[0]) || ops[0].size != 4))) {
+			fail("bad operands");
+		}
+		encode_rm(&in, 0, 8, 0x63, &ops[1], 0, &ops[0], 0);
+		break;
+	case I_FIXED:
+		if (nops != 0) {
+			fail("bad operands");
+		}
+		for (bp = m->bytes; *bp != 0; ++bp) {
+			put(&in, (unsigned char)*bp);
+		}
+		break;
+	case I_JMP:
+	case I_CALL:
+		if (nops != 1) {
+			fail("bad operands");
+		}
+		if (ops[0].type == OP_REG || ops[0].indirect) {
+			if (ops[0].type == OP_REG
+				&& (!is_gpr(&ops[0]) || ops[0].size != 8)) {
+				fail("bad operands");
+			}
+			encode_rm(&in, 0, 0, 0xff, NULL,
+				m->cls == I_CALL? 2: 4, ops, 0);
+		} else if (m->cls == I_JMP) {
+			emit_jump(-1, ops);
+			return;
+		} else {
+			if (ops[0].type != OP_MEM || ops[0].base != -1
+				|| ops[0].index != -1 || ops[0].rip
+				|| ops[0].disp.add == NULL
+				|| ops[0].disp.sub != NULL) {
+				fail("bad call target");
+			}
+			put(&in, 0xe8);
+			put_field(&in, &ops[0].disp, 4, FIX_PLT, -4);
+		}
+		break;
+	case I_JCC:
+		if (nops != 1 || ops[0].indirect) {
+			fail("bad operands");
+		}
+		emit_jump(m->op, ops);
+		return;
+	case I_LOOP:
+		if (nops != 1 || ops[0].type != OP_MEM || ops[0].base != -1
+			|| ops[0].index != -1 || ops[0].rip
+			|| ops[0].disp.add == NULL) {
+			fail("bad operands");
+		}
+		put(&in, m->op);
+		put_field(&in, &ops[0].disp, 1, FIX_PC8, -1);
+		break;
+	case I_SETCC:
+		if (nops != 1 || ops[0].type == OP_IMM
+			|| (ops[0].type == OP_REG
+				&& (!is_gpr(&ops[0]) || ops[0].size != 1))) {
+			fail("bad operands");
+		}
+		encode_rm(&in, 0, 0, 0x0f90 + m->op, NULL, 0, ops, 0);
+		break;
+	case I_CMOV:
+		if (nops != 2 || !is_gpr(&ops[1]) || ops[0].type == OP_IMM) {
+			fail("bad operands");
+		}
+		size = get_size(size, ops, 2);
+		if (size == 1) {
+			fail("bad operand size");
+		}
+		encode_rm(&in, 0, size, 0x0f40 + m->op, &ops[1], 0, &ops[0], 0);
+		break;
+	case I_SSE:
+	case I_SSEMOV:
+	case I_CVTI2F:
+	case I_CVTF2I:
+	case I_MOVD:
+		if (nops != 2) {
+			fail("bad operands");
+		}
+		do_sse(&in, m, size, &ops[0], &ops[1]);
+		break;
+	case I_MOVQ:
+		if (nops != 2) {
+			fail("bad operands");
+		}
+		if (!is_xmm(&ops[0]) && !is_xmm(&ops[1])) {
+			do_mov(&in, 8, &ops[0], &ops[1]);
+		} else {
+			do_sse(&in, m, 8, &ops[0], &ops[1]);
+		}
+		break;
+	case I_X87M:
+	case I_X87R:
+		do_x87(&in, m, ops, nops);
+		break;
+	default:
+		fail("unknown instruction");
+	}
+	commit_insn(&in);
+}
+
+static char *
+parse_name(char *p, struct as_sym **sym) {
+	char	*start;
+
+	p = skip_ws(p);
+	if (!IS_IDENT_START(*p)) {
+		fail("symbol name expected");
+	}
+	for (start = p; IS_IDENT(*p); ++p)
+		;
+	*sym = lookup_sym(start, p - start);
+	return skip_ws(p);
+}
+
+static char *
+expect_comma(char *p) {
+	p = skip_ws(p);
+	if (*p != ',') {
+		fail("`,' expected");
+	}
+	return p + 1;
+}
+
+static void
+expect_end(char *p) {
+	if (*skip_ws(p) != 0) {
+		fail("junk at end of line");
+	}
+}
+
+static long
+parse_const(char **p) {
+	struct as_expr	e;
+
+	*p = parse_expr(*p, &e);
+	if (!is_const(&e)) {
+		fail("constant expected");
+	}
+	return e.val;
+}
+
+static void
+emit_data(char *p, int size) {
+	unsigned char	buf[8];
+	struct as_expr	e;
+
+	for (;;) {
+		p = parse_expr(p, &e);
+		if (is_const(&e)) {
+			put_le(buf, (unsigned long)fit_value(e.val, size), size);
+		} else {
+			add_fixup(cur_sect, cur_sect->nfrags - 1,
+				frag_offset(cur_sect), size, FIX_ABS, &e);
+			memset(buf, 0, size);
+		}
+		put_bytes(buf, size);
+		p = skip_ws(p);
+		if (*p == 0) {
+			break;
+		}
+		p = expect_comma(p);
+	}
+}
+
+static void
+emit_fill(unsigned long count, int fill) {
+	unsigned char	buf[256];
+
+	memset(buf, fill, sizeof buf);
+	while (count > 0) {
+		unsigned long	n = count > sizeof buf? sizeof buf: count;
+
+		put_bytes(buf, n);
+		count -= n;
+	}
+}
+
+static void
+emit_strings(char *p, int zero) {
+	struct as_buf	*b = &cur_sect->buf;
+
+	if (cur_sect->type == SHT_NOBITS) {
+		fail("string in nobits section");
+	}
+	for (;;) {
+		p = skip_ws(p);
+		if (*p++ != '"') {
+			fail("string expected");
+		}
+		while (*p != '"') {
+			unsigned char	ch = (unsigned char)*p++;
+
+			if (ch == 0) {
+				fail("unterminated string");
+			}
+			if (ch == '\\') {
+				ch = (unsigned char)*p++;
+				switch (ch) {
+				case 'n': ch = '\n'; break;
+				case 't': ch = '\t'; break;
+				case 'r': ch = '\r'; break;
+				case 'b': ch = '\b'; break;
+				case 'f': ch = '\f'; break;
+				case 'v': ch = '\v'; break;
+				case 'x':
+				case 'X':
+					ch = 0;
+					while (isxdigit((unsigned char)*p)) {
+						int	d = *p++;
+
+						ch = (unsigned char)(ch * 16
+							+ (isdigit(d)? d - '0':
+							tolower(d) - 'a' + 10));
+					}
+					break;
+				case '0': case '1': case '2': case '3':
+				case '4': case '5': case '6': case '7': {
+					int	i;
+
+					ch -= '0';
+					for (i = 0; i < 2 && *p >= '0'
+						&& *p <= '7'; ++i) {
+						ch = (unsigned char)
+							(ch * 8 + *p++ - '0');
+					}
+					break;
+				}
+				case 0:
+					fail("unterminated string");
+					break;
+				default:
+					/* \\, \", ... */
+					break;
+				}
+			}
+			buf_put(b, &ch, 1);
+		}
+		if (zero) {
+			buf_put(b, "", 1);
+		}
+		p = skip_ws(p + 1);
+		if (*p == 0) {
+			break;
+		}
+		p = expect_comma(p);
+	}
+}
+
+static struct as_section *
+find_section(const char *name) {
+	struct as_section	*s;
+
+	for (s = sections; s != NULL; s = s->next) {
+		if (strcmp(s->name, name) == 0) {
+			return s;
+		}
+	}
+	return NULL;
+}
+
+static int
+has_prefix(const char *name, const char *prefix) {
+	size_t	len = strlen(prefix);
+
+	return strncmp(name, prefix, len) == 0
+		&& (name[len] == 0 || name[len] == '.');
+}
+
+static void
+do_section(char *p) {
+	char			*start;
+	char			*name;
+	int			type = SHT_PROGBITS;
+	unsigned long		flags;
+	unsigned long		entsize = 0;
+	int			have_flags = 0;
+	struct as_section	*s;
+
+	p = skip_ws(p);
+	for (start = p; IS_IDENT(*p); ++p)
+		;
+	if (p == start) {
+		fail("section name expected");
+	}
+	name = as_alloc(p - start + 1);
+	memcpy(name, start, p - start);
+	name[p - start] = 0;
+
+	if (has_prefix(name, ".text")) {
+		flags = SHF_ALLOC | SHF_EXECINSTR;
+	} else if (has_prefix(name, ".data")) {
+		flags = SHF_ALLOC | SHF_WRITE;
+	} else if (has_prefix(name, ".rodata")) {
+		flags = SHF_ALLOC;
+	} else if (has_prefix(name, ".bss")) {
+		flags = SHF_ALLOC | SHF_WRITE;
+		type = SHT_NOBITS;
+	} else {
+		flags = 0;
+	}
+	p = skip_ws(p);
+	if (*p == ',') {
+		p = skip_ws(p + 1);
+		if (*p++ != '"') {
+			fail("section flags expected");
+		}
+		flags = 0;
+		have_flags = 1;
+		for (; *p != '"'; ++p) {
+			switch (*p) {
+			case 'a': flags |= SHF_ALLOC; break;
+			case 'w': flags |= SHF_WRITE; break;
+			case 'x': flags |= SHF_EXECINSTR; break;
+			case 'M': flags |= SHF_MERGE; break;
+			case 'S': flags |= SHF_STRINGS; break;
+			default:
+				/* G, T, ... */
+				fail("unsupported section flag");
+			}
+		}
+		p = skip_ws(p + 1);
+		if (*p == ',') {
+			p = skip_ws(p + 1);
+			if (*p != '@' && *p != '%') {
+				fail("section type expected");
+			}
+			++p;
+			if (strncmp(p, "progbits", 8) == 0) {
+				type = SHT_PROGBITS;
+				p += 8;
+			} else if (strncmp(p, "nobits", 6) == 0) {
+				type = SHT_NOBITS;
+				p += 6;
+			} else {
+				fail("unsupported section type");
+			}
+			p = skip_ws(p);
+			if (flags & SHF_MERGE) {
+				/* Entity size of mergeable section */
+				p = expect_comma(p);
+				entsize = (unsigned long)parse_const(&p);
+			}
+		}
+		if ((flags & SHF_MERGE) && entsize == 0) {
+			fail("entity size expected");
+		}
+	}
+	expect_end(p);
+	if ((s = find_section(name)) == NULL) {
+		if (flags == 0 && !have_flags) {
+			fail("unknown section");
+		}
+		s = new_section(name, type, flags);
+		s->entsize = entsize;
+	}
+	cur_sect = s;
+}
+
+static void
+do_align(char *p, unsigned long align) {
+	struct as_frag	*f;
+	int		fill = (cur_sect->flags & SHF_EXECINSTR)? -1: 0;
+
+	p = skip_ws(p);
+	if (*p == ',') {
+		p = skip_ws(p + 1);
+		if (*p != ',' && *p != 0) {
+			fill = (int)fit_value(parse_const(&p), 1) & 0xff;
+		}
+		p = skip_ws(p);
+		if (*p == ',') {
+			fail("maximum alignment skip");
+		}
+	}
+	expect_end(p);
+	if (align == 0 || (align & (align - 1)) != 0) {
+		fail("alignment not a power of 2");
+	}
+	if (align > cur_sect->align) {
+		cur_sect->align = align;
+	}
+	f = close_frag(cur_sect, FRAG_ALIGN);
+	f->align = align;
+	f->fill = fill;
+	new_frag(cur_sect);
+}
+
+static void
+do_directive(char *name, size_t len, char *p) {
+	struct as_sym	*sym;
+	long		val;
+
+#define IS(str) (len == sizeof str - 1 && memcmp(name, str, len) == 0)
+	if (IS(".byte")) {
+		emit_data(p, 1);
+	} else if (IS(".word") || IS(".short") || IS(".value")) {
+		emit_data(p, 2);
+	} else if (IS(".long") || IS(".int")) {
+		emit_data(p, 4);
+	} else if (IS(".quad")) {
+		emit_data(p, 8);
+	} else if (IS(".zero") || IS(".space") || IS(".skip")) {
+		int	fill = 0;
+
+		val = parse_const(&p);
+		p = skip_ws(p);
+		if (*p == ',' && !IS(".zero")) {
+			++p;
+			fill = (int)fit_value(parse_const(&p), 1) & 0xff;
+		}
+		expect_end(p);
+		if (val < 0) {
+			fail("negative size");
+		}
+		emit_fill((unsigned long)val, fill);
+	} else if (IS(".ascii")) {
+		emit_strings(p, 0);
+	} else if (IS(".asciz") || IS(".string")) {
+		emit_strings(p, 1);
+	} else if (IS(".align") || IS(".balign")) {
+		val = parse_const(&p);
+		do_align(p, (unsigned long)val);
+	} else if (IS(".p2align")) {
+		val = parse_const(&p);
+		if (val < 0 || val > 16) {
+			fail("bad alignment");
+		}
+		do_align(p, 1UL << val);
+	} else if (IS(".text")) {
+		expect_end(p);
+		cur_sect = find_section(".text");
+	} else if (IS(".data")) {
+		expect_end(p);
+		cur_sect = find_section(".data");
+	} else if (IS(".bss")) {
+		expect_end(p);
+		cur_sect = find_section(".bss");
+	} else if (IS(".section")) {
+		do_section(p);
+	} else if (IS(".globl") || IS(".global")) {
+		for (;;) {
+			p = parse_name(p, &sym);
+			sym->flags |= SYM_GLOBAL;
+			if (*p == 0) {
+				break;
+			}
+			p = expect_comma(p);
+		}
+	} else if (IS(".type")) {
+		p = parse_name(p, &sym);
+		p = skip_ws(expect_comma(p));
+		if (*p != '@' && *p != '%') {
+			fail("symbol type expected");
+		}
+		++p;
+		if (strncmp(p, "function", 8) == 0) {
+			sym->type = STT_FUNC;
+			p += 8;
+		} else if (strncmp(p, "object", 6) == 0) {
+			sym->type = STT_OBJECT;
+			p += 6;
+		} else if (strncmp(p, "notype", 6) == 0) {
+			sym->type = STT_NOTYPE;
+			p += 6;
+		} else {
+			fail("unsupported symbol type");
+		}
+		expect_end(p);
+	} else if (IS(".size")) {
+		p = parse_name(p, &sym);
+		p = parse_expr(expect_comma(p), &sym->sizeexpr);
+		expect_end(p);
+		sym->has_sizeexpr = 1;
+	} else if (IS(".comm")) {
+		p = parse_name(p, &sym);
+		p = expect_comma(p);
+		val = parse_const(&p);
+		p = expect_comma(p);
+		sym->align = (unsigned long)parse_const(&p);
+		expect_end(p);
+		if (sym->flags & SYM_DEFINED) {
+			fail("symbol redefined");
+		}
+		if (val > (long)sym->size) {
+			sym->size = (unsigned long)val;
+		}
+		sym->flags |= SYM_COMMON;
+		sym->type = STT_OBJECT;
+	} else if (IS(".set") || IS(".equ")) {
+		p = parse_name(p, &sym);
+		p = parse_expr(expect_comma(p), &sym->setexpr);
+		expect_end(p);
+		if (sym->flags & (SYM_DEFINED | SYM_COMMON | SYM_SET)
+			|| sym->setexpr.add == NULL
+			|| sym->setexpr.sub != NULL) {
+			fail("unsupported .set");
+		}
+		sym->flags |= SYM_SET;
+	} else {
+		/* .weak, .local, .file, .ident, .cfi_*, ... */
+		fail("unsupported directive");
+	}
+#undef IS
+}
+
+/*
+ * Returns the end of the statement starting at p. Statements are
+ * terminated by newlines, `;' and comments
+ */
+static char *
+statement_end(char *p) {
+	for (;; ++p) {
+		switch (*p) {
+		case 0:
+		case '\n':
+		case ';':
+		case '#':
+			return p;
+		case '"':
+			for (++p; *p != '"'; ++p) {
+				if (*p == '\\' && p[1] != 0) {
+					++p;
+				} else if (*p == 0 || *p == '\n') {
+					return p;
+				}
+			}
+			break;
+		case '\'':
+			if (p[1] != 0 && p[1] != '\n') {
+				++p;
+			}
+			break;
+		}
+	}
+}
+
+static void
+do_statement(char *p) {
+	char	*name;
+	char	*end;
+
+	for (;;) {
+		p = skip_ws(p);
+		if (*p == 0) {
+			return;
+		}
+		if (!IS_IDENT_START(*p)) {
+			fail("syntax error");
+		}
+		for (name = p; IS_IDENT(*p); ++p)
+			;
+		end = p;
+		p = skip_ws(p);
+		if (*p == ':') {
+			define_label(lookup_sym(name, end - name));
+			++p;
+			continue;
+		}
+		if (*name == '.') {
+			do_directive(name, end - name, p);
+		} else {
+			do_insn(name, end - name, p);
+		}
+		return;
+	}
+}
+
+static void
+assemble(char *text) {
+	char	*p = text;
+	char	*end;
+	int	ch;
+
+	lineno = 1;
+	while (*p != 0) {
+		end = statement_end(p);
+		ch = *end;
+		*end = 0;
+		do_statement(p);
+		*end = (char)ch;
+		if (ch == '#') {
+			while (*end != '\n' && *end != 0) {
+				++end;
+			}
+			ch = *end;
+		}
+		if (ch == '\n') {
+			++lineno;
+		}
+		p = ch != 0? end + 1: end;
+	}
+}
+
+static unsigned long
+sym_addr(struct as_sym *s) {
+	return s->sect->frags[s->frag].addr + s->off;
+}
+
+static int
+jump_size(struct as_frag *f) {
+	if (!f->is_long) {
+		return 2;
+	}
+	return f->cc == -1? 5: 6;
+}
+
+/*
+ * Assigns addresses to all frags of a section. Jumps start out short
+ * and are made long if their target is out of range; this is repeated
+ * until nothing changes anymore, since growing one jump may push other
+ * targets out of range
+ */
+static void
+layout_section(struct as_section *s) {
+	struct as_frag	*f;
+	unsigned long	addr;
+	int		changed;
+	int		i;
+
+	for (i = 0; i < s->nfrags; ++i) {
+		f = &s->frags[i];
+		if (f->kind == FRAG_JUMP) {
+			struct as_sym	*t = f->target.add;
+
+			f->is_long = !(t->flags & SYM_DEFINED) || t->sect != s;
+		}
+	}
+	do {
+		changed = 0;
+		addr = 0;
+		for (i = 0; i < s->nfrags; ++i) {
+			f = &s->frags[i];
+			f->addr = addr;
+			addr += f->len;
+			if (f->kind == FRAG_ALIGN) {
+				f->varlen = (f->align - addr % f->align)
+					% f->align;
+			} else if (f->kind == FRAG_JUMP) {
+				f->varlen = jump_size(f);
+			} else {
+				f->varlen = 0;
+			}
+			addr += f->varlen;
+		}
+		s->size = addr;
+		for (i = 0; i < s->nfrags; ++i) {
+			long	disp;
+
+			f = &s->frags[i];
+			if (f->kind != FRAG_JUMP || f->is_long) {
+				continue;
+			}
+			disp = (long)(sym_addr(f->target.add)
+				+ f->target.val - (f->addr + f->len + 2));
+			if (!fits_signed(disp, 1)) {
+				f->is_long = 1;
+				changed = 1;
+			}
+		}
+	} while (changed);
+}
+
+/*
+ * The nop sequences used by gas to pad code to an alignment boundary
+ */
+static const unsigned char	nop_patterns[11][11] = {
+	{ 0x90 },
+	{ 0x66, 0x90 },
+	{ 0x0f, 0x1f, 0x00 },
+	{ 0x0f, 0x1f, 0x40, 0x00 },
+	{ 0x0f, 0x1f, 0x44, 0x00, 0x00 },
+	{ 0x66, 0x0f, 0x1f, 0x44, 0x00, 0x00 },
+	{ 0x0f, 0x1f, 0x80, 0x00, 0x00, 0x00, 0x00 },
+	{ 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+	{ 0x66, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+	{ 0x66, 0x2e, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 },
+	{ 0x66, 0x66, 0x2e, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 }
+};
+
+static void
+fill_nops(unsigned char *p, unsigned long n) {
+	for (; n > 11; n -= 11, p += 11) {
+		memcpy(p, nop_patterns[10], 11);
+	}
+	if (n > 0) {
+		memcpy(p, nop_patterns[n - 1], n);
+	}
+}
+
+/*
+ * Creates the final section contents, including the variable parts of
+ * all frags. Long jumps get a fixup like any other pc-relative field
+ */
+static void
+build_image(struct as_section *s) {
+	struct as_frag	*f;
+	unsigned char	*p;
+	int		i;
+
+	if (s->type == SHT_NOBITS) {
+		return;
+	}
+	s->image = n_xmalloc(s->size + 1);
+	for (i = 0; i < s->nfrags; ++i) {
+		f = &s->frags[i];
+		memcpy(s->image + f->addr, s->buf.data + f->start, f->len);
+		p = s->image + f->addr + f->len;
+		if (f->kind == FRAG_ALIGN) {
+			if (f->fill == -1) {
+				fill_nops(p, f->varlen);
+			} else {
+				memset(p, f->fill, f->varlen);
+			}
+		} else if (f->kind == FRAG_JUMP) {
+			struct as_expr	e = f->target;
+			int		oplen = f->cc == -1? 1: 2;
+
+			if (!f->is_long) {
+				p[0] = (unsigned char)(f->cc == -1? 0xeb:
+					0x70 + f->cc);
+				p[1] = (unsigned char)(sym_addr(e.add) + e.val
+					- (f->addr + f->len + 2));
+				continue;
+			}
+			if (f->cc == -1) {
+				p[0] = 0xe9;
+			} else {
+				p[0] = 0x0f;
+				p[1] = (unsigned char)(0x80 + f->cc);
+			}
+			e.val -= 4;
+			add_fixup(s, i, f->len + oplen, 4, FIX_JUMP, &e);
+		}
+	}
+}
+
+static int
+is_local_def(struct as_sym *s) {
+	return (s->flags & SYM_DEFINED)
+		&& !(s->flags & (SYM_GLOBAL | SYM_WEAK | SYM_COMMON));
+}
+
+static void
+add_reloc(struct as_section *s, unsigned long off, struct as_sym *sym,
+	int type, long addend) {
+	struct as_reloc	*r;
+
+	if (sym->flags & SYM_SET) {
+		fail("relocation against .set symbol");
+	}
+	if (s->nrelocs == s->relocalloc) {
+		s->relocalloc = s->relocalloc * 2 + 16;
+		s->relocs = n_xrealloc(s->relocs,
+			s->relocalloc * sizeof *s->relocs);
+	}
+	r = &s->relocs[s->nrelocs++];
+	r->off = off;
+	r->type = type;
+	if (is_local_def(sym)
+		&& (!(sym->sect->flags & SHF_MERGE) || addend == 0)) {
+		/*
+		 * Local symbols are turned into section offsets. Like
+		 * gas, keep the symbol if there is an addend and the
+		 * section is mergeable, since the linker has to know
+		 * which entity is referenced
+		 */
+		r->sym = NULL;
+		r->sect = sym->sect;
+		r->addend = addend + (long)sym_addr(sym);
+		sym->sect->need_secsym = 1;
+	} else {
+		if ((sym->flags & SYM_NOEMIT)
+			&& !(sym->flags & SYM_DEFINED)) {
+			fail("undefined local label");
+		}
+		r->sym = sym;
+		r->sect = NULL;
+		r->addend = addend;
+		sym->flags |= SYM_RELOC;
+	}
+}
+
+static void
+resolve_fixup(struct as_section *s, struct as_fixup *fx) {
+	unsigned long	p = s->frags[fx->frag].addr + fx->off;
+	struct as_sym	*a = fx->e.add;
+	struct as_sym	*b = fx->e.sub;
+	long		v = fx->e.val;
+	int		local;
+
+	lineno = fx->line;
+	if (s->type == SHT_NOBITS) {
+		fail("relocation in nobits section");
+	}
+	if (b != NULL) {
+		if (!(b->flags & SYM_DEFINED) || fx->kind != FIX_ABS) {
+			fail("unsupported difference");
+		}
+		if (a != NULL && (a->flags & SYM_DEFINED)
+			&& a->sect == b->sect) {
+			v += (long)(sym_addr(a) - sym_addr(b));
+		} else if (a != NULL && b->sect == s
+			&& (fx->size == 4 || fx->size == 8)) {
+			/* a - b, with b in this section, is pc-relative */
+			add_reloc(s, p, a, fx->size == 8?
+				R_X86_64_PC64: R_X86_64_PC32,
+				v + (long)(p - sym_addr(b)));
+			return;
+		} else {
+			fail("unsupported difference");
+		}
+	} else if (a != NULL) {
+		local = (a->flags & SYM_DEFINED) && a->sect == s;
+		switch (fx->kind) {
+		case FIX_ABS:
+		case FIX_ABS_S:
+			add_reloc(s, p, a,
+				fx->size == 8? R_X86_64_64:
+				fx->size == 2? R_X86_64_16:
+				fx->size == 1? R_X86_64_8:
+				fx->kind == FIX_ABS_S? R_X86_64_32S: R_X86_64_32,
+				v);
+			return;
+		case FIX_PC:
+		case FIX_PLT:
+			/*
+			 * Like gas, only resolve references to local symbols,
+			 * so that global ones can still be interposed
+			 */
+			if (local && is_local_def(a)) {
+				v += (long)(sym_addr(a) - p);
+				break;
+			}
+			add_reloc(s, p, a,
+				fx->kind == FIX_PLT && !is_local_def(a)?
+				R_X86_64_PLT32: R_X86_64_PC32, v);
+			return;
+		case FIX_JUMP:
+			if (local) {
+				v += (long)(sym_addr(a) - p);
+				break;
+			}
+			add_reloc(s, p, a, is_local_def(a)?
+				R_X86_64_PC32: R_X86_64_PLT32, v);
+			return;
+		case FIX_PC8:
+			if (!local) {
+				fail("loop target not in same section");
+			}
+			v += (long)(sym_addr(a) - p);
+			break;
+		}
+	}
+	if (fx->kind == FIX_ABS) {
+		v = fit_value(v, fx->size);
+	} else if (!fits_signed(v, fx->size)) {
+		fail("value out of range");
+	}
+	put_le(s->image + p, (unsigned long)v, fx->size);
+}
+
+static void
+finish_symbols(void) {
+	struct as_sym	*s;
+	struct as_sym	*t;
+
+	for (s = syms; s != NULL; s = s->next) {
+		if (s->flags & SYM_SET) {
+			t = s->setexpr.add;
+			if (!(t->flags & SYM_DEFINED) || (t->flags & SYM_SET)) {
+				fail("unsupported .set");
+			}
+			s->sect = t->sect;
+			s->frag = t->frag;
+			s->off = t->off + s->setexpr.val;
+			s->flags |= SYM_DEFINED;
+		}
+	}
+	for (s = syms; s != NULL; s = s->next) {
+		struct as_expr	*e = &s->sizeexpr;
+
+		if (!s->has_sizeexpr) {
+			continue;
+		}
+		if (is_const(e)) {
+			s->size = (unsigned long)e->val;
+		} else if (e->add != NULL && e->sub != NULL
+			&& (e->add->flags & SYM_DEFINED)
+			&& (e->sub->flags & SYM_DEFINED)
+			&& e->add->sect == e->sub->sect) {
+			s->size = sym_addr(e->add) - sym_addr(e->sub) + e->val;
+		} else {
+			fail("unsupported .size expression");
+		}
+	}
+}
+
+static int
+emit_sym(struct as_sym *s) {
+	if (s->flags & SYM_NOEMIT) {
+		return 0;
+	}
+	return (s->flags & (SYM_DEFINED | SYM_COMMON | SYM_GLOBAL
+		| SYM_RELOC)) != 0;
+}
+
+static int
+is_global_sym(struct as_sym *s) {
+	return (s->flags & (SYM_GLOBAL | SYM_COMMON))
+		|| !(s->flags & SYM_DEFINED);
+}
+
+static unsigned long
+add_string(struct as_buf *b, const char *str) {
+	unsigned long	ret = b->len;
+
+	buf_put(b, str, strlen(str) + 1);
+	return ret;
+}
+
+static void
+put_shdr(unsigned char *p, unsigned long name, unsigned long type,
+	unsigned long flags, unsigned long off, unsigned long size,
+	unsigned long link, unsigned long info, unsigned long align,
+	unsigned long entsize) {
+	put_le(p, name, 4);
+	put_le(p + 4, type, 4);
+	put_le(p + 8, flags, 8);
+	put_le(p + 16, 0, 8);
+	put_le(p + 24, off, 8);
+	put_le(p + 32, size, 8);
+	put_le(p + 40, link, 4);
+	put_le(p + 44, info, 4);
+	put_le(p + 48, align, 8);
+	put_le(p + 56, entsize, 8);
+}
+
+#define ALIGN_UP(x, a)	(((x) + (a) - 1) & ~((unsigned long)(a) - 1))
+
+static int
+write_object(const char *output) {
+	struct as_section	*s;
+	struct as_sym		*sym;
+	struct as_buf		strtab;
+	struct as_buf		shstrtab;
+	unsigned char		*image;
+	unsigned char		*p;
+	unsigned long		off;
+	unsigned long		symtab_off;
+	unsigned long		strtab_off;
+	unsigned long		shstrtab_off;
+	unsigned long		shoff;
+	unsigned long		shname[3];
+	int			nsyms = 1;
+	int			first_global = 0;
+	int			nsects = 1;
+	int			symtab_ndx;
+	int			pass;
+	int			i;
+	FILE			*fd;
+
+	memset(&strtab, 0, sizeof strtab);
+	memset(&shstrtab, 0, sizeof shstrtab);
+	buf_put(&strtab, "", 1);
+	buf_put(&shstrtab, "", 1);
+
+	/*
+	 * Symbol order: null symbol, local symbols, then global symbols.
+	 * Like gas, a section symbol goes among the locals at the point
+	 * where the section was created
+	 */
+	for (pass = 0; pass < 2; ++pass) {
+		if (pass == 1) {
+			first_global = nsyms;
+		}
+		s = sections;
+		sym = NULL;
+		for (;;) {
+			for (; pass == 0 && s != NULL && s->sym_before == sym;
+				s = s->next) {
+				if (s->need_secsym) {
+					s->symndx = nsyms++;
+				}
+			}
+			sym = sym == NULL? syms: sym->next;
+			if (sym == NULL) {
+				break;
+			}
+			if (emit_sym(sym) && is_global_sym(sym) == pass) {
+				sym->index = nsyms++;
+				sym->name_off = add_string(&strtab, sym->name);
+			}
+		}
+	}
+
+	/* Section header indices */
+	for (s = sections; s != NULL; s = s->next) {
+		s->shndx = nsects++;
+		if (s->nrelocs > 0) {
+			s->relndx = nsects++;
+		}
+	}
+	symtab_ndx = nsects;
+	nsects += 3;
+
+	/* File layout */
+	off = 64;
+	for (s = sections; s != NULL; s = s->next) {
+		if (s->type != SHT_NOBITS) {
+			off = ALIGN_UP(off, s->align);
+			s->fileoff = off;
+			off += s->size;
+		} else {
+			s->fileoff = off;
+		}
+		if (s->nrelocs > 0) {
+			off = ALIGN_UP(off, 8);
+			s->relfileoff = off;
+			off += s->nrelocs * 24;
+		}
+	}
+	off = ALIGN_UP(off, 8);
+	symtab_off = off;
+	off += nsyms * 24;
+	strtab_off = off;
+	off += strtab.len;
+	for (s = sections; s != NULL; s = s->next) {
+		(void) add_string(&shstrtab, s->name);
+		if (s->nrelocs > 0) {
+			buf_put(&shstrtab, ".rela", 5);
+			(void) add_string(&shstrtab, s->name);
+		}
+	}
+	shname[0] = add_string(&shstrtab, ".symtab");
+	shname[1] = add_string(&shstrtab, ".strtab");
+	shname[2] = add_string(&shstrtab, ".shstrtab");
+	shstrtab_off = off;
+	off += shstrtab.len;
+	shoff = ALIGN_UP(off, 8);
+	off = shoff + nsects * 64;
+
+	image = n_xmalloc(off);
+	memset(image, 0, off);
+
+	/* ELF header */
+	memcpy(image, "\177ELF", 4);
+	image[4] = 2;	/* ELFCLASS64 */
+	image[5] = 1;	/* ELFDATA2LSB */
+	image[6] = 1;	/* EV_CURRENT */
+	put_le(image + 16, 1, 2);	/* ET_REL */
+	put_le(image + 18, 62, 2);	/* EM_X86_64 */
+	put_le(image + 20, 1, 4);
+	put_le(image + 40, shoff, 8);
+	put_le(image + 52, 64, 2);
+	put_le(image + 58, 64, 2);
+	put_le(image + 60, nsects, 2);
+	put_le(image + 62, symtab_ndx + 2, 2);
+
+	/* Symbol table */
+	for (s = sections; s != NULL; s = s->next) {
+		if (s->need_secsym) {
+			p = image + symtab_off + s->symndx * 24;
+			p[4] = (STB_LOCAL << 4) | STT_SECTION;
+			put_le(p + 6, s->shndx, 2);
+		}
+	}
+	for (sym = syms; sym != NULL; sym = sym->next) {
+		if (sym->index == 0) {
+			continue;
+		}
+		p = image + symtab_off + sym->index * 24;
+		put_le(p, sym->name_off, 4);
+		p[4] = (unsigned char)(((is_global_sym(sym)? STB_GLOBAL:
+			STB_LOCAL) << 4) | sym->type);
+		if (sym->flags & SYM_DEFINED) {
+			put_le(p + 6, sym->sect->shndx, 2);
+			put_le(p + 8, sym_addr(sym), 8);
+		} else if (sym->flags & SYM_COMMON) {
+			put_le(p + 6, SHN_COMMON, 2);
+			put_le(p + 8, sym->align, 8);
+		}
+		put_le(p + 16, sym->size, 8);
+	}
+	memcpy(image + strtab_off, strtab.data, strtab.len);
+	memcpy(image + shstrtab_off, shstrtab.data, shstrtab.len);
+
+	/* Section contents, relocations and headers */
+	p = image + shoff + 64;
+	off = 1;
+	for (s = sections; s != NULL; s = s->next) {
+		unsigned long	name = off;
+
+		if (s->type != SHT_NOBITS && s->size > 0) {
+			memcpy(image + s->fileoff, s->image, s->size);
+		}
+		put_shdr(p, name, s->type, s->flags, s->fileoff, s->size,
+			0, 0, s->align, s->entsize);
+		p += 64;
+		off += strlen(s->name) + 1;
+		if (s->nrelocs > 0) {
+			unsigned char	*r = image + s->relfileoff;
+
+			for (i = 0; i < s->nrelocs; ++i, r += 24) {
+				struct as_reloc	*rel = &s->relocs[i];
+				unsigned long	ndx = rel->sym != NULL?
+					(unsigned long)rel->sym->index:
+					(unsigned long)rel->sect->symndx;
+
+				put_le(r, rel->off, 8);
+				put_le(r + 8, (ndx << 32) | rel->type, 8);
+				put_le(r + 16, (unsigned long)rel->addend, 8);
+			}
+			put_shdr(p, off, SHT_RELA, SHF_INFO_LINK,
+				s->relfileoff, s->nrelocs * 24,
+				symtab_ndx, s->shndx, 8, 24);
+			p += 64;
+			off += 5 + strlen(s->name) + 1;
+		}
+	}
+	put_shdr(p, shname[0], SHT_SYMTAB, 0, symtab_off, nsyms * 24,
+		symtab_ndx + 1, first_global, 8, 24);
+	put_shdr(p + 64, shname[1], SHT_STRTAB, 0, strtab_off, strtab.len,
+		0, 0, 1, 0);
+	put_shdr(p + 128, shname[2], SHT_STRTAB, 0, shstrtab_off,
+		shstrtab.len, 0, 0, 1, 0);
+
+	free(strtab.data);
+	free(shstrtab.data);
+	if ((fd = fopen(output, "wb")) == NULL) {
+		free(image);
+		fail("cannot open output file");
+	}
+	if (fwrite(image, 1, shoff + nsects * 64, fd) != shoff + nsects * 64
+		|| fclose(fd) == EOF) {
+		free(image);
+		(void) remove(output);
+		fail("cannot write output file");
+	}
+	free(image);
+	return 0;
+}
+
+static void
+free_all(void) {
+	struct as_section	*s;
+	struct as_chunk		*c;
+
+	for (s = sections; s != NULL; s = s->next) {
+		free(s->buf.data);
+		free(s->frags);
+		free(s->fixups);
+		free(s->relocs);
+		free(s->image);
+	}
+	while ((c = chunks) != NULL) {
+		chunks = c->next;
+		free(c);
+	}
+	sections = cur_sect = NULL;
+	syms = syms_tail = NULL;
+	memset(sym_hash, 0, sizeof sym_hash);
+}
+
+static char *
+read_input(const char *input) {
+	FILE	*fd;
+	char	*text;
+	long	size;
+
+	if ((fd = fopen(input, "r")) == NULL) {
+		return NULL;
+	}
+	if (fseek(fd, 0, SEEK_END) == -1
+		|| (size = ftell(fd)) == -1
+		|| fseek(fd, 0, SEEK_SET) == -1) {
+		(void) fclose(fd);
+		return NULL;
+	}
+	text = n_xmalloc(size + 1);
+	if (fread(text, 1, size, fd) != (size_t)size) {
+		free(text);
+		(void) fclose(fd);
+		return NULL;
+	}
+	text[size] = 0;
+	(void) fclose(fd);
+	return text;
+}
+
+int
+amd64_as_assemble(const char *input, const char *output,
+	const char **reason) {
+	static char		msg[128];
+	struct as_section	*s;
+	char			*text;
+	int			i;
+	int			rc = -1;
+
+	if (sizeof(long) < 8) {
+		/* Addresses and addends are computed in longs */
+		if (reason != NULL) {
+			*reason = "host long type too small";
+		}
+		return -1;
+	}
+	if ((text = read_input(input)) == NULL) {
+		if (reason != NULL) {
+			*reason = "cannot read input file";
+		}
+		return -1;
+	}
+	init_regs();
+	init_mnemonics();
+
+	if (setjmp(fail_env) != 0) {
+		sprintf(msg, "%.80s (line %d)", fail_reason, lineno);
+		if (reason != NULL) {
+			*reason = msg;
+		}
+		rc = -1;
+		goto out;
+	}
+
+	/* gas always creates these three, in this order */
+	cur_sect = new_section(".text", SHT_PROGBITS,
+		SHF_ALLOC | SHF_EXECINSTR);
+	(void) new_section(".data", SHT_PROGBITS, SHF_ALLOC | SHF_WRITE);
+	(void) new_section(".bss", SHT_NOBITS, SHF_ALLOC | SHF_WRITE);
+
+	assemble(text);
+
+	for (s = sections; s != NULL; s = s->next) {
+		(void) close_frag(s, FRAG_NONE);
+		layout_section(s);
+	}
+	finish_symbols();
+	for (s = sections; s != NULL; s = s->next) {
+		build_image(s);
+		for (i = 0; i < s->nfixups; ++i) {
+			resolve_fixup(s, &s->fixups[i]);
+		}
+	}
+	rc = write_object(output);
+out:
+	free_all();
+	free(text);
+	return rc;
+}
+
@@ -43,6 +43,7 @@
 #include "dwarf.h"
 #include "cc1_main.h"
 #include "x86_gen.h"
+#include "amd64_gen.h"
 #include "typemap.h"
 #include "expr.h"
 #include "x86_emit_gas.h"
@@ -194,19 +195,13 @@ emit_support_buffers(void) {
 
 static void
 emit_comment(const char *fmt, ...) {
-	int		rc;
 	va_list	va;
 
 	va_start(va, fmt);
 	x_fprintf(out, "# ");
-	rc = vfprintf(out, fmt, va);
+	x_vfprintf(out, fmt, va);
 	va_end(va);
 	x_fputc('\n', out);
-
-	if (rc == EOF || fflush(out) == EOF) {
-		perror("vfprintf");
-		exit(EXIT_FAILURE);
-	}
 }
 
 
@@ -470,7 +465,10 @@ static void
 emit_freestack(struct function *f, size_t *nbytes) {
 	if (nbytes == NULL) {
 		/* Procedure outro */
-		if (f->total_allocated != 0) {
+		if (f->alloca_head != NULL || f->vla_head != NULL) {
+			/* 10/17/26: Also drops alloca() and VLA storage */
+			x_fprintf(out, "\tmov %%rbp, %%rsp\n");
+		} else if (f->total_allocated != 0) {
 			x_fprintf(out, "\tadd $%lu, %%rsp\n",
 				(unsigned long)f->total_allocated);
 		}	
@@ -531,13 +529,14 @@ print_mem_or_reg(struct reg *r, struct vreg *vr) {
 		struct decl	*d = vr->var_backed;
 
 		if (d->stack_addr) {
-			x_fprintf(out, "-%ld(%%rbp)",
-				d->stack_addr->offset);
+			print_mem_gas_x86(out, "-", d->stack_addr->offset,
+				"rbp");
+			x_fputc(')', out);
 		} else {
-			x_fprintf(out, "%s", d->dtype->name);
+			x_fputs(d->dtype->name, out);
 		}
 	} else {
-		x_fprintf(out, "%%%s", r->name);
+		print_reg_gas_x86(out, r->name);
 	}
 }
 
@@ -636,7 +635,9 @@ emit_load(struct reg *r, struct vreg *vr) {
 
 	print_mem_operand(vr, NULL);
 	if (r->type != REG_FPR || !STUPID_X87(r)) {
-		x_fprintf(out, ", %%%s\n", r->name);
+		x_fputs(", ", out);
+		print_reg_gas_x86(out, r->name);
+		x_fputc('\n', out);
 	}	
 	x_fputc('\n', out);
 }
@@ -651,6 +652,33 @@ emit_comp_goto(struct reg *r) {
 	x_fprintf(out, "\tjmp *%%%s\n", r->name);
 }
 
+/*
+ * 10/17/26: The table entries are 32bit offsets relative to the table
+ * start, so it can be used for PIC code as well
+ */
+static void
+emit_switch_table(struct reg *idx, struct reg *tmp, struct switch_table *tab) {
+	char	*name = tab->label->dat;
+	size_t	i;
+
+	x_fprintf(out, "\tlea .%s(%%rip), %%%s\n", name, tmp->name);
+	x_fprintf(out, "\tmovslq (%%%s,%%%s,4), %%%s\n",
+		tmp->name, idx->name, idx->name);
+	x_fprintf(out, "\tadd %%%s, %%%s\n", tmp->name, idx->name);
+	x_fprintf(out, "\tjmp *%%%s\n", idx->name);
+
+	if (sysflag != OS_OSX) {
+		emit_setsection(SECTION_RODATA);
+	}
+	x_fprintf(out, "\t.align 4\n");
+	x_fprintf(out, ".%s:\n", name);
+	for (i = 0; i < tab->nentries; ++i) {
+		x_fprintf(out, "\t.long .%s-.%s\n",
+			(char *)tab->targets[i]->dat, name);
+	}
+	emit_setsection(SECTION_TEXT);
+}
+
 /*
  * Takes vreg source arg - not preg - so that it can be either a preg
  * or immediate (where that makes sense!)
@@ -836,6 +864,13 @@ emit_sub(struct reg **dest, struct icode_instr *src) {
 /* XXX 64bit */
 static void
 emit_add(struct reg **dest, struct icode_instr *src) {
+	if (src->dat != NULL) {
+		/* 10/17/26: Pointer plus scaled index (see ptrarit()) */
+		x_fprintf(out, "\tlea (%%%s,%%%s,%d), %%%s\n",
+			dest[0]->name, src->src_pregs[0]->name,
+			*(int *)src->dat, dest[0]->name);
+		return;
+	}
 	if (dest[0]->type == REG_FPR) {
 		if (STUPID_X87(dest[0])) {
 			x_fprintf(out, "\tfaddp ");
@@ -876,6 +911,9 @@ emit_div(struct reg **dest, struct icode_instr *src, int formod) {
 	int		is_x87 = 0;
 
 	(void) dest; (void) formod;
+	if (!formod && emit_const_muldiv_gas_x86(out, dest, src, INSTR_DIV)) {
+		return;
+	}
 	if (!IS_FLOATING(ty->code)) {
 		int	is_64bit = IS_LONG(ty->code) || IS_LLONG(ty->code);
 
@@ -926,6 +964,9 @@ emit_div(struct reg **dest, struct icode_instr *src, int formod) {
 /* XXX 64bit ... */
 static void
 emit_mod(struct reg **dest, struct icode_instr *src) {
+	if (emit_const_muldiv_gas_x86(out, dest, src, INSTR_MOD)) {
+		return;
+	}
 	emit_div(dest, src, 1);
 	if (!IS_LLONG(src->dest_vreg->type->code)
 		&& !IS_LONG(src->dest_vreg->type->code)) {
@@ -943,6 +984,9 @@ emit_mul(struct reg **dest, struct icode_instr *src) {
 
 	(void) dest;
 
+	if (emit_const_muldiv_gas_x86(out, dest, src, INSTR_MUL)) {
+		return;
+	}
 	if (IS_FLOATING(ty->code)) {
 		if (STUPID_X87(dest[0])) {
 			x_fprintf(out, "\tfmulp ");
@@ -1035,8 +1079,13 @@ emit_cmp(struct reg **dest, struct icode_instr *src) {
 			last_sse_cmp = src;
 		}
 		return;
+	} else if (src->hints & HINT_INSTR_GENERIC_MODIFIER) {
+		/* 10/17/26: Set by x86_rule_cmp_zero() at -O1 */
+		x_fprintf(out, "\ttest %%%s, %%%s\n",
+			dest[0]->name, dest[0]->name);
+		return;
 	} else {
-		fprintf(out, "\tcmp ");
+		x_fprintf(out, "\tcmp ");
 	}	
 	if (src->src_pregs == NULL || src->src_vreg == NULL) {
 		x_fprintf(out, "$0");
@@ -1102,13 +1151,27 @@ get_function_sym_representation(const char *name) {
  */
 static void
 emit_copyinit(struct decl *d) {
-	x_fprintf(out, "\tmov $%lu, %%rdx\n",
-		(unsigned long)backend->get_sizeof_type(d->dtype, 0));
+	size_t	size = backend->get_sizeof_type(d->dtype, 0);
+
+	if (size > AMD64_MAX_UNROLLED_COPY) {
+		x_fprintf(out, "\tmov $%lu, %%rdx\n", (unsigned long)size);
+	}
 	if (sysflag == OS_OSX) {
 		x_fprintf(out, "\tlea .%s(%%rip), %%rsi\n", d->init_name->name); /* XXX */
 	} else {
 		x_fprintf(out, "\tmov %s, %%rsi\n", get_local_sym_representation(d->init_name->name)); /* XXX */
 	}
+	if (size <= AMD64_MAX_UNROLLED_COPY) {
+		/*
+		 * 10/17/26: Copy small initializers inline. The GPRs and
+		 * SSE registers have been invalidated for the memcpy()
+		 * call anyway
+		 */
+		emit_unrolled_copy_gas_x86(out, "%rbp",
+			-(long)d->stack_addr->offset, "%rsi", 0, size,
+			"%xmm0", NULL, "%al");
+		return;
+	}
 	x_fprintf(out, "\tlea -%lu(%%rbp), %%rdi\n", d->stack_addr->offset);
 	if (sysflag == OS_OSX) {
 		x_fprintf(out, "\tcall _memcpy\n");
@@ -1122,96 +1185,102 @@ emit_copyinit(struct decl *d) {
  * Assign one struct to another (may be any of automatic or static or
  * addressed thru pointer)
  *
- * This stuff now copies intrinsically - i.e. doesn't use memcpy() -
- * because that way we can guarantee that no registers are trashed.
- * This simplifies things like passing structs to functions on the
- * stack, but is currently very simplistic and thus not very fast
- * for big structs
- *
- * (Note that the frontend cannot assume that all registers remain
- * intact because other backends do still call memcpy())
+ * 10/17/26: This used to save five fixed registers and copy byte by
+ * byte. The scratch registers now come from the allocator (see
+ * icode_make_structreloc() in amd64_gen.c). Structs of up to
+ * AMD64_MAX_INLINE_STRUCT_COPY bytes are copied with overlapping 16/8/4
+ * byte moves, larger ones with memcpy(). Addresses that come from a
+ * pointer register are used as base registers directly, without
+ * modifying them
  */
 static void
 emit_copystruct(struct copystruct *cs) {
-	struct vreg		*stop;
-	static unsigned long	lcount;
-
-	x_fprintf(out, "\tpush %%rdx\n");
-	x_fprintf(out, "\tpush %%rdi\n");
-	x_fprintf(out, "\tpush %%rsi\n");
-	x_fprintf(out, "\tpush %%rax\n");
-	x_fprintf(out, "\tpush %%rcx\n");
-
-	/*
-	 * 07/26/12: XXX ugly kludge to ensure that the register saving above
-	 * does not corrupt sp-relative addressing of structs for function
-	 * call arguments
-	 */
-	x_fprintf(out, "\tadd $40, %%rsp\n");
-
-	/* arg 3 = rdx */
-#if 0
-	x_fprintf(out, "\tmov rdx, %lu\n", (unsigned long)cs->src_vreg->size);
-#endif
-	x_fprintf(out, "\tmov $%lu, %%rcx\n", (unsigned long)cs->src_vreg->size);
-	if (cs->src_from_ptr == NULL) {
+	struct vreg	*stop;
+	char		srcbuf[16];
+	char		destbuf[16];
+	char		tempbuf[16];
+	char		xmmbuf[16];
+	char		*temp = NULL;
+	char		*xmm = NULL;
+	long		srcoff = 0;
+	long		destoff = 0;
+	unsigned long	size = cs->src_vreg->size;
+
+	if (cs->src_addr == NULL) {
+		/* Copy through pointer register */
+		sprintf(srcbuf, "%%%s", cs->src_from_ptr->name);
 		if (cs->src_vreg->parent) {
-			stop = get_parent_struct(cs->src_vreg);
-		} else {
-			stop = NULL;
-		}	
-		/* arg 2 = rsi */
-		emit_addrof(&amd64_x86_gprs[4], cs->src_vreg, stop); 
+			srcoff = calc_offsets(cs->src_vreg);
+		}
 	} else {
-		if (cs->src_vreg->parent) {
-			x_fprintf(out, "\tadd $%lu, %%%s\n",
-				calc_offsets(cs->src_vreg),	
-				/*cs->src_vreg->memberdecl->offset,*/
-				cs->src_from_ptr->name);
+		sprintf(srcbuf, "%%%s", cs->src_addr->name);
+		if (cs->src_from_ptr == NULL) {
+			if (cs->src_vreg->parent) {
+				stop = get_parent_struct(cs->src_vreg);
+			} else {
+				stop = NULL;
+			}	
+			emit_addrof(cs->src_addr, cs->src_vreg, stop); 
+		} else {
+			x_fprintf(out, "\tlea %lu(%%%s), %s\n",
+				cs->src_vreg->parent?
+					calc_offsets(cs->src_vreg): 0,
+				cs->src_from_ptr->name, srcbuf);
 		}
-		/* arg 2 = rsi */
-		x_fprintf(out, "\tmov %%%s, %%rsi\n", cs->src_from_ptr->name);
 	}
 
-	if (cs->dest_vreg == NULL) {
-		/* copy to hidden pointer */
-		emit_load(&amd64_x86_gprs[5], curfunc->hidden_pointer);
-	} else if (cs->dest_from_ptr == NULL) {
+	if (cs->dest_addr == NULL) {
+		sprintf(destbuf, "%%%s", cs->dest_from_ptr->name);
 		if (cs->dest_vreg->parent) {
-			stop = get_parent_struct(cs->dest_vreg);
+			destoff = calc_offsets(cs->dest_vreg);
+		}
+	} else {
+		sprintf(destbuf, "%%%s", cs->dest_addr->name);
+		if (cs->dest_vreg == NULL) {
+			/* copy to hidden pointer */
+			emit_load(cs->dest_addr, curfunc->hidden_pointer);
+		} else if (cs->dest_from_ptr == NULL) {
+			if (cs->dest_vreg->parent) {
+				stop = get_parent_struct(cs->dest_vreg);
+			} else {
+				stop = NULL;
+			}	
+			emit_addrof(cs->dest_addr, cs->dest_vreg, stop); 
 		} else {
-			stop = NULL;
-		}	
-		/* arg 3 = rdi */
-		emit_addrof(&amd64_x86_gprs[5], cs->dest_vreg, stop); 
-	} else {	
-		if (cs->dest_vreg->parent) {
-			x_fprintf(out, "\tadd $%lu, %%%s\n",
-				calc_offsets(cs->dest_vreg),	
-				/*cs->dest_vreg->memberdecl->offset,*/
-				cs->dest_from_ptr->name);
-		}	
-		/* arg 3 = rdi */
-		x_fprintf(out, "\tmov %%%s, %%rdi\n", cs->dest_from_ptr->name);
-	}	
-#if 0
-	x_fprintf(out, "\tcall memcpy\n");
-#endif
-	x_fprintf(out, "\t.copystruct%lu:\n", lcount);
-	x_fprintf(out, "\tmov (%%rsi), %%al\n");
-	x_fprintf(out, "\tmov %%al, (%%rdi)\n");
-	x_fprintf(out, "\tinc %%rdi\n");
-	x_fprintf(out, "\tinc %%rsi\n");
-	x_fprintf(out, "\tloop .copystruct%lu\n", lcount++);
-
-	x_fprintf(out, "\tsub $40, %%rsp\n"); /* XXX reverte addressing kludge */
+			x_fprintf(out, "\tlea %lu(%%%s), %s\n",
+				cs->dest_vreg->parent?
+					calc_offsets(cs->dest_vreg): 0,
+				cs->dest_from_ptr->name, destbuf);
+		}
+	}
 
-	/* 04/06/08: This was missing! */
-	x_fprintf(out, "\tpop %%rcx\n");
-	x_fprintf(out, "\tpop %%rax\n");
-	x_fprintf(out, "\tpop %%rsi\n");
-	x_fprintf(out, "\tpop %%rdi\n");
-	x_fprintf(out, "\tpop %%rdx\n");
+	if (size > AMD64_MAX_INLINE_STRUCT_COPY) {
+		/*
+		 * Live GPRs have been saved by icode_make_structreloc(),
+		 * and the address registers are never rsi or rdi
+		 */
+		x_fprintf(out, "\tmov %s, %%rsi\n", srcbuf);
+		x_fprintf(out, "\tmov %s, %%rdi\n", destbuf);
+		x_fprintf(out, "\tmov $%lu, %%rdx\n", size);
+		if (sysflag == OS_OSX) {
+			x_fprintf(out, "\tcall _memcpy\n");
+		} else {
+			x_fprintf(out, "\tcall %s\n",
+				get_function_sym_representation("memcpy"));
+		}
+		return;
+	}
+	if (cs->fpr_temp != NULL) {
+		sprintf(xmmbuf, "%%%s", cs->fpr_temp->name);
+		xmm = xmmbuf;
+	}
+	if (cs->temp_reg != NULL) {
+		/* Has word size if the struct has, else byte size */
+		sprintf(tempbuf, "%%%s", cs->temp_reg->name);
+		temp = tempbuf;
+	}
+	emit_unrolled_copy_gas_x86(out, destbuf, destoff, srcbuf, srcoff,
+		size, xmm, temp, temp);
 }
 
 static void
@@ -1221,6 +1290,15 @@ emit_intrinsic_memcpy(struct int_memcpy_data *data) {
 
 static void
 emit_zerostack(struct stack_block *sb, size_t nbytes) {
+	if (nbytes <= AMD64_MAX_UNROLLED_COPY) {
+		/* 10/17/26: Store zeros directly */
+		if (nbytes >= 4) {
+			x_fprintf(out, "\tpxor %%xmm0, %%xmm0\n");
+		}
+		emit_unrolled_copy_gas_x86(out, "%rbp", -(long)sb->offset,
+			NULL, 0, nbytes, "%xmm0", NULL, "$0");
+		return;
+	}
 	x_fprintf(out, "\tmov $%lu, %%rdx\n",
 		(unsigned long)nbytes);
 	x_fprintf(out, "\tmov $0, %%rsi\n");
@@ -1233,56 +1311,62 @@ emit_zerostack(struct stack_block *sb, size_t nbytes) {
 	}
 }	
 
+/*
+ * 10/17/26: alloca() and VLA storage is now carved out of the stack
+ * instead of being malloc()ed. The stack pointer is lowered by the
+ * requested size and rounded down to a multiple of 16, which keeps
+ * the call alignment intact. alloca() storage lives until the outro
+ * resets %rsp from %rbp. VLAs record the stack pointer from before
+ * the allocation in the last slot of their info block, and release
+ * their storage by restoring it when the declaring scope is left or
+ * the declaration is executed again
+ */
 static void
 emit_alloca(struct allocadata *ad) {
-	x_fprintf(out, "\tmov %%%s, %%%s\n", ad->size_reg->name,
-		ad->size_reg->size == 4? "edi": "rdi");
-	if (sysflag == OS_OSX) {
-		x_fprintf(out, "\tcall _malloc\n");
-	} else {
-		x_fprintf(out, "\tcall malloc\n");
-	}
-	if (ad->result_reg != &amd64_x86_gprs[0]) {
-		x_fprintf(out, "\tmov %%rax, %%%s\n",
-			ad->result_reg->name);
-	}
+	x_fprintf(out, "\tsub %%%s, %%rsp\n", ad->size_reg->name);
+	x_fprintf(out, "\tand $-16, %%rsp\n");
+	x_fprintf(out, "\tmov %%rsp, %%%s\n", ad->result_reg->name);
 }	
 
 static void
 emit_dealloca(struct stack_block *sb, struct reg *r) {
-	char	*regname = r? r->name: "rdi";
-	x_fprintf(out, "\tmovq -%lu(%%rbp), %%%s\n",
-		(unsigned long)sb->offset, regname);
-	if (sysflag == OS_OSX) {
-		x_fprintf(out, "\tcall _free\n");
-	} else {
-		x_fprintf(out, "\tcall free\n");
-	}
+	/* Released by the function outro */
+	(void) sb; (void) r;
 }
 
+static unsigned long
+vla_saved_sp_offset(struct stack_block *sb) {
+	return (unsigned long)sb->offset - sb->nbytes
+		+ backend->get_ptr_size();
+}	
+
 static void
 emit_alloc_vla(struct stack_block *sb) {
-	x_fprintf(out, "\tmov -%lu(%%rbp), %%rdi\n",
+	x_fprintf(out, "\tmov %%rsp, -%lu(%%rbp)\n", vla_saved_sp_offset(sb));
+	x_fprintf(out, "\tsub -%lu(%%rbp), %%rsp\n",
 		(unsigned long)sb->offset - backend->get_ptr_size());	
-	if (sysflag == OS_OSX) {
-		x_fprintf(out, "\tcall _malloc\n");
-	} else {
-		x_fprintf(out, "\tcall malloc\n");
-	}
-	x_fprintf(out, "\tmov %%rax, -%lu(%%rbp)\n",
+	x_fprintf(out, "\tand $-16, %%rsp\n");
+	x_fprintf(out, "\tmov %%rsp, -%lu(%%rbp)\n",
 		(unsigned long)sb->offset);
 }
 
 static void
 emit_dealloc_vla(struct stack_block *sb, struct reg *r) {
-	char	*regname = r? r->name: "rdi";
-	x_fprintf(out, "\tmovq -%lu(%%rbp), %%%s\n",
-		(unsigned long)sb->offset, regname);
-	if (sysflag == OS_OSX) {
-		x_fprintf(out, "\tcall _free\n");
-	} else {
-		x_fprintf(out, "\tcall free\n");
+	unsigned long	saved = vla_saved_sp_offset(sb);
+
+	(void) r;
+	if (curfunc->alloca_head == NULL) {
+		/*
+		 * A non-null saved stack pointer means the VLA is still
+		 * allocated. Anything below it is released too, which
+		 * is fine because any VLA declared later is dead as
+		 * well. alloca() storage must survive though, so with
+		 * alloca() in the function this is left to the outro
+		 */
+		x_fprintf(out, "\tcmpq $0, -%lu(%%rbp)\n", saved);
+		x_fprintf(out, "\tcmovne -%lu(%%rbp), %%rsp\n", saved);
 	}
+	x_fprintf(out, "\tmovq $0, -%lu(%%rbp)\n", saved);
 }
 
 static void
@@ -1343,7 +1427,7 @@ do_stack(FILE *out, struct decl *d) {
 	} else {
 		sign = "-";
 	}	
-	x_fprintf(out, "%s%lu(%%rbp", sign, d->stack_addr->offset);
+	print_mem_gas_x86(out, sign, d->stack_addr->offset, "rbp");
 }
 
 static void
@@ -1453,12 +1537,15 @@ print_mem_operand(struct vreg *vr, struct token *constant) {
 		 * the stack rather than frame pointer
 		 */
 		if (vr->stack_addr->use_frame_pointer) {
-			x_fprintf(out, "-%lu(%%rbp", vr->stack_addr->offset);
+			print_mem_gas_x86(out, "-", vr->stack_addr->offset,
+				"rbp");
 		} else {
-			x_fprintf(out, "%lu(%%rsp", vr->stack_addr->offset);
+			print_mem_gas_x86(out, "", vr->stack_addr->offset,
+				"rsp");
 		}
 	} else if (vr->from_ptr) {
-		x_fprintf(out, "(%%%s", vr->from_ptr->pregs[0]->name);
+		x_fputs("(%", out);
+		x_fputs(vr->from_ptr->pregs[0]->name, out);
 	} else {
 		abort();
 	}
@@ -1682,6 +1769,7 @@ struct emitter amd64_emit_gas = {
 	emit_load,
 	emit_load_addrlabel,
 	emit_comp_goto,
+	emit_switch_table,
 	emit_store,
 	emit_setsection,
 	emit_alloc,
@@ -44,6 +44,7 @@
 #include "dwarf.h"
 #include "cc1_main.h"
 #include "x86_gen.h"
+#include "amd64_gen.h"
 #include "expr.h"
 #include "x86_emit_nasm.h"
 #include "inlineasm.h"
@@ -193,19 +194,13 @@ emit_support_buffers(void) {
 
 static void
 emit_comment(const char *fmt, ...) {
-	int		rc;
 	va_list	va;
 
 	va_start(va, fmt);
 	x_fprintf(out, "; ");
-	rc = vfprintf(out, fmt, va);
+	x_vfprintf(out, fmt, va);
 	va_end(va);
 	x_fputc('\n', out);
-
-	if (rc == EOF || fflush(out) == EOF) {
-		perror("vfprintf");
-		exit(EXIT_FAILURE);
-	}
 }
 
 static void
@@ -442,7 +437,10 @@ static void
 emit_freestack(struct function *f, size_t *nbytes) {
 	if (nbytes == NULL) {
 		/* Procedure outro */
-		if (f->total_allocated != 0) {
+		if (f->alloca_head != NULL || f->vla_head != NULL) {
+			/* 10/17/26: Also drops alloca() and VLA storage */
+			x_fprintf(out, "\tmov rsp, rbp\n");
+		} else if (f->total_allocated != 0) {
 			x_fprintf(out, "\tadd rsp, %lu\n",
 				(unsigned long)f->total_allocated);
 		}	
@@ -627,6 +625,30 @@ emit_comp_goto(struct reg *r) {
 	x_fprintf(out, "\tjmp [%s]\n", r->name);
 }
 
+/*
+ * 10/17/26: Like the gas version, but the table is placed into the text
+ * section right behind the jump so that the label differences can be
+ * resolved by the assembler
+ */
+static void
+emit_switch_table(struct reg *idx, struct reg *tmp, struct switch_table *tab) {
+	char	*name = tab->label->dat;
+	size_t	i;
+
+	x_fprintf(out, "\tlea %s, [rel .%s]\n", tmp->name, name);
+	x_fprintf(out, "\tmovsxd %s, dword [%s + %s * 4]\n",
+		idx->name, tmp->name, idx->name);
+	x_fprintf(out, "\tadd %s, %s\n", idx->name, tmp->name);
+	x_fprintf(out, "\tjmp %s\n", idx->name);
+
+	x_fprintf(out, "\talign 4\n");
+	x_fprintf(out, ".%s:\n", name);
+	for (i = 0; i < tab->nentries; ++i) {
+		x_fprintf(out, "\tdd .%s - .%s\n",
+			(char *)tab->targets[i]->dat, name);
+	}
+}
+
 
 /*
  * Takes vreg source arg - not preg - so that it can be either a preg
@@ -776,6 +798,13 @@ emit_sub(struct reg **dest, struct icode_instr *src) {
 /* XXX 64bit */
 static void
 emit_add(struct reg **dest, struct icode_instr *src) {
+	if (src->dat != NULL) {
+		/* 10/17/26: Pointer plus scaled index (see ptrarit()) */
+		x_fprintf(out, "\tlea %s, [%s + %s * %d]\n",
+			dest[0]->name, dest[0]->name,
+			src->src_pregs[0]->name, *(int *)src->dat);
+		return;
+	}
 	if (dest[0]->type == REG_FPR) {
 		if (STUPID_X87(dest[0])) {
 			x_fprintf(out, "\tfaddp %s, ", dest[0]->name);
@@ -962,11 +991,16 @@ emit_cmp(struct reg **dest, struct icode_instr *src) {
 			last_sse_cmp = src;
 		}
 		return;
+	} else if (src->hints & HINT_INSTR_GENERIC_MODIFIER) {
+		/* 10/17/26: Set by x86_rule_cmp_zero() at -O1 */
+		x_fprintf(out, "\ttest %s, %s\n",
+			dest[0]->name, dest[0]->name);
+		return;
 	} else {
-		fprintf(out, "\tcmp %s, ", dest[0]->name);
+		x_fprintf(out, "\tcmp %s, ", dest[0]->name);
 	}	
 	if (src->src_pregs == NULL || src->src_vreg == NULL) {
-		fputc('0', out);
+		x_fputc('0', out);
 	} else {
 		print_mem_or_reg(src->src_pregs[0], src->src_vreg);
 	}
@@ -1016,91 +1050,126 @@ emit_copyinit(struct decl *d) {
 }
 
 
+/*
+ * 10/17/26: yasm counterpart of emit_unrolled_copy_gas_x86(); Copies
+ * nbytes from [src + srcoff] to [dest + destoff] with overlapping
+ * moves through xmm, or through word/byte if that is NULL
+ */
+static void
+emit_unrolled_copy(const char *dest, long destoff,
+	const char *src, long srcoff, unsigned long nbytes,
+	const char *xmm, const char *word, const char *byte) {
+
+	unsigned long	chunk;
+	unsigned long	i;
+	const char	*mov;
+	const char	*reg;
+
+	if (nbytes >= 16 && xmm != NULL) {
+		chunk = 16;
+		mov = "movdqu";
+		reg = xmm;
+	} else if (nbytes >= 8 && xmm != NULL) {
+		chunk = 8;
+		mov = "movq";
+		reg = xmm;
+	} else if (nbytes >= 4) {
+		chunk = 4;
+		mov = xmm != NULL? "movd": "mov";
+		reg = xmm != NULL? xmm: word;
+	} else {
+		chunk = 1;
+		mov = "mov";
+		reg = byte;
+	}
+
+	for (i = 0; i < nbytes; i += chunk) {
+		if (i + chunk > nbytes) {
+			i = nbytes - chunk;
+		}
+		x_fprintf(out, "\t%s %s, [%s + %ld]\n",
+			mov, reg, src, srcoff + (long)i);
+		x_fprintf(out, "\t%s [%s + %ld], %s\n",
+			mov, dest, destoff + (long)i, reg);
+	}
+}
+
 /*
  * Assign one struct to another (may be any of automatic or static or
  * addressed thru pointer)
  *
- * This stuff now copies intrinsically - i.e. doesn't use memcpy() -
- * because that way we can guarantee that no registers are trashed.
- * This simplifies things like passing structs to functions on the
- * stack, but is currently very simplistic and thus not very fast
- * for big structs
- *
- * (Note that the frontend cannot assume that all registers remain
- * intact because other backends do still call memcpy())
+ * 10/17/26: Works like the gas version; Small structs are copied inline
+ * through scratch registers from the allocator, large ones with
+ * memcpy()
  */
 static void
 emit_copystruct(struct copystruct *cs) {
-	struct vreg		*stop;
-	static unsigned long	lcount;
-
-	x_fprintf(out, "\tpush rdx\n");
-	x_fprintf(out, "\tpush rdi\n");
-	x_fprintf(out, "\tpush rsi\n");
-	x_fprintf(out, "\tpush rax\n");
-	x_fprintf(out, "\tpush rcx\n");
-
-	/* arg 3 = rdx */
-#if 0
-	x_fprintf(out, "\tmov rdx, %lu\n", (unsigned long)cs->src_vreg->size);
-#endif
-	x_fprintf(out, "\tmov rcx, %lu\n", (unsigned long)cs->src_vreg->size);
-	if (cs->src_from_ptr == NULL) {
+	struct vreg	*stop;
+	const char	*src;
+	const char	*dest;
+	long		srcoff = 0;
+	long		destoff = 0;
+	unsigned long	size = cs->src_vreg->size;
+
+	if (cs->src_addr == NULL) {
+		/* Copy through pointer register */
+		src = cs->src_from_ptr->name;
 		if (cs->src_vreg->parent) {
-			stop = get_parent_struct(cs->src_vreg);
-		} else {
-			stop = NULL;
-		}	
-		/* arg 2 = rsi */
-		emit_addrof(&amd64_x86_gprs[4], cs->src_vreg, stop); 
+			srcoff = calc_offsets(cs->src_vreg);
+		}
 	} else {
-		if (cs->src_vreg->parent) {
-			x_fprintf(out, "\tadd %s, %lu\n",
-				cs->src_from_ptr->name,
-				calc_offsets(cs->src_vreg)
-				/*cs->src_vreg->memberdecl->offset*/);	
+		src = cs->src_addr->name;
+		if (cs->src_from_ptr == NULL) {
+			if (cs->src_vreg->parent) {
+				stop = get_parent_struct(cs->src_vreg);
+			} else {
+				stop = NULL;
+			}	
+			emit_addrof(cs->src_addr, cs->src_vreg, stop); 
+		} else {
+			x_fprintf(out, "\tlea %s, [%s + %lu]\n",
+				src, cs->src_from_ptr->name,
+				cs->src_vreg->parent?
+					calc_offsets(cs->src_vreg): 0);
 		}
-		/* arg 2 = rsi */
-		x_fprintf(out, "\tmov rsi, %s\n", cs->src_from_ptr->name);
 	}
 
-	if (cs->dest_vreg == NULL) {
-		/* copy to hidden pointer */
-		emit_load(&amd64_x86_gprs[5], curfunc->hidden_pointer);
-	} else if (cs->dest_from_ptr == NULL) {
+	if (cs->dest_addr == NULL) {
+		dest = cs->dest_from_ptr->name;
 		if (cs->dest_vreg->parent) {
-			stop = get_parent_struct(cs->dest_vreg);
+			destoff = calc_offsets(cs->dest_vreg);
+		}
+	} else {
+		dest = cs->dest_addr->name;
+		if (cs->dest_vreg == NULL) {
+			/* copy to hidden pointer */
+			emit_load(cs->dest_addr, curfunc->hidden_pointer);
+		} else if (cs->dest_from_ptr == NULL) {
+			if (cs->dest_vreg->parent) {
+				stop = get_parent_struct(cs->dest_vreg);
+			} else {
+				stop = NULL;
+			}	
+			emit_addrof(cs->dest_addr, cs->dest_vreg, stop); 
 		} else {
-			stop = NULL;
-		}	
-		/* arg 3 = rdi */
-		emit_addrof(&amd64_x86_gprs[5], cs->dest_vreg, stop); 
-	} else {	
-		if (cs->dest_vreg->parent) {
-			x_fprintf(out, "\tadd %s, %lu\n",
-				cs->dest_from_ptr->name,
-				calc_offsets(cs->dest_vreg)
-				/*cs->dest_vreg->memberdecl->offset*/);	
-		}	
-		/* arg 3 = rdi */
-		x_fprintf(out, "\tmov rdi, %s\n", cs->dest_from_ptr->name);
-	}	
-#if 0
-	x_fprintf(out, "\tcall memcpy\n");
-#endif
-	x_fprintf(out, "\t.copystruct%lu:\n", lcount);
-	x_fprintf(out, "\tmov al, [rsi]\n");
-	x_fprintf(out, "\tmov [rdi], al\n");
-	x_fprintf(out, "\tinc rdi\n");
-	x_fprintf(out, "\tinc rsi\n");
-	x_fprintf(out, "\tloop .copystruct%lu\n", lcount++);
+			x_fprintf(out, "\tlea %s, [%s + %lu]\n",
+				dest, cs->dest_from_ptr->name,
+				cs->dest_vreg->parent?
+					calc_offsets(cs->dest_vreg): 0);
+		}
+	}
 
-	/* 04/06/08: rcx was missing! */
-	x_fprintf(out, "\tpop rcx\n");
-	x_fprintf(out, "\tpop rax\n");
-	x_fprintf(out, "\tpop rsi\n");
-	x_fprintf(out, "\tpop rdi\n");
-	x_fprintf(out, "\tpop rdx\n");
+	if (size > AMD64_MAX_INLINE_STRUCT_COPY) {
+		x_fprintf(out, "\tmov rsi, %s\n", src);
+		x_fprintf(out, "\tmov rdi, %s\n", dest);
+		x_fprintf(out, "\tmov rdx, %lu\n", size);
+		x_fprintf(out, "\tcall memcpy\n");
+		return;
+	}
+	emit_unrolled_copy(dest, destoff, src, srcoff, size,
+		cs->fpr_temp? cs->fpr_temp->name: (char *)NULL,
+		cs->temp_reg? cs->temp_reg->name: (char *)NULL,
+		cs->temp_reg? cs->temp_reg->name: (char *)NULL);
 }
 
 static void
@@ -1118,42 +1187,50 @@ emit_zerostack(struct stack_block *sb, size_t nbytes) {
 	x_fprintf(out, "\tcall memset\n");
 }	
 
+/*
+ * 10/17/26: alloca() and VLA storage now comes from the stack rather
+ * than from malloc(); See amd64_emit_gas.c
+ */
 static void
 emit_alloca(struct allocadata *ad) {
-	x_fprintf(out, "\tmov %s, %s\n",
-		ad->size_reg->size == 4? "edi": "rdi", ad->size_reg->name);
-	x_fprintf(out, "\tcall malloc\n");
-	if (ad->result_reg != &amd64_x86_gprs[0]) {
-		x_fprintf(out, "\tmov %s, rax\n",
-			ad->result_reg->name);
-	}
+	x_fprintf(out, "\tsub rsp, %s\n", ad->size_reg->name);
+	x_fprintf(out, "\tand rsp, -16\n");
+	x_fprintf(out, "\tmov %s, rsp\n", ad->result_reg->name);
 }
 
 static void
 emit_dealloca(struct stack_block *sb, struct reg *r) {
-	char	*regname = r? r->name: "rdi";
-	x_fprintf(out, "\tmov %s, [rbp - %lu]\n",
-		regname,	
-		(unsigned long)sb->offset);
-	x_fprintf(out, "\tcall free\n");
+	/* Released by the function outro */
+	(void) sb; (void) r;
 }
 
+static unsigned long
+vla_saved_sp_offset(struct stack_block *sb) {
+	return (unsigned long)sb->offset - sb->nbytes
+		+ backend->get_ptr_size();
+}	
+
 static void
 emit_alloc_vla(struct stack_block *sb) {
-	x_fprintf(out, "\tmov rdi, [rbp - %lu]\n",
+	x_fprintf(out, "\tmov [rbp - %lu], rsp\n", vla_saved_sp_offset(sb));
+	x_fprintf(out, "\tsub rsp, [rbp - %lu]\n",
 		(unsigned long)sb->offset - backend->get_ptr_size());
-	x_fprintf(out, "\tcall malloc\n");
-	x_fprintf(out, "\tmov [rbp - %lu], rax\n",
+	x_fprintf(out, "\tand rsp, -16\n");
+	x_fprintf(out, "\tmov [rbp - %lu], rsp\n",
 		(unsigned long)sb->offset);	
 }
 
 static void
 emit_dealloc_vla(struct stack_block *sb, struct reg *r) {
-	char	*regname = r? r->name: "rdi";
-	x_fprintf(out, "\tmov %s, [rbp - %lu]\n",
-		regname,	
-		(unsigned long)sb->offset);
-	x_fprintf(out, "\tcall free\n");
+	unsigned long	saved = vla_saved_sp_offset(sb);
+
+	(void) r;
+	if (curfunc->alloca_head == NULL) {
+		/* alloca() storage below the VLA must survive */
+		x_fprintf(out, "\tcmp qword [rbp - %lu], 0\n", saved);
+		x_fprintf(out, "\tcmovne rsp, [rbp - %lu]\n", saved);
+	}
+	x_fprintf(out, "\tmov qword [rbp - %lu], 0\n", saved);
 }
 
 static void
@@ -1511,6 +1588,7 @@ struct emitter amd64_emit_yasm = {
 	emit_load,
 	emit_load_addrlabel,
 	emit_comp_goto,
+	emit_switch_table,
 	emit_store,
 	emit_setsection,
 	emit_alloc,
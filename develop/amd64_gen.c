@@ -64,6 +64,8 @@
 #include "amd64_emit_gas.h"
 #include "cc1_main.h"
 #include "n_libc.h"
+#include "regalloc.h"
+#include "peephole.h"
 
 
 
@@ -409,44 +411,11 @@ get_sizeof_basic(int type) {
 }
 
 static struct vreg		saved_gprs[4]; /* r12 - r15 */
-static struct stack_block	*saved_gprs_sb[4];
 
 static void
 do_ret(struct function *f, struct icode_instr *ip) {
 	int	i;
 
-	if (f->alloca_head != NULL) {
-		struct stack_block	*sb;
-		static struct vreg	rvr;
-
-		rvr.stack_addr = f->alloca_regs;
-		rvr.size = 8;
-		backend_vreg_map_preg(&rvr, &amd64_x86_gprs[0]);
-		emit->store(&rvr, &rvr);
-
-		for (sb = f->alloca_head; sb != NULL; sb = sb->next) {
-			emit->dealloca(sb, NULL);
-		}
-
-		emit->load(&amd64_x86_gprs[0], &rvr);
-		backend_vreg_unmap_preg(&amd64_x86_gprs[0]);
-	}
-	if (f->vla_head != NULL) {
-		struct stack_block	*sb;
-		static struct vreg	rvr;
-
-		rvr.stack_addr = f->alloca_regs;
-		rvr.size = 8;
-		backend_vreg_map_preg(&rvr, &amd64_x86_gprs[0]);
-		emit->store(&rvr, &rvr);
-
-		for (sb = f->vla_head; sb != NULL; sb = sb->next) {
-			emit->dealloc_vla(sb, NULL);
-		}
-
-		emit->load(&amd64_x86_gprs[0], &rvr);
-		backend_vreg_unmap_preg(&amd64_x86_gprs[0]);
-	}
 	if (f->callee_save_used & CSAVE_EBX) {
 		emit->load(&amd64_x86_gprs[1], &csave_rbx);
 	}
@@ -763,7 +732,6 @@ gen_function(struct function *f) {
 	struct stack_block	*sb;
 	struct sym_entry	*se;
 	size_t			size;
-	size_t			alloca_bytes = 0;
 	size_t			vla_bytes = 0;
 	int			i;
 	unsigned		mask;
@@ -777,6 +745,34 @@ gen_function(struct function *f) {
 
 	map_parameters(f, proto);
 
+	if (Oflag > 0 && !gflag) {
+		/*
+		 * 10/17/26: Keep local variables in those callee-saved
+		 * registers which the register allocator has not used
+		 */
+		struct reg	*regs[4];
+		int		regnos[4];
+		int		nregs = 0;
+		unsigned	used;
+
+		for (i = 12; i < 16; ++i) {
+			if (!(f->callee_save_used & (1 << (i - 8)))) {
+				regnos[nregs] = i;
+				regs[nregs++] = &amd64_gprs[i];
+			}
+		}
+		used = regalloc_promote_vars(f, regs, nregs);
+		for (i = 0; i < nregs; ++i) {
+			if (used & (1 << i)) {
+				f->callee_save_used |= 1 << (regnos[i] - 8);
+			}
+		}
+		if (used != 0) {
+			/* Clean up moves between promoted and temp regs */
+			peephole_optimize(f);
+		}
+	}
+
 	/* Make local variables */
 	for (scope = f->scope; scope != NULL; scope = scope->next) {
 		struct stack_block	*sb;
@@ -849,16 +845,19 @@ gen_function(struct function *f) {
 			= make_stack_block(f->total_allocated, 8);
 	}	
 
-	for (i = 12, mask = 1 << 11; i < 16; ++i, mask <<= 1) {
+	/*
+	 * 10/17/26: generic_alloc_gpr() records r12 - r15 as bits 4 - 7
+	 * (the register number relative to r8), so those are the bits to
+	 * check. This used to test bits 11 - 14, such that the registers
+	 * were never saved. The stack blocks must not be cached across
+	 * functions because the zone allocator resets them
+	 */
+	for (i = 12, mask = 1 << 4; i < 16; ++i, mask <<= 1) {
 		if (f->callee_save_used & mask) {
-			if (saved_gprs_sb[i-12] == NULL) {
-				saved_gprs_sb[i-12] = make_stack_block(0, 8);
-			}	
 			f->total_allocated += 8;
-			saved_gprs[i-12].stack_addr = saved_gprs_sb[i-12];
+			saved_gprs[i-12].stack_addr =
+				make_stack_block(f->total_allocated, 8);
 			saved_gprs[i-12].size = 8;
-			saved_gprs[i-12].stack_addr->offset =
-				f->total_allocated;
 		} else {
 			saved_gprs[i-12].stack_addr = NULL;
 		}	
@@ -888,34 +887,19 @@ gen_function(struct function *f) {
 		sb->offset = f->total_allocated;
 	}
 	/*
-	 * Allocate storage for saving alloca() pointers, and initialize
-	 * it to zero
-	 */
-	stack_align(f, 8);
-	for (sb = f->alloca_head; sb != NULL; sb = sb->next) {
-		f->total_allocated += sb->nbytes;
-		alloca_bytes += sb->nbytes;
-		sb->offset = f->total_allocated;
-	}
-
-	/*
+	 * 10/17/26: alloca() storage now lives on the stack below the
+	 * frame and is released by the outro, so the alloca() blocks
+	 * need no frame slots anymore
+	 *
 	 * Allocate storage for saving VLA data, and initialize
 	 * it to zero
 	 */
+	stack_align(f, 8);
 	for (sb = f->vla_head; sb != NULL; sb = sb->next) {
 		f->total_allocated += sb->nbytes;
 		vla_bytes += sb->nbytes;
 		sb->offset = f->total_allocated;
 	}
-	if (f->alloca_head != NULL || f->vla_head != NULL) {
-		/*
-		 * Get stack for saving return value register (rax)
-		 * before performing free() on alloca()ted blocks
-		 */
-		f->alloca_regs = make_stack_block(0, 8);
-		f->total_allocated += 8;
-		f->alloca_regs->offset = f->total_allocated;
-	}
 
 	if (f->total_allocated > 0) {
 		stack_align(f, 16);
@@ -1053,9 +1037,6 @@ gen_function(struct function *f) {
 	if (stackprotectflag) {
 		emit->save_ret_addr(f, saved_ret_addr);
 	}
-	if (curfunc->alloca_head != NULL) {
-		emit->zerostack(curfunc->alloca_tail, alloca_bytes);
-	}
 	if (curfunc->vla_head != NULL) {
 		emit->zerostack(curfunc->vla_tail, vla_bytes);
 	}	
@@ -1353,6 +1334,7 @@ struct icode_list *il)
 	struct icode_instr	*ii;
 	struct type_node	*tn;
 	struct vreg		*struct_lvalue;
+	int			pass_hidden_pointer = 0;
 	struct reg 		*fptr_reg = NULL;
 	int			i;
 	int			need_dap = 0;
@@ -1426,14 +1408,13 @@ struct icode_list *il)
 		ii = icode_make_addrof(NULL, struct_lvalue, il);
 		append_icode_list(il, ii);
 #endif
-		{
-			struct reg	*r;
-			/*ii*/ r = make_addrof_structret(struct_lvalue, il);
-
-			free_preg(amd64_argregs[0], il, 1, 1);
-			icode_make_copyreg(amd64_argregs[0], r /*ii->dat*/, NULL, NULL, il);
-			++regs_used;
-		}
+		/*
+		 * 10/17/26: The pointer is only loaded after the stack
+		 * arguments have been passed, since struct arguments
+		 * may be copied with memcpy(), which trashes rdi
+		 */
+		pass_hidden_pointer = 1;
+		++regs_used;
 	}
 
 	/*
@@ -1556,6 +1537,15 @@ struct icode_list *il)
 	 */
 	allpushed = pass_args_stack(vrs, /*i*/ nvrs, allpushed, would_use_stack_bytes, il);
 
+	if (pass_hidden_pointer) {
+		struct reg	*r;
+
+		/*ii*/ r = make_addrof_structret(struct_lvalue, il);
+		free_preg(amd64_argregs[0], il, 1, 1);
+		icode_make_copyreg(amd64_argregs[0], r /*ii->dat*/, NULL, NULL, il);
+		reg_set_unallocatable(amd64_argregs[0]);
+	}
+
 	for (i = 0; i < nvrs; ++i) {
 		struct reg		*curreg;
 
@@ -1842,6 +1832,76 @@ icode_prepare_op(
 	x86_backend.icode_prepare_op(dest0, src0, op, il);
 }
 
+/*
+ * 10/17/26: Gets scratch registers for emit_copystruct() from the
+ * allocator, so it does not have to save and restore a fixed set of
+ * registers around every copy. Small structs are copied inline using
+ * an SSE register (or a GPR if none is available); Their addresses
+ * are only computed into a GPR if they do not already come from a
+ * pointer. Larger structs are passed to memcpy(), so only the GPRs
+ * which are actually live are saved
+ */
+static void
+icode_make_structreloc(struct copystruct *cs, struct icode_list *il) {
+	struct reg	*ptrs[4];
+	struct reg	*temps[4];
+	int		is_inline = cs->src_vreg->size
+				<= AMD64_MAX_INLINE_STRUCT_COPY;
+	int		i;
+
+	/* The pointer registers must survive the allocations */
+	ptrs[0] = cs->src_from_ptr;
+	ptrs[1] = cs->dest_from_ptr;
+	ptrs[2] = cs->src_from_ptr_struct;
+	ptrs[3] = cs->dest_from_ptr_struct;
+	for (i = 0; i < 4; ++i) {
+		if (ptrs[i] != NULL && reg_allocatable(ptrs[i])) {
+			reg_set_unallocatable(ptrs[i]);
+		} else {
+			ptrs[i] = NULL;
+		}
+	}
+
+	if (!is_inline || cs->src_from_ptr == NULL) {
+		cs->src_addr = ALLOC_GPR(curfunc, 8, il, NULL);
+		reg_set_unallocatable(cs->src_addr);
+	}
+	if (!is_inline || cs->dest_from_ptr == NULL) {
+		cs->dest_addr = ALLOC_GPR(curfunc, 8, il, NULL);
+		reg_set_unallocatable(cs->dest_addr);
+	}
+	if (is_inline) {
+		if (cs->src_vreg->size >= 4) {
+			cs->fpr_temp = backend->alloc_fpr(curfunc, 8, il, NULL);
+			if (cs->fpr_temp != NULL) {
+				reg_set_unallocatable(cs->fpr_temp);
+			}
+		}
+		if (cs->fpr_temp == NULL) {
+			cs->temp_reg = ALLOC_GPR(curfunc,
+				cs->src_vreg->size >= 4? 4: 1, il, NULL);
+			reg_set_unallocatable(cs->temp_reg);
+		}
+	}
+
+	temps[0] = cs->src_addr;
+	temps[1] = cs->dest_addr;
+	temps[2] = cs->fpr_temp;
+	temps[3] = cs->temp_reg;
+	for (i = 0; i < 4; ++i) {
+		if (temps[i] != NULL) {
+			reg_set_allocatable(temps[i]);
+			free_preg(temps[i], il, 1, 0);
+		}
+		if (ptrs[i] != NULL) {
+			reg_set_allocatable(ptrs[i]);
+		}
+	}
+	if (!is_inline) {
+		backend->invalidate_gprs(il, 1, INV_FOR_FCALL);
+	}
+}
+
 
 
 /*
@@ -1910,6 +1970,7 @@ struct backend amd64_backend = {
 	0, /* need pic initialization? */
 	0, /* emulate long double? */
 	0, /* relax alloc gpr order */
+	1, /* stack alloca */
 	0, /* max displacement */
 	0, /* min displacement */
 	x86_have_immediate_op,
@@ -1947,7 +2008,7 @@ struct backend amd64_backend = {
 	icode_prepare_op,
 	NULL, /* prepare_load_addrlabel */
 	icode_make_cast,
-	NULL, /* icode_make_structreloc */
+	icode_make_structreloc,
 	NULL, /* icode_initialize_pic */
 	NULL, /* icode_complete_func */
 	make_null_block,
@@ -1959,6 +2020,7 @@ struct backend amd64_backend = {
 	do_ret,
 	get_abi_reg,
 	get_abi_ret_reg,
-	generic_same_representation
+	generic_same_representation,
+	x86_peephole_rules
 };
 
@@ -35,6 +35,12 @@ struct init_with_name;
 
 #include "reg.h"
 
+/*
+ * 10/17/26: Largest struct that the AMD64 emitters copy inline; Bigger
+ * ones are passed to memcpy()
+ */
+#define AMD64_MAX_INLINE_STRUCT_COPY	64
+
 struct amd64_va_patches {
 	int			*gp_offset;
 	int			*fp_offset;
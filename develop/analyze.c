@@ -51,7 +51,11 @@
 #include "features.h"
 #include "icode.h"
 #include "control.h"
+#include "inliner.h"
 #include "n_libc.h"
+#include "profile.h"
+#include "lex.h"
+#include "cc1_main.h"
 
 static void
 check_main(struct token *t, struct type *ty) {
@@ -128,6 +132,94 @@ is_deferrable_inline_function(struct function *func) {
 }
 
 
+/*
+ * 10/17/26: Tokens of the function body being translated, and the
+ * lists through which they may be referenced after the function has
+ * been emitted
+ */
+static struct {
+	struct token		*start;
+	struct token		*head;
+	struct decl		*siv_tail;
+	struct decl		*siuv_tail;
+	struct sym_entry	*extern_tail;
+	struct sym_entry	*global_tail;
+	struct ty_struct	*global_structs;
+	int			global_enums;
+} body;
+
+static void
+hold_body_tokens(struct token *t) {
+	body.start = t;
+	body.head = t->prev;
+	body.siv_tail = siv_tail;
+	body.siuv_tail = siuv_tail;
+	body.extern_tail = extern_vars_tail;
+	body.global_tail = global_scope.slist_tail;
+	body.global_structs = global_scope.struct_defs.tail;
+	body.global_enums = global_scope.enum_defs.ndecls;
+	token_defer_free = 1;
+}
+
+/*
+ * Frees the tokens of the function body which ends at ``end'' (the
+ * closing brace, which is left to the caller), such that only one
+ * function body has to be kept in memory at a time. The body is kept,
+ * apart from tokens which have been passed to free_token(), if ``keep''
+ * is set or if something outside of the function may refer to it: Static
+ * variables are initialized at the end of the translation unit, implicit
+ * and block scope extern declarations are entered into global lists,
+ * and errors and debugging information refer to tokens as well
+ */
+static void
+release_body_tokens(struct token *end, int keep) {
+	struct token	*t;
+	struct token	*next;
+
+	token_defer_free = 0;
+	if (body.start == NULL) {
+		return;
+	}
+	if (errors
+		|| gflag
+		|| siv_tail != body.siv_tail
+		|| siuv_tail != body.siuv_tail
+		|| extern_vars_tail != body.extern_tail
+		|| global_scope.slist_tail != body.global_tail
+		|| global_scope.struct_defs.tail != body.global_structs
+		|| global_scope.enum_defs.ndecls != body.global_enums) {
+		keep = 1;
+	}
+	if (!keep) {
+		/* Don't free anything if the list has been taken apart */
+		for (t = body.start; t != NULL && t != end; t = t->next)
+			;
+		if (t == NULL) {
+			keep = 1;
+		}
+	}
+
+	for (t = body.start; t != NULL && t != end; t = next) {
+		next = t->next;
+		if (!keep || (t->flags & TOK_FLAG_FREED)) {
+			if (!(t->flags & TOK_FLAG_ARENA)) {
+				free(t);
+			}
+		}
+	}
+	if (!keep) {
+		if (body.head != NULL) {
+			body.head->next = end;
+		}
+		end->prev = body.head;
+	}
+
+	/* Arena tokens are freed (or kept) in one go */
+	token_release_body(body.start, end, keep);
+	body.start = NULL;
+}
+
+
 /* 
  * Do semantic analysis of translation unit. 
  * Initialize functions, structure, globals subsystems
@@ -144,6 +236,7 @@ analyze(struct token **curtok) {
 	static int		level;
 	int			braces = 0;
 	int			is_func;
+	int			generated;
 	int			i;
 
 	if (++level == 1) {
@@ -254,7 +347,12 @@ analyze(struct token **curtok) {
 		t = *curtok; /* Start at current token */
 	}
 	
-	for (; t != NULL; t = t->next) {
+	/*
+	 * 10/17/26: The lexer may not have read further than the current
+	 * declaration yet, so lex_next_token() is used to advance at the
+	 * end of it
+	 */
+	for (; t != NULL; t = lex_next_token(t)) {
 		if (t->prev
 			&& (t->prev->type == TOK_COMP_OPEN
 			|| t->prev->type == TOK_COMP_CLOSE
@@ -265,7 +363,7 @@ analyze(struct token **curtok) {
 				 * still sometimes used if we have parse
 				 * errors!!!!
 				 */
-				free(t->prev);
+				free_token(t->prev);
 				t->prev = NULL;
 			}	
 		}
@@ -292,7 +390,7 @@ analyze(struct token **curtok) {
 		 */
 		if (IS_TYPE(t)
 			&& (t->type != TOK_IDENTIFIER
-			|| (lookup_symbol(curscope, t->data, 1) == NULL
+			|| (lookup_symbol_atom(curscope, token_atom(t), 1) == NULL
 				&& !is_label(&t) ) ) ) {
 do_decl:
 			if (curscope->have_stmt) {
@@ -307,11 +405,11 @@ do_decl:
 				/*
 				 * XXX call recover() instead? 
 				 */
-				 t = t->next;
+				 t = lex_next_token(t);
 				 while (t != NULL
 					 && t->type != TOK_SEMICOLON
 					 && !IS_KEYWORD(t->type)) {
-					t = t->next;
+					t = lex_next_token(t);
 				 }
 				 if (t == NULL) {
 					break;
@@ -432,6 +530,7 @@ do_decl:
 						/* XXX complete ... */
 						check_main(t, d[0]->dtype);
 						curfunc = func;
+						prof_func_begin(func);
 
 						/*
 						 * Note that in cases like
@@ -475,6 +574,7 @@ do_decl:
 						 */
 						put_func_name(func->proto->
 							dtype->name);	
+						hold_body_tokens(t);
 						
 					}
 				} else {
@@ -545,7 +645,7 @@ do_decl:
 					/* Recover from error */
 					while (t != NULL
 						&& t->type != TOK_SEMICOLON) {
-						t = t->next;
+						t = lex_next_token(t);
 					}
 					if (t == NULL) {
 						break;
@@ -624,6 +724,24 @@ do_decl:
 					func->next = funclist;
 					funclist = func;
 #endif
+					/*
+					 * 10/17/26: Make the function
+					 * available for inlining into
+					 * subsequent functions
+					 */
+					inline_register_function(func);
+					prof_func_end(func);
+					release_body_tokens(t, 1);
+
+					/*
+					 * 10/17/26: Reset curfunc like for
+					 * other functions, or the parameter
+					 * declarations of the next function
+					 * are zone allocated under the stale
+					 * curfunc and reused after the next
+					 * zalloc_reset()
+					 */
+					curfunc = func = NULL;
 					goto skip_fdef;
 				}
 #endif
@@ -643,6 +761,7 @@ do_decl:
 						d = static_init_vars;
 					}
 
+					prof_func_stage(func, PROF_FN_ICODE);
 					xlate_func_to_icode(func);
 					if (d != NULL) {
 #if 0
@@ -650,17 +769,18 @@ do_decl:
 #endif
 					}
 					forbid_vreg_map_preg();
+					prof_func_stage(func, PROF_FN_EMIT);
 					(void) backend->generate_function(func);
+					x_flushoutbuf(X_OUTBUF_FLUSH_SIZE);
+					prof_func_end(func);
 #if    USE_ZONE_ALLOCATOR
 					/* Reset function data structures */
 					zalloc_reset();
-#      endif
-#      if FAST_SYMBOL_LOOKUP
-					reset_fast_sym_hash();
 #      endif
 					curscope = temp;
 				}
 #endif
+				release_body_tokens(t, ! XLATE_IMMEDIATELY);
 
 				curfunc = func = NULL;
 			}
@@ -745,23 +865,43 @@ skip_fdef:
 			 * referenced. That's the point of keeping them
 			 * back until now
 			 */
-			for (func = funclist; func != NULL; func = func->next) {
-				curscope = &global_scope;
-
-				if (is_deferrable_inline_function(func)
-					&& func->proto->references > 0) {
-
-					/*IS_INLINE(func->proto->dtype->flags) &&
-					(func->proto->dtype->storage == TOK_KEY_EXTERN
-					|| func->proto->dtype->storage == TOK_KEY_STATIC)
-					&& func->proto->references > 0) { */
+			/*
+			 * 10/17/26: Repeat until no more functions are
+			 * generated; Generating one function may reference
+			 * another one for the first time, e.g. if it could
+			 * not be inlined into that function
+			 */
+			do {
+				generated = 0;
+				for (func = funclist; func != NULL; func = func->next) {
+					curscope = &global_scope;
 
-					allow_vreg_map_preg();
-					xlate_func_to_icode(func);
-					forbid_vreg_map_preg();
-					(void) backend->generate_function(func);
+					if (is_deferrable_inline_function(func)
+						&& !func->generated
+						&& func->proto->references > 0) {
+
+						/*IS_INLINE(func->proto->dtype->flags) &&
+						(func->proto->dtype->storage == TOK_KEY_EXTERN
+						|| func->proto->dtype->storage == TOK_KEY_STATIC)
+						&& func->proto->references > 0) { */
+
+						func->generated = 1;
+						++generated;
+						prof_func_stage(func,
+							PROF_FN_ICODE);
+						inline_prepare_standalone(func);
+						allow_vreg_map_preg();
+						xlate_func_to_icode(func);
+						forbid_vreg_map_preg();
+						prof_func_stage(func,
+							PROF_FN_EMIT);
+						(void) backend->generate_function(func);
+						x_flushoutbuf(
+							X_OUTBUF_FLUSH_SIZE);
+						prof_func_end(func);
+					}
 				}
-			}
+			} while (generated > 0);
 #endif
 		}
 	} else if (level != 0) {
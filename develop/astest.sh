@@ -0,0 +1,92 @@
+#!/bin/sh
+#
+# 10/17/26: Differential test for the integrated AMD64 assembler. Every
+# file (default: tests/*.c) is compiled to assembly, which is then turned
+# into an object both by the integrated assembler and by gas. The two
+# objects are compared using objdump and readelf, so any encoding,
+# relaxation, relocation or symbol table difference shows up. Files the
+# integrated assembler declines are counted but not treated as errors.
+#
+# Usage: ./astest.sh [-O] [file.c|file.asm ...]
+#
+# Set NWCC to the compiler to test (default: nwcc)
+#
+
+NWCC=${NWCC:-nwcc}
+OPT=
+
+if test "$1" = "-O"; then
+	OPT=-O
+	shift
+fi
+
+if ! test -d astest; then
+	if ! mkdir astest; then
+		exit 1
+	fi
+fi
+
+DIR=`pwd`
+if test $# = 0; then
+	set -- tests/*.c
+fi
+
+dump() {
+	objdump -dr "$1" | sed 1,2d
+	objdump -s "$1" | sed 1,2d
+	readelf -rW "$1" | sed 's/ at offset 0x[0-9a-f]*//'
+	readelf -sW "$1"
+	# File offsets and string table sizes depend on the file layout
+	readelf -SW "$1" | grep '^  \[' \
+		| sed -e 's/^\(  \[..\] [^ ]* *[^ ]* *\)[0-9a-f]* [0-9a-f]* /\1/' \
+		-e '/strtab/s/^\(  \[..\] [^ ]* *[^ ]* *\)[0-9a-f]*/\1/'
+}
+
+OK=0
+FAILED=0
+DECLINED=0
+for i in "$@"; do
+	case "$i" in
+	/*)	file=$i ;;
+	*)	file=$DIR/$i ;;
+	esac
+	base=`basename "$i" | sed 's/\.[^.]*$//'`
+	cd "$DIR/astest" || exit 1
+	rm -f "$base.asm" int.o gas.o
+	case "$i" in
+	*.asm)	cp "$file" "$base.asm" ;;
+	*)	if ! $NWCC $OPT -S "$file" >/dev/null 2>&1; then
+			cd "$DIR"
+			continue
+		fi ;;
+	esac
+	if ! test -f "$base.asm"; then
+		cd "$DIR"
+		continue
+	fi
+	if ! as --64 "$base.asm" -o gas.o 2>/dev/null; then
+		# gas rejects it too; nothing to compare
+		cd "$DIR"
+		continue
+	fi
+	msg=`$NWCC -v -c "$base.asm" -o int.o 2>&1 \
+		| grep 'Integrated assembler cannot'`
+	if test "$msg" != ""; then
+		echo "$i: declined: $msg" | sed 's/ - using .*//'
+		DECLINED=`expr $DECLINED + 1`
+	else
+		dump gas.o >gas.dump
+		dump int.o >int.dump
+		if test "`diff gas.dump int.dump`" != ""; then
+			echo "$i: FAILED"
+			diff gas.dump int.dump | head -20
+			FAILED=`expr $FAILED + 1`
+		else
+			OK=`expr $OK + 1`
+		fi
+	fi
+	cd "$DIR"
+done
+
+echo "$OK identical, $FAILED different, $DECLINED declined"
+test $FAILED = 0
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2026, Nils R. Weller
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Identifier atom table
+ *
+ * 10/17/26: The lexer interns every identifier here, such that symbol,
+ * typedef and tag lookups can hash identifiers once and then compare
+ * pointers instead of strings
+ */
+#include "atom.h"
+#include <stdlib.h>
+#include <string.h>
+#include "n_libc.h"
+
+#define ATOM_TAB_INIT	4096	/* must be power of 2 */
+
+static struct atom	**atom_tab;
+static int		atom_tab_size;
+static int		atom_count;
+
+/*
+ * Last atom returned; Tokens and declarations pass the names of atoms
+ * around, so re-interning such a name is answered without hashing
+ */
+static struct atom	*last_atom;
+
+
+static unsigned
+hash_atom_name(const char *name, size_t len) {
+	unsigned	key = 0;
+	size_t		i;
+
+	for (i = 0; i < len; ++i) {
+		key = 33 * key + (unsigned char)name[i];
+	}
+	return key;
+}
+
+
+static void
+grow_atom_tab(void) {
+	struct atom	**newtab;
+	int		newsize;
+	int		i;
+
+	newsize = atom_tab_size? atom_tab_size * 2: ATOM_TAB_INIT;
+	newtab = n_xmalloc(newsize * sizeof *newtab);
+	memset(newtab, 0, newsize * sizeof *newtab);
+	for (i = 0; i < atom_tab_size; ++i) {
+		struct atom	*a;
+		struct atom	*next;
+
+		for (a = atom_tab[i]; a != NULL; a = next) {
+			int	key = a->hash & (newsize - 1);
+
+			next = a->next;
+			a->next = newtab[key];
+			newtab[key] = a;
+		}
+	}
+	free(atom_tab);
+	atom_tab = newtab;
+	atom_tab_size = newsize;
+}
+
+
+static struct atom *
+do_lookup_atom(const char *name, size_t len, unsigned hash) {
+	struct atom	*a;
+
+	for (a = atom_tab[hash & (atom_tab_size - 1)]; a != NULL; a = a->next) {
+		if (a->hash == hash
+			&& a->len == len
+			&& memcmp(a->name, name, len) == 0) {
+			return last_atom = a;
+		}
+	}
+	return NULL;
+}
+
+
+/*
+ * Returns the atom for the identifier of length ``len'' starting at
+ * ``name'' (which need not be null-terminated), creating it if this
+ * spelling has not been seen before
+ */
+struct atom *
+atom_intern(const char *name, size_t len) {
+	struct atom	*a;
+	unsigned	hash;
+	int		key;
+
+	if (last_atom != NULL && name == last_atom->name) {
+		return last_atom;
+	}
+	if (atom_tab == NULL) {
+		grow_atom_tab();
+	}
+	hash = hash_atom_name(name, len);
+	if ((a = do_lookup_atom(name, len, hash)) != NULL) {
+		return a;
+	}
+
+	if (atom_count >= atom_tab_size) {
+		grow_atom_tab();
+	}
+	a = n_xmalloc(sizeof *a + len);
+	a->hash = hash;
+	a->len = len;
+	memcpy(a->name, name, len);
+	a->name[len] = 0;
+	key = hash & (atom_tab_size - 1);
+	a->next = atom_tab[key];
+	atom_tab[key] = a;
+	++atom_count;
+	return last_atom = a;
+}
+
+
+struct atom *
+atom_intern_str(const char *name) {
+	if (last_atom != NULL && name == last_atom->name) {
+		return last_atom;
+	}
+	return atom_intern(name, strlen(name));
+}
+
+
+/*
+ * Returns the atom for ``name'' if it exists, else a null pointer. No
+ * declaration can have a name which was never interned, so a lookup
+ * can fail right away in that case
+ */
+struct atom *
+atom_find(const char *name) {
+	size_t	len;
+
+	if (last_atom != NULL && name == last_atom->name) {
+		return last_atom;
+	}
+	if (atom_tab == NULL) {
+		return NULL;
+	}
+	len = strlen(name);
+	return do_lookup_atom(name, len, hash_atom_name(name, len));
+}
+
+
+void
+atom_map_put(struct atom_map *map, struct atom *a, void *item) {
+	struct atom_map_entry	*ent;
+	int			key;
+
+	if (map->nitems >= map->nslots) {
+		struct atom_map_entry	**newslots;
+		int			newsize;
+		int			i;
+
+		newsize = map->nslots? map->nslots * 2: 8;
+		newslots = n_xmalloc(newsize * sizeof *newslots);
+		memset(newslots, 0, newsize * sizeof *newslots);
+		for (i = 0; i < map->nslots; ++i) {
+			struct atom_map_entry	*next;
+
+			for (ent = map->slots[i]; ent != NULL; ent = next) {
+				next = ent->next;
+				key = ent->atom->hash & (newsize - 1);
+				ent->next = newslots[key];
+				newslots[key] = ent;
+			}
+		}
+		free(map->slots);
+		map->slots = newslots;
+		map->nslots = newsize;
+	}
+
+	key = a->hash & (map->nslots - 1);
+	for (ent = map->slots[key]; ent != NULL; ent = ent->next) {
+		if (ent->atom == a) {
+			/* Replace (e.g. enum forward declaration) */
+			ent->item = item;
+			return;
+		}
+	}
+	ent = n_xmalloc(sizeof *ent);
+	ent->atom = a;
+	ent->item = item;
+	ent->next = map->slots[key];
+	map->slots[key] = ent;
+	++map->nitems;
+}
+
+
+void *
+atom_map_get(struct atom_map *map, struct atom *a) {
+	struct atom_map_entry	*ent;
+
+	if (map->slots == NULL || a == NULL) {
+		return NULL;
+	}
+	for (ent = map->slots[a->hash & (map->nslots - 1)];
+		ent != NULL;
+		ent = ent->next) {
+		if (ent->atom == a) {
+			return ent->item;
+		}
+	}
+	return NULL;
+}
+
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2026, Nils R. Weller
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ATOM_H
+#define ATOM_H
+
+#include <stddef.h>
+
+/*
+ * 10/17/26: Interned identifier. Every distinct identifier spelling
+ * exists exactly once in the atom table, so two identifiers are equal
+ * if and only if their atoms are the same pointer. The hash value is
+ * computed once when the atom is created and is used by all hash
+ * tables keyed on atoms. Atoms are never freed, so the name may be
+ * used as an ordinary (read-only!) string for the rest of the run
+ */
+struct atom {
+	struct atom	*next;
+	unsigned	hash;
+	size_t		len;
+	char		name[1];
+};
+
+struct atom	*atom_intern(const char *name, size_t len);
+struct atom	*atom_intern_str(const char *name);
+struct atom	*atom_find(const char *name);
+
+/*
+ * Hash table mapping atoms to arbitrary items (used for structure and
+ * enum tags). The table grows as needed; a null ``slots'' pointer is
+ * an empty table
+ */
+struct atom_map_entry {
+	struct atom		*atom;
+	void			*item;
+	struct atom_map_entry	*next;
+};
+
+struct atom_map {
+	struct atom_map_entry	**slots;
+	int			nslots; /* always a power of 2 */
+	int			nitems;
+};
+
+void	atom_map_put(struct atom_map *map, struct atom *a, void *item);
+void	*atom_map_get(struct atom_map *map, struct atom *a);
+
+#endif
+
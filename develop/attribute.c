@@ -107,7 +107,7 @@ static struct attrent {
 } attrtab[] = {
 	{ "alias", ATTRF_ALIAS, A_OK, 1, 0, 0, alias_args, 0 },
 	{ "aligned", ATTRS_ALIGNED, A_OK, 1, 0, CATTR_ALIGNED, aligned_args, 0 },
-	{ "always_inline", ATTRF_ALWAYS_INLINE, A_UNIMPL, 0, 1, 0, NULL, 0 },
+	{ "always_inline", ATTRF_ALWAYS_INLINE, A_OK, 0, 1, CATTR_ALWAYS_INLINE, NULL, 0 },
 	{ "bounded", ATTRV_BOUNDED, A_IGNORED, -1, 1, 0, NULL, 0 },
 	{ "cdecl", ATTRF_CDECL, A_UNIMPL, 0, 0, 0, NULL, 0 },
 	{ "cleanup", ATTRV_CLEANUP, A_UNIMPL, 0, 0, 0, NULL, 0 },
@@ -145,7 +145,7 @@ static struct attrent {
 	{ "no_instrument_function",
 		ATTRF_NO_INSTRUMENT_FUNCTION, A_UNIMPL, 0, 0, 0, NULL, 0 },
 	{ "nocommon", ATTRV_NOCOMMON, A_UNIMPL, 0, 0, 0, NULL, 0 },
-	{ "noinline", ATTRF_NOINLINE, A_IGNORED, 0, 1, 0, NULL, 0 },
+	{ "noinline", ATTRF_NOINLINE, A_OK, 0, 1, CATTR_NOINLINE, NULL, 0 },
 	{ "nonnull", ATTRF_NONNULL, A_IGNORED, 0, 1, 0, NULL, 0 },
 	{ "noreturn", ATTRF_NORETURN, A_IGNORED, 0, 1, 0, NULL, 0 },
 	{ "nothrow", ATTRF_NOTHROW, A_IGNORED, 0, 0, 0, NULL, 0 },
@@ -636,6 +636,9 @@ merge_attr_with_type(struct type *ty) {
 			break;
 		case ATTRF_FORMAT: /* 02/01/10 */
 			break;
+		case ATTRF_NOINLINE: /* 10/17/26 */
+		case ATTRF_ALWAYS_INLINE:
+			break;
 		case ATTRS_ALIGNED:
 			if ((attr->iarg & (attr->iarg - 1)) != 0) {
 				errorfl(attr->tok, "Alignment is not "
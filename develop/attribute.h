@@ -146,6 +146,8 @@
 #define CATTR_PURE		(1 << 7)
 #define CATTR_USED		(1 << 8)
 #define CATTR_UNUSED		(1 << 9)
+#define CATTR_NOINLINE		(1 << 10)
+#define CATTR_ALWAYS_INLINE	(1 << 11)
 
 
 #define ATTR_FUNC	1
@@ -46,6 +46,7 @@
 #include "cc1_main.h"
 #include "typemap.h"
 #include "symlist.h"
+#include "inliner.h"
 #include "n_libc.h"
 
 struct backend		*backend;
@@ -124,6 +125,8 @@ init_backend(FILE *fd, struct scope *s) {
 
 /*backend = &power_backend;*/
 
+	/* 10/17/26: Collect assembler output in memory */
+	x_setoutbuf(fd);
 	return backend->init(fd, s);
 }
 
@@ -154,10 +157,10 @@ check_need_indirect_loadstore(struct icode_instr *ip) {
 	} else if (ip->src_vreg->var_backed
 		&& ip->src_vreg->var_backed->stack_addr) {
 		sb = ip->src_vreg->var_backed->stack_addr;
-	} else if (ip->src_parent_struct
-		&& ip->src_parent_struct->var_backed
-		&& ip->src_parent_struct->var_backed->stack_addr) {
-		sb = ip->src_parent_struct->var_backed->stack_addr;
+	} else if (ICODE_SRC_PARENT_STRUCT(ip)
+		&& ip->memref->src_parent_struct->var_backed
+		&& ip->memref->src_parent_struct->var_backed->stack_addr) {
+		sb = ip->memref->src_parent_struct->var_backed->stack_addr;
 		offset = calc_offsets(ip->src_vreg);
 	}
 
@@ -246,38 +249,49 @@ do_xlate(
 	struct icode_instr **ipp) {
 
 	struct icode_instr	*ip = *ipp;
+	struct icode_memref	*mr;
 	struct stack_block	*sb;
 	struct allocstack	*as;
 	int			found;
 
 	map_pregs(ip->src_vreg, ip->src_pregs);
 	map_pregs(ip->dest_vreg, ip->dest_pregs);
-	if (ip->src_parent_struct) {
-		if (ip->src_ptr_preg) {
-			/*
-			 * 08/05/07: UNBELIEVABLE! This used to map the
-			 * register to the parent struct vreg, but not to
-			 * the parent struct from_ptr vreg, whree it would
-			 * have belonged! That one is used by the emitters,
-			 * so stuff broke
-			 */
-			backend_vreg_map_preg(ip->src_parent_struct->from_ptr,
-					ip->src_ptr_preg);
+	if ((mr = ip->memref) == NULL) {
+		/* 10/17/26: Not a memory access, nothing to do */
+		;
+	} else {
+		if (mr->src_parent_struct) {
+			if (mr->src_ptr_preg) {
+				/*
+				 * 08/05/07: UNBELIEVABLE! This used to map
+				 * the register to the parent struct vreg,
+				 * but not to the parent struct from_ptr
+				 * vreg, whree it would have belonged! That
+				 * one is used by the emitters, so stuff
+				 * broke
+				 */
+				backend_vreg_map_preg(
+					mr->src_parent_struct->from_ptr,
+					mr->src_ptr_preg);
+			}
+		} else if (mr->src_ptr_preg) {
+			backend_vreg_map_preg(ip->src_vreg->from_ptr,
+				mr->src_ptr_preg);
 		}
-	} else if (ip->src_ptr_preg) {
-		backend_vreg_map_preg(ip->src_vreg->from_ptr, ip->src_ptr_preg);
-	}
-	if (ip->dest_parent_struct) {
-		if (ip->dest_ptr_preg) {
-			/*
-			 * 08/05/07: See comment above about source parent
-			 * pointer
-			 */
-			backend_vreg_map_preg(ip->dest_parent_struct->from_ptr,
-				ip->dest_ptr_preg);
+		if (mr->dest_parent_struct) {
+			if (mr->dest_ptr_preg) {
+				/*
+				 * 08/05/07: See comment above about source
+				 * parent pointer
+				 */
+				backend_vreg_map_preg(
+					mr->dest_parent_struct->from_ptr,
+					mr->dest_ptr_preg);
+			}
+		} else if (mr->dest_ptr_preg) {
+			backend_vreg_map_preg(ip->dest_vreg->from_ptr,
+				mr->dest_ptr_preg);
 		}
-	} else if (ip->dest_ptr_preg) {
-		backend_vreg_map_preg(ip->dest_vreg->from_ptr, ip->dest_ptr_preg);
 	}
 	
 	switch (ip->type) {
@@ -455,6 +469,10 @@ do_xlate(
 	case INSTR_COMP_GOTO:
 		emit->comp_goto(ip->dat);
 		break;
+	case INSTR_SWITCH_TABLE:
+		emit->switch_table(ip->src_pregs[0],
+			ip->dest_pregs? ip->dest_pregs[0]: NULL, ip->dat);
+		break;
 	case INSTR_DEBUG:
 		if (emit->debug != NULL) {
 			emit->debug(ip);
@@ -516,6 +534,10 @@ do_xlate(
 			 *    make_void_ptr_type() instead
 			 */
 			emit->alloca_(ad);
+			if (backend->stack_alloca) {
+				/* 10/17/26: Nothing to free() later */
+				break;
+			}
 
 			/* Now save the result pointer */
 			vr.stack_addr = ad->addr;
@@ -724,32 +746,17 @@ do_xlate(
 #if XLATE_IMMEDIATELY
 	unmap_pregs(ip->src_vreg, ip->src_pregs);
 	unmap_pregs(ip->dest_vreg, ip->dest_pregs);
-	if (ip->src_parent_struct) {
-		if (ip->src_ptr_preg) {
-			/*
-			 * 08/05/07: UNBELIEVABLE! This used to map the
-			 * register to the parent struct vreg, but not to
-			 * the parent struct from_ptr vreg, whree it would
-			 * have belonged! That one is used by the emitters,
-			 * so stuff broke
-			 */
-			backend_vreg_unmap_preg(
-					ip->src_ptr_preg);
+	if ((mr = ip->memref) != NULL) {
+		/*
+		 * The parent struct distinction made when mapping doesn't
+		 * matter here; Just unmap whatever pointer registers we have
+		 */
+		if (mr->src_ptr_preg) {
+			backend_vreg_unmap_preg(mr->src_ptr_preg);
 		}
-	} else if (ip->src_ptr_preg) {
-		backend_vreg_unmap_preg(ip->src_ptr_preg);
-	}
-	if (ip->dest_parent_struct) {
-		if (ip->dest_ptr_preg) {
-			/*
-			 * 08/05/07: See comment above about source parent
-			 * pointer
-			 */
-			backend_vreg_unmap_preg(
-				ip->dest_ptr_preg);
+		if (mr->dest_ptr_preg) {
+			backend_vreg_unmap_preg(mr->dest_ptr_preg);
 		}
-	} else if (ip->dest_ptr_preg) {
-		backend_vreg_unmap_preg(ip->dest_ptr_preg);
 	}
 #endif /* XLATE_IMMEDIATELY */
 	return 0;
@@ -861,7 +868,16 @@ vreg_stack_alloc(struct type *ty, struct icode_list *il, int on_frame,
 		 *                        foo's return value here
 		 */
 		decp->is_unrequested_decl = 1;
-		store_decl_scope(curscope, dummy);
+		if (inline_current_function() != NULL) {
+			/*
+			 * 10/17/26: Translating the body of an inline
+			 * function at a call site; The storage belongs
+			 * to the frame of the caller
+			 */
+			inline_store_frame_decl(decp);
+		} else {
+			store_decl_scope(curscope, dummy);
+		}
 	}
 	/*
 	 * Careful now if we have an initializer. Since this function is
@@ -1385,13 +1401,87 @@ as_print_string_init(FILE *o, size_t howmany, struct ty_string *str) {
 
         if (howmany >= str->size) {
                 if (str->size > 1) {
-                        (void) fprintf(o, ", ");
+                        x_fprintf(o, ", ");
                 }
-                (void) fprintf(o, "0");
+                x_fprintf(o, "0");
         }
         x_fputc('\n', o);
 }
 
+/*
+ * 10/17/26: Prints the byte image of an INIT_BYTES initializer. Little
+ * endian targets whose assembler supports .quad get runs of 64bit words
+ * (in target byte order), everyone else gets .byte lists
+ */
+void
+as_print_init_bytes(FILE *o, struct init_bytes *ib, int use_quad) {
+	size_t	i = 0;
+	int	j;
+
+	if (use_quad) {
+		for (; i + 8 <= ib->size; i += 8) {
+			unsigned long	lo = 0;
+			unsigned long	hi = 0;
+
+			for (j = 3; j >= 0; --j) {
+				lo = lo << 8 | ib->data[i + j];
+				hi = hi << 8 | ib->data[i + 4 + j];
+			}
+			if (i % 32 == 0) {
+				x_fprintf(o, "\t.quad 0x%08lx%08lx", hi, lo);
+			} else {
+				x_fprintf(o, ",0x%08lx%08lx", hi, lo);
+			}
+			if (i % 32 == 24 || i + 8 > ib->size - 8) {
+				x_fputc('\n', o);
+			}
+		}
+	}
+	for (; i < ib->size; ++i) {
+		if (i % 16 == 0 || (use_quad && i % 8 == 0)) {
+			x_fprintf(o, "\t.byte 0x%x", ib->data[i]);
+		} else {
+			x_fprintf(o, ",0x%x", ib->data[i]);
+		}
+		if (i % 16 == 15 || i + 1 == ib->size) {
+			x_fputc('\n', o);
+		}
+	}
+}
+
+/*
+ * 10/17/26: Like as_print_string_init(), but narrow strings are written
+ * as a single .ascii (or null-terminated .string) directive instead of
+ * lists of .byte values, which makes the output a lot smaller
+ */
+void
+as_print_ascii_string(FILE *o, size_t howmany, struct ty_string *str) {
+	size_t	i;
+
+	if (str->is_wide_char) {
+		as_print_string_init(o, howmany, str);
+		return;
+	}
+	if (howmany >= str->size) {
+		x_fprintf(o, sysflag == OS_OSX? "\t.asciz \"": "\t.string \"");
+	} else {
+		x_fprintf(o, "\t.ascii \"");
+	}
+	for (i = 0; i < str->size - 1; ++i) {
+		int	ch = (unsigned char)str->str[i];
+
+		if (ch == '"' || ch == '\\') {
+			x_fputc('\\', o);
+			x_fputc(ch, o);
+		} else if (ch >= 0x20 && ch < 0x7f) {
+			x_fputc(ch, o);
+		} else {
+			x_fprintf(o, "\\%03o", ch);
+		}
+	}
+	x_fprintf(o, "\"\n");
+}
+
 struct reg *
 generic_alloc_gpr(
 	struct function *f, 
@@ -2063,6 +2153,8 @@ generic_print_init_list(FILE *out, struct decl *dec, struct initializer *init,
 
 			ex = init->data;
 			print_init_expr(ex->const_value->type, ex);
+		} else if (init->type == INIT_BYTES) {
+			as_print_init_bytes(out, init->data, 0);
 		} else if (init->type == INIT_NULL) {
 			x_fprintf(out, "\t.%s %lu\n",
 				backend->arch == ARCH_SPARC? "skip": "space",
@@ -2335,6 +2427,8 @@ new_generic_print_init_list(FILE *out, struct decl *dec, struct initializer *ini
 					continue;
 				}
 			}
+		} else if (init->type == INIT_BYTES) {
+			as_print_init_bytes(out, init->data, 0);
 		} else if (init->type == INIT_NULL) {
 			if (init->varinit && init->left_type->tbit != NULL) {
 				continue;
@@ -2575,6 +2669,14 @@ generic_elf_section_name(int value) {
 		return "tdata";
 	case SECTION_UNINIT_THREAD:
 		return "tbss";
+	case SECTION_RODATA_STR:
+		return "rodata.str1.1";
+	case SECTION_RODATA_CST4:
+		return "rodata.cst4";
+	case SECTION_RODATA_CST8:
+		return "rodata.cst8";
+	case SECTION_RODATA_CST16:
+		return "rodata.cst16";
 	default:
 		unimpl();
 	}
@@ -2584,10 +2686,16 @@ generic_elf_section_name(int value) {
 
 char *
 generic_mach_o_section_name(int value) {
-	if (value == SECTION_RODATA) {
+	if (value == SECTION_RODATA || value == SECTION_RODATA_STR) {
 		return "cstring";
 	} else if (value == SECTION_UNINIT) {
 		return "data";
+	} else if (value == SECTION_RODATA_CST4) {
+		return "literal4";
+	} else if (value == SECTION_RODATA_CST8) {
+		return "literal8";
+	} else if (value == SECTION_RODATA_CST16) {
+		return "literal16";
 	}
 	return generic_elf_section_name(value);
 }
@@ -50,6 +50,7 @@ struct copystruct;
 struct allocadata;
 
 struct vlasizedata;
+struct switch_table;
 
 #include <stdio.h>
 #include <stdarg.h>
@@ -169,6 +170,9 @@ extern struct stupidtrace_entry	*stupidtrace_list_tail;
 void	as_align_for_type(FILE *o, struct type *, int struct_member);
 
 void	as_print_string_init(FILE *o, size_t howmany, struct ty_string *str);
+void	as_print_ascii_string(FILE *o, size_t howmany, struct ty_string *str);
+struct init_bytes;
+void	as_print_init_bytes(FILE *o, struct init_bytes *ib, int use_quad);
 
 
 typedef int	(*have_immediate_op_func_t)(struct type *ty, int op);
@@ -270,6 +274,7 @@ struct emitter;
 struct reg;
 struct copystruct;
 struct copyreg;
+struct peephole_rule;
 
 #include "archdefs.h"
 #include "features.h"
@@ -283,6 +288,11 @@ struct backend {
 	int				need_pic_init;
 	int				emulate_long_double;
 	int				relax_alloc_gpr_order;
+	/*
+	 * 10/17/26: Set if the emitters allocate alloca() and VLA
+	 * storage on the stack rather than with malloc()/free()
+	 */
+	int				stack_alloca;
 	long				max_displacement;
 	long				min_displacement;
 	have_immediate_op_func_t	have_immediate_op;
@@ -355,6 +365,9 @@ struct backend {
 	get_abi_reg_func_t		get_abi_reg;
 	get_abi_ret_reg_func_t		get_abi_ret_reg;
 	same_representation_func_t	same_representation;
+
+	/* 10/17/26: Target-specific -O rules, or null (see peephole.h) */
+	struct peephole_rule		*peephole_rules;
 };
 
 struct scope;
@@ -455,6 +468,8 @@ typedef void	(*dec_func_t)(struct icode_instr *);
 typedef void	(*load_func_t)(struct reg *r, struct vreg *vr);
 typedef void	(*load_addrlabel_func_t)(struct reg *r, struct icode_instr *label);
 typedef void	(*comp_goto_func_t)(struct reg *addr);
+typedef void	(*switch_table_func_t)(struct reg *idx, struct reg *tmp,
+		struct switch_table *tab);
 typedef void	(*store_func_t)(struct vreg *dest, struct vreg *src);
 typedef void	(*neg_func_t)(struct reg **dest, struct icode_instr *src);
 typedef void	(*sub_func_t)(struct reg **dest, struct icode_instr *src);
@@ -490,6 +505,16 @@ typedef void	(*branch_func_t)(struct icode_instr *ii);
 /* 12/25/08: PPC TOC */
 #define SECTION_TOC	8
 
+/*
+ * 10/17/26: Mergeable sections for pooled string literals and floating
+ * point constants of 4, 8 and 16 bytes, which the linker can merge
+ * across translation units
+ */
+#define SECTION_RODATA_STR	9
+#define SECTION_RODATA_CST4	10
+#define SECTION_RODATA_CST8	11
+#define SECTION_RODATA_CST16	12
+
 
 typedef void	(*setsection_func_t)(int value);
 typedef void	(*alloc_func_t)(size_t nbytes);
@@ -577,6 +602,7 @@ struct emitter {
 	load_func_t		load;
 	load_addrlabel_func_t	load_addrlabel;
 	comp_goto_func_t	comp_goto;
+	switch_table_func_t	switch_table; /* opt */
 	store_func_t		store;
 
 	/* 30 */
@@ -726,6 +726,13 @@ generic_builtin_alloca_to_icode(struct fcall_data *fdat,
 		return vr;
 	}
 
+	/*
+	 * 10/17/26: Convert the size to size_t first, so the backend
+	 * always gets a register of pointer size, rather than e.g. a
+	 * char or short one which it cannot pass on or subtract
+	 */
+	size_vr = backend->icode_make_cast(size_vr, backend->get_size_t(), il);
+
 	/*
 	 * Now allocate a stack block in which to store the returned
 	 * pointer, so that we can free it upon return from the function.
@@ -54,6 +54,8 @@
 #include "n_libc.h"
 #include "fcatalog.h"
 #include "standards.h"
+#include "profile.h"
+#include "lex_ucpp.h"
 
 #if USE_ZONE_ALLOCATOR
 /* Some includes for zalloc_init() */
@@ -106,6 +108,21 @@ int	fsignedchar_flag;
 int	fnocommon_flag;
 int	use_common_variables;
 
+/*
+ * 10/17/26: Inliner controls; -finline-limit=n (-1 = default budget),
+ * -fno-inline and -finline-report
+ */
+int	finline_limit = -1;
+int	fnoinline_flag;
+int	finlinereport_flag;
+
+/*
+ * 10/17/26: Compilation profile; -ftime-report prints it to stderr,
+ * -ftime-report-json=file writes it to a file (see profile.c)
+ */
+static int	ftimereport_flag;
+static char	*ftimereport_json;
+
 /*
  * 05/18/09: Added -notgnu
  */
@@ -119,6 +136,7 @@ int	save_bad_translation_unit_flag;
 
 /*
  * 20141116: Flag to indicate whether we're using ucpp (experimental)
+ * 10/17/26: This is the default now if nwcc was built with ucpp
  */
 int	using_ucpp;
 int	using_nwcpp;
@@ -137,23 +155,28 @@ check_preprocessor(const char *path, const char *name, int *using_nwcpp, int *us
 	*using_ucpp = 0;
 
 	if (strcmp(name, "ucpp") == 0) {
+#if USE_UCPP
 		*using_ucpp = 1;
+#else
+		(void) fprintf(stderr, "nwcc was built without the "
+			"integrated ucpp preprocessor\n");
+		return NULL;
+#endif
 	} else if (strcmp(name, "nwcpp") == 0) {
 		*using_nwcpp = 1;
 	} else if (strcmp(name, "cpp") == 0) {
 		; /* OK - cpp  (XXX: check system?) */
 	} else if (strcmp(name, "gcc") == 0) {
-		/* OK - gcc - append -E */
-		char	*temp;
-
-		temp = n_xmalloc(strlen(path)
-			+ sizeof " -E");
-		sprintf(temp, "%s -E", path);
-		path = temp;
+		/*
+		 * OK - gcc - append -E
+		 * 10/17/26: As a flag; exec_cmd() took "gcc -E" for the
+		 * name of the program
+		 */
+		cpp_progflag = "-E";
 	} else {
 		(void) fprintf(stderr, "Unrecognized "
 			"preprocessor `%s' - must be "
-			"gcc, cpp or nwcpp\n",
+			"gcc, cpp, nwcpp or ucpp\n",
 			name);
 		return NULL;
 	}
@@ -187,6 +210,18 @@ determine_preprocessor(void) {
 	if (cpp_env_var == NULL) {
 		cpp_env_var = getenv("NWCC_CPP");
 		if (cpp_env_var == NULL) {
+#if USE_UCPP
+			/*
+			 * 10/17/26: No user preference; The source is
+			 * preprocessed by the integrated ucpp while it is
+			 * being tokenized, so there is no temporary file,
+			 * no second lexing pass over it and no process to
+			 * spawn. An external preprocessor can still be
+			 * selected using NWCC_CPP or -cpp
+			 */
+			using_ucpp = 1;
+			return 0;
+#endif
 			/*
 			 * No user preference; We use gcc -E if available,
 			 * otherwise cpp, otherwise nwcpp. gcc comes
@@ -240,7 +275,13 @@ determine_preprocessor(void) {
 					return -1;
 				}
 			} else {
-				if (strcmp(cpp_env_var, "nwcpp") == 0) {
+				if (strcmp(cpp_env_var, "ucpp") == 0) {
+					/* 10/17/26: The integrated one */
+					cpp_progname = check_preprocessor(cpp_env_var, cpp_env_var, &using_nwcpp, &using_ucpp);
+					if (cpp_progname == NULL) {
+						return -1;
+					}
+				} else if (strcmp(cpp_env_var, "nwcpp") == 0) {
 					cpp_progname = INSTALLDIR "/nwcc/bin/nwcpp";
 					using_nwcpp = 1;
 				} else {
@@ -251,17 +292,6 @@ determine_preprocessor(void) {
 				}
 			}
 		}
-	} else {
-		/*
-		 * 20141116: No preprocessor selected. In this case, we may use
-		 * the new experimental implementation with ucpp if nwcc was
-		 * compiled that way
-		 */
-#if USE_UCPP /* XXX This should be configurable dynamically as well */
-		using_ucpp = 1;
-#else
-		using_ucpp = 0;
-#endif
 	}
 	return 0;
 }
@@ -279,6 +309,30 @@ remove_garbage(void) {
 	}
 }
 
+/*
+ * Records the name of the source file being compiled, and derives the
+ * translation unit name from it
+ */
+static void
+set_input_file_name(char *file) {
+	char	*p;
+	int	i;
+
+	tunit_name = n_xmalloc(strlen(file) + 1);
+	for (p = file, i = 0; *p != 0; ++p) {
+		if (isalnum((unsigned char)*p) || *p == '_') {
+			tunit_name[i++] = *p;
+		}
+	}
+	tunit_name[i] = 0;
+
+	if ((p = strrchr(tunit_name, '.')) != NULL) {
+		*p = 0;
+	}
+	
+	input_file = n_xstrdup(file);
+}
+
 static char *
 do_cpp(char *file, char **args, int cppind) {
 	/* XXX FILENAME_MAX is broken on HP-UX */
@@ -286,10 +340,8 @@ do_cpp(char *file, char **args, int cppind) {
 	char		buf[FILENAME_MAX + 1];
 	char		tmpbuf[128] = "/var/tmp/cpp";
 	char		*arch;
-	char		*p;
 	char		*gnooh = NULL;
 	char		*gnooh2 = NULL;
-	int		i;
 	int		host_sys;
 	FILE		*fd;
 	FILE		*fd2;
@@ -374,19 +426,7 @@ do_cpp(char *file, char **args, int cppind) {
 
 	args[cppind] = NULL;
 
-	tunit_name = n_xmalloc(strlen(file) + 1);
-	for (p = file, i = 0; *p != 0; ++p) {
-		if (isalnum((unsigned char)*p) || *p == '_') {
-			tunit_name[i++] = *p;
-		}
-	}
-	tunit_name[i] = 0;
-
-	if ((p = strrchr(tunit_name, '.')) != NULL) {
-		*p = 0;
-	}
-	
-	input_file = n_xstrdup(file);
+	set_input_file_name(file);
 	if (Eflag) {
 		fd = stdout;
 	} else if (save_bad_translation_unit_flag) {
@@ -538,8 +578,9 @@ do_ncc(char *cppfile, char *nccfile, int is_tmpfile) {
 	static int		timing_analysis;
 	static int		timing_gen;
 	struct stat		sbuf;
+	int			timing = timeflag || prof_enabled;
 
-	if (timeflag) {
+	if (timing) {
 		/* Time initialization stuff */
 		start_timer(&tv);
 	}
@@ -619,22 +660,31 @@ do_ncc(char *cppfile, char *nccfile, int is_tmpfile) {
 	 * needed since the switch label changes were made, or else the
 	 * ctrl->labels (ctrl_to_icode() for TOK_KEY_SWITCH) list will
 	 * end up containing a member that links to itself.
+	 *
+	 * 10/17/26: Labels and statements are now released with the
+	 * rest of the function after gen_function(). Statements for file
+	 * scope declarations and structure members are malloc()ed (see
+	 * do_store_decl()).
+	 *
+	 * Initializers stay on malloc() because static initializers are
+	 * emitted at the end of the translation unit, and struct function
+	 * is malloc()ed by alloc_function() since funclist outlives the
+	 * function body (TOC entries on PPC, deferred inline functions)
 	 */
-	zalloc_init(Z_LABEL, sizeof(struct label), 1, 1);
-	zalloc_init(Z_EXPR, sizeof(struct expr), 1, 0);  /* XXX doesn't work */
+	zalloc_init(Z_LABEL, sizeof(struct label), 1, 0);
+	zalloc_init(Z_EXPR, sizeof(struct expr), 1, 0);
 	zalloc_init(Z_INITIALIZER, sizeof(struct initializer), 1, 1);
-	zalloc_init(Z_STATEMENT, sizeof(struct statement), 1, 1);
+	zalloc_init(Z_STATEMENT, sizeof(struct statement), 1, 0);
 	zalloc_init(Z_FUNCTION, sizeof(struct function), 1, 1);
 	zalloc_init(Z_ICODE_INSTR, sizeof(struct icode_instr), 1, 0);
 	zalloc_init(Z_ICODE_LIST, sizeof(struct icode_list), 1, 0);
+	zalloc_init(Z_ICODE_MEMREF, sizeof(struct icode_memref), 1, 0);
+	zalloc_init(Z_ICODE_PREGS, 2 * sizeof(struct reg *), 0, 0);
 	zalloc_init(Z_VREG, sizeof(struct vreg), 1, 0);
 	zalloc_init(Z_STACK_BLOCK, sizeof(struct stack_block), 1, 0);
 	zalloc_init(Z_S_EXPR, sizeof(struct s_expr), 1, 0);
 	zalloc_init(Z_FCALL_DATA, sizeof(struct fcall_data), 1, 0);
 /*	zalloc_init(Z_IDENTIFIER, sizeof(struct control), 1);*/
-#if FAST_SYMBOL_LOOKUP
-	zalloc_init(Z_FASTSYMHASH, sizeof(struct fast_sym_hash_entry), 1, 0);
-#endif
 
 	zalloc_init(Z_CEXPR_BUF, 16, 1, 1); /* XXX */
 
@@ -659,17 +709,26 @@ do_ncc(char *cppfile, char *nccfile, int is_tmpfile) {
 		(void) fcat_open_index_file("fcatalog.idx");
 	}
 
-	if (timeflag) {
+	if (timing) {
 		timing_init = stop_timer(&tv);
+		prof_phase(PROF_INIT, timing_init);
 		start_timer(&tv);
 	}
 
+	/*
+	 * 10/17/26: Only the first declaration is read here; The parser
+	 * requests the rest as it goes, and releases function bodies
+	 * after they have been emitted, so the token list of the whole
+	 * translation unit is never kept in memory
+	 */
+	lex_streaming = 1;
 	if (lex_nwcc(create_input_file(input)) != 0) {
 		REM_EXIT(cppfile, nccfile);
 	}
 
-	if (timeflag) {
+	if (timing) {
 		timing_lex = stop_timer(&tv);
+		prof_phase(PROF_LEX, timing_lex);
 		start_timer(&tv);
 	}
 		
@@ -691,8 +750,9 @@ do_ncc(char *cppfile, char *nccfile, int is_tmpfile) {
 	}
 #endif
 
-	if (timeflag) {
+	if (timing) {
 		timing_analysis = stop_timer(&tv);
+		prof_phase(PROF_ANALYSIS, timing_analysis);
 		start_timer(&tv);
 	}
 
@@ -705,9 +765,11 @@ do_ncc(char *cppfile, char *nccfile, int is_tmpfile) {
 		;
 	}
 #endif
+	x_flushoutbuf(0);
 
-	if (timeflag) {
+	if (timing) {
 		timing_gen = stop_timer(&tv);
+		prof_phase(PROF_GEN, timing_gen);
 	}
 
 	/* destroy_toklist(&toklist); */
@@ -745,6 +807,12 @@ do_ncc(char *cppfile, char *nccfile, int is_tmpfile) {
 		(void) fprintf(stderr, "   Emission:        %f sec  "
 			"(%f%% of total)\n", RESULT(timing_gen));
 	}
+	if (ftimereport_flag) {
+		prof_report(stderr);
+	}
+	if (ftimereport_json != NULL) {
+		(void) prof_write_json(ftimereport_json);
+	}
 	
 	if (errors) {
 		remove(nccfile);
@@ -818,6 +886,11 @@ main(int argc, char *argv[]) {
 		{ 0, "funsigned-char", 0 },
 		{ 0, "fsigned-char", 0 },
 		{ 0, "fno-common", 0 },
+		{ 0, "finline-limit", 1 },
+		{ 0, "fno-inline", 0 },
+		{ 0, "finline-report", 0 },
+		{ 0, "ftime-report", 0 },
+		{ 0, "ftime-report-json", 1 },
 		{ 0, "notgnu", 0 },
 		{ 0, "gnu", 0 },
 		{ 0, "color", 0 },
@@ -882,10 +955,14 @@ main(int argc, char *argv[]) {
 					if (strcmp(options[idx].name, "O-1")
 						== 0) {
 						Oflag = -1;
-					} else if (options[idx].name[1] == '0') {
-						Oflag = 0;
 					} else {
-						; /* ignore for now */
+						/*
+						 * 10/17/26: -O1 and up enable
+						 * the register promotion of
+						 * local variables
+						 */
+						Oflag = options[idx].name[1]
+							- '0';
 					}
 				} else if (strcmp(options[idx].name, "stackprotect")
 					== 0) {
@@ -993,6 +1070,23 @@ main(int argc, char *argv[]) {
 				} else if (strcmp(options[idx].name, "fno-common")
 					== 0) {
 					fnocommon_flag = 1;
+				} else if (strcmp(options[idx].name, "finline-limit")
+					== 0) {
+					finline_limit = atoi(n_optarg);
+				} else if (strcmp(options[idx].name, "fno-inline")
+					== 0) {
+					fnoinline_flag = 1;
+				} else if (strcmp(options[idx].name, "finline-report")
+					== 0) {
+					finlinereport_flag = 1;
+				} else if (strcmp(options[idx].name, "ftime-report")
+					== 0) {
+					ftimereport_flag = 1;
+					prof_enabled = 1;
+				} else if (strcmp(options[idx].name,
+					"ftime-report-json") == 0) {
+					ftimereport_json = n_xstrdup(n_optarg);
+					prof_enabled = 1;
 				} else if (strcmp(options[idx].name, "notgnu") == 0) {
 					notgnu_flag = 1;
 				} else if (strcmp(options[idx].name, "gnu") == 0) {
@@ -1142,7 +1236,10 @@ argv[0] = "new.c";
 		return EXIT_FAILURE;
 	}
 
-	if (timeflag) {
+	if (prof_enabled) {
+		prof_set_source(nccfile);
+	}
+	if (timeflag || prof_enabled) {
 		start_timer(&tv);
 	}
 
@@ -1151,12 +1248,23 @@ argv[0] = "new.c";
 		return EXIT_FAILURE;
 	}
 
-	if (strcmp(p, "i") == 0 || using_ucpp) {
+	if (strcmp(p, "i") == 0) {
 		/*
-		 * This file is already preprocessed (.i extension), or we're
-		 * going to preprocess it "on the fly" using ucpp. In both
-		 * cases no external preprocessor needs to be invoked
+		 * This file is already preprocessed (.i extension), so no
+		 * preprocessor needs to be invoked
 		 */
+		using_ucpp = 0;
+		tmp = n_xstrdup(nccfile);
+	} else if (using_ucpp) {
+		/*
+		 * We're going to preprocess it "on the fly" using ucpp,
+		 * unless we're only asked for the preprocessor output
+		 */
+		set_input_file_name(nccfile);
+		if (Eflag || dump_macros_flag) {
+			return ucpp_preprocess(nccfile, stdout,
+				dump_macros_flag) != 0? EXIT_FAILURE: 0;
+		}
 		tmp = n_xstrdup(nccfile);
 	} else {
 		/*
@@ -1168,8 +1276,9 @@ argv[0] = "new.c";
 		}
 	}	
 
-	if (timeflag) {
+	if (timeflag || prof_enabled) {
 		timing_cpp = stop_timer(&tv);
+		prof_phase(PROF_CPP, timing_cpp);
 	}
 
 	if (Eflag) {
@@ -23,8 +23,12 @@ extern int	funsignedchar_flag;
 extern int	fsignedchar_flag;
 extern int	fnocommon_flag;
 extern int	use_common_variables;
+extern int	finline_limit;
+extern int	fnoinline_flag;
+extern int	finlinereport_flag;
 
 extern int	notgnu_flag;
+extern int	gnuheadersflag;
 extern int	color_flag;
 
 extern int	write_fcat_flag;
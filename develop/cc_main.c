@@ -61,6 +61,7 @@ int		pedanticflag;
 int		verboseflag;
 char		*asmflag;
 char		*asmname;
+int		integrated_as_flag;
 char		*gnuc_version;
 char		*cppflag;
 
@@ -90,6 +91,11 @@ int		fulltocflag;
 int		funsignedchar_flag;
 int		fsignedchar_flag;
 int		fnocommon_flag;
+int		finline_limit = -1;
+int		fnoinline_flag;
+int		finlinereport_flag;
+int		ftimereport_flag;
+char		*ftimereport_json;
 
 char		*custom_cpp_args;
 char		*custom_ld_args;
@@ -110,6 +116,11 @@ int		dump_macros_flag;
 int		write_fcat_flag;
 int		save_bad_translation_unit_flag;
 
+/*
+ * 10/17/26: Number of files to compile in parallel (-j N)
+ */
+int		jobsflag = 1;
+
 static void
 usage(void) {
 	/* XXX add useful stuff here */
@@ -258,6 +269,7 @@ main(int argc, char *argv[]) {
 		{ 'o', NULL, 1 },
 		{ 'n', NULL, 1 },
 		{ 'R', NULL, 1 },
+		{ 'j', NULL, 1 },
 		{ 'S', NULL, 0 },
 		{ 'E', NULL, 0 },
 		{ 'c', NULL, 0 },
@@ -292,10 +304,10 @@ main(int argc, char *argv[]) {
 		{ 0, "xarch", 1 },
 #endif
 		{ 0, "O-1", 0 }, /* disable even VERY simple optimizations */
-		{ 0, "O0", 0 }, /* ignore */
-		{ 0, "O1", 0 }, /* ignore */
-		{ 0, "O2", 0 }, /* ignore */
-		{ 0, "O3", 0 }, /* ignore */
+		{ 0, "O0", 0 },
+		{ 0, "O1", 0 },
+		{ 0, "O2", 0 },
+		{ 0, "O3", 0 },
 		{ 0, "ggdb", 0 }, /* ignore */
 		{ 0, "Wall", 0 }, /* ignore */
 		{ 0, "pedantic", 0 }, /* ignore */
@@ -319,6 +331,11 @@ main(int argc, char *argv[]) {
 		{ 0, "color", 0 },
 		{ 0, "uncolor", 0 },
 		{ 0, "fno-common", 0 },
+		{ 0, "finline-limit", 1 },
+		{ 0, "fno-inline", 0 },
+		{ 0, "finline-report", 0 },
+		{ 0, "ftime-report", 0 },
+		{ 0, "ftime-report-json", 1 },
 		{ 0, "soname", 1 },
 		{ 0, "abi", 1 },
 		{ 0, "sys", 1 },
@@ -459,6 +476,13 @@ main(int argc, char *argv[]) {
 		case 'O':
 			Oflag = 1;
 			break;
+		case 'j':
+			if ((jobsflag = atoi(n_optarg)) < 1) {
+				(void) fprintf(stderr, "Bad argument to -j "
+					"(should be a number of jobs)\n");
+				return EXIT_FAILURE;
+			}
+			break;
 		case 'W': /* Ignore -W */
 			break;
 		case 'g':	
@@ -509,10 +533,14 @@ main(int argc, char *argv[]) {
 						 * are disabled
 						 */
 						Oflag = -1;
-					} else if (options[idx].name[0] == '0') {
-						Oflag = 0;
 					} else {
-						; /* Ignore */
+						/*
+						 * 10/17/26: This used to ignore
+						 * everything but -O-1 (and
+						 * tested name[0] for -O0)
+						 */
+						Oflag = options[idx].name[1]
+							- '0';
 					}
 				} else if (strcmp(options[idx].name, "ggdb")
 					== 0) {
@@ -722,6 +750,23 @@ main(int argc, char *argv[]) {
 					fsignedchar_flag = 1;
 				} else if (strcmp(options[idx].name, "fno-common") == 0) {
 					fnocommon_flag = 1;
+				} else if (strcmp(options[idx].name, "finline-limit") == 0) {
+					/* 10/17/26: Inliner size budget */
+					finline_limit = atoi(n_optarg);
+					if (finline_limit < 0) {
+						(void) fprintf(stderr, "Warning: "
+							"Ignoring negative "
+							"-finline-limit\n");
+						finline_limit = -1;
+					}
+				} else if (strcmp(options[idx].name, "fno-inline") == 0) {
+					fnoinline_flag = 1;
+				} else if (strcmp(options[idx].name, "finline-report") == 0) {
+					finlinereport_flag = 1;
+				} else if (strcmp(options[idx].name, "ftime-report") == 0) {
+					ftimereport_flag = 1;
+				} else if (strcmp(options[idx].name, "ftime-report-json") == 0) {
+					ftimereport_json = n_optarg;
 				} else if (strcmp(options[idx].name, "Wp") == 0) {
 					custom_cpp_args = n_xmalloc(strlen(n_optarg) + sizeof "-Wp,");
 					sprintf(custom_cpp_args, "-Wp,%s", n_optarg);
@@ -1164,6 +1209,15 @@ main(int argc, char *argv[]) {
 			asmname = "gas";
 			assembler = ASM_GAS  /*NASM*/;
 			*asm_flags = 0;
+
+			/*
+			 * 10/17/26: Objects are written by the integrated
+			 * assembler if possible; -asm=gas selects the
+			 * external one
+			 */
+			if (sd_host_sys == OS_LINUX) {
+				integrated_as_flag = 1;
+			}
 		} else if (strcmp(asmname, "yasm") == 0) {	
 			assembler = ASM_YASM; /* XXX */
 			strcpy(asm_flags, "-f elf -m amd64");
@@ -29,6 +29,7 @@ extern int	Oflag;
 extern int	sharedflag;
 extern int	stupidtraceflag;
 extern int	picflag;
+extern int	integrated_as_flag;
 
 
 extern char	*out_file;
@@ -43,6 +44,11 @@ extern int	fulltocflag;
 extern int	funsignedchar_flag;
 extern int	fsignedchar_flag;
 extern int	fnocommon_flag;
+extern int	finline_limit;
+extern int	fnoinline_flag;
+extern int	finlinereport_flag;
+extern int	ftimereport_flag;
+extern char	*ftimereport_json;
 
 extern char	*custom_cpp_args;
 extern char	*custom_ld_args;
@@ -59,5 +65,7 @@ extern int	dump_macros_flag;
 extern int	write_fcat_flag;
 extern int	save_bad_translation_unit_flag;
 
+extern int	jobsflag;
+
 #endif
 
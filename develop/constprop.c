@@ -0,0 +1,1681 @@
+/*
+ * Copyright (c) 2026, Nils R. Weller
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * 10/17/26: Constant propagation over the completed icode list of a
+ * function.
+ *
+ * The front end only folds expressions which are constant by themselves,
+ * so in
+ *
+ *    const int n = 16;       ...  x * n  ...
+ *    int k = 3;              ...  if (k * 4 + 1 == 13)  ...
+ *    static const int dbg = 1;  ...  if (dbg > 2)  ...
+ *
+ * the variables are still loaded, computed with and branched on at run
+ * time. This pass does sparse conditional constant propagation over the
+ * basic blocks of the function: The values of automatic scalar variables
+ * (the same kind of variables which regalloc.c may keep in registers) are
+ * propagated along those control flow edges only which can actually be
+ * taken given the values known so far. Within a block we also follow the
+ * constants held in general purpose registers. Afterwards
+ *
+ *    - loads of variables with a known value become immediate loads
+ *    - arithmetic on known operands becomes an immediate load of the result
+ *    - compare and branch pairs on known operands become a jump or vanish
+ *    - blocks which cannot be reached are removed
+ *    - stores to variables which are no longer loaded anywhere are removed
+ *
+ * Loads of static const-qualified scalars with a constant initializer are
+ * treated like constants too.
+ *
+ * Register values are not carried across block boundaries, and every
+ * instruction whose register effects are not modelled below forgets all
+ * of them, so the analysis errs on the safe side
+ */
+#include "constprop.h"
+#include <stdlib.h>
+#include <string.h>
+#include "backend.h"
+#include "functions.h"
+#include "scope.h"
+#include "decl.h"
+#include "type.h"
+#include "token.h"
+#include "expr.h"
+#include "icode.h"
+#include "reg.h"
+#include "typemap.h"
+#include "zalloc.h"
+#include "n_libc.h"
+
+#define CP_TOP		0	/* No value seen yet */
+#define CP_CONST	1	/* Always ``value'' */
+#define CP_BOTTOM	2	/* Not constant */
+
+struct cp_val {
+	int			state;
+	unsigned long long	value;
+};
+
+struct cp_var {
+	struct decl	*dec;
+	size_t		size;
+	int		bad;
+	unsigned long	loads;
+};
+
+struct cp_block {
+	int		first;
+	int		last;
+	int		*succ;
+	int		nsucc;
+	int		executable;
+	int		queued;
+	struct cp_val	*in;
+};
+
+struct cp_label {
+	struct icode_instr	*label;
+	int			block;
+};
+
+/*
+ * Known register contents within a block. A register which overlaps a
+ * written register (e.g. rax and eax) is forgotten
+ */
+#define CP_MAX_REGS	32
+
+struct cp_regs {
+	int			n;
+	struct reg		*regs[CP_MAX_REGS];
+	unsigned long long	values[CP_MAX_REGS];
+};
+
+/*
+ * Functions whose block count times variable count exceeds this are not
+ * worth the memory
+ */
+#define CP_MAX_STATES	(1L << 22)
+
+static struct icode_instr	**instrs;
+static char			*dead;
+static int			ninstrs;
+static struct cp_block		*blocks;
+static int			nblocks;
+static struct cp_var		*vars;
+static int			nvars;
+static struct cp_label		*labels;
+static int			nlabels;
+
+static unsigned long long
+size_mask(size_t size) {
+	if (size >= sizeof(unsigned long long)) {
+		return ~0ULL;
+	}
+	return (1ULL << (size * 8)) - 1;
+}
+
+static long long
+sign_extend(unsigned long long value, size_t size) {
+	value &= size_mask(size);
+	if (size < sizeof(unsigned long long)
+		&& (value & (1ULL << (size * 8 - 1)))) {
+		value |= ~size_mask(size);
+	}
+	return (long long)value;
+}
+
+static int
+is_transparent(struct icode_instr *ip) {
+	return ip->type == INSTR_SEQPOINT
+		|| ip->type == INSTR_DEBUG
+		|| ip->type == INSTR_DBGINFO_LINE;
+}
+
+static int
+is_cond_branch(int type) {
+	return type >= INSTR_BR_EQUAL && type <= INSTR_BR_SMALLEREQ;
+}
+
+static int
+is_unsigned_type(struct type *ty) {
+	return ty->tlist != NULL || ty->sign == TOK_KEY_UNSIGNED;
+}
+
+static int
+is_candidate(struct decl *d) {
+	struct type	*ty = d->dtype;
+	size_t		size;
+
+	if (d->stack_addr != NULL
+		|| d->invalid
+		|| d->asmname != NULL
+		|| IS_VOLATILE(ty->flags)
+		|| IS_VLA(ty->flags)) {
+		return 0;
+	}
+	if (ty->tlist != NULL) {
+		if (ty->tlist->type != TN_POINTER_TO) {
+			return 0;
+		}
+	} else if (!is_integral_type(ty)) {
+		return 0;
+	}
+	size = backend->get_sizeof_decl(d, NULL);
+	return size == 1 || size == 2 || size == 4 || size == 8;
+}
+
+static int
+compare_vars(const void *p1, const void *p2) {
+	const struct cp_var	*v1 = p1;
+	const struct cp_var	*v2 = p2;
+
+	if (v1->dec < v2->dec) {
+		return -1;
+	} else if (v1->dec > v2->dec) {
+		return 1;
+	}
+	return 0;
+}
+
+static int
+compare_labels(const void *p1, const void *p2) {
+	const struct cp_label	*l1 = p1;
+	const struct cp_label	*l2 = p2;
+
+	if (l1->label < l2->label) {
+		return -1;
+	} else if (l1->label > l2->label) {
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Collects the automatic variables of all blocks of the function, like
+ * regalloc.c does
+ */
+static void
+collect_vars(struct function *f) {
+	struct scope	*scope;
+	struct scope	*tmp;
+	int		nslots = 0;
+	int		i;
+
+	nvars = 0;
+	for (scope = f->scope; scope != NULL; scope = scope->next) {
+		struct decl	**dec;
+
+		for (tmp = scope; tmp != NULL; tmp = tmp->parent) {
+			if (tmp == f->scope) {
+				break;
+			}
+		}
+		if (tmp == NULL) {
+			break;
+		}
+		if (scope->type != SCOPE_CODE) {
+			continue;
+		}
+
+		dec = scope->automatic_decls.data;
+		for (i = 0; i < scope->automatic_decls.ndecls; ++i) {
+			if (!is_candidate(dec[i])) {
+				continue;
+			}
+			if (nvars == nslots) {
+				nslots = nslots? nslots * 2: 16;
+				vars = n_xrealloc(vars, nslots * sizeof *vars);
+			}
+			vars[nvars].dec = dec[i];
+			vars[nvars].size = backend->get_sizeof_decl(dec[i], NULL);
+			vars[nvars].bad = 0;
+			vars[nvars].loads = 0;
+			++nvars;
+		}
+	}
+	if (nvars > 0) {
+		qsort(vars, nvars, sizeof *vars, compare_vars);
+	}
+}
+
+/*
+ * Returns the index of the variable backing ``vr'', or -1 if it is not
+ * a (remaining) candidate
+ */
+static int
+lookup_var(struct vreg *vr) {
+	struct cp_var	key;
+	struct cp_var	*v;
+
+	if (vr == NULL || vr->var_backed == NULL || nvars == 0) {
+		return -1;
+	}
+	key.dec = vr->var_backed;
+	v = bsearch(&key, vars, nvars, sizeof *vars, compare_vars);
+	if (v == NULL || v->bad) {
+		return -1;
+	}
+	return v - vars;
+}
+
+static void
+mark_bad(struct vreg *vr) {
+	int	i;
+
+	if ((i = lookup_var(vr)) != -1) {
+		vars[i].bad = 1;
+	}
+}
+
+/*
+ * A variable stays a candidate only if it is accessed as a whole through
+ * a general purpose register of its own size
+ */
+static void
+check_access(struct vreg *vr, struct reg *r) {
+	int	i;
+
+	if ((i = lookup_var(vr)) == -1) {
+		return;
+	}
+	if (vr->parent != NULL
+		|| vr->from_ptr != NULL
+		|| vr->from_const != NULL
+		|| vr->is_multi_reg_obj
+		|| r == NULL
+		|| r->type != REG_GPR
+		|| r->size != vars[i].size) {
+		vars[i].bad = 1;
+	}
+}
+
+static int
+is_reg_operand_instr(int type) {
+	switch (type) {
+	case INSTR_ADD:
+	case INSTR_SUB:
+	case INSTR_MUL:
+	case INSTR_DIV:
+	case INSTR_MOD:
+	case INSTR_SHL:
+	case INSTR_SHR:
+	case INSTR_AND:
+	case INSTR_OR:
+	case INSTR_XOR:
+	case INSTR_NOT:
+	case INSTR_NEG:
+	case INSTR_CMP:
+	case INSTR_INC:
+	case INSTR_DEC:
+	case INSTR_RET:
+		return 1;
+	}
+	return 0;
+}
+
+static int
+label_block(struct icode_instr *label) {
+	struct cp_label	key;
+	struct cp_label	*l;
+
+	if (nlabels == 0) {
+		return -1;
+	}
+	key.label = label;
+	l = bsearch(&key, labels, nlabels, sizeof *labels, compare_labels);
+	return l? l->block: -1;
+}
+
+static void
+add_succ(struct cp_block *b, int succ) {
+	b->succ = n_xrealloc(b->succ, (b->nsucc + 1) * sizeof *b->succ);
+	b->succ[b->nsucc++] = succ;
+}
+
+/*
+ * Splits the instruction array into basic blocks, records the variable
+ * accesses and connects the blocks. Returns -1 if the function contains
+ * something we cannot analyze
+ */
+static int
+build_blocks(struct function *f) {
+	struct icode_instr	*ip;
+	int			slots = 0;
+	int			labslots = 0;
+	int			i;
+	int			j;
+
+	ninstrs = nblocks = nlabels = 0;
+	for (ip = f->icode->head; ip != NULL; ip = ip->next) {
+		if (ninstrs == slots) {
+			slots = slots? slots * 2: 256;
+			instrs = n_xrealloc(instrs, slots * sizeof *instrs);
+		}
+		instrs[ninstrs++] = ip;
+	}
+
+	blocks = n_xmalloc((ninstrs + 1) * sizeof *blocks);
+	for (i = 0; i < ninstrs; ++i) {
+		ip = instrs[i];
+		if (i == 0
+			|| ip->type == INSTR_LABEL
+			|| instrs[i - 1]->type == INSTR_JUMP
+			|| instrs[i - 1]->type == INSTR_RET
+			|| instrs[i - 1]->type == INSTR_SWITCH_TABLE
+			|| is_cond_branch(instrs[i - 1]->type)) {
+			if (nblocks > 0) {
+				blocks[nblocks - 1].last = i - 1;
+			}
+			blocks[nblocks].first = i;
+			blocks[nblocks].succ = NULL;
+			blocks[nblocks].nsucc = 0;
+			blocks[nblocks].executable = 0;
+			blocks[nblocks].queued = 0;
+			blocks[nblocks].in = NULL;
+			++nblocks;
+		}
+		if (ip->type == INSTR_LABEL) {
+			if (nlabels == labslots) {
+				labslots = labslots? labslots * 2: 32;
+				labels = n_xrealloc(labels,
+					labslots * sizeof *labels);
+			}
+			labels[nlabels].label = ip;
+			labels[nlabels++].block = nblocks - 1;
+		}
+
+		switch (ip->type) {
+		case INSTR_ASM:
+		case INSTR_COMP_GOTO:
+		case INSTR_LOAD_ADDRLABEL:
+			/* Anything may happen */
+			return -1;
+		case INSTR_LOAD:
+			check_access(ip->src_vreg,
+				ip->src_pregs? ip->src_pregs[0]: NULL);
+			break;
+		case INSTR_STORE:
+			/* XXX confusingly messed up order of args */
+			check_access(ip->src_vreg,
+				ip->dest_pregs? ip->dest_pregs[0]: NULL);
+			break;
+		case INSTR_WRITEBACK:
+			check_access(ip->src_vreg,
+				ip->src_pregs? ip->src_pregs[0]: NULL);
+			break;
+		case INSTR_X86_FILD:
+			mark_bad(((struct filddata *)ip->dat)->vr);
+			break;
+		case INSTR_X86_FIST:
+			mark_bad(((struct fistdata *)ip->dat)->vr);
+			break;
+		case INSTR_COPYINIT:
+			for (j = 0; j < nvars; ++j) {
+				if (vars[j].dec == ip->dat) {
+					vars[j].bad = 1;
+				}
+			}
+			break;
+		default:
+			if (is_reg_operand_instr(ip->type)) {
+				if (ip->src_pregs == NULL
+					|| ip->src_pregs[0] == NULL) {
+					mark_bad(ip->src_vreg);
+				}
+				if (ip->dest_pregs == NULL
+					|| ip->dest_pregs[0] == NULL) {
+					mark_bad(ip->dest_vreg);
+				}
+			} else if (!is_cond_branch(ip->type)) {
+				/* (dest_vreg of branches only supplies a type) */
+				mark_bad(ip->src_vreg);
+				mark_bad(ip->dest_vreg);
+			}
+		}
+	}
+	if (nblocks == 0) {
+		return -1;
+	}
+	blocks[nblocks - 1].last = ninstrs - 1;
+	if (nlabels > 0) {
+		qsort(labels, nlabels, sizeof *labels, compare_labels);
+	}
+
+	for (i = 0; i < nblocks; ++i) {
+		struct cp_block	*b = &blocks[i];
+		int		target;
+
+		ip = instrs[b->last];
+		if (ip->type == INSTR_SWITCH_TABLE) {
+			struct switch_table	*st = ip->dat;
+			size_t			k;
+
+			for (k = 0; k < st->nentries; ++k) {
+				if ((target = label_block(st->targets[k])) == -1) {
+					return -1;
+				}
+				add_succ(b, target);
+			}
+			continue;
+		}
+		if (ip->type == INSTR_RET) {
+			continue;
+		}
+		if (ip->type != INSTR_JUMP && i + 1 < nblocks) {
+			/* Fall through - always the first successor */
+			add_succ(b, i + 1);
+		}
+		if (ip->type == INSTR_JUMP || is_cond_branch(ip->type)) {
+			if ((target = label_block(ip->dat)) == -1) {
+				/* Branch to unknown place */
+				return -1;
+			}
+			add_succ(b, target);
+		}
+	}
+	return 0;
+}
+
+static int
+reg_contains(struct reg *outer, struct reg *inner) {
+	int	i;
+
+	if (outer == inner) {
+		return 1;
+	}
+	if (outer->composed_of == NULL) {
+		return 0;
+	}
+	for (i = 0; outer->composed_of[i] != NULL; ++i) {
+		if (reg_contains(outer->composed_of[i], inner)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void
+regs_forget(struct cp_regs *rs, struct reg *r) {
+	int	i;
+
+	for (i = 0; i < rs->n;) {
+		if (reg_contains(rs->regs[i], r)
+			|| reg_contains(r, rs->regs[i])) {
+			--rs->n;
+			rs->regs[i] = rs->regs[rs->n];
+			rs->values[i] = rs->values[rs->n];
+		} else {
+			++i;
+		}
+	}
+}
+
+static void
+regs_set(struct cp_regs *rs, struct reg *r, unsigned long long value) {
+	regs_forget(rs, r);
+	if (r->type != REG_GPR || rs->n == CP_MAX_REGS) {
+		return;
+	}
+	rs->regs[rs->n] = r;
+	rs->values[rs->n++] = value & size_mask(r->size);
+}
+
+/*
+ * Looks up the value of ``r''. The low part of a known register (e.g.
+ * eax of rax) is known as well
+ */
+static int
+regs_get(struct cp_regs *rs, struct reg *r, unsigned long long *value) {
+	struct reg	*sub;
+	int		i;
+
+	if (r == NULL) {
+		return 0;
+	}
+	for (i = 0; i < rs->n; ++i) {
+		for (sub = rs->regs[i]; sub != NULL;) {
+			if (sub == r) {
+				*value = rs->values[i] & size_mask(r->size);
+				return 1;
+			}
+			if (sub->composed_of == NULL
+				|| sub->composed_of[0] == NULL
+				|| sub->composed_of[1] != NULL) {
+				break;
+			}
+			sub = sub->composed_of[0];
+		}
+	}
+	return 0;
+}
+
+static int
+token_value(struct token *t, unsigned long long *value) {
+	struct tyval	tv;
+
+	/* (Immediates are never narrower than int anyway) */
+	if (t->data2 != NULL
+		|| !(IS_INT(t->type)
+		|| IS_LONG(t->type)
+		|| IS_LLONG(t->type))) {
+		return 0;
+	}
+	memset(&tv, 0, sizeof tv);
+	tv.type = make_basic_type(t->type);
+	tv.value = t->data;
+	if (is_unsigned_type(tv.type)) {
+		*value = cross_to_host_unsigned_long_long(&tv);
+	} else {
+		*value = (unsigned long long)cross_to_host_long_long(&tv);
+	}
+	return 1;
+}
+
+/*
+ * Returns the value of a static const-qualified scalar with a constant
+ * initializer
+ */
+static int
+static_const_value(struct vreg *vr, unsigned long long *value) {
+	struct decl	*d = vr->var_backed;
+	struct expr	*ex;
+	struct tyval	tv;
+
+	if (d == NULL
+		|| vr->parent != NULL
+		|| vr->from_ptr != NULL
+		|| d->dtype->storage != TOK_KEY_STATIC
+		|| !IS_CONST(d->dtype->flags)
+		|| IS_VOLATILE(d->dtype->flags)
+		|| d->dtype->tlist != NULL
+		|| !(IS_INT(d->dtype->code)
+		|| IS_LONG(d->dtype->code)
+		|| IS_LLONG(d->dtype->code))
+		|| d->init == NULL
+		|| d->init->type != INIT_EXPR
+		|| d->init->next != NULL) {
+		return 0;
+	}
+	ex = d->init->data;
+	if (ex->const_value == NULL
+		|| ex->const_value->str != NULL
+		|| ex->const_value->address != NULL) {
+		return 0;
+	}
+
+	/* The value has already been converted to the declared type */
+	memset(&tv, 0, sizeof tv);
+	tv.type = d->dtype;
+	tv.value = ex->const_value->value;
+	if (is_unsigned_type(d->dtype)) {
+		*value = cross_to_host_unsigned_long_long(&tv);
+	} else {
+		*value = (unsigned long long)cross_to_host_long_long(&tv);
+	}
+	return 1;
+}
+
+/*
+ * Returns the value of the source operand of an arithmetic or compare
+ * instruction, which is a register, an immediate or a memory operand
+ */
+static int
+src_value(struct cp_regs *rs, struct icode_instr *ip,
+	unsigned long long *value) {
+
+	/*
+	 * 10/17/26: Constants come first because a constant multiplier or
+	 * divisor may be mapped to a scratch register without having been
+	 * loaded into it (see icode_prepare_op() in x86_gen.c)
+	 */
+	if (ip->src_vreg != NULL
+		&& !ip->src_vreg->is_multi_reg_obj
+		&& ip->src_vreg->from_const != NULL
+		&& token_value(ip->src_vreg->from_const, value)) {
+		return 1;
+	}
+	if (ip->src_pregs != NULL && ip->src_pregs[0] != NULL) {
+		return regs_get(rs, ip->src_pregs[0], value);
+	}
+	if (ip->src_vreg == NULL || ip->src_vreg->is_multi_reg_obj) {
+		return 0;
+	}
+	return static_const_value(ip->src_vreg, value);
+}
+
+static int
+fold_arith(int op, unsigned long long a, unsigned long long b,
+	size_t size, int is_unsigned, unsigned long long *res) {
+
+	long long	sa = sign_extend(a, size);
+	long long	sb = sign_extend(b, size);
+
+	a &= size_mask(size);
+	b &= size_mask(size);
+	switch (op) {
+	case INSTR_ADD:
+		*res = a + b;
+		break;
+	case INSTR_SUB:
+		*res = a - b;
+		break;
+	case INSTR_MUL:
+		*res = a * b;
+		break;
+	case INSTR_DIV:
+	case INSTR_MOD:
+		if (b == 0) {
+			return 0;
+		}
+		if (is_unsigned) {
+			*res = op == INSTR_DIV? a / b: a % b;
+		} else {
+			if (sb == -1 && sa == sign_extend(
+				1ULL << (size * 8 - 1), size)) {
+				/* Overflow */
+				return 0;
+			}
+			*res = (unsigned long long)(op == INSTR_DIV?
+				sa / sb: sa % sb);
+		}
+		break;
+	case INSTR_SHL:
+	case INSTR_SHR:
+		if (b >= size * 8) {
+			return 0;
+		}
+		if (op == INSTR_SHL) {
+			*res = a << b;
+		} else if (is_unsigned) {
+			*res = a >> b;
+		} else if (sa < 0) {
+			/* Don't rely on the host's signed shift */
+			*res = ~(~(unsigned long long)sa >> b);
+		} else {
+			*res = (unsigned long long)sa >> b;
+		}
+		break;
+	case INSTR_AND:
+		*res = a & b;
+		break;
+	case INSTR_OR:
+		*res = a | b;
+		break;
+	case INSTR_XOR:
+		*res = a ^ b;
+		break;
+	default:
+		return 0;
+	}
+	*res &= size_mask(size);
+	return 1;
+}
+
+static int
+fold_compare(int btype, unsigned long long a, unsigned long long b,
+	size_t size, int is_unsigned) {
+
+	long long	sa = sign_extend(a, size);
+	long long	sb = sign_extend(b, size);
+
+	a &= size_mask(size);
+	b &= size_mask(size);
+	switch (btype) {
+	case INSTR_BR_EQUAL:
+		return a == b;
+	case INSTR_BR_NEQUAL:
+		return a != b;
+	case INSTR_BR_GREATER:
+		return is_unsigned? a > b: sa > sb;
+	case INSTR_BR_SMALLER:
+		return is_unsigned? a < b: sa < sb;
+	case INSTR_BR_GREATEREQ:
+		return is_unsigned? a >= b: sa >= sb;
+	case INSTR_BR_SMALLEREQ:
+		return is_unsigned? a <= b: sa <= sb;
+	}
+	return 0;
+}
+
+static struct vreg *
+make_const_vreg(int code, long long value) {
+	struct token	*tok;
+
+	tok = alloc_token();
+	tok->type = code;
+	tok->data = zalloc_buf(Z_CEXPR_BUF);
+	cross_to_type_from_host_long_long(tok->data, code, value);
+	return vreg_alloc(NULL, tok, NULL, NULL);
+}
+
+/*
+ * Turns ``ip'' into an immediate load of ``value'' into ``r''. Only
+ * values which every backend can load with one instruction are used
+ */
+static void
+make_const_load(struct icode_instr *ip, struct reg *r,
+	unsigned long long value) {
+
+	long long	sv = sign_extend(value, r->size);
+	int		code;
+
+	if (backend->get_sizeof_type(make_basic_type(TY_INT), NULL)
+		== r->size) {
+		code = TY_INT;
+	} else if (backend->get_sizeof_type(make_basic_type(TY_LONG), NULL)
+		== r->size) {
+		code = TY_LONG;
+	} else {
+		return;
+	}
+	if (sv < -0x7fffffffL - 1 || sv > 0x7fffffffL) {
+		return;
+	}
+
+	ip->type = INSTR_LOAD;
+	ip->src_vreg = make_const_vreg(code, sv);
+	ip->src_pregs = make_icode_pregs(NULL, r);
+	ip->dest_vreg = NULL;
+	ip->dest_pregs = NULL;
+	ip->memref = NULL;
+	ip->dat = NULL;
+	ip->hints = 0;
+}
+
+/*
+ * Turns a multiplication, unsigned division or unsigned modulo by a
+ * power of two ``value'' into the shift or mask the front end would
+ * have generated if the operand had been a constant there (see
+ * can_transform_to_bitwise() in icode.c). The register the operand
+ * was loaded into is no longer used, so the load may become dead
+ */
+static void
+strength_reduce(struct icode_instr *ip, unsigned long long value,
+	size_t size) {
+
+	int	k;
+	int	op;
+	int	newtype;
+
+	value &= size_mask(size);
+	if (value < 2 || (value & (value - 1)) != 0) {
+		return;
+	}
+	for (k = 0; (value >> k) != 1; ++k) {
+		;
+	}
+	if (ip->type == INSTR_MUL) {
+		op = TOK_OP_BSHL;
+		newtype = INSTR_SHL;
+	} else if (!is_unsigned_type(ip->dest_vreg->type) || k > 30) {
+		return;
+	} else if (ip->type == INSTR_DIV) {
+		op = TOK_OP_BSHR;
+		newtype = INSTR_SHR;
+	} else {
+		op = TOK_OP_BAND;
+		newtype = INSTR_AND;
+	}
+	if (!backend->have_immediate_op(ip->dest_vreg->type, op)) {
+		return;
+	}
+	ip->type = newtype;
+	ip->src_vreg = make_const_vreg(TY_INT, newtype == INSTR_AND?
+		(long long)value - 1: k);
+	ip->src_pregs = make_icode_pregs(NULL, NULL);
+	ip->memref = NULL;
+}
+
+static int
+is_gpr_operation(struct icode_instr *ip, struct reg *r) {
+	if (r == NULL || r->type != REG_GPR) {
+		return 0;
+	}
+	if (ip->dest_vreg != NULL
+		&& (ip->dest_vreg->is_multi_reg_obj
+		|| is_floating_type(ip->dest_vreg->type))) {
+		return 0;
+	}
+	if (ip->src_vreg != NULL
+		&& (ip->src_vreg->is_multi_reg_obj
+		|| is_floating_type(ip->src_vreg->type))) {
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * Interprets the instructions of block ``b'' given the variable values
+ * ``vals'' at block entry, which are updated to those at block exit. If
+ * ``rewrite'' is set, instructions with known results are replaced.
+ * Returns 1 or 0 if the block ends with a conditional branch which is
+ * always or never taken, -1 otherwise
+ */
+static int
+interpret_block(struct cp_block *b, struct cp_val *vals, int rewrite) {
+	struct cp_regs		rs;
+	struct icode_instr	*ip;
+	struct icode_instr	*prev = NULL;
+	struct icode_instr	*cmp = NULL;
+	struct reg		*r;
+	unsigned long long	a;
+	unsigned long long	v;
+	unsigned long long	cmp_a = 0;
+	unsigned long long	cmp_b = 0;
+	size_t			cmp_size = 0;
+	int			cmp_pos = 0;
+	int			outcome = -1;
+	int			known;
+	int			src_known;
+	int			i;
+	int			idx;
+
+	rs.n = 0;
+	for (i = b->first; i <= b->last; ++i) {
+		ip = instrs[i];
+		if (dead[i] || is_transparent(ip)) {
+			continue;
+		}
+
+		switch (ip->type) {
+		case INSTR_LABEL:
+		case INSTR_JUMP:
+		case INSTR_RET:
+			break;
+		case INSTR_LOAD:
+			r = ip->src_pregs? ip->src_pregs[0]: NULL;
+			if (ip->dat != NULL
+				|| r == NULL
+				|| r->type != REG_GPR
+				|| ip->src_vreg->is_multi_reg_obj) {
+				/* May use a support register */
+				rs.n = 0;
+				break;
+			}
+			known = 0;
+			if ((idx = lookup_var(ip->src_vreg)) != -1) {
+				if (vals[idx].state == CP_CONST) {
+					v = vals[idx].value;
+					known = 1;
+				}
+			} else if (ip->src_vreg->from_const != NULL) {
+				known = ip->src_vreg->size == r->size
+					&& token_value(ip->src_vreg->from_const,
+					&v);
+			} else if (ip->src_vreg->size == r->size) {
+				known = static_const_value(ip->src_vreg, &v);
+			}
+			if (known) {
+				regs_set(&rs, r, v);
+				if (rewrite && ip->src_vreg->from_const == NULL) {
+					make_const_load(ip, r, v);
+				}
+			} else {
+				regs_forget(&rs, r);
+			}
+			break;
+		case INSTR_STORE:
+		case INSTR_WRITEBACK:
+			if (ip->type == INSTR_STORE) {
+				r = ip->dest_pregs? ip->dest_pregs[0]: NULL;
+			} else {
+				r = ip->src_pregs? ip->src_pregs[0]: NULL;
+			}
+			if ((idx = lookup_var(ip->src_vreg)) != -1) {
+				if (regs_get(&rs, r, &v)) {
+					vals[idx].state = CP_CONST;
+					vals[idx].value = v & size_mask(
+						vars[idx].size);
+				} else {
+					vals[idx].state = CP_BOTTOM;
+				}
+			}
+			if (ip->dat != NULL) {
+				rs.n = 0;
+			}
+			break;
+		case INSTR_MOV: {
+			struct copyreg	*cr = ip->dat;
+
+			if (cr->dest_preg == NULL) {
+				rs.n = 0;
+			} else if (cr->src_preg != NULL
+				&& cr->src_preg->size == cr->dest_preg->size
+				&& regs_get(&rs, cr->src_preg, &v)) {
+				regs_set(&rs, cr->dest_preg, v);
+			} else {
+				regs_forget(&rs, cr->dest_preg);
+			}
+			break;
+		}
+		case INSTR_SETREG:
+			r = ip->src_pregs[0];
+			regs_set(&rs, r, (unsigned long long)
+				sign_extend((unsigned)*(int *)ip->dat,
+				sizeof(int)));
+			break;
+		case INSTR_ADD:
+		case INSTR_SUB:
+		case INSTR_MUL:
+		case INSTR_DIV:
+		case INSTR_MOD:
+		case INSTR_SHL:
+		case INSTR_SHR:
+		case INSTR_AND:
+		case INSTR_OR:
+		case INSTR_XOR:
+			r = ip->dest_pregs? ip->dest_pregs[0]: NULL;
+			if (!is_gpr_operation(ip, r)
+				|| ip->dest_vreg == NULL
+				|| ip->src_vreg == NULL) {
+				rs.n = 0;
+				break;
+			}
+			known = regs_get(&rs, r, &a);
+			src_known = src_value(&rs, ip, &v)
+				&& (ip->type == INSTR_SHL || ip->type == INSTR_SHR
+				|| is_unsigned_type(ip->dest_vreg->type)
+				== is_unsigned_type(ip->src_vreg->type));
+			known = known && src_known
+				&& fold_arith(ip->type, a, v, r->size,
+				is_unsigned_type(ip->dest_vreg->type), &a)
+				/* Not scaled index add (see ptrarit()) */
+				&& (ip->type != INSTR_ADD || ip->dat == NULL);
+			if (ip->type == INSTR_MUL
+				|| ip->type == INSTR_DIV
+				|| ip->type == INSTR_MOD) {
+				/* May use fixed registers (x86 edx:eax) */
+				rs.n = 0;
+				if (!known && src_known && rewrite
+					&& ip->src_vreg->from_const == NULL) {
+					strength_reduce(ip, v, r->size);
+				}
+			}
+			if (known) {
+				regs_set(&rs, r, a);
+				if (rewrite) {
+					make_const_load(ip, r, a);
+				}
+			} else {
+				regs_forget(&rs, r);
+			}
+			break;
+		case INSTR_NOT:
+		case INSTR_NEG:
+		case INSTR_INC:
+		case INSTR_DEC:
+			r = ip->src_pregs? ip->src_pregs[0]: NULL;
+			if (r == NULL) {
+				/* Memory operand - not a candidate */
+				break;
+			}
+			if (!is_gpr_operation(ip, r)) {
+				rs.n = 0;
+				break;
+			}
+			if (regs_get(&rs, r, &v)) {
+				switch (ip->type) {
+				case INSTR_NOT:	v = ~v; break;
+				case INSTR_NEG:	v = -v; break;
+				case INSTR_INC:	++v; break;
+				default:	--v;
+				}
+				regs_set(&rs, r, v);
+				if (rewrite) {
+					make_const_load(ip, r, v & size_mask(
+						r->size));
+				}
+			} else {
+				regs_forget(&rs, r);
+			}
+			break;
+		case INSTR_CMP:
+			r = ip->dest_pregs? ip->dest_pregs[0]: NULL;
+			cmp = NULL;
+			if (!is_gpr_operation(ip, r)
+				|| !regs_get(&rs, r, &cmp_a)) {
+				break;
+			}
+			if (ip->src_pregs == NULL || ip->src_vreg == NULL) {
+				/* Compare with zero */
+				cmp_b = 0;
+			} else if (!src_value(&rs, ip, &cmp_b)) {
+				break;
+			}
+			cmp = ip;
+			cmp_pos = i;
+			cmp_size = r->size;
+			break;
+		default:
+			if (is_cond_branch(ip->type)) {
+				struct icode_instr	*next;
+				int			j;
+
+				if (prev != cmp
+					|| cmp == NULL
+					|| (ip->dest_vreg != NULL
+					&& is_floating_type(
+						ip->dest_vreg->type))) {
+					break;
+				}
+
+				/* The flags must not be used again */
+				for (j = i + 1; j < ninstrs; ++j) {
+					if (!is_transparent(instrs[j])) {
+						break;
+					}
+				}
+				next = j < ninstrs? instrs[j]: NULL;
+				if (next != NULL && is_cond_branch(next->type)) {
+					break;
+				}
+
+				outcome = fold_compare(ip->type, cmp_a, cmp_b,
+					cmp_size, ip->dest_vreg != NULL
+					&& is_unsigned_type(ip->dest_vreg->type));
+				if (rewrite) {
+					/*
+					 * The compare is no longer needed, and
+					 * the branch becomes a jump or vanishes
+					 */
+					dead[cmp_pos] = 1;
+					if (outcome) {
+						ip->type = INSTR_JUMP;
+						ip->dest_vreg = NULL;
+						ip->src_vreg = NULL;
+					} else {
+						dead[i] = 1;
+					}
+				}
+				break;
+			}
+			/* Unknown register effects (calls, conversions, ...) */
+			rs.n = 0;
+		}
+		prev = ip;
+	}
+	return outcome;
+}
+
+/*
+ * Merges the values ``vals'' at the end of a block into the entry values
+ * of its successor ``b''. Returns 1 if those have changed
+ */
+static int
+meet(struct cp_block *b, struct cp_val *vals) {
+	int	changed = 0;
+	int	i;
+
+	for (i = 0; i < nvars; ++i) {
+		struct cp_val	*in = &b->in[i];
+
+		if (in->state == CP_BOTTOM || vals[i].state == CP_TOP) {
+			continue;
+		}
+		if (vals[i].state == CP_BOTTOM) {
+			in->state = CP_BOTTOM;
+			changed = 1;
+		} else if (in->state == CP_TOP) {
+			*in = vals[i];
+			changed = 1;
+		} else if (in->value != vals[i].value) {
+			in->state = CP_BOTTOM;
+			changed = 1;
+		}
+	}
+	return changed;
+}
+
+/*
+ * Returns the successors of ``b'' which may be taken given the branch
+ * outcome ``outcome'' (see interpret_block()) in ``*from'' and ``*to''
+ */
+static void
+live_succ(struct cp_block *b, int outcome, int *from, int *to) {
+	*from = 0;
+	*to = b->nsucc;
+	if (outcome == -1 || !is_cond_branch(instrs[b->last]->type)) {
+		return;
+	}
+	if (outcome) {
+		/* The branch target is always the last successor */
+		*from = b->nsucc - 1;
+	} else if (b->nsucc == 2) {
+		*to = 1;
+	} else {
+		/* Branch at end of function never taken */
+		*to = 0;
+	}
+}
+
+/*
+ * Instructions which can be removed from unreachable code without
+ * upsetting the bookkeeping of the backend
+ */
+static int
+is_removable(struct icode_instr *ip) {
+	switch (ip->type) {
+	case INSTR_LOAD:
+	case INSTR_STORE:
+	case INSTR_WRITEBACK:
+		return ip->dat == NULL;
+	case INSTR_MOV:
+	case INSTR_SETREG:
+	case INSTR_ADD:
+	case INSTR_SUB:
+	case INSTR_MUL:
+	case INSTR_DIV:
+	case INSTR_MOD:
+	case INSTR_SHL:
+	case INSTR_SHR:
+	case INSTR_AND:
+	case INSTR_OR:
+	case INSTR_XOR:
+	case INSTR_NOT:
+	case INSTR_NEG:
+	case INSTR_INC:
+	case INSTR_DEC:
+	case INSTR_CMP:
+	case INSTR_JUMP:
+	case INSTR_SEQPOINT:
+	case INSTR_CALL:
+	case INSTR_CALLINDIR:
+	case INSTR_ADDROF:
+		return 1;
+	case INSTR_FREESTACK:
+		/*
+		 * Pushes and stack adjustments must stay balanced because
+		 * the emitter keeps track of them, but freeing nothing is
+		 * harmless (and no freeing at all is the function outro)
+		 */
+		return ip->dat != NULL && *(size_t *)ip->dat == 0;
+	}
+	return is_cond_branch(ip->type);
+}
+
+/*
+ * Registers which occur in the function, for the liveness analysis
+ * which removes immediate loads whose value is never used; These are
+ * left behind e.g. by the operands of folded compares and by strength
+ * reduced multiplications
+ */
+static struct reg	**univ;
+static int		nuniv;
+static struct function	*curfn;
+
+static void
+add_univ(struct reg *r) {
+	int	i;
+
+	if (r == NULL || r->type != REG_GPR) {
+		return;
+	}
+	for (i = 0; i < nuniv; ++i) {
+		if (univ[i] == r) {
+			return;
+		}
+	}
+	if ((nuniv & 15) == 0) {
+		univ = n_xrealloc(univ, (nuniv + 16) * sizeof *univ);
+	}
+	univ[nuniv++] = r;
+}
+
+static void
+collect_univ(void) {
+	struct icode_instr	*ip;
+	int			i;
+
+	nuniv = 0;
+	for (i = 0; i < ninstrs; ++i) {
+		ip = instrs[i];
+		if (dead[i]) {
+			continue;
+		}
+		if (ip->dest_pregs != NULL) {
+			add_univ(ip->dest_pregs[0]);
+			if (ip->dest_pregs[0] != NULL) {
+				add_univ(ip->dest_pregs[1]);
+			}
+		}
+		if (ip->src_pregs != NULL) {
+			add_univ(ip->src_pregs[0]);
+			if (ip->src_pregs[0] != NULL) {
+				add_univ(ip->src_pregs[1]);
+			}
+		}
+		if (ip->type == INSTR_MOV) {
+			struct copyreg	*cr = ip->dat;
+
+			add_univ(cr->src_preg);
+			add_univ(cr->dest_preg);
+		}
+	}
+}
+
+static int
+is_simple_operand(struct vreg *vr) {
+	return vr == NULL
+		|| (!vr->is_multi_reg_obj
+		&& vr->from_ptr == NULL
+		&& vr->parent == NULL);
+}
+
+/*
+ * Records the registers which ``ip'' reads in ``use'' and the one it
+ * overwrites in ``*def''. Returns -1 if it may read any register
+ */
+static int
+reg_effects(struct icode_instr *ip, struct reg **use, int *nuse,
+	struct reg **def) {
+
+	struct reg	*r;
+
+	*nuse = 0;
+	*def = NULL;
+	if (is_transparent(ip)
+		|| ip->type == INSTR_LABEL
+		|| ip->type == INSTR_JUMP
+		|| is_cond_branch(ip->type)) {
+		return 0;
+	}
+	if (ip->memref != NULL
+		|| !is_simple_operand(ip->src_vreg)
+		|| !is_simple_operand(ip->dest_vreg)) {
+		return -1;
+	}
+
+	switch (ip->type) {
+	case INSTR_LOAD:
+		r = ip->src_pregs? ip->src_pregs[0]: NULL;
+		if (ip->dat != NULL || r == NULL || r->type != REG_GPR) {
+			return -1;
+		}
+		*def = r;
+		return 0;
+	case INSTR_STORE:
+	case INSTR_WRITEBACK:
+		if (ip->type == INSTR_STORE) {
+			r = ip->dest_pregs? ip->dest_pregs[0]: NULL;
+		} else {
+			r = ip->src_pregs? ip->src_pregs[0]: NULL;
+		}
+		if (ip->dat != NULL || r == NULL || r->type != REG_GPR) {
+			return -1;
+		}
+		use[(*nuse)++] = r;
+		return 0;
+	case INSTR_MOV: {
+		struct copyreg	*cr = ip->dat;
+
+		if (cr->src_preg == NULL
+			|| cr->dest_preg == NULL
+			|| cr->src_preg->type != REG_GPR
+			|| cr->dest_preg->type != REG_GPR) {
+			return -1;
+		}
+		use[(*nuse)++] = cr->src_preg;
+		*def = cr->dest_preg;
+		return 0;
+	}
+	case INSTR_SETREG:
+		*def = ip->src_pregs[0];
+		return 0;
+	case INSTR_RET:
+		/*
+		 * Callee-saved registers are restored by the outro, so
+		 * only the return value register is read
+		 */
+		if (curfn->rettype->code == TY_VOID
+			&& curfn->rettype->tlist == NULL) {
+			return 0;
+		}
+		if ((backend->arch == ARCH_X86 || backend->arch == ARCH_AMD64)
+			&& (is_integral_type(curfn->rettype)
+			|| curfn->rettype->tlist != NULL)
+			&& backend->get_sizeof_type(curfn->rettype, NULL)
+			<= (size_t)backend->get_ptr_size()) {
+			use[(*nuse)++] = backend->get_abi_ret_reg(
+				curfn->rettype);
+			return 0;
+		}
+		return -1;
+	case INSTR_ADD:
+	case INSTR_SUB:
+	case INSTR_SHL:
+	case INSTR_SHR:
+	case INSTR_AND:
+	case INSTR_OR:
+	case INSTR_XOR:
+	case INSTR_CMP:
+		r = ip->dest_pregs? ip->dest_pregs[0]: NULL;
+		if (!is_gpr_operation(ip, r)
+			|| (ip->type == INSTR_ADD && ip->dat != NULL)) {
+			return -1;
+		}
+		use[(*nuse)++] = r;
+		if (ip->src_pregs != NULL && ip->src_pregs[0] != NULL) {
+			use[(*nuse)++] = ip->src_pregs[0];
+		}
+		return 0;
+	case INSTR_NOT:
+	case INSTR_NEG:
+	case INSTR_INC:
+	case INSTR_DEC:
+		r = ip->src_pregs? ip->src_pregs[0]: NULL;
+		if (r != NULL) {
+			if (!is_gpr_operation(ip, r)) {
+				return -1;
+			}
+			use[(*nuse)++] = r;
+		}
+		return 0;
+	}
+	/* Calls, returns, fixed register operations, ... */
+	return -1;
+}
+
+/*
+ * Applies the effects of ``ip'' to the set of registers ``live'' which
+ * are live after it, such that it contains those live before it
+ */
+static void
+live_step(struct icode_instr *ip, char *live) {
+	struct reg	*use[2];
+	struct reg	*def;
+	int		nuse;
+	int		i;
+	int		j;
+
+	if (reg_effects(ip, use, &nuse, &def) == -1) {
+		memset(live, 1, nuniv);
+		return;
+	}
+	if (def != NULL) {
+		for (i = 0; i < nuniv; ++i) {
+			if (reg_contains(def, univ[i])) {
+				live[i] = 0;
+			}
+		}
+	}
+	for (j = 0; j < nuse; ++j) {
+		for (i = 0; i < nuniv; ++i) {
+			if (reg_contains(use[j], univ[i])
+				|| reg_contains(univ[i], use[j])) {
+				live[i] = 1;
+			}
+		}
+	}
+}
+
+static int
+is_live(char *live, struct reg *r) {
+	int	i;
+
+	for (i = 0; i < nuniv; ++i) {
+		if (live[i]
+			&& (reg_contains(r, univ[i])
+			|| reg_contains(univ[i], r))) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Sets ``live'' to the registers which are live at the end of block
+ * ``b'', i.e. at the start of any of its reachable successors. All of
+ * them are at the end of a function without return instruction
+ */
+static void
+live_out(struct cp_block *b, char *live_in, char *live) {
+	int	i;
+	int	j;
+
+	memset(live, b->nsucc == 0 && instrs[b->last]->type != INSTR_RET,
+		nuniv);
+	for (i = 0; i < b->nsucc; ++i) {
+		if (!blocks[b->succ[i]].executable) {
+			continue;
+		}
+		for (j = 0; j < nuniv; ++j) {
+			live[j] |= live_in[b->succ[i] * nuniv + j];
+		}
+	}
+}
+
+/*
+ * Computes the live-in sets of all blocks, then walks every block
+ * backwards and removes the immediate loads of registers which are not
+ * live after them
+ */
+static void
+remove_dead_loads(struct function *f) {
+	char	*live_in;
+	char	*live;
+	int	changed;
+	int	i;
+	int	j;
+
+	curfn = f;
+	collect_univ();
+	if (nuniv == 0) {
+		return;
+	}
+	live_in = n_xmalloc(nblocks * nuniv);
+	memset(live_in, 0, nblocks * nuniv);
+	live = n_xmalloc(nuniv);
+
+	do {
+		changed = 0;
+		for (i = nblocks - 1; i >= 0; --i) {
+			struct cp_block	*b = &blocks[i];
+
+			live_out(b, live_in, live);
+			for (j = b->last; j >= b->first; --j) {
+				if (!dead[j]) {
+					live_step(instrs[j], live);
+				}
+			}
+			if (memcmp(live, &live_in[i * nuniv], nuniv) != 0) {
+				memcpy(&live_in[i * nuniv], live, nuniv);
+				changed = 1;
+			}
+		}
+	} while (changed);
+
+	for (i = 0; i < nblocks; ++i) {
+		struct cp_block	*b = &blocks[i];
+
+		live_out(b, live_in, live);
+		for (j = b->last; j >= b->first; --j) {
+			struct icode_instr	*ip = instrs[j];
+
+			if (dead[j]) {
+				continue;
+			}
+			if (ip->type == INSTR_LOAD
+				&& ip->dat == NULL
+				&& ip->memref == NULL
+				&& ip->src_vreg->from_const != NULL
+				&& !ip->src_vreg->is_multi_reg_obj
+				&& ip->src_pregs != NULL
+				&& ip->src_pregs[0] != NULL
+				&& ip->src_pregs[0]->type == REG_GPR
+				&& !is_live(live, ip->src_pregs[0])) {
+				dead[j] = 1;
+				continue;
+			}
+			live_step(ip, live);
+		}
+	}
+	free(live);
+	free(live_in);
+}
+
+static void
+free_blocks(void) {
+	int	i;
+
+	for (i = 0; i < nblocks; ++i) {
+		free(blocks[i].succ);
+		free(blocks[i].in);
+	}
+	free(blocks);
+	blocks = NULL;
+	nblocks = 0;
+}
+
+void
+constprop_optimize(struct function *f) {
+	struct icode_instr	*ip;
+	struct icode_instr	*prev;
+	struct cp_val		*vals;
+	int			*worklist;
+	int			nwork;
+	int			from;
+	int			to;
+	int			i;
+	int			j;
+
+	if (f->icode == NULL || f->icode->head == NULL) {
+		return;
+	}
+	collect_vars(f);
+	if (build_blocks(f) != 0
+		|| (long)nblocks * (nvars + 1) > CP_MAX_STATES) {
+		free_blocks();
+		return;
+	}
+
+	dead = n_xmalloc(ninstrs);
+	memset(dead, 0, ninstrs);
+	for (i = 0; i < nblocks; ++i) {
+		blocks[i].in = n_xmalloc((nvars + 1) * sizeof *blocks[i].in);
+		for (j = 0; j < nvars; ++j) {
+			blocks[i].in[j].state = CP_TOP;
+			blocks[i].in[j].value = 0;
+		}
+	}
+	vals = n_xmalloc((nvars + 1) * sizeof *vals);
+	worklist = n_xmalloc(nblocks * sizeof *worklist);
+
+	/* Nothing is known about the variables at function entry */
+	for (j = 0; j < nvars; ++j) {
+		blocks[0].in[j].state = CP_BOTTOM;
+	}
+	blocks[0].executable = blocks[0].queued = 1;
+	worklist[0] = 0;
+	nwork = 1;
+
+	while (nwork > 0) {
+		struct cp_block	*b = &blocks[worklist[--nwork]];
+		int		outcome;
+
+		b->queued = 0;
+		memcpy(vals, b->in, nvars * sizeof *vals);
+		outcome = interpret_block(b, vals, 0);
+		live_succ(b, outcome, &from, &to);
+		for (i = from; i < to; ++i) {
+			struct cp_block	*s = &blocks[b->succ[i]];
+
+			if ((meet(s, vals) || !s->executable) && !s->queued) {
+				s->executable = s->queued = 1;
+				worklist[nwork++] = b->succ[i];
+			}
+		}
+	}
+
+	/*
+	 * Rewrite reachable code with the final entry values and remove
+	 * unreachable code
+	 */
+	for (i = 0; i < nblocks; ++i) {
+		struct cp_block	*b = &blocks[i];
+
+		if (b->executable) {
+			memcpy(vals, b->in, nvars * sizeof *vals);
+			(void) interpret_block(b, vals, 1);
+			continue;
+		}
+		for (j = b->first; j <= b->last; ++j) {
+			if (is_removable(instrs[j])) {
+				dead[j] = 1;
+			}
+		}
+	}
+
+	/*
+	 * Stores to variables which are never loaded anymore are useless
+	 */
+	for (i = 0; i < ninstrs; ++i) {
+		ip = instrs[i];
+		if (!dead[i]
+			&& ip->type == INSTR_LOAD
+			&& (j = lookup_var(ip->src_vreg)) != -1) {
+			++vars[j].loads;
+		}
+	}
+	for (i = 0; i < ninstrs; ++i) {
+		ip = instrs[i];
+		if ((ip->type == INSTR_STORE || ip->type == INSTR_WRITEBACK)
+			&& ip->dat == NULL
+			&& (j = lookup_var(ip->src_vreg)) != -1
+			&& vars[j].loads == 0) {
+			dead[i] = 1;
+		}
+	}
+
+	remove_dead_loads(f);
+
+	for (i = 0, prev = NULL; i < ninstrs; ++i) {
+		if (dead[i]) {
+			continue;
+		}
+		if (prev == NULL) {
+			f->icode->head = instrs[i];
+		} else {
+			prev->next = instrs[i];
+		}
+		prev = instrs[i];
+	}
+	if (prev != NULL) {
+		prev->next = NULL;
+		f->icode->tail = prev;
+	}
+	/*
+	 * (Everything dead leaves the list unchanged, which is still
+	 * correct since folded branches keep their compare then)
+	 */
+
+	free(worklist);
+	free(vals);
+	free(dead);
+	dead = NULL;
+	free_blocks();
+}
@@ -280,6 +280,7 @@ parse_ctrl(struct control *parent, struct token **tok, int putscope, int *compou
 		 * to do { } while, and could perhaps be solved better
 		 */
 		cont->putscope = putscope;
+		cont->scope = curscope;
 	}
 	cont->tok = *tok;
 
@@ -308,7 +309,7 @@ parse_ctrl(struct control *parent, struct token **tok, int putscope, int *compou
 		if (expect_token(&t, TOK_PAREN_OPEN, 1) != 0) {
 			goto fail;
 		}
-		free(t->prev);
+		free_token(t->prev);
 		ex = parse_expr(&t, TOK_PAREN_CLOSE, 0, 0, 1);
 		if (is_dowhile) {
 			/* End of do ... while */
@@ -342,7 +343,7 @@ parse_ctrl(struct control *parent, struct token **tok, int putscope, int *compou
 		if (expect_token(&t, TOK_PAREN_OPEN, 1) != 0) {
 			goto fail;
 		}
-		free(t->prev);
+		free_token(t->prev);
 		
 		/*
 		 * 11/28/07: C99 style extended for statements
@@ -397,13 +398,13 @@ parse_ctrl(struct control *parent, struct token **tok, int putscope, int *compou
 			cont->dfinit = NULL;
 		}
 
-		free(t->prev);
+		free_token(t->prev);
 		cont->cond = parse_expr(&t, TOK_SEMICOLON, 0, 0, 1);
 		if (cont->cond == NULL
 			|| next_token(&t) != 0) {
 			goto fail;
 		}
-		free(t->prev);
+		free_token(t->prev);
 		if (t->type != TOK_PAREN_CLOSE) {
 			cont->fcont = parse_expr(&t, TOK_PAREN_CLOSE, 0, 0, 1);
 			cont->fcont_label = icode_make_label(NULL);
@@ -448,7 +449,7 @@ parse_ctrl(struct control *parent, struct token **tok, int putscope, int *compou
 		if (expect_token(&t, TOK_PAREN_OPEN, 1) != 0) {
 			goto fail;
 		}
-		free(t->prev);
+		free_token(t->prev);
 		cont->cond = parse_expr(&t, TOK_PAREN_CLOSE, 0, 0, 1);
 		cont->endlabel = icode_make_label(NULL);
 		if (putscope) put_ctrl_scope(cont);
@@ -474,7 +475,7 @@ parse_ctrl(struct control *parent, struct token **tok, int putscope, int *compou
 		if (expect_token(&t, TOK_PAREN_OPEN, 1) != 0) {
 			goto fail;
 		}
-		free(t->prev);
+		free_token(t->prev);
 		cont->cond = parse_expr(&t, TOK_PAREN_CLOSE, 0, 0, 1);
 		cont->endlabel = icode_make_label(NULL);
 		if (putscope) put_ctrl_scope(cont);
@@ -118,6 +118,12 @@ struct control {
 
 	struct control	*parent; /* parent control structure, if any */
 
+	/*
+	 * 10/17/26: Scope the statement appears in, used to find the
+	 * VLAs which break and continue leave
+	 */
+	struct scope	*scope;
+
 	struct control	*prev; /* `if' if this is `else' */
 
 	struct control	*next; /* `else' if this is `if' */
@@ -13,6 +13,7 @@
 #include "standards.h"
 #include "system.h"
 #include "preprocess.h"
+#include "pch.h"
 
 static struct include_dir	*includes_tail = NULL;
 
@@ -135,7 +136,8 @@ main(int argc, char **argv) {
 		{ 0, "dM", 0 },
 		{ 0, "nostdinc", 0 },
 		{ 0, "fsigned-char", 0 },
-		{ 0, "funsigned-char", 0 }
+		{ 0, "funsigned-char", 0 },
+		{ 0, "pch-dir", 1 }
 	};
 	int			n_opts = sizeof options / sizeof options[0];
 	int			ch;
@@ -217,6 +219,10 @@ static struct input_file	nullinput;
 				} else if (strcmp(options[idx].name, "sys")
 					== 0) {
 					sys_str = n_xstrdup(n_optarg);
+				} else if (strcmp(options[idx].name, "pch-dir")
+					== 0) {
+					/* 10/17/26: Cache header prefixes */
+					pch_dir = n_xstrdup(n_optarg);
 				} else if (strcmp(options[idx].name, "nostdinc")
 					== 0) {	
 					nostdincflag = 1;
@@ -493,7 +499,7 @@ static struct input_file	nullinput;
 					tmp_in_file(predef_file, "predef"),
 					stdout);
 			}	
-			rc |= preprocess(files, stdout);
+			rc |= pch_preprocess(files, stdout);
 		}
 	}
 	return errors != 0? EXIT_FAILURE: 0; 
@@ -1,7 +1,61 @@
 #ifndef _NWCPP_LIMITS_H
 #define _NWCPP_LIMITS_H
 
+/*
+ * 10/17/26: glibc's limits.h leaves the type limits to gcc's one (which
+ * it would #include_next) if __GNUC__ is defined. We don't have that,
+ * so they are defined below using nwcc's predefined macros
+ */
+#define _GCC_LIMITS_H_
+
 #include "/usr/include/limits.h"
 
+#ifdef __INT_MAX__
+
+#ifndef CHAR_BIT
+#define CHAR_BIT	__CHAR_BIT__
+#endif
+
+#ifndef SCHAR_MAX
+#define SCHAR_MIN	(-SCHAR_MAX - 1)
+#define SCHAR_MAX	__SCHAR_MAX__
+#define UCHAR_MAX	(SCHAR_MAX * 2 + 1)
+#endif
+
+#ifndef CHAR_MAX
+#ifdef __CHAR_UNSIGNED__
+#define CHAR_MIN	0
+#define CHAR_MAX	UCHAR_MAX
+#else
+#define CHAR_MIN	SCHAR_MIN
+#define CHAR_MAX	SCHAR_MAX
+#endif
+#endif
+
+#ifndef SHRT_MAX
+#define SHRT_MIN	(-SHRT_MAX - 1)
+#define SHRT_MAX	__SHRT_MAX__
+#define USHRT_MAX	(SHRT_MAX * 2 + 1)
 #endif
 
+#ifndef INT_MAX
+#define INT_MIN		(-INT_MAX - 1)
+#define INT_MAX		__INT_MAX__
+#define UINT_MAX	(INT_MAX * 2U + 1U)
+#endif
+
+#ifndef LONG_MAX
+#define LONG_MIN	(-LONG_MAX - 1L)
+#define LONG_MAX	__LONG_MAX__
+#define ULONG_MAX	(LONG_MAX * 2UL + 1UL)
+#endif
+
+#ifndef LLONG_MAX
+#define LLONG_MIN	(-LLONG_MAX - 1LL)
+#define LLONG_MAX	__LONG_LONG_MAX__
+#define ULLONG_MAX	(LLONG_MAX * 2ULL + 1ULL)
+#endif
+
+#endif /* __INT_MAX__ */
+
+#endif
@@ -1,12 +1,32 @@
+#ifndef _NWCPP_GNUC_VA_LIST
+#define _NWCPP_GNUC_VA_LIST
+
+typedef __builtin_va_list	__gnuc_va_list; /* for glibc */
+
+#endif
+
+/*
+ * 10/17/26: glibc's stdio.h and wchar.h only ask for __gnuc_va_list,
+ * and define va_list themselves
+ */
+#ifdef __need___va_list
+#undef __need___va_list
+#else
+
 #ifndef _NWCPP_STDARG_H
 #define _NWCPP_STDARG_H
 
-typedef __builtin_va_list	__gnuc_va_list; /* for glibc */
+#ifndef _VA_LIST_DEFINED
 typedef __builtin_va_list	va_list;
+#define _VA_LIST_DEFINED
+#endif
 
 #define va_start __builtin_va_start
 #define va_arg __builtin_va_arg
 #define va_end __builtin_va_end
+#define va_copy __builtin_va_copy
+#define __va_copy __builtin_va_copy
 
 #endif
 
+#endif
@@ -1,9 +1,18 @@
 #ifndef _NWCPP_STDDEF_H
 #define _NWCPP_STDDEF_H
 
+/*
+ * 10/17/26: nwcc predefines the types for the target
+ */
+#ifdef __SIZE_TYPE__
+typedef __SIZE_TYPE__	size_t;
+typedef __PTRDIFF_TYPE__	ptrdiff_t;
+typedef __WCHAR_TYPE__	wchar_t;
+#else
 typedef unsigned long	size_t;
 typedef signed long	ptrdiff_t;
 typedef unsigned long	wchar_t;
+#endif
 
 #if 0
 #ifdef __linux__
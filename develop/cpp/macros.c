@@ -289,6 +289,115 @@ drop_macro(const char *name, int slen, int hashkey) {
 	return 0;
 }	
 
+/*
+ * 10/17/26: Drop all macros except for builtins such as __LINE__. This
+ * is used to replace the macro table with the one recorded in a
+ * precompiled header (see pch.c)
+ */
+void
+drop_all_macros(void) {
+	int	i;
+
+	for (i = 0; i < N_HASHLISTS; ++i) {
+		struct macro	*m;
+		struct macro	*next;
+		struct macro	*keep = NULL;
+		struct macro	*keep_tail = NULL;
+
+		for (m = macro_list_hash[i]; m != NULL; m = next) {
+			next = m->next;
+			if (m->builtin != NULL) {
+				m->next = NULL;
+				if (keep == NULL) {
+					keep = keep_tail = m;
+				} else {
+					keep_tail->next = m;
+					keep_tail = m;
+				}
+			} else {
+				free(m->name);
+				free(m);
+			}
+		}
+		macro_list_hash[i] = keep;
+		macro_list_hash_tail[i] = keep_tail;
+	}
+}
+
+static void
+append_def_text(char **buf, size_t *len, size_t *alloc, const char *text) {
+	size_t	tlen = strlen(text);
+
+	if (*len + tlen + 1 > *alloc) {
+		*alloc = (*len + tlen + 1) * 2;
+		*buf = n_xrealloc(*buf, *alloc);
+	}
+	memcpy(*buf + *len, text, tlen + 1);
+	*len += tlen;
+}
+
+/*
+ * 10/17/26: Turn all non-builtin macros back into #define lines which
+ * can be processed like a predefined macro file. Returns a malloc()ed
+ * buffer and stores its length in *len
+ */
+char *
+macro_defs_to_string(size_t *len) {
+	char	*buf = NULL;
+	size_t	alloc = 0;
+	int	i;
+
+	*len = 0;
+	append_def_text(&buf, len, &alloc, "");
+	for (i = 0; i < N_HASHLISTS; ++i) {
+		struct macro	*m;
+
+		for (m = macro_list_hash[i]; m != NULL; m = m->next) {
+			struct macro_arg	*ma;
+			struct token		*t;
+			size_t			start;
+
+			if (m->builtin != NULL || m->name == NULL) {
+				continue;
+			}
+			append_def_text(&buf, len, &alloc, "#define ");
+			append_def_text(&buf, len, &alloc, m->name);
+			if (m->functionlike) {
+				append_def_text(&buf, len, &alloc, "(");
+				for (ma = m->arglist; ma != NULL; ma = ma->next) {
+					append_def_text(&buf, len, &alloc,
+						ma->name);
+					if (ma == m->trailing_last) {
+						append_def_text(&buf, len,
+							&alloc, "...");
+					}
+					if (ma->next != NULL) {
+						append_def_text(&buf, len,
+							&alloc, ",");
+					}
+				}
+				append_def_text(&buf, len, &alloc, ")");
+			}
+			append_def_text(&buf, len, &alloc, " ");
+			start = *len;
+			for (t = m->toklist; t != NULL; t = t->next) {
+				append_def_text(&buf, len, &alloc,
+					t->type == TOK_HASH? "#":
+					t->type == TOK_HASHHASH? "##":
+					t->ascii);
+			}
+			/* Continued lines must stay on one line */
+			for (; start < *len; ++start) {
+				if (buf[start] == '\n') {
+					buf[start] = ' ';
+				}
+			}
+			append_def_text(&buf, len, &alloc, "\n");
+		}
+	}
+	return buf;
+}
+
 struct token *
 builtin_to_tok(struct macro *m, struct token **tail) {
 	struct token	*ret = alloc_token();
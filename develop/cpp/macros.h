@@ -29,6 +29,8 @@ struct predef_macro *tmp_pre_macro(const char *name, const char *text);
 struct macro	*lookup_macro(const char *name, size_t len, int key);
 struct macro	*put_macro(struct macro *m, int slen, int key);
 int		drop_macro(const char *name, int slen, int key);
+void		drop_all_macros(void);
+char		*macro_defs_to_string(size_t *len);
 struct token	*builtin_to_tok(struct macro *mp, struct token **tail);
 struct token	*skip_ws(struct token *); /* XXX token.c ... */
 
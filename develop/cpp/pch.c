@@ -0,0 +1,607 @@
+/*
+ * Copyright (c) 2026, Nils R. Weller
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Precompiled header prefixes
+ *
+ * Most translation units begin with a block of #include lines which
+ * pulls in the same (system) headers again and again. With -pch-dir=dir
+ * we preprocess that header prefix once and store the resulting text
+ * output along with the macro table in a cache file. Subsequent runs
+ * with the same prefix, macro definitions and include paths just copy
+ * the output and reload the macros instead of reading and tokenizing
+ * every header.
+ *
+ * The cache file is named after a hash of everything that can affect
+ * the prefix (the prefix text itself, all macros defined before it -
+ * i.e. -D/-U and the target macros -, include directories and the
+ * working directory.) The files which were opened or probed while
+ * preprocessing the prefix are recorded with their size and content
+ * hash, and are checked again before a cache file is used.
+ *
+ * Headers with #pragma once are recorded too, since they must not be
+ * included again after a cache hit. (Headers wrapped in include guards
+ * need no such record; their guard macros are restored with the macro
+ * table, so including them again yields nothing.)
+ *
+ * File layout:
+ *
+ *    NWPCH 2
+ *    lines <number of lines in the prefix>
+ *    dep <exists> <size> <hash> <path>     (one per file)
+ *    once <dirno> <name>                   (one per #pragma once file,
+ *                                           dirno -1 for the current
+ *                                           directory)
+ *    macros <length>
+ *    <#define lines>
+ *    output <length>
+ *    <preprocessed text>
+ */
+#include "pch.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "preprocess.h"
+#include "macros.h"
+#include "error.h"
+#include "n_libc.h"
+
+#define PCH_VERSION	"NWPCH 2"
+
+char	*pch_dir = NULL;
+
+struct pch_hash {
+	unsigned long	h1;
+	unsigned long	h2;
+};
+
+struct pch_dep {
+	char		*path;
+	int		exists;
+	size_t		size;
+	struct pch_hash	hash;
+	struct pch_dep	*next;
+};
+
+static int		recording;
+static int		uncacheable;
+static struct pch_dep	*deps;
+static struct pch_dep	*deps_tail;
+
+/*
+ * Two independent 32bit string hashes (FNV-1a and Bernstein) make for
+ * a 64bit key without requiring a 64bit integer type
+ */
+static void
+hash_init(struct pch_hash *h) {
+	h->h1 = 2166136261UL;
+	h->h2 = 5381;
+}
+
+static void
+hash_data(struct pch_hash *h, const void *data, size_t len) {
+	const unsigned char	*p = data;
+	unsigned long		h1 = h->h1;
+	unsigned long		h2 = h->h2;
+
+	while (len-- > 0) {
+		h1 = ((h1 ^ *p) * 16777619UL) & 0xffffffffUL;
+		h2 = ((h2 << 5) + h2 + *p) & 0xffffffffUL;
+		++p;
+	}
+	h->h1 = h1;
+	h->h2 = h2;
+}
+
+static void
+hash_string(struct pch_hash *h, const char *str) {
+	/* Include terminating null byte to separate adjacent strings */
+	hash_data(h, str, strlen(str) + 1);
+}
+
+
+/*
+ * Called by open_input_file() for every file that is opened or probed.
+ * data is NULL if the file does not exist (exists = 0) or cannot be
+ * mapped (exists = -1), in which case the prefix cannot be cached
+ */
+void
+pch_note_input(const char *path, const char *data, size_t size, int exists) {
+	struct pch_dep	*d;
+
+	if (!recording) {
+		return;
+	}
+	if (exists == -1) {
+		uncacheable = 1;
+		return;
+	}
+	for (d = deps; d != NULL; d = d->next) {
+		if (strcmp(d->path, path) == 0) {
+			return;
+		}
+	}
+	d = n_xmalloc(sizeof *d);
+	d->path = n_xstrdup(path);
+	d->exists = exists;
+	d->size = size;
+	hash_init(&d->hash);
+	if (exists) {
+		hash_data(&d->hash, data, size);
+	}
+	d->next = NULL;
+	if (deps == NULL) {
+		deps = deps_tail = d;
+	} else {
+		deps_tail->next = d;
+		deps_tail = d;
+	}
+}
+
+static void
+free_deps(void) {
+	struct pch_dep	*d;
+
+	while (deps != NULL) {
+		d = deps;
+		deps = deps->next;
+		free(d->path);
+		free(d);
+	}
+	deps_tail = NULL;
+}
+
+
+/*
+ * Determine the header prefix of the translation unit; That is the
+ * leading run of complete lines consisting of nothing but whitespace,
+ * comments and #include directives. Returns its length in bytes, and
+ * the number of lines and #include directives it contains
+ */
+static size_t
+scan_prefix(const char *p, const char *end, int *lines, int *includes) {
+	const char	*start = p;
+	const char	*safe = p;
+	int		cur_lines = 0;
+	int		cur_includes = 0;
+	int		line_has_include = 0;
+
+	*lines = 0;
+	*includes = 0;
+	while (p < end) {
+		if (*p == '\n') {
+			++cur_lines;
+			if (line_has_include) {
+				++cur_includes;
+				line_has_include = 0;
+			}
+			safe = ++p;
+			*lines = cur_lines;
+			*includes = cur_includes;
+		} else if (*p == ' ' || *p == '\t' || *p == '\r'
+			|| *p == '\f' || *p == '\v') {
+			++p;
+		} else if (*p == '/' && p + 1 < end && p[1] == '*') {
+			if (line_has_include) {
+				/* Comment may continue the directive */
+				break;
+			}
+			for (p += 2; p + 1 < end; ++p) {
+				if (*p == '*' && p[1] == '/') {
+					break;
+				}
+				if (*p == '\n') {
+					++cur_lines;
+				}
+			}
+			if (p + 1 >= end) {
+				break;
+			}
+			p += 2;
+		} else if (*p == '/' && p + 1 < end && p[1] == '/') {
+			while (p < end && *p != '\n') {
+				if (*p == '\\') {
+					break;
+				}
+				++p;
+			}
+			if (p < end && *p == '\\') {
+				break;
+			}
+		} else if (*p == '#' && !line_has_include) {
+			const char	*q = p + 1;
+
+			while (q < end && (*q == ' ' || *q == '\t')) {
+				++q;
+			}
+			if (end - q < 8
+				|| strncmp(q, "include", 7) != 0
+				|| (q[7] != ' ' && q[7] != '\t'
+				&& q[7] != '"' && q[7] != '<')) {
+				break;
+			}
+			for (p = q + 7; p < end && *p != '\n'; ++p) {
+				if (*p == '\\'
+					|| (*p == '/' && p + 1 < end
+					&& p[1] == '*')) {
+					break;
+				}
+			}
+			if (p < end && *p != '\n') {
+				break;
+			}
+			line_has_include = 1;
+		} else {
+			break;
+		}
+	}
+	return safe - start;
+}
+
+
+static void
+cache_path(struct input_file *inf, size_t prefix_len, char *buf, size_t bufsize) {
+	struct pch_hash		h;
+	struct include_dir	*id;
+	char			cwd[1024];
+	char			*defs;
+	size_t			defs_len;
+
+	hash_init(&h);
+	hash_string(&h, PCH_VERSION);
+
+	defs = macro_defs_to_string(&defs_len);
+	hash_data(&h, defs, defs_len);
+	free(defs);
+
+	for (id = include_dirs; id != NULL; id = id->next) {
+		hash_string(&h, id->path);
+	}
+	if (getcwd(cwd, sizeof cwd) == NULL) {
+		*cwd = 0;
+	}
+	hash_string(&h, cwd);
+	hash_string(&h, inf->path);
+	hash_data(&h, inf->filemap, prefix_len);
+
+	sprintf(buf, "%.*s/%08lx%08lx.pch",
+		(int)(bufsize - sizeof "/0123456789abcdef.pch"), pch_dir,
+		h.h1, h.h2);
+}
+
+
+/*
+ * Check whether a recorded dependency still matches the file system
+ */
+static int
+dep_is_current(const char *path, int exists, unsigned long size,
+	unsigned long h1, unsigned long h2) {
+
+	struct stat	s;
+	struct pch_hash	h;
+	char		*map;
+	int		fd;
+
+	if ((fd = open(path, O_RDONLY)) == -1) {
+		return !exists && errno == ENOENT;
+	}
+	if (!exists
+		|| fstat(fd, &s) == -1
+		|| !S_ISREG(s.st_mode)
+		|| (unsigned long)s.st_size != size) {
+		(void) close(fd);
+		return 0;
+	}
+	hash_init(&h);
+	if (size > 0) {
+		map = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+		if (map == MAP_FAILED) {
+			(void) close(fd);
+			return 0;
+		}
+		hash_data(&h, map, size);
+		(void) munmap(map, size);
+	}
+	(void) close(fd);
+	return h.h1 == h1 && h.h2 == h2;
+}
+
+/*
+ * Read header line starting at *p into buf and advance *p
+ */
+static int
+get_header_line(char **p, char *end, char *buf, size_t bufsize) {
+	char	*nl;
+	size_t	len;
+
+	if ((nl = memchr(*p, '\n', end - *p)) == NULL) {
+		return -1;
+	}
+	if ((len = nl - *p) >= bufsize) {
+		return -1;
+	}
+	memcpy(buf, *p, len);
+	buf[len] = 0;
+	*p = nl + 1;
+	return 0;
+}
+
+/*
+ * Load the cache file at path if it is valid for a prefix of the given
+ * number of lines. The recorded output is written to out and the macro
+ * table is replaced with the recorded one. Returns -1 if the cache
+ * cannot be used
+ */
+static int
+load_pch(const char *path, int want_lines, FILE *out) {
+	static struct input_file	nullf;
+	struct input_file		defs;
+	struct stat			s;
+	char				line[2048];
+	char				*map;
+	char				*p;
+	char				*end;
+	int				fd;
+	int				lines;
+	unsigned long			len;
+	unsigned long			out_len;
+	char				*defs_start;
+	char				*once_start;
+	FILE				*null_out;
+
+	if ((fd = open(path, O_RDONLY)) == -1) {
+		return -1;
+	}
+	if (fstat(fd, &s) == -1 || s.st_size == 0) {
+		(void) close(fd);
+		return -1;
+	}
+	map = mmap(0, s.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	(void) close(fd);
+	if (map == MAP_FAILED) {
+		return -1;
+	}
+	p = map;
+	end = map + s.st_size;
+
+	if (get_header_line(&p, end, line, sizeof line) != 0
+		|| strcmp(line, PCH_VERSION) != 0
+		|| get_header_line(&p, end, line, sizeof line) != 0
+		|| sscanf(line, "lines %d", &lines) != 1
+		|| lines != want_lines) {
+		goto bad;
+	}
+
+	for (;;) {
+		int		exists;
+		int		n;
+		unsigned long	size;
+		unsigned long	h1;
+		unsigned long	h2;
+
+		if (get_header_line(&p, end, line, sizeof line) != 0) {
+			goto bad;
+		}
+		if (strncmp(line, "dep ", 4) != 0) {
+			break;
+		}
+		if (sscanf(line, "dep %d %lu %8lx%8lx %n",
+			&exists, &size, &h1, &h2, &n) != 4) {
+			goto bad;
+		}
+		if (!dep_is_current(line + n, exists, size, h1, h2)) {
+			goto bad;
+		}
+	}
+
+	/*
+	 * The #pragma once records are only applied once the whole file
+	 * has been found to be valid. once_start is the start of the line
+	 * just read
+	 */
+	once_start = p - strlen(line) - 1;
+	while (strncmp(line, "once ", 5) == 0) {
+		int	dirno;
+
+		if (sscanf(line, "once %d ", &dirno) != 1
+			|| get_header_line(&p, end, line, sizeof line) != 0) {
+			goto bad;
+		}
+	}
+
+	if (sscanf(line, "macros %lu", &len) != 1
+		|| len > (unsigned long)(end - p)) {
+		goto bad;
+	}
+	defs_start = p;
+	p += len;
+	if (get_header_line(&p, end, line, sizeof line) != 0
+		|| sscanf(line, "output %lu", &out_len) != 1
+		|| out_len != (unsigned long)(end - p)) {
+		goto bad;
+	}
+
+	if ((null_out = fopen("/dev/null", "w")) == NULL) {
+		goto bad;
+	}
+	for (;;) {
+		int	dirno;
+		int	n;
+
+		(void) get_header_line(&once_start, end, line, sizeof line);
+		if (sscanf(line, "once %d %n", &dirno, &n) != 1) {
+			break;
+		}
+		restore_once_include(dirno, line + n);
+	}
+	if (fwrite(p, 1, out_len, out) != out_len) {
+		perror("fwrite");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	 * Now replace the macro table. The definitions are processed just
+	 * like the predefined macros from the command line
+	 */
+	drop_all_macros();
+	defs = nullf;
+	defs.path = "<pch>";
+	defs.is_cmdline = 1;
+	defs.filemap = defs.filep = defs_start;
+	defs.filemapend = defs_start + len;
+	defs.filesize = len;
+	(void) preprocess(&defs, null_out);
+	(void) fclose(null_out);
+
+	/*
+	 * The mapping cannot be released because the macro tokens may
+	 * still point into it
+	 */
+	return 0;
+
+bad:
+	(void) munmap(map, s.st_size);
+	return -1;
+}
+
+
+static void
+write_pch(const char *path, int lines, FILE *prefix_out) {
+	struct pch_dep	*d;
+	char		*tmppath;
+	char		*defs;
+	size_t		defs_len;
+	long		out_len;
+	FILE		*fd;
+	int		ch;
+
+	tmppath = n_xmalloc(strlen(path) + 32);
+	sprintf(tmppath, "%s.%lu", path, (unsigned long)getpid());
+	if ((fd = fopen(tmppath, "w")) == NULL) {
+		/* Not fatal, we just don't get a cache */
+		perror(tmppath);
+		free(tmppath);
+		return;
+	}
+
+	defs = macro_defs_to_string(&defs_len);
+	out_len = ftell(prefix_out);
+	rewind(prefix_out);
+
+	(void) fprintf(fd, "%s\nlines %d\n", PCH_VERSION, lines);
+	for (d = deps; d != NULL; d = d->next) {
+		(void) fprintf(fd, "dep %d %lu %08lx%08lx %s\n",
+			d->exists, (unsigned long)d->size,
+			d->hash.h1, d->hash.h2, d->path);
+	}
+	write_once_includes(fd);
+	(void) fprintf(fd, "macros %lu\n", (unsigned long)defs_len);
+	(void) fwrite(defs, 1, defs_len, fd);
+	(void) fprintf(fd, "output %ld\n", out_len);
+	while ((ch = getc(prefix_out)) != EOF) {
+		(void) putc(ch, fd);
+	}
+	free(defs);
+
+	if (fclose(fd) == EOF || rename(tmppath, path) == -1) {
+		perror(tmppath);
+		(void) unlink(tmppath);
+	}
+	free(tmppath);
+}
+
+
+/*
+ * Preprocess the translation unit inf, using and creating a cached
+ * version of its header prefix if possible
+ */
+int
+pch_preprocess(struct input_file *inf, FILE *out) {
+	static struct input_file	nullf;
+	struct input_file		prefix;
+	char				path[2048];
+	size_t				prefix_len;
+	int				lines;
+	int				includes;
+	int				prefix_errors = 0;
+	int				rc;
+	FILE				*tmp;
+	int				ch;
+
+	if (pch_dir == NULL || inf->fd != NULL || inf->filemap == NULL) {
+		return preprocess(inf, out);
+	}
+	prefix_len = scan_prefix(inf->filemap, inf->filemapend,
+		&lines, &includes);
+	if (includes == 0) {
+		return preprocess(inf, out);
+	}
+
+	cache_path(inf, prefix_len, path, sizeof path);
+	if (load_pch(path, lines, out) != 0) {
+		/*
+		 * Cache miss - Preprocess the prefix on its own while
+		 * recording which files it depends on
+		 */
+		if ((tmp = tmpfile()) == NULL) {
+			perror("tmpfile");
+			return preprocess(inf, out);
+		}
+		prefix = nullf;
+		prefix.path = inf->path;
+		prefix.filemap = prefix.filep = inf->filemap;
+		prefix.filemapend = inf->filemap + prefix_len;
+		prefix.filesize = prefix_len;
+
+		recording = 1;
+		uncacheable = 0;
+		prefix_errors = preprocess(&prefix, tmp);
+		recording = 0;
+
+		rewind(tmp);
+		while ((ch = getc(tmp)) != EOF) {
+			(void) putc(ch, out);
+		}
+		if (prefix_errors == 0 && !uncacheable) {
+			write_pch(path, lines, tmp);
+		}
+		(void) fclose(tmp);
+		free_deps();
+	}
+
+	/* Process the rest of the file */
+	inf->filep = inf->filemap + prefix_len;
+	inf->resume_line = lines + 1;
+	rc = preprocess(inf, out);
+	errors += prefix_errors;
+	return rc + prefix_errors;
+}
+
@@ -47,6 +47,7 @@
 #include "type.h"
 #include "n_libc.h"
 #include "macros.h"
+#include "pch.h"
 
 
 #ifdef DEBUG
@@ -78,6 +79,7 @@ struct include_dir	*include_dirs;
 static int		pre_directive	= 1;
 int			lineno		= 1;
 char			*curfile = NULL;
+static struct include_file	*current_include;
  
 static int
 try_mmap(struct input_file *infile, const char *input, int silent) {
@@ -125,14 +127,17 @@ open_input_file(struct input_file *inf, const char *input, int silent) {
 
 	if (try_mmap(inf, input, silent) == 0) {
 		inf->fd = NULL;
+		pch_note_input(input, inf->filemap, inf->filesize, 1);
 		return 0;
 	}
 	inf->filemap = NULL;
 	if (errno == ENOENT) {
 		/* File doesn't exist, give up */
 		inf->fd = NULL;
+		pch_note_input(input, NULL, 0, 0);
 		return -1;
 	}
+	pch_note_input(input, NULL, 0, -1);
 		
 	if ((inf->fd = fopen(input, "r")) == NULL) {
 		if (!silent) {
@@ -775,12 +780,29 @@ garbage:
 		}	
 		return 0;
 	} else if (dir->code == CMD_PRAGMA) {
-		/* Ignore for now */
+		/*
+		 * Ignore for now - except for #pragma once, which is
+		 * recorded for do_include()
+		 */
+		i = 0;
 		if (ch != '\n') {
 			do {
 				ch = FGETC(inf);
+				if (i < (int)sizeof buf - 1) {
+					buf[i++] = ch;
+				}
 			} while (ch != EOF && ch != '\n');
 		}
+		buf[i] = 0;
+		for (i = 0; isspace((unsigned char)buf[i]); ++i)
+			;
+		if (strncmp(buf + i, "once", 4) == 0
+			&& (buf[i + 4] == 0
+			|| isspace((unsigned char)buf[i + 4]))) {
+			if (current_include != NULL && !g_ignore_text) {
+				current_include->once = 1;
+			}
+		}
 	}
 	return 0;
 }
@@ -798,7 +820,6 @@ garbage:
  * whether that covers the entire header. The helps us skip a lot of
  * stuff, particularly in the system headers.
  */
-static struct include_file	*current_include;
 static struct include_dir	current_working_directory; /* misnomer */
 
 static struct include_file *
@@ -817,6 +838,25 @@ lookup_include(struct include_dir *dir, const char *name) {
 	return NULL;
 }
 
+/*
+ * 10/17/26: Check whether a known include file need not be read again
+ * because it contains #pragma once, or because it is fully wrapped in
+ * an include guard that evaluates to false now. This is done before
+ * the file is opened
+ */
+static int
+include_is_redundant(struct include_file *inc) {
+	if (inc->once) {
+		return 1;
+	}
+	if (inc->has_guard && inc->fully_guarded) {
+		if (complete_directive(NULL, inc, NULL, NULL, NULL) == 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
 static void
 put_include(struct include_dir *dir, struct include_file *inc) {
 	inc->namelen = strlen(inc->name);
@@ -825,7 +865,62 @@ put_include(struct include_dir *dir, struct include_file *inc) {
 	} else {
 		dir->inc_files_tail->next = inc;
 		dir->inc_files_tail = inc;
-	}	
+	}
+}
+
+/*
+ * 10/17/26: Write a line ``once <dir> <name>'' for every include file
+ * containing #pragma once to out, <dir> being the index of the include
+ * directory it was found in or -1 for the current directory. This
+ * state has to be saved along with the macros in precompiled header
+ * prefixes (see pch.c)
+ */
+void
+write_once_includes(FILE *out) {
+	struct include_dir	*id = &current_working_directory;
+	struct include_file	*inf;
+	int			dirno = -1;
+
+	while (id != NULL) {
+		for (inf = id->inc_files; inf != NULL; inf = inf->next) {
+			if (inf->once) {
+				(void) fprintf(out, "once %d %s\n",
+					dirno, inf->name);
+			}
+		}
+		id = dirno == -1? include_dirs: id->next;
+		++dirno;
+	}
+}
+
+/*
+ * Restore a record written by write_once_includes(). Records for
+ * include directories which don't exist are ignored; They cannot
+ * occur since the directories are part of the cache file name
+ */
+void
+restore_once_include(int dirno, const char *name) {
+	static struct include_file	nullif;
+	struct include_dir		*id;
+	struct include_file		*inf;
+
+	if (dirno == -1) {
+		id = &current_working_directory;
+	} else {
+		for (id = include_dirs; id != NULL && dirno > 0; --dirno) {
+			id = id->next;
+		}
+		if (id == NULL || dirno < 0) {
+			return;
+		}
+	}
+	if ((inf = lookup_include(id, name)) == NULL) {
+		inf = n_xmalloc(sizeof *inf);
+		*inf = nullif;
+		inf->name = n_xstrdup(name);
+		put_include(id, inf);
+	}
+	inf->once = 1;
 }
 
 
@@ -833,7 +928,7 @@ static int
 do_include(FILE *out, char *str, struct token *toklist, int type) {
 	char				*p;
 	char				*oldname;
-	int				rc;
+	int				rc = 0;
 	int				oldline;
 	char				*oldfile = curfile;
 	struct macro			*mp;
@@ -874,6 +969,12 @@ do_include(FILE *out, char *str, struct token *toklist, int type) {
 		 * Try opening file in . first, then fall back to standard
 		 * directories (actually absolute paths are ok too.)
 		 */
+		cached_file = lookup_include(&current_working_directory,
+			str+1);
+		if (cached_file != NULL && include_is_redundant(cached_file)) {
+			lastdir = NULL;
+			goto out;
+		}
 #if 0
 		if ((fd = fopen(str+1, "r")) != NULL) {
 #endif
@@ -918,7 +1019,18 @@ do_include(FILE *out, char *str, struct token *toklist, int type) {
 					break;
 				}
 			}	
-						
+
+			/*
+			 * 10/17/26: If the file was already found in this
+			 * directory, we may not have to open it again
+			 */
+			cached_file = lookup_include(id, str+1);
+			if (cached_file != NULL
+				&& include_is_redundant(cached_file)) {
+				lastdir = id;
+				goto out;
+			}
+
 			buf = n_xmalloc(strlen(id->path) +
 				sizeof "/" + strlen(str+1));
 			sprintf(buf, "%s/%s", id->path, str+1);
@@ -947,24 +1059,10 @@ do_include(FILE *out, char *str, struct token *toklist, int type) {
 	inf.is_header = 1;
 	old_current_include = current_include;
 	if ((cached_file = lookup_include(source_dir, str+1)) != NULL) {
-		if (cached_file->has_guard) {
-			if (cached_file->fully_guarded) {
-				if (complete_directive(NULL, cached_file,
-					NULL, NULL, NULL) == 0) {
-					/*
-					 * Include guard condition evaluates
-					 * to false - as expected - so the
-					 * file need not be read 
-					 */
-#if 0
-					(void) fclose(inf.fd); /* XXX */
-#endif
-					close_input_file(&inf);
-					goto out;
-				}	
-			}
-		}
-		/* file is already known - don't record guard */
+		/*
+		 * File is already known and was found not to be redundant
+		 * above - don't record guard
+		 */
 		current_include = NULL;
 	} else {
 		/* Processing new file */
@@ -1528,6 +1626,12 @@ preprocess(struct input_file *inf, FILE *out) {
 	if (!inf->is_header && !inf->is_cmdline) {
 		/* Processing new .c file */
 		lineno = 1;
+		if (inf->resume_line) {
+			/* Header prefix already done by pch_preprocess() */
+			lineno = inf->resume_line;
+			lex_chars_read = inf->filep - inf->filemap;
+			lex_line_ptr = inf->filep;
+		}
 		set_compiler_line(out, lineno, curfile);
 		err_setline(&lineno);
 
@@ -46,6 +46,7 @@ struct include_file {
 	struct pp_directive	*end_dir;
 	size_t			start_guard; /* only valid if has_guard set */
 	size_t			end_guard;
+	int			once;	/* #pragma once seen */
 	struct include_file	*next;
 };
 
@@ -76,12 +77,20 @@ struct input_file {
 	int			unread_chars[10];
 	int			unread_idx;
 
+	/*
+	 * 10/17/26: Nonzero if preprocessing starts in the middle of the
+	 * file at filep, which is line resume_line (see pch.c)
+	 */
+	int			resume_line;
+
 	struct input_file	*next;
 };	
 
 extern struct include_dir	*include_dirs;
 
 int	open_input_file(struct input_file *, const char *, int silent);
+void	write_once_includes(FILE *out);
+void	restore_once_include(int dirno, const char *name);
 int preprocess(struct input_file *file, FILE *out);
 int get_next_char(struct input_file *fd);
 int unget_char(int ch, struct input_file *fd);
@@ -6,15 +6,14 @@ fi
 cp ../nwcpp .
 INPUT="Some stuff for input"
 
-for i in `ls *.c`; do
-	printf "Trying $i ... "
-	if ! ./nwcpp $i >nwcpp.out.i; then
+try_file() {
+	if ! ./nwcpp $NWCPP_FLAGS $i >nwcpp.out.i; then
 		echo NWCPP ERROR
-		continue
+		return
 	fi
 	if ! gcc nwcpp.out.i 2>/dev/null; then
 		echo INVALID CODE
-		continue
+		return
 	fi
 	rm nwcpp.out.i
 	echo $INPUT | ./a.out >nwcpp.out
@@ -27,6 +26,24 @@ for i in `ls *.c`; do
 	else
 		echo OK
 	fi
+}
+
+for i in `ls *.c`; do
+	printf "Trying $i ... "
+	NWCPP_FLAGS=""
+	try_file
 done	
 
+# 10/17/26: Again with precompiled header prefixes; The first run
+# creates the cache file, the second one uses it
+rm -rf pch.tmp
+mkdir pch.tmp
+for i in `ls *.c`; do
+	printf "Trying $i with -pch-dir ... "
+	NWCPP_FLAGS="-pch-dir=pch.tmp"
+	./nwcpp $NWCPP_FLAGS $i >/dev/null 2>&1
+	try_file
+done
+rm -rf pch.tmp
+
 cd ..
@@ -0,0 +1,5 @@
+/* Fully guarded header */
+#ifndef GUARD1_H
+#define GUARD1_H
+static int guard1_val = 1;
+#endif
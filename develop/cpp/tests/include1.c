@@ -0,0 +1,15 @@
+#include "guard1.h"
+#include "once1.h"
+#include "guard1.h"
+#include "once1.h"
+
+int printf(const char *, ...);
+
+int
+main() {
+	int	count = 0;
+#include "count1.h"
+#include "count1.h"
+	printf("%d %d %d\n", guard1_val, once1_val, count);
+	return 0;
+}
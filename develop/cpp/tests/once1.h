@@ -0,0 +1,2 @@
+#pragma once
+static int once1_val = 2;
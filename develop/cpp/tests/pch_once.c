@@ -0,0 +1,17 @@
+#include "once1.h"
+
+/*
+ * once1.h is in the header prefix, which may come from a precompiled
+ * header cache; It must not be included again
+ */
+int	pch_once_val = 3;
+
+#include "once1.h"
+
+int printf(const char *, ...);
+
+int
+main() {
+	printf("%d %d\n", once1_val, pch_once_val);
+	return 0;
+}
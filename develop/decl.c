@@ -347,6 +347,7 @@ get_base_type(struct token **curtok, int type) {
 	char			decascii[1024] = { 0 };
 #endif
 	char			*tag;
+	struct atom		*tag_atom = NULL;
 	int			repetitions = 0;
 	int			curtype;
 	int			errors = 0;
@@ -354,14 +355,14 @@ get_base_type(struct token **curtok, int type) {
 
 	ty = alloc_type();
 	ty->line = (*curtok)->line;
-	ty->file = (*curtok)->file;
+	ty->file = token_file(*curtok);
 
 	if (doing_fcatalog) {
 		/* Can't be implicit declaration, may be dummy typedef */
 		;
 	} else if (!IS_KEYWORD((*curtok)->type)
 		&& ((*curtok)->type != TOK_IDENTIFIER
-			|| lookup_typedef(curscope, (*curtok)->data, 1,
+			|| lookup_typedef_atom(curscope, token_atom(*curtok), 1,
 					LTD_IGNORE_IDENT) == NULL)) {
 		/* No base type specified - implicit int! ... as in main() {} */
 		ty->code = TY_INT;
@@ -536,6 +537,7 @@ get_base_type(struct token **curtok, int type) {
 				return NULL;
 			} else {
 				tag = tok->data;
+				tag_atom = token_atom(tok);
 
 				/* Is this actually a definition? */
 				if (tok->next == NULL) {
@@ -581,8 +583,8 @@ get_base_type(struct token **curtok, int type) {
 					 * does not work!
 					 */
 					if (tag != NULL) {
-						inc = lookup_struct(curscope,
-							tag, 1);
+						inc = lookup_struct_atom(curscope,
+							tag_atom, 1);
 						if (inc != NULL) {
 							if (!inc->incomplete) {
 								inc = NULL;
@@ -639,8 +641,8 @@ get_base_type(struct token **curtok, int type) {
 					struct ty_struct	*ts;
 
 					if ((ty->tstruc
-						= lookup_struct(curscope, tag,
-						SCOPE_NESTED)) == NULL) {
+						= lookup_struct_atom(curscope,
+						tag_atom, SCOPE_NESTED)) == NULL) {
 						/*
 						 * This is a new incomplete type
 						 */
@@ -729,7 +731,8 @@ get_base_type(struct token **curtok, int type) {
 					 * enum type
 					 */
 					if ((ty->tenum =
-						lookup_enum(curscope, tag, 1))
+						lookup_enum_atom(curscope,
+							tag_atom, 1))
 						== NULL) {
 						/*
 						 * 20141115: Use of undefined enums is
@@ -922,8 +925,8 @@ get_base_type(struct token **curtok, int type) {
 					goto exit_swtch;
 				}
 			} else if (ty->code != 0
-				|| (tytmp = lookup_typedef(curscope, tok->data, 1,
-				LTD_IGNORE_IDENT))
+				|| (tytmp = lookup_typedef_atom(curscope,
+				token_atom(tok), 1, LTD_IGNORE_IDENT))
 				== NULL) {
 				/* Must be identifier in declaration */
 				goto exit_swtch;
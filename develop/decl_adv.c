@@ -1756,7 +1756,8 @@ parse_func(struct token **curtok, const char *name) {
 	 * identifier, we simply assume a K&R declaration, else ISO 
 	 */
 	if (t->type == TOK_IDENTIFIER
-		&& (td = lookup_typedef(curscope, t->data, 1, 0)) == NULL
+		&& (td = lookup_typedef_atom(curscope, token_atom(t), 1, 0))
+			== NULL
 		&& !doing_fcatalog) {
 		/* Is K&R declaration */
 		if (do_parse_kr_func(&t, ret) != 0) {
@@ -35,6 +35,7 @@
 #include <sys/wait.h>
 #include <unistd.h>
 #include <assert.h>
+#include <errno.h>
 #include "exectools.h"
 #include "backend.h"
 #include "misc.h"
@@ -78,6 +79,410 @@ char *name, int *output_index) {
 
 extern int Sflag; /* XXX */
 
+/*
+ * Replace the current process with nwcc1 for the source file ``p2''
+ */
+static void
+exec_nwcc1(char *p2, char **cpp_flags) {
+	char	*nwcc1_args[512]; /* XXX */
+	char	*arch = NULL;
+	char	*p;
+	int	j = 0;
+	int	k = 0;
+
+	nwcc1_args[j++] = "nwcc1";
+	if (stackprotectflag) {
+		nwcc1_args[j++] = "-stackprotect";
+	}
+	if (gnuc_version) {
+		static char	gnubuf[128];
+		sprintf(gnubuf, "-gnuc=%s",
+			gnuc_version);	
+		nwcc1_args[j++] = gnubuf;
+	}
+	if (std_flag != NULL) {
+		static char	std[16];
+		sprintf(std, "-std=%s", std_flag);
+		nwcc1_args[j++] = std;
+	}
+	if (pedanticflag) {
+		nwcc1_args[j++] = "-pedantic";
+	}	
+	if (verboseflag) {
+		nwcc1_args[j++] = "-verbose";
+	}
+	if (nostdinc_flag) {
+		nwcc1_args[j++] = "-nostdinc";
+	}
+	if (picflag) {
+		nwcc1_args[j++] = "-fpic";
+	}
+	if (fulltocflag || (!mintocflag && !fulltocflag)) {
+		nwcc1_args[j++] = "-mfull-toc";
+	} else {
+		nwcc1_args[j++] = "-mminimal-toc";
+	}
+	if (stupidtraceflag) {
+		nwcc1_args[j++] = "-stupidtrace";
+	}
+
+
+	if (gflag) {
+		nwcc1_args[j++] = "-g";
+	}
+	if (Eflag) {
+		nwcc1_args[j++] = "-E";
+	}
+	if (Oflag) {
+		static char	obuf[16];
+		sprintf(obuf, "-O%d", Oflag);
+		nwcc1_args[j++] = obuf; 
+	}
+	if (write_fcat_flag) {
+		nwcc1_args[j++] = "-write-fcat";
+	}
+	if (save_bad_translation_unit_flag) {
+		nwcc1_args[j++] = "-save-bad-translation-unit";
+	}
+
+	/* XXX this should go into misc.c */
+	switch (archflag) {
+	case ARCH_X86:	
+		arch = "-arch=x86";
+		break;
+	case ARCH_AMD64:
+		arch = "-arch=amd64";
+		break;
+	case ARCH_POWER:
+		arch = "-arch=ppc";
+		break;
+	case ARCH_MIPS:
+		if (get_target_endianness() == ENDIAN_LITTLE) {
+			arch = "-arch=mipsel";
+		} else {
+			arch = "-arch=mips";
+		}
+		break;
+	case ARCH_SPARC:
+		arch = "-arch=sparc";
+		break;
+	case ARCH_PA:
+	case ARCH_ARM:
+	case ARCH_SH:
+		unimpl();
+	}
+	nwcc1_args[j++] = arch;
+		
+	if (abiflag != abiflag_default) {
+		if (abiflag != 0) {
+			nwcc1_args[j++] = /*abi*/
+				abi_to_option(abiflag);
+		}	
+	}
+
+	if (sysflag != sysflag_default) {
+		if (sysflag != 0) {
+			nwcc1_args[j++] = sys_to_option(sysflag);
+		}
+	}
+
+	if (asmflag) {
+		nwcc1_args[j] =
+			n_xmalloc(strlen(asmflag)+16);
+		sprintf(nwcc1_args[j++],
+			"-asm=%s", asmflag);	
+	}
+	if (cppflag) {
+		nwcc1_args[j] =
+			n_xmalloc(strlen(cppflag+16));
+		sprintf(nwcc1_args[j++],
+			"-cpp=%s", cppflag);
+	}
+	if (timeflag) {
+		nwcc1_args[j++] = n_xstrdup("-time");
+	}
+	if (funsignedchar_flag) {
+		nwcc1_args[j++] = n_xstrdup("-funsigned-char");
+	}
+	if (fsignedchar_flag) {
+		nwcc1_args[j++] = n_xstrdup("-fsigned-char");
+	}
+	if (fnocommon_flag) {
+		nwcc1_args[j++] = n_xstrdup("-fno-common");
+	}
+	if (finline_limit != -1) {
+		nwcc1_args[j] = n_xmalloc(sizeof "-finline-limit=" + 16);
+		sprintf(nwcc1_args[j++], "-finline-limit=%d", finline_limit);
+	}
+	if (fnoinline_flag) {
+		nwcc1_args[j++] = n_xstrdup("-fno-inline");
+	}
+	if (finlinereport_flag) {
+		nwcc1_args[j++] = n_xstrdup("-finline-report");
+	}
+	if (ftimereport_flag) {
+		nwcc1_args[j++] = n_xstrdup("-ftime-report");
+	}
+	if (ftimereport_json != NULL) {
+		nwcc1_args[j] = n_xmalloc(strlen(ftimereport_json)
+			+ sizeof "-ftime-report-json=");
+		sprintf(nwcc1_args[j++], "-ftime-report-json=%s",
+			ftimereport_json);
+	}
+	if (notgnu_flag) {
+		nwcc1_args[j++] = n_xstrdup("-notgnu");
+	} else {
+		nwcc1_args[j++] = n_xstrdup("-gnu");
+	}
+	if (color_flag) {
+		nwcc1_args[j++] = n_xstrdup("-color");
+	}
+	if (dump_macros_flag) {
+		nwcc1_args[j++] = n_xstrdup("-dM");
+	}
+
+	if (custom_cpp_args) {
+		nwcc1_args[j++] = custom_cpp_args;
+	}
+
+	nwcc1_args[j++] = p2;
+	for (; cpp_flags[k] != NULL; ++j, ++k) {
+		nwcc1_args[j] = cpp_flags[k];
+	}
+	nwcc1_args[j] = NULL;
+#define DEVEL
+#ifdef DEVEL
+	execv("./nwcc1", nwcc1_args);
+#endif 
+
+	if ((p = getenv("NWCC_CC1")) != NULL) {
+		execv(p, nwcc1_args);
+		perror(p);
+	} else {	
+#if 0
+		execv("/usr/local/bin/nwcc1",
+			nwcc1_args);
+		perror("/usr/local/bin/nwcc1");
+#endif
+		execv(INSTALLDIR "/bin/nwcc1",
+			nwcc1_args);
+		perror(INSTALLDIR "/bin/nwcc1");
+	}
+	exit(EXIT_FAILURE);
+}
+
+/*
+ * Run nwcc1 and the assembler on the source file ``p2''. Returns the path
+ * of the resulting object file, or a null pointer if there is nothing to
+ * link (either because of an error or because -S/-E/-write-fcat stopped
+ * us early). *cc1_failed is set if the compiler proper failed
+ */
+static char *
+compile_file(char *p2, char **cpp_flags, char *asm_flags, int *cc1_failed) {
+	static struct timeval	tv;
+	char			*p;
+	pid_t			pid;
+	int			rc;
+
+	*cc1_failed = 0;
+
+#ifdef DEBUG
+	printf("Preprocessed successfully as %s\n", p2);
+#endif
+
+	/* Compile file ``p2''. */
+	if ((pid = fork()) == -1) {
+		perror("fork");
+		exit(EXIT_FAILURE);
+	} else if (pid == 0) {
+		exec_nwcc1(p2, cpp_flags);
+	} else {
+		if (waitpid(pid, &rc, 0) == -1) {
+			perror("waitpid");
+			exit(EXIT_FAILURE);
+		}
+		if (dump_macros_flag) {
+			/*
+			 * 05/19/09: -dM
+			 */
+			exit(EXIT_SUCCESS);
+		}
+		if (rc != 0) {
+			*cc1_failed = 1;
+			return NULL;
+		}
+	}
+
+	/*
+	 * nwcc just outputs with the same name as the input,
+	 * except that the ending is .asm instead of .cpp
+	 */
+#ifdef DEBUG
+	printf("Compiled successfully as %s\n", p2);
+#endif
+
+	if (Sflag || Eflag || write_fcat_flag) {
+		return NULL;
+	}
+
+	p = p2;
+	p2 = n_xmalloc(strlen(p2) + sizeof ".asm");
+	strcpy(p2, p);
+	p = strrchr(p2, '.');
+	strcpy(++p, "asm");
+
+	/* Hopefully p2 is a valid .asm file now... */
+	if (timeflag) {
+		start_timer(&tv);
+	}
+
+	if ((p = strrchr(p2, '/')) != NULL) {
+		char	*saved = p+1;
+		p2 = do_asm(p+1, asm_flags, abiflag);
+		remove(saved);
+	} else {
+		char	*saved_p2 = p2;
+		p2 = do_asm(p2, asm_flags, abiflag);
+		remove(saved_p2);
+	}	
+	if (p2 == NULL) {
+		/* Ignore failure, try other files anyway. */
+		return NULL;
+	}
+
+	if (timeflag) {
+		int	res = stop_timer(&tv);
+		(void) fprintf(stderr,
+			"=== Timing for assembling ===\n");
+		(void) fprintf(stderr,
+			"    %f sec\n", res / 1000000.0);
+	}
+
+#ifdef DEBUG
+	printf("Assembled successfully as %s\n", p2);
+#endif
+	return p2;
+}
+
+/*
+ * 10/17/26: Parallel compilation with -j N. Every C source file is run
+ * through cpp, nwcc1 and the assembler in a child process of its own, and
+ * at most N of them are active at a time. The output of each job is
+ * redirected into a temporary log file which is replayed in command line
+ * order, so that diagnostics of different files do not get mixed up
+ */
+struct cc_job {
+	pid_t	pid;
+	int	out_slot;	/* Index into output_names */
+	int	status;		/* CC_JOB_* */
+	int	done;
+	char	log_path[FILENAME_MAX + 1];
+};
+
+#define CC_JOB_OBJECT	0	/* Object file created */
+#define CC_JOB_CC1_ERR	1	/* nwcc1 failed */
+#define CC_JOB_ASM_ERR	2	/* Assembler failed */
+#define CC_JOB_NOOBJ	3	/* Nothing to link (-S) */
+
+static pid_t
+start_job(struct cc_job *job, char *file, char **cpp_flags, char *asm_flags) {
+	FILE	*log;
+	pid_t	pid;
+	int	cc1_failed;
+
+	if ((log = get_tmp_file("/var/tmp/nwccjob", job->log_path, "log"))
+		== NULL) {
+		exit(EXIT_FAILURE);
+	}
+
+	/* Don't let the child inherit pending output */
+	(void) fflush(NULL);
+
+	if ((pid = fork()) == -1) {
+		perror("fork");
+		exit(EXIT_FAILURE);
+	} else if (pid == 0) {
+		char	*obj;
+
+		if (dup2(fileno(log), STDOUT_FILENO) == -1
+			|| dup2(fileno(log), STDERR_FILENO) == -1) {
+			perror("dup2");
+			exit(CC_JOB_CC1_ERR);
+		}
+		(void) fclose(log);
+		obj = compile_file(file, cpp_flags, asm_flags, &cc1_failed);
+		(void) fflush(NULL);
+		if (obj != NULL) {
+			exit(CC_JOB_OBJECT);
+		} else if (cc1_failed) {
+			exit(CC_JOB_CC1_ERR);
+		} else if (Sflag || Eflag || write_fcat_flag) {
+			exit(CC_JOB_NOOBJ);
+		} else {
+			exit(CC_JOB_ASM_ERR);
+		}
+	}
+	(void) fclose(log);
+	job->pid = pid;
+	job->done = 0;
+	return pid;
+}
+
+/*
+ * Wait for any running job to terminate and record its exit status. Returns
+ * -1 if there are no more jobs to wait for
+ */
+static int
+reap_job(struct cc_job *jobs, int njobs) {
+	pid_t	pid;
+	int	rc;
+	int	i;
+
+	for (;;) {
+		do {
+			pid = waitpid(-1, &rc, 0);
+		} while (pid == -1 && errno == EINTR);
+		if (pid == -1) {
+			return -1;
+		}
+
+		for (i = 0; i < njobs; ++i) {
+			if (jobs[i].pid == pid && !jobs[i].done) {
+				jobs[i].done = 1;
+				if (WIFEXITED(rc)) {
+					jobs[i].status = WEXITSTATUS(rc);
+				} else {
+					jobs[i].status = CC_JOB_CC1_ERR;
+				}
+				return i;
+			}
+		}
+		/* Not one of ours - keep waiting */
+	}
+}
+
+/*
+ * Copy the saved output of a finished job to stdout and remove the log file
+ */
+static void
+replay_job_output(struct cc_job *job) {
+	FILE	*fd;
+	char	buf[1024];
+	size_t	n;
+
+	if ((fd = fopen(job->log_path, "r")) == NULL) {
+		perror(job->log_path);
+		return;
+	}
+	while ((n = fread(buf, 1, sizeof buf, fd)) > 0) {
+		(void) fwrite(buf, 1, n, stdout);
+	}
+	(void) fclose(fd);
+	(void) fflush(stdout);
+	remove(job->log_path);
+}
+
+
 int
 driver(char **cpp_flags, char *asm_flags, char *ld_flags, char **files) {
 	int			i;
@@ -90,7 +495,11 @@ driver(char **cpp_flags, char *asm_flags, char *ld_flags, char **files) {
 	char			**output_names = NULL;
 	char			buf[256];
 	int			*output_del = NULL;
-	pid_t			pid;
+	int			parallel;
+	int			njobs = 0;
+	int			running = 0;
+	int			next_replay = 0;
+	struct cc_job		*jobs = NULL;
 	FILE			*fd;
 	char			ld_std_flags[512];
 	char			ld_pre_std_flags[128];
@@ -407,6 +816,20 @@ driver(char **cpp_flags, char *asm_flags, char *ld_flags, char **files) {
 		unimpl();
 	}
 
+	/*
+	 * -E and -dM write their results to stdout, which must not be
+	 * reordered, so they always run sequentially
+	 */
+	parallel = jobsflag > 1
+		&& !Eflag
+		&& !dump_macros_flag
+		&& !write_fcat_flag;
+	if (parallel) {
+		for (i = 0; files[i] != NULL; ++i)
+			;
+		jobs = n_xmalloc((i + 1) * sizeof *jobs);
+	}
+
 	for (i = 0; files[i] != NULL; ++i) {
 		char	*p = strrchr(files[i], '.');
 		char	*p2;
@@ -467,249 +890,50 @@ driver(char **cpp_flags, char *asm_flags, char *ld_flags, char **files) {
 		}
 #endif
 
-		if (strcmp(p, "c") == 0 || strcmp(p, "i") == 0) {
-			p2 = files[i];
-
-#ifdef DEBUG
-			printf("Preprocessed successfully as %s\n", p2);
-#endif
-
-			/* Compile file ``p2''. */
-			if ((pid = fork()) == -1) {
-				perror("fork");
-				exit(EXIT_FAILURE);
-			} else if (pid == 0) {
-				char	*nwcc1_args[512]; /* XXX */
-				char	*arch = NULL;
-				int	j = 0;
-				int	k = 0;
-
-				nwcc1_args[j++] = "nwcc1";
-				if (stackprotectflag) {
-					nwcc1_args[j++] = "-stackprotect";
-				}
-				if (gnuc_version) {
-					static char	gnubuf[128];
-					sprintf(gnubuf, "-gnuc=%s",
-						gnuc_version);	
-					nwcc1_args[j++] = gnubuf;
-				}
-				if (std_flag != NULL) {
-					static char	std[16];
-					sprintf(std, "-std=%s", std_flag);
-					nwcc1_args[j++] = std;
-				}
-				if (pedanticflag) {
-					nwcc1_args[j++] = "-pedantic";
-				}	
-				if (verboseflag) {
-					nwcc1_args[j++] = "-verbose";
-				}
-				if (nostdinc_flag) {
-					nwcc1_args[j++] = "-nostdinc";
-				}
-				if (picflag) {
-					nwcc1_args[j++] = "-fpic";
-				}
-				if (fulltocflag || (!mintocflag && !fulltocflag)) {
-					nwcc1_args[j++] = "-mfull-toc";
-				} else {
-					nwcc1_args[j++] = "-mminimal-toc";
-				}
-				if (stupidtraceflag) {
-					nwcc1_args[j++] = "-stupidtrace";
-				}
-
-
-				if (gflag) {
-					nwcc1_args[j++] = "-g";
-				}
-				if (Eflag) {
-					nwcc1_args[j++] = "-E";
-				}
-				if (Oflag) {
-					static char	obuf[16];
-					sprintf(obuf, "-O%d", Oflag);
-					nwcc1_args[j++] = obuf; 
-				}
-				if (write_fcat_flag) {
-					nwcc1_args[j++] = "-write-fcat";
-				}
-				if (save_bad_translation_unit_flag) {
-					nwcc1_args[j++] = "-save-bad-translation-unit";
-				}
-
-				/* XXX this should go into misc.c */
-				switch (archflag) {
-				case ARCH_X86:	
-					arch = "-arch=x86";
-					break;
-				case ARCH_AMD64:
-					arch = "-arch=amd64";
-					break;
-				case ARCH_POWER:
-					arch = "-arch=ppc";
-					break;
-				case ARCH_MIPS:
-					if (get_target_endianness() == ENDIAN_LITTLE) {
-						arch = "-arch=mipsel";
-					} else {
-						arch = "-arch=mips";
-					}
-					break;
-				case ARCH_SPARC:
-					arch = "-arch=sparc";
-					break;
-				case ARCH_PA:
-				case ARCH_ARM:
-				case ARCH_SH:
-					unimpl();
-				}
-				nwcc1_args[j++] = arch;
-					
-				if (abiflag != abiflag_default) {
-					if (abiflag != 0) {
-						nwcc1_args[j++] = /*abi*/
-							abi_to_option(abiflag);
-					}	
-				}
-
-				if (sysflag != sysflag_default) {
-					if (sysflag != 0) {
-						nwcc1_args[j++] = sys_to_option(sysflag);
-					}
-				}
-
-				if (asmflag) {
-					nwcc1_args[j] =
-						n_xmalloc(strlen(asmflag)+16);
-					sprintf(nwcc1_args[j++],
-						"-asm=%s", asmflag);	
-				}
-				if (cppflag) {
-					nwcc1_args[j] =
-						n_xmalloc(strlen(cppflag+16));
-					sprintf(nwcc1_args[j++],
-						"-cpp=%s", cppflag);
-				}
-				if (timeflag) {
-					nwcc1_args[j++] = n_xstrdup("-time");
-				}
-				if (funsignedchar_flag) {
-					nwcc1_args[j++] = n_xstrdup("-funsigned-char");
-				}
-				if (fsignedchar_flag) {
-					nwcc1_args[j++] = n_xstrdup("-fsigned-char");
-				}
-				if (fnocommon_flag) {
-					nwcc1_args[j++] = n_xstrdup("-fno-common");
-				}
-				if (notgnu_flag) {
-					nwcc1_args[j++] = n_xstrdup("-notgnu");
-				} else {
-					nwcc1_args[j++] = n_xstrdup("-gnu");
-				}
-				if (color_flag) {
-					nwcc1_args[j++] = n_xstrdup("-color");
-				}
-				if (dump_macros_flag) {
-					nwcc1_args[j++] = n_xstrdup("-dM");
-				}
-
-				if (custom_cpp_args) {
-					nwcc1_args[j++] = custom_cpp_args;
-				}
-
-				nwcc1_args[j++] = p2;
-				for (; cpp_flags[k] != NULL; ++j, ++k) {
-					nwcc1_args[j] = cpp_flags[k];
-				}
-				nwcc1_args[j] = NULL;
-#define DEVEL
-#ifdef DEVEL
-				execv("./nwcc1", nwcc1_args);
-#endif 
-
-				if ((p = getenv("NWCC_CC1")) != NULL) {
-					execv(p, nwcc1_args);
-					perror(p);
-				} else {	
-#if 0
-					execv("/usr/local/bin/nwcc1",
-						nwcc1_args);
-					perror("/usr/local/bin/nwcc1");
-#endif
-					execv(INSTALLDIR "/bin/nwcc1",
-						nwcc1_args);
-					perror(INSTALLDIR "/bin/nwcc1");
-				}
-				exit(EXIT_FAILURE);
-			} else {
-				if (waitpid(pid, &rc, 0) == -1) {
-					perror("waitpid");
-					exit(EXIT_FAILURE);
-				}
-				if (dump_macros_flag) {
-					/*
-					 * 05/19/09: -dM
-					 */
-					exit(EXIT_SUCCESS);
-				}
-				if (rc != 0) {
-					/* Try other files anyway */
-					has_errors = 1;
-					continue;
-				}
-			}
+		if ((strcmp(p, "c") == 0 || strcmp(p, "i") == 0) && parallel) {
+			static char	objbuf[FILENAME_MAX + 1];
+			char		*filep;
 
 			/*
-			 * nwcc just outputs with the same name as the input,
-			 * except that the ending is .asm instead of .cpp
+			 * Reserve the object file slot now so the link order
+			 * matches the command line. Failed jobs are removed
+			 * from output_names once all of them are done
 			 */
-#ifdef DEBUG
-			printf("Compiled successfully as %s\n", p2);
-#endif
-
-			if (Sflag || Eflag || write_fcat_flag) {
-				continue;
+			if ((filep = strrchr(files[i], '/')) != NULL) {
+				++filep;
+			} else {
+				filep = files[i];
 			}
+			sprintf(objbuf, "%.*s.o", (int)(p - filep - 1), filep);
 
-			p = p2;
-			p2 = n_xmalloc(strlen(p2) + sizeof ".asm");
-			strcpy(p2, p);
-			p = strrchr(p2, '.');
-			strcpy(++p, "asm");
-
-			/* Hopefully p2 is a valid .asm file now... */
-			if (timeflag) {
-				start_timer(&tv);
+			while (running >= jobsflag) {
+				if (reap_job(jobs, njobs) == -1) {
+					break;
+				}
+				--running;
+				while (next_replay < njobs
+					&& jobs[next_replay].done) {
+					replay_job_output(&jobs[next_replay++]);
+				}
 			}
+			jobs[njobs].out_slot = out_index;
+			(void) start_job(&jobs[njobs], files[i], cpp_flags,
+				asm_flags);
+			++njobs;
+			++running;
+			p2 = objbuf;
+		} else if (strcmp(p, "c") == 0 || strcmp(p, "i") == 0) {
+			int	cc1_failed;
 
-			if ((p = strrchr(p2, '/')) != NULL) {
-				char	*saved = p+1;
-				p2 = do_asm(p+1, asm_flags, abiflag);
-				remove(saved);
-			} else {
-				char	*saved_p2 = p2;
-				p2 = do_asm(p2, asm_flags, abiflag);
-				remove(saved_p2);
-			}	
+			p2 = compile_file(files[i], cpp_flags, asm_flags,
+				&cc1_failed);
 			if (p2 == NULL) {
-				/* Ignore failure, try other files anyway. */
+				/* Try other files anyway */
+				if (cc1_failed) {
+					has_errors = 1;
+				}
 				continue;
 			}
-
-			if (timeflag) {
-				int	res = stop_timer(&tv);
-				(void) fprintf(stderr,
-					"=== Timing for assembling ===\n");
-				(void) fprintf(stderr,
-					"    %f sec\n", res / 1000000.0);
-			}
-
-#ifdef DEBUG
-			printf("Assembled successfully as %s\n", p2);
-#endif
 		} else if (strcmp(p, "asm") == 0) {
 			p2 = do_asm(files[i], asm_flags, abiflag);
 			if (p2 == NULL) {
@@ -741,6 +965,42 @@ driver(char **cpp_flags, char *asm_flags, char *ld_flags, char **files) {
 		}
 	}
 
+	if (parallel) {
+		int	j;
+		int	k;
+
+		while (running > 0 && reap_job(jobs, njobs) != -1) {
+			--running;
+		}
+		while (next_replay < njobs) {
+			replay_job_output(&jobs[next_replay++]);
+		}
+
+		/* Drop the slots of jobs which did not produce an object */
+		for (j = 0; j < njobs; ++j) {
+			if (jobs[j].status == CC_JOB_CC1_ERR) {
+				has_errors = 1;
+			}
+			if (jobs[j].status != CC_JOB_OBJECT) {
+				free(output_names[jobs[j].out_slot]);
+				output_names[jobs[j].out_slot] = NULL;
+			}
+		}
+		for (j = k = 0; j < out_index; ++j) {
+			if (output_names[j] != NULL) {
+				output_names[k] = output_names[j];
+				output_del[k] = output_del[j];
+				++k;
+			}
+		}
+		out_index = k;
+		if (out_index == 0) {
+			free(output_names);
+			output_names = NULL;
+		}
+		free(jobs);
+	}
+
 	if (i == 0) {
 		fprintf(stderr, "Missing input files.\n");
 		return 1;
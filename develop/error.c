@@ -39,7 +39,6 @@
 #include "n_libc.h"
 
 static char	*file = NULL;
-static char	*lineptr = NULL;
 static int	*line = NULL;
 static FILE	*output;
 
@@ -57,11 +56,6 @@ err_setline(int *l) {
 	line = l;
 }
 
-void
-err_setlineptr(char *lp) {
-	lineptr = lp;
-}
-
 static int	is_inited = 0;
 static void 
 init_output(void) {
@@ -105,9 +99,6 @@ reset_text_color(void) {
 void
 print_source_line(const char *linep, const char *tokp, const char *tok, int as)
 {
-if (using_ucpp) {
-	return;
-}
 	if (linep != NULL) {
 		const char	*p;
 		size_t	len;
@@ -171,7 +162,7 @@ lexerror(char *fmt, ...) {
 	fputc('\n', output);
 
 
-	print_source_line(lineptr, lex_file_map + lex_chars_read, " ", 0); 
+	print_source_line(lex_line_ptr, lex_file_map + lex_chars_read, " ", 0); 
 		
 	va_end(v);
 	++errors;
@@ -191,13 +182,13 @@ errorfl(struct token *f, const char *fmt, ...) {
 		init_output();
 	}
 	if (f != NULL) {
-		file = f->file;
+		file = token_file(f);
 		line = &f->line;
 		fprintf(output, "%s:%d: Error: ", file? file : "<unknown>",
 						*line);
 		vfprintf(output, fmt, v);
 		fputc('\n', output);
-		print_source_line(f->line_ptr, f->tok_ptr, f->ascii, 0);
+		print_token_source_line(f, 0);
 	} else {
 		fprintf(output, "Error: ");
 		vfprintf(output, fmt, v);
@@ -209,6 +200,23 @@ errorfl(struct token *f, const char *fmt, ...) {
 }
 
 
+/*
+ * 10/17/26: Prints the source line containing token ``t'' with
+ * print_source_line()
+ */
+void
+print_token_source_line(struct token *t, int as) {
+	const char	*tokp = token_src_ptr(t);
+	const char	*linep;
+
+	if (tokp == NULL) {
+		return;
+	}
+	for (linep = tokp; linep > lex_file_map && linep[-1] != '\n'; --linep)
+		;
+	print_source_line(linep, tokp + 1, t->ascii, as);
+}
+
 
 /*
  * XXX line_ptr unused! if we use this, we need line_offset
@@ -218,9 +226,9 @@ struct token *
 errorfl_mk_tok(const char *f, int l, char *line_ptr) {
 	static struct token	tok;
 	(void) line_ptr;
-	tok.file = (char *)f;
+	tok.file_idx = token_file_index(f);
 	tok.line = l;
-	tok.line_ptr = NULL;
+	tok.src_off = 0;
 	return &tok;
 }
 
@@ -229,12 +237,13 @@ suppress_warning(struct token *tok) {
 	char	*f;
 
 	if (tok != NULL) {
-		f = tok->file;
+		f = token_file(tok);
 	} else {
 		f = file;
 	}
 
-	if (strncmp(f, "/usr/include/", strlen("/usr/include")) == 0) {
+	if (f != NULL
+		&& strncmp(f, "/usr/include/", strlen("/usr/include")) == 0) {
 		/*
 		 * 12/25/08: Suppress warnings about system headers (not
 		 * much we can do about those anyway) unless requested
@@ -293,7 +302,7 @@ vwarningfl(struct token *tok, const char *fmt, int tcol, va_list v) {
 	}
 
 	if (tok != NULL) {
-		file = f = tok->file;
+		file = f = token_file(tok);
 		l = tok->line;
 		line = &l;
 
@@ -304,7 +313,7 @@ vwarningfl(struct token *tok, const char *fmt, int tcol, va_list v) {
 		fprintf(output, "Warning: ");
 		vfprintf(output, fmt, v);
 		fputc('\n', output);
-		print_source_line(tok->line_ptr, tok->tok_ptr, tok->ascii, 0);
+		print_token_source_line(tok, 0);
 	} else {	
 		fprintf(output, "Warning: ");
 		vfprintf(output, fmt, v);
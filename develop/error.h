@@ -38,7 +38,6 @@ void err_setline(int *l);
  */
 void lexerror(char *fmt, ...);
 
-void err_setlineptr(char *l);
 
 /*
  * Same as error, but also lets caller specify file name and line
@@ -64,6 +63,9 @@ void warningfl(struct token *t, const char *fmt, ...);
 void
 print_source_line(const char*linep, const char*tokp, const char*tok, int as);
 
+void
+print_token_source_line(struct token *t, int as);
+
 void
 reset_text_color(void);
 
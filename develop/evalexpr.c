@@ -783,7 +783,16 @@ do_eval_const_expr(struct expr *tree, int extype, int is_paren_subex) {
 					struct ty_float	*fc;
 
 					fc = t->data;
-					ret.value = fc->num->value;
+
+					/*
+					 * 10/17/26: Copy the value, since
+					 * it may be converted in place and
+					 * freed, and the pooled constant
+					 * may be used again
+					 */
+					ret.value = zalloc_buf(Z_CEXPR_BUF);
+					memcpy(ret.value, fc->num->value,
+						cross_get_sizeof_type(ret.type));
 
 					/*
 					 * This constant is not needed
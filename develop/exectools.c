@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <errno.h>
 #include <assert.h>
 #include <sys/stat.h>
@@ -47,10 +48,43 @@
 #include "driver.h"
 #include "debug.h"
 #include "n_libc.h"
+#include "amd64_as.h"
 
 extern int gflag; /* XXX */
 extern int assembler; /* XXX */
 
+/*
+ * 10/17/26: Returns the object file name if the assembler flags consist
+ * of nothing but ``-o file'', which is all the integrated assembler
+ * understands
+ */
+static char *
+get_plain_output(const char *asm_flags, char *buf, size_t size) {
+	const char	*start;
+
+	while (isspace((unsigned char)*asm_flags)) {
+		++asm_flags;
+	}
+	if (strncmp(asm_flags, "-o", 2) != 0
+		|| !isspace((unsigned char)asm_flags[2])) {
+		return NULL;
+	}
+	for (asm_flags += 2; isspace((unsigned char)*asm_flags); ++asm_flags)
+		;
+	for (start = asm_flags; *asm_flags && !isspace((unsigned char)*asm_flags);
+		++asm_flags)
+		;
+	if (asm_flags == start || (size_t)(asm_flags - start) >= size) {
+		return NULL;
+	}
+	memcpy(buf, start, asm_flags - start);
+	buf[asm_flags - start] = 0;
+	while (isspace((unsigned char)*asm_flags)) {
+		++asm_flags;
+	}
+	return *asm_flags == 0? buf: NULL;
+}
+
 char *
 do_asm(char *file, char *asm_flags, int abiflag) {
 	static char	output_path[FILENAME_MAX + 1];
@@ -96,6 +130,30 @@ do_asm(char *file, char *asm_flags, int abiflag) {
 		 * integration in mixed 32/64bit AMD64 systems
 		 */
 		if (assembler == ASM_GAS) {
+			char		objname[FILENAME_MAX + 1];
+			const char	*reason;
+
+			/*
+			 * 10/17/26: Try the integrated assembler first. It
+			 * declines anything it cannot encode exactly like
+			 * gas, in which case gas is still run
+			 */
+			if (integrated_as_flag
+				&& archflag != ARCH_X86
+				&& !gflag
+				&& get_plain_output(asm_flags, objname,
+					sizeof objname) != NULL) {
+				if (amd64_as_assemble(file, objname,
+					&reason) == 0) {
+					return output_path;
+				}
+				if (verboseflag) {
+					(void) fprintf(stderr, "Integrated "
+						"assembler cannot handle %s: "
+						"%s - using %s\n",
+						file, reason, asmflag);
+				}
+			}
 			fd = exec_cmd(1, asmflag, " %s %s %s",
 				archflag == ARCH_X86? "--32": "--64", file, asm_flags);
 		} else {
@@ -59,6 +59,7 @@
 #include "evalexpr.h"
 #include "libnwcc.h"
 #include "n_libc.h"
+#include "lex.h"
 
 void
 append_expr(struct expr **head, struct expr **tail, struct expr *e) {
@@ -904,6 +905,122 @@ replace_cur_init(struct desig_init_data *data, struct initializer *init) {
 	data->cur_init_ptr = init->next;
 }
 
+/*
+ * 10/17/26: Checks whether the array element initializer at ``t'' is a
+ * plain, possibly negated, integer constant followed by `,' or `}' (as
+ * is typical for generated tables), and if so appends its value as
+ * element type ``ty'' to the byte image at the end of the initializer
+ * list. Returns the token following the constant, or NULL if the
+ * element has to be read by parse_expr()
+ */
+static struct token *
+put_init_bytes_elem(struct desig_init_data *data, struct token *t,
+	struct type *ty) {
+
+	struct initializer	*init = *data->init_tail;
+	struct init_bytes	*ib;
+	struct tyval		tv;
+	unsigned long long	val;
+	int			negate = 0;
+	int			size;
+
+	if (t->type == TOK_OPERATOR
+		&& (*(int *)t->data == TOK_OP_AMB_MINUS
+		|| *(int *)t->data == TOK_OP_UMINUS)) {
+		negate = 1;
+		t = t->next;
+	}
+	if (t == NULL
+		|| t->next == NULL
+		|| !(IS_INT(t->type) || IS_LONG(t->type) || IS_LLONG(t->type))
+		|| (t->next->type != TOK_COMP_CLOSE
+		&& (t->next->type != TOK_OPERATOR
+		|| *(int *)t->next->data != TOK_OP_COMMA))) {
+		return NULL;
+	}
+
+	tv.type = make_basic_type(t->type);
+	tv.value = t->data;
+	if (t->type == TY_INT || t->type == TY_LONG || t->type == TY_LLONG) {
+		val = (unsigned long long)cross_to_host_long_long(&tv);
+	} else if (negate) {
+		/* Negated unsigned value wraps in the constant type */
+		return NULL;
+	} else {
+		val = cross_to_host_unsigned_long_long(&tv);
+	}
+	if (negate) {
+		val = -val;
+	}
+
+	size = backend->get_sizeof_type(ty, NULL);
+	if (init == NULL || init->type != INIT_BYTES) {
+		init = alloc_initializer();
+		init->type = INIT_BYTES;
+		init->left_type = dup_type(ty);
+		ib = n_xmalloc(sizeof *ib);
+		memset(ib, 0, sizeof *ib);
+		init->data = ib;
+		append_init_list(data->init_head, data->init_tail, init);
+	} else {
+		ib = init->data;
+	}
+	if (ib->size + size > ib->alloc) {
+		ib->alloc = ib->alloc? ib->alloc * 2: 64;
+		ib->data = n_xrealloc(ib->data, ib->alloc);
+	}
+	(void) cross_put_target_bytes(ib->data + ib->size, ty->code, val);
+	ib->size += size;
+	++ib->nelem;
+	return t->next;
+}
+
+/*
+ * 10/17/26: Splits all byte images in the initializer list into one
+ * initializer per element. This is done when the first designated
+ * initializer is encountered, since that may replace any element
+ */
+static void
+split_init_bytes(struct desig_init_data *data) {
+	struct initializer	*init;
+	struct initializer	*next;
+
+	for (init = *data->init_head; init != NULL; init = next) {
+		struct init_bytes	*ib = init->data;
+		size_t			elemsize;
+		size_t			i;
+
+		next = init->next;
+		if (init->type != INIT_BYTES || ib->nelem < 2) {
+			continue;
+		}
+		elemsize = ib->size / ib->nelem;
+		for (i = 1; i < ib->nelem; ++i) {
+			struct initializer	*elem = dup_initializer(init);
+			struct init_bytes	*elemib;
+
+			elemib = n_xmalloc(sizeof *elemib);
+			elemib->data = n_xmemdup(ib->data + i * elemsize,
+				elemsize);
+			elemib->size = elemib->alloc = elemsize;
+			elemib->nelem = 1;
+			elem->data = elemib;
+
+			/* Insert in front of the next node */
+			elem->next = next;
+			elem->prev = next? next->prev: *data->init_tail;
+			elem->prev->next = elem;
+			if (next != NULL) {
+				next->prev = elem;
+			} else {
+				*data->init_tail = elem;
+			}
+		}
+		ib->size = ib->alloc = elemsize;
+		ib->nelem = 1;
+	}
+}
+
 /*
  * Put an initializer into the designated initializer list. As soon as the
  * first designated initializer is encountered, this function also has to
@@ -1646,6 +1763,7 @@ get_init_expr(struct token **tok, struct expr *saved_first_expr0,
 	int			needbrace = 0;
 	int			have_desig = 0;
 	int			struct_ends = 0;
+	int			use_bytes = 0;
 
 	init_data.init_head = &ret;
 	init_data.init_tail = &rettail;
@@ -2143,10 +2261,26 @@ skip_expr_reading:
 		}
 	}
 
-
+	/*
+	 * 10/17/26: Plain integer constant elements of braced scalar
+	 * array initializers are stored in a byte image
+	 */
+	if (is_array
+		&& needbrace
+		&& curtype->tlist == NULL
+		&& curtype->tbit == NULL
+		&& curtype->code != TY_BOOL
+		&& (IS_CHAR(curtype->code)
+		|| IS_SHORT(curtype->code)
+		|| IS_INT(curtype->code)
+		|| IS_LONG(curtype->code)
+		|| IS_LLONG(curtype->code))) {
+		use_bytes = 1;
+	}
 
 	do {
 		struct token		*starttok = t;
+		struct token		*nexttok;
 		struct sym_entry	*desig_se = NULL;
 		struct sym_entry	*prev_se = se;
 		int			desig_elem = -1;
@@ -2154,6 +2288,16 @@ skip_expr_reading:
 		
 		is_unnamed_bitfield = 0; /* 10/12/08 */
 
+		if (use_bytes
+			&& !have_desig
+			&& (nexttok = put_init_bytes_elem(&init_data, t,
+				curtype)) != NULL) {
+			t = nexttok;
+			++init_data.real_items_read;
+			init_data.highest_encountered_index = items_read;
+			goto elem_read;
+		}
+
 		if (se != NULL && se->dec->dtype->tbit != NULL && se->dec->dtype->name == NULL) {
 			/*
 			 * 10/12/08: Handle unnamed bitfields by skipping them
@@ -2235,6 +2379,9 @@ skip_expr_reading:
 			size_t		startelem;
 			size_t		endelem;
 
+			if (!have_desig && use_bytes) {
+				split_init_bytes(&init_data);
+			}
 			have_desig = 1;
 			if (next_token(&t) != 0) {
 				return NULL;
@@ -2393,6 +2540,7 @@ skip_expr_reading:
 					starttok, &items_read);	
 		}
 
+elem_read:
 		++items_read;
 		if (items_ok != 0) {
 			/*
@@ -2990,7 +3138,11 @@ recover(struct token **tok, int delim, int delim2) {
 		++braces;
 	}
 
-	for (t = *tok; t != NULL; t = t->next) {
+	/*
+	 * 10/17/26: The delimiter may be in a declaration which hasn't
+	 * been read by the streaming lexer yet, so use lex_next_token()
+	 */
+	for (t = *tok; t != NULL; t = lex_next_token(t)) {
 		int	ty = -1; /* 0 compared even with unused delim :( */
 
 #ifdef DEBUG2
@@ -34,6 +34,8 @@ struct ty_string;
 struct initializer;
 struct label;
 
+#include <stddef.h>
+
 struct addr_const {
 	/* If static variable */
 	struct decl	*dec;
@@ -70,6 +72,7 @@ struct initializer {
 #define INIT_NULL	3
 #define INIT_STRUCTEXPR	4
 #define INIT_BITFIELD	5
+#define INIT_BYTES	6 /* 10/17/26: data is struct init_bytes */
 	void			*data;
 	/*
 	 * If type = INIT_NULL and varinit != NULL, varinit is the
@@ -102,6 +105,21 @@ struct initializer {
 	struct initializer	*prev;
 };	
 
+/*
+ * 10/17/26: Flat image of consecutive constant scalar array elements,
+ * stored in target byte order. get_init_expr() folds plain integer
+ * constant elements into this, rather than creating an initializer
+ * with an expression for each element, since large tables would
+ * otherwise take huge amounts of time and memory. The initializer's
+ * left_type is the element type
+ */
+struct init_bytes {
+	unsigned char	*data;
+	size_t		size;	/* Bytes used */
+	size_t		alloc;
+	size_t		nelem;
+};
+
 struct init_with_name {
 	struct initializer	*init;
 	char			*name;
@@ -133,8 +133,14 @@
  * It is DISABLED now because it STILL has bugs! Doesn't compile ftp.c
  * of wget because of a huge bogus index (stack overflow?) in symlist.c
  * on line 444
+ *
+ * 10/17/26: Rewritten as one open addressing table keyed on identifier
+ * atoms, with per-name shadowing chains and cheap removal when a scope
+ * is closed (see symlist.c). This is now the default. The per-scope
+ * lists are still maintained, so setting this to 0 gives the old
+ * scope-by-scope lookup
  */
-#define FAST_SYMBOL_LOOKUP		0
+#define FAST_SYMBOL_LOOKUP		1
 
 /*
  * 08/13/09
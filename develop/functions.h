@@ -31,6 +31,7 @@ struct decl;
 struct function;
 struct icode;
 struct vreg;
+struct inline_info;
 
 
 extern struct function	*curfunc;
@@ -109,6 +110,17 @@ struct function {
 	struct stack_block	*regs_head;
 	struct stack_block	*regs_tail;
 	struct stack_block	*free_list;
+
+	/*
+	 * 10/17/26: Inliner data for static/extern inline functions
+	 * (see inliner.c), and whether a deferred inline function has
+	 * already been generated at the end of the translation unit
+	 */
+	struct inline_info	*inline_info;
+	int			generated;
+
+	/* 10/17/26: -ftime-report record (index + 1, or 0) */
+	int			prof_slot;
 };
 
 extern struct function	*funclist;
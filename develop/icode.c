@@ -53,6 +53,9 @@
 #include "scope.h"
 #include "x87_nonsense.h"
 #include "inlineasm.h"
+#include "peephole.h"
+#include "constprop.h"
+#include "inliner.h"
 #include "n_libc.h"
 
 int	optimizing;
@@ -95,6 +98,15 @@ fcall_to_icode(
 		}
 	}
 
+	if (eval) {
+		struct function	*f;
+
+		/* 10/17/26: Expand small inline functions at -O */
+		if ((f = inline_get_candidate(fcall)) != NULL) {
+			return inline_fcall_to_icode(f, fcall, il, t);
+		}
+	}
+
 	/* XXX bad */
 	if (fcall->callto != NULL) {
 		fty = fcall->callto->dtype;
@@ -166,6 +178,16 @@ fcall_to_icode(
 			args[i++] = ex->res;
 		}
 
+		if (eval && ex->op == 0 && ex->data != NULL) {
+			/*
+			 * 10/17/26: The only_load shortcut above must not
+			 * pick up the result of a previous translation of
+			 * this call (inline function bodies are translated
+			 * once per call site)
+			 */
+			ex->data->only_load = 0;
+		}
+
 		if (!eval) {
 			/*
 			 * 07/15/08: For constant expressions, reset
@@ -395,6 +417,36 @@ pro_mote(struct vreg **vr, struct icode_list *il, int eval) {
 }
 
 
+/*
+ * 10/17/26: Multiplications, divisions and modulo operations by
+ * constants which can_transform_to_bitwise() cannot handle are left to
+ * the x86 and AMD64 emitters, which turn them into lea, shifts and
+ * multiplications by the reciprocal (see emit_const_muldiv_gas_x86()).
+ * For that the constant operand must not be anonymified, or the
+ * emitter won't see its value anymore
+ */
+static int
+keep_const_operand(struct vreg *left, struct vreg *right, int op) {
+	if (op != TOK_OP_MOD
+		&& op != TOK_OP_DIVIDE
+		&& op != TOK_OP_MULTI
+		&& op != TOK_OP_COMOD
+		&& op != TOK_OP_CODIVIDE
+		&& op != TOK_OP_COMULTI) {
+		return 0;
+	}
+	if (Oflag == -1
+		|| (backend->arch != ARCH_X86 && backend->arch != ARCH_AMD64)) {
+		return 0;
+	}
+	return right->from_const != NULL
+		&& left->from_const == NULL
+		&& is_integral_type(left->type)
+		&& is_integral_type(right->type)
+		&& !left->is_multi_reg_obj
+		&& !right->is_multi_reg_obj;
+}
+
 /*
  * Perform usual arithmetic conversions
  */
@@ -492,7 +544,26 @@ convert_operands(
 					 * XXX 07/13/08: We should convert
 					 * constants at compile time!
 					 */
-					if (!(lt->code == TY_LONG
+					if (keep_const_operand(*left, *right,
+						op0)
+						&& (*right)->from_const->data2
+						== NULL
+						&& (IS_INT((*right)->from_const->type)
+						|| IS_LONG((*right)->from_const->type))) {
+						/*
+						 * 10/17/26: Convert the
+						 * constant at compile time
+						 * so that the emitter still
+						 * sees it
+						 */
+						(*right)->from_const =
+							cross_convert_const_token(
+							(*right)->from_const,
+							lt->code);
+						(*right)->type = lt;
+						(*right)->size = backend->
+							get_sizeof_type(lt, NULL);
+					} else if (!(lt->code == TY_LONG
 						&& rt->code == TY_UINT)
 	|| cross_get_target_arch_properties()->long_can_store_uint) {
 						*right = backend->
@@ -915,11 +986,26 @@ ptrarit(
 
 			tmpvr->from_const = const_from_value(&shift_by, NULL);
 
-			if (op == TOK_OP_PLUS) {
+			if (op == TOK_OP_PLUS
+				&& shift_by <= 3
+				&& Oflag != -1
+				&& (backend->arch == ARCH_X86
+				|| backend->arch == ARCH_AMD64)
+				&& toscale->size == addto->size
+				&& !addto->is_multi_reg_obj) {
+				/*
+				 * 10/17/26: Let the emitter use a scaled
+				 * index instead, i.e.
+				 *
+				 *    lea (addto, toscale, factor), addto
+				 */
+				factor = 1 << shift_by;
+				ii = icode_make_add(addto, toscale);
+				ii->dat = n_xmemdup(&factor, sizeof factor);
+				append_icode_list(ilp, ii);
+			} else if (op == TOK_OP_PLUS) {
 				ii = icode_make_shl(toscale, tmpvr);
 				append_icode_list(ilp, ii);
-			}	
-			if (op == TOK_OP_PLUS) {
 				ii = icode_make_add(addto, toscale);
 				append_icode_list(ilp, ii);
 			} else {
@@ -1165,11 +1251,14 @@ can_transform_to_bitwise(struct vreg **left, struct vreg **right,
 		 */
 		dest = left;
 		src = right;
-		if (op == TOK_OP_DIVIDE) {
+		if (op == TOK_OP_DIVIDE || op == TOK_OP_CODIVIDE) {
 			/*
 			 * 07/14/08: XXX: Turned shift transformation off for
 			 * signed values! Because negative values are not
 			 * handled correctly, the result is off by one
+			 *
+			 * 10/17/26: This was missing /=, which was still
+			 * turned into a shift for signed values
 			 */
 			if ((*left)->type->sign != TOK_KEY_UNSIGNED) {
 				return 0;
@@ -1757,8 +1846,10 @@ do_comp_assign(struct vreg *lres, struct vreg *rres,
 #endif
 			} else {	
 				vreg_faultin(NULL, NULL, lres, il, 0); 
-				vreg_faultin_protected(lres, NULL, NULL,
-					rres, il, 0); 
+				if (!keep_const_operand(lres, rres, op)) {
+					vreg_faultin_protected(lres, NULL,
+						NULL, rres, il, 0); 
+				}
 			}	
 		}
 		if (needprep) {
@@ -1913,6 +2004,14 @@ do_assign(
 			if (is_x87_trash(rres)
 				|| is_x87_trash(lres)) {
 				is_x87 = 1;
+			} else if (ex->op != TOK_OP_ASSIGN
+				&& keep_const_operand(lres, rres, ex->op)) {
+				/*
+				 * 10/17/26: Left to icode_prepare_op(),
+				 * which does not load the constant if the
+				 * emitter doesn't need it
+				 */
+				;
 			} else {
 				vreg_faultin(NULL, NULL, rres, ilp, 0);
 			}
@@ -1922,7 +2021,9 @@ do_assign(
 	if (ex->op != TOK_OP_ASSIGN) {
 		/* Compound assignment operator */
 		if (eval && !is_x87) {
-			vreg_faultin(NULL, NULL, rres, ilp, 0);
+			if (!keep_const_operand(lres, rres, ex->op)) {
+				vreg_faultin(NULL, NULL, rres, ilp, 0);
+			}
 			vreg_faultin_protected(rres, NULL, NULL, lres, ilp, 0);
 		}
 		if (!eval)  {  /*rres->type->tbit != NULL || is_bitfield) {*/
@@ -2696,6 +2797,12 @@ do_cond(
 	struct control *ctrl,
 	struct vreg *have_cmp);
 
+/*
+ * 10/17/26: Nesting level of expr_to_icode(); Was a static variable in
+ * that function, but xlate_nested_to_icode() has to reset it
+ */
+static int	expr_level;
+
 struct vreg *
 expr_to_icode(
 	struct expr *ex,
@@ -2714,14 +2821,13 @@ expr_to_icode(
 	struct type		*restype = NULL;
 	struct type		*ltold;
 	struct type		*rtold;
-	static int		level;
 	struct reg		*r;
 	int			tmpop;
 	struct vreg		*temp_rres = NULL;
 	struct vreg		*temp_lres = NULL;
 	int			changed_vrs = 0;
 
-	if (level++ == 0 && eval) {
+	if (expr_level++ == 0 && eval) {
 		/* Initialize allocator */
 		/*
 		 * XXX July 2007: This SUCKS! I wasn't aware it's still
@@ -2773,7 +2879,7 @@ expr_to_icode(
 				if (ilp) {
 					/* XXX free */
 				}
-				--level;
+				--expr_level;
 				return NULL;
 			}
 
@@ -2803,7 +2909,7 @@ expr_to_icode(
 				
 				if ((restype = promote(&lres, &rres,
 					ex->op, ex->tok, ilp, eval)) == NULL) {
-					--level;
+					--expr_level;
 					return NULL;
 				}
 							
@@ -2838,7 +2944,7 @@ expr_to_icode(
 			if (ex->left->op != 0) {
 				errorfl(ex->left->tok,
 					"Bad lvalue in assignment");
-				--level;
+				--expr_level;
 				return NULL;
 			}
 
@@ -2848,13 +2954,13 @@ expr_to_icode(
 			 */
 			if ((lres = expr_to_icode(ex->left, NULL, ilp, TOK_OP_ASSIGN, 0, eval))
 				== NULL) {
-				--level;
+				--expr_level;
 				return NULL;
 			}
 			if (!ex->left->data->is_lvalue) {
 				errorfl(ex->tok,
 			"Left operand in assignment is not an lvalue");
-				--level;
+				--expr_level;
 				return NULL;
 			}
 			lres = ex->left->data->res;
@@ -2863,7 +2969,7 @@ expr_to_icode(
 			rres = expr_to_icode(ex->right, lres, ilp,
 				/*purpose*/0, 0, eval);
 			if (rres == NULL) {
-				--level;
+				--expr_level;
 				return NULL;
 			}
 
@@ -2899,7 +3005,9 @@ expr_to_icode(
 				if (!can_transform_to_bitwise(&lres, &rres,
 					&tmpop, ilp)) {
 					/* 07/03/08: Eval */
-					if (rres->from_const && eval) {
+					if (rres->from_const && eval
+						&& !keep_const_operand(lres,
+						rres, tmpop)) {
 						vreg_anonymify(&rres, NULL,
 							NULL, ilp);
 					}
@@ -2907,8 +3015,8 @@ expr_to_icode(
 				ex->op = tmpop;
 
 				if ((ret = do_assign(lres, rres, ex, ilp,
-					level, purpose, eval)) == NULL) {
-					--level;
+					expr_level, purpose, eval)) == NULL) {
+					--expr_level;
 					return NULL;
 				}	
 				ex->op = savedop;
@@ -2938,7 +3046,7 @@ expr_to_icode(
 			lres = expr_to_icode(ex->left, NULL, ilp,
 				/*purpose*/0, 0, eval);
 			if (lres == NULL) {
-				--level;
+				--expr_level;
 				return NULL;
 			}	
 
@@ -3004,7 +3112,7 @@ expr_to_icode(
 			rres = expr_to_icode(ex->right, NULL, ilp,
 				/*purpose*/ 0, 0, eval);
 			if (rres == NULL) {
-				--level;
+				--expr_level;
 				return NULL;
 			}	
 			
@@ -3079,17 +3187,33 @@ expr_to_icode(
 					backend->icode_prepare_op(&lres, &rres,
 						tmpop, ilp);
 				} else {
+					int	keep = 0;
+
 					if (rres->from_const) {
-						vreg_anonymify(&rres, NULL,
-							NULL, ilp);
+						keep = keep_const_operand(lres,
+							rres, tmpop);
+						if (!keep) {
+							vreg_anonymify(&rres,
+								NULL, NULL,
+								ilp);
+						}
 					} else if (lres->from_const) {
 						vreg_anonymify(&lres, NULL,
 							NULL, ilp);
 					}
 	
 					vreg_faultin(NULL, NULL, lres, ilp, tmpop);
-					vreg_faultin_protected(lres, NULL, NULL,
-						rres, ilp, 0);
+					if (!keep) {
+						/*
+						 * 10/17/26: A kept constant
+						 * is only loaded by
+						 * icode_prepare_op() if
+						 * the emitter needs it
+						 */
+						vreg_faultin_protected(lres,
+							NULL, NULL, rres,
+							ilp, 0);
+					}
 	
 					backend->icode_prepare_op(&lres, &rres,
 						tmpop, ilp);
@@ -3109,7 +3233,7 @@ expr_to_icode(
 				|| tmpop == TOK_OP_MOD) {
 				if (do_mul(&temp_lres, temp_rres, operator,
 					ex->tok, ilp, eval)) {
-					--level;
+					--expr_level;
 					return NULL;
 				}
 
@@ -3121,7 +3245,7 @@ expr_to_icode(
 				|| tmpop == TOK_OP_BXOR) {
 				if (do_bitwise(&temp_lres, temp_rres, operator, ex->tok,
 					ilp, eval)) {
-					--level;
+					--expr_level;
 					return NULL;
 				}
 				ii = NULL;
@@ -3182,7 +3306,7 @@ expr_to_icode(
 			/* Conditional operator */
 			ret = do_cond_op(ex, &restype, lvalue, ilp, eval);
 			if (ret == NULL) {
-				--level;
+				--expr_level;
 				return NULL;
 			}	
 			break;
@@ -3200,7 +3324,7 @@ expr_to_icode(
 			
 			/* 07/03/08: Eval */
 			if (eval) {
-				if (purpose != TOK_KEY_IF || level != 1) {
+				if (purpose != TOK_KEY_IF || expr_level != 1) {
 					/*
 					 * Need to allocate gpr so it isn't wiped out
 					 * by faultins below
@@ -3243,7 +3367,7 @@ expr_to_icode(
 		
 			/* 07/03/08: Eval */
 			if (eval) {
-				if (purpose == TOK_KEY_IF && level == 1) {
+				if (purpose == TOK_KEY_IF && expr_level == 1) {
 					/*
 					 * We want to generate the expected cmp + je
 					 * for ``if (stuff == stuff)'' so the caller
@@ -3306,7 +3430,7 @@ expr_to_icode(
 		 * ``standalone'' expression whose value is not used.
 		 * That allows us to optimize ``i--;'' to ``--i;''
 		 */
-		if (resval_not_used && level == 1) {
+		if (resval_not_used && expr_level == 1) {
 			standalone_subexpr = 1;
 		} else {
 			standalone_subexpr = 0;
@@ -3317,7 +3441,7 @@ expr_to_icode(
 			ex->data->code, standalone_subexpr, eval);
 		if (eval) {
 			if ((ilp->res = ret) == NULL) {
-				--level;
+				--expr_level;
 				return NULL;
 			}
 		}
@@ -3391,7 +3515,7 @@ expr_to_icode(
 			backend->invalidate_gprs(ilp, 1, 0);  /* save */
 			tmp = xlate_to_icode(ex->stmt_as_expr->code, 0);
 			if (tmp == NULL) {
-				--level;
+				--expr_level;
 				return NULL;
 			}	
 			merge_icode_lists(ilp, tmp);
@@ -3413,7 +3537,7 @@ expr_to_icode(
 	if (eval && ret) {
 		ilp->res = ret;
 	}
-	if (--level == 0 && eval) {
+	if (--expr_level == 0 && eval) {
 		if (ilp->res->pregs[0] != NULL
 			&& ilp->res->pregs[0]->vreg == ilp->res) {
 			vreg_map_preg(ilp->res, ilp->res->pregs[0]);
@@ -4205,9 +4329,303 @@ icode_align_ptr_up_to(struct vreg *ptr,
 }
 
 
+/*
+ * 10/17/26: Switch statement lowering. Switches with only a few cases
+ * are translated to a linear compare-and-branch chain as before. Larger
+ * ones become a jump table if the case values are dense enough and the
+ * emitter supports it, and a balanced binary compare tree otherwise
+ */
+#define SWITCH_LINEAR_MAX	4	/* Max cases for linear chain */
+#define SWITCH_TABLE_MAX	4096	/* Max jump table entries */
+#define SWITCH_TABLE_DENSITY	3	/* Max entries per case label */
+
+struct switch_case {
+	struct label		*label;
+	struct token		*tok;
+	unsigned long long	key;
+};
+
+static int
+compare_switch_cases(const void *p1, const void *p2) {
+	const struct switch_case	*c1 = p1;
+	const struct switch_case	*c2 = p2;
+
+	if (c1->key < c2->key) {
+		return -1;
+	} else if (c1->key > c2->key) {
+		return 1;
+	}
+	return 0;
+}
+
+static void
+switch_cmp_branch(struct vreg *vr_cond, struct token *casetok,
+	struct icode_instr *label, int btype, struct icode_list *il) {
+
+	struct vreg		*vr_case;
+	struct icode_instr	*ii;
+
+	vr_case = vreg_alloc(NULL, casetok, NULL, NULL);
+	vreg_faultin_protected(vr_cond, NULL, NULL, vr_case, il, 0);
+	vreg_faultin_protected(vr_case, NULL, NULL, vr_cond, il, 0);
+
+	ii = icode_make_cmp(vr_cond, vr_case);
+	append_icode_list(il, ii);
+	free_pregs_vreg(vr_case, il, 0, 0);
+	ii = icode_make_branch(label, btype, vr_cond);
+	append_icode_list(il, ii);
+	if (vr_cond->is_multi_reg_obj) {
+		ii = icode_make_cmp(vr_cond, vr_case);
+		append_icode_list(il, ii);
+		ii = icode_make_branch(label, btype, vr_cond);
+		append_icode_list(il, ii);
+	}
+}
+
+/*
+ * Generate a binary search over the sorted cases lo ... hi. Every compare
+ * is immediately followed by its branch because the RISC emitters only
+ * remember the last compare for a single branch
+ */
+static void
+switch_tree_to_icode(struct vreg *vr_cond, struct switch_case *cases,
+	int lo, int hi, struct icode_instr *default_label,
+	struct icode_list *il) {
+
+	struct icode_instr	*upper;
+	int			mid;
+	int			i;
+
+	if (hi - lo + 1 <= SWITCH_LINEAR_MAX) {
+		for (i = lo; i <= hi; ++i) {
+			switch_cmp_branch(vr_cond, cases[i].tok,
+				cases[i].label->instr, INSTR_BR_EQUAL, il);
+		}
+		append_icode_list(il, icode_make_jump(default_label));
+		return;
+	}
+
+	mid = lo + (hi - lo) / 2;
+	upper = icode_make_label(NULL);
+	switch_cmp_branch(vr_cond, cases[mid].tok,
+		cases[mid].label->instr, INSTR_BR_EQUAL, il);
+	switch_cmp_branch(vr_cond, cases[mid].tok,
+		upper, INSTR_BR_GREATER, il);
+	switch_tree_to_icode(vr_cond, cases, lo, mid - 1, default_label, il);
+	append_icode_list(il, upper);
+	switch_tree_to_icode(vr_cond, cases, mid + 1, hi, default_label, il);
+}
+
+static struct token *
+make_size_t_const(unsigned long long value) {
+	struct token	*ret = alloc_token();
+
+	ret->type = backend->get_size_t()->code;
+	ret->data = zalloc_buf(Z_CEXPR_BUF);
+	cross_to_type_from_host_long_long(ret->data, ret->type,
+		(long long)value);
+	return ret;
+}
+
+/*
+ * Jump through a table indexed by (size_t)cond - min. The subtraction is
+ * done after the conversion to size_t, so a single unsigned comparison
+ * catches values below and above the case range
+ */
+static void
+switch_table_to_icode(struct vreg *vr_cond, struct switch_case *cases,
+	int ncases, struct icode_instr *default_label,
+	struct icode_list *il) {
+
+	struct switch_table	*tab;
+	struct vreg		*vr_idx;
+	struct vreg		*vr_tmp;
+	struct reg		*tmpreg = NULL;
+	struct icode_instr	*ii;
+	unsigned long long	min = cases[0].key;
+	unsigned long long	range = cases[ncases - 1].key - min;
+	size_t			i;
+
+	tab = n_xmalloc(sizeof *tab);
+	tab->label = icode_make_label(NULL);
+	tab->nentries = range + 1;
+	tab->targets = n_xmalloc(tab->nentries * sizeof *tab->targets);
+	for (i = 0; i < tab->nentries; ++i) {
+		tab->targets[i] = default_label;
+	}
+	for (i = 0; i < (size_t)ncases; ++i) {
+		tab->targets[cases[i].key - min] = cases[i].label->instr;
+	}
+
+	vreg_faultin(NULL, NULL, vr_cond, il, 0);
+	vr_idx = vr_cond;
+	vreg_anonymify(&vr_idx, NULL, NULL, il);
+	vr_idx = backend->icode_make_cast(vr_idx, backend->get_size_t(), il);
+
+	if (min != 0) {
+		/*
+		 * The keys of signed values are biased by 2^63, which
+		 * cancels out in the range but not in the minimum
+		 */
+		if (vr_cond->type->sign != TOK_KEY_UNSIGNED) {
+			min ^= 1ULL << 63;
+		}
+		if (min != 0) {
+			vr_tmp = vreg_alloc(NULL, make_size_t_const(min),
+				NULL, NULL);
+			vreg_faultin_protected(vr_idx, NULL, NULL, vr_tmp,
+				il, 0);
+			vreg_faultin_protected(vr_tmp, NULL, NULL, vr_idx,
+				il, 0);
+			ii = icode_make_sub(vr_idx, vr_tmp);
+			append_icode_list(il, ii);
+			free_pregs_vreg(vr_tmp, il, 0, 0);
+		}
+	}
+
+	vr_tmp = vreg_alloc(NULL, make_size_t_const(range), NULL, NULL);
+	vreg_faultin_protected(vr_idx, NULL, NULL, vr_tmp, il, 0);
+	vreg_faultin_protected(vr_tmp, NULL, NULL, vr_idx, il, 0);
+	ii = icode_make_cmp(vr_idx, vr_tmp);
+	append_icode_list(il, ii);
+	free_pregs_vreg(vr_tmp, il, 0, 0);
+	ii = icode_make_branch(default_label, INSTR_BR_GREATER, vr_idx);
+	append_icode_list(il, ii);
+
+	if (backend->arch == ARCH_AMD64) {
+		/* Needed to form the RIP-relative table address */
+		reg_set_unallocatable(vr_idx->pregs[0]);
+		tmpreg = ALLOC_GPR(curfunc, backend->get_ptr_size(), il, NULL);
+		reg_set_allocatable(vr_idx->pregs[0]);
+	}
+	icode_make_switch_table(vr_idx->pregs[0], tmpreg, tab, il);
+	if (tmpreg != NULL) {
+		free_preg(tmpreg, il, 1, 0);
+	}
+	free_pregs_vreg(vr_idx, il, 0, 0);
+}
+
+static int
+switch_can_use_table(struct vreg *vr_cond, struct switch_case *cases,
+	int ncases) {
+
+	unsigned long long	range;
+
+	if (emit->switch_table == NULL) {
+		return 0;
+	}
+	if (backend->arch == ARCH_X86 && picflag) {
+		/* Absolute table addresses are not usable */
+		return 0;
+	}
+	if (backend->get_sizeof_type(vr_cond->type, NULL)
+		> backend->get_sizeof_type(backend->get_size_t(), NULL)) {
+		return 0;
+	}
+	range = cases[ncases - 1].key - cases[0].key;
+	return range < SWITCH_TABLE_MAX
+		&& range + 1 <= (unsigned long long)ncases * SWITCH_TABLE_DENSITY;
+}
+
+static void
+switch_to_icode(struct vreg **vr_cond0, struct control *ctrl,
+	struct icode_instr *default_label, struct icode_list *il) {
+
+	struct label		*label;
+	struct switch_case	*cases;
+	struct vreg		*vr_cond;
+	struct tyval		*tv;
+	int			ncases = 0;
+	int			i;
+
+	for (label = ctrl->labels; label != NULL; label = label->next) {
+		if (label->value != NULL && label->is_switch_label) {
+			++ncases;
+		}
+	}
+	if (ncases == 0) {
+		return;
+	}
+	cases = n_xmalloc(ncases * sizeof *cases);
+
+	i = 0;
+	for (label = ctrl->labels;
+		label != NULL;
+		label = label->next) {
+		if (label->value == NULL || !label->is_switch_label) {
+			continue;
+		}
+
+		/*
+		 * 08/22/07: This did usual arithmetic conversion
+		 * betwen condition and case, instead of converting
+		 * case to condition. Also, const_from_value was
+		 * called on the original case value, such that
+		 *
+		 *     case ((char)1):
+		 *
+		 * would instruct the backend to load an ``immediate
+		 * char'', which if bogus. Now the condition is
+		 * instead promoted, and then the case is converted
+		 * to it.
+		 *
+		 * Another problem with that:
+		 *
+		 *    switch (enum_type) {
+		 *    case value:
+		 *
+		 * ... would convert value to an enum type, which is
+		 * also not handled by the backends. Thus the TY_INT
+		 * workaround below.
+		 */
+		(void) promote(vr_cond0, NULL, 0, NULL, il, 1);
+		vr_cond = *vr_cond0;
+		tv = label->value->const_value;
+		cross_do_conv(tv, vr_cond->type->code, 1);
+		tv->type->code = vr_cond->type->code == TY_ENUM? TY_INT:
+			vr_cond->type->code;
+		cases[i].label = label;
+		cases[i].tok = const_from_value(tv->value, tv->type);
+		if (vr_cond->type->sign == TOK_KEY_UNSIGNED) {
+			cases[i].key = cross_to_host_unsigned_long_long(tv);
+		} else {
+			/* Bias so that unsigned order matches signed order */
+			cases[i].key = (unsigned long long)
+				cross_to_host_long_long(tv) ^ (1ULL << 63);
+		}
+		++i;
+	}
+
+	if (ncases <= SWITCH_LINEAR_MAX
+		|| Oflag == -1
+		|| vr_cond->is_multi_reg_obj) {
+		for (i = 0; i < ncases; ++i) {
+			switch_cmp_branch(vr_cond, cases[i].tok,
+				cases[i].label->instr, INSTR_BR_EQUAL, il);
+		}
+	} else {
+		qsort(cases, ncases, sizeof *cases, compare_switch_cases);
+		if (switch_can_use_table(vr_cond, cases, ncases)) {
+			switch_table_to_icode(vr_cond, cases, ncases,
+				default_label, il);
+		} else {
+			vreg_faultin(NULL, NULL, vr_cond, il, 0);
+			reg_set_unallocatable(vr_cond->pregs[0]);
+			switch_tree_to_icode(vr_cond, cases, 0, ncases - 1,
+				default_label, il);
+			reg_set_allocatable(vr_cond->pregs[0]);
+		}
+	}
+	free(cases);
+}
+
+
 void
 xlate_decl(struct decl *d, struct icode_list *il);
 
+static void
+dealloc_jump_vlas(struct control *ctrl, struct icode_list *il);
+
 struct icode_list *
 ctrl_to_icode(struct control *ctrl) {
 	struct icode_list	*il;
@@ -4359,9 +4777,7 @@ ctrl_to_icode(struct control *ctrl) {
 			append_icode_list(il, ctrl->endlabel);
 		}
 	} else if (ctrl->type == TOK_KEY_SWITCH) {
-		struct token	*cond;
 		struct vreg	*vr_cond;
-		struct vreg	*vr_case;
 		struct label	*default_case = NULL;
 
 		vr_cond = expr_to_icode(ctrl->cond, NULL, il, 0, 0, 1);
@@ -4381,83 +4797,12 @@ ctrl_to_icode(struct control *ctrl) {
 		for (label = ctrl->labels;
 			label != NULL;
 			label = label->next) {
-			if (label->value == NULL) {
-				if (label->is_switch_label) {
-					default_case = label;
-				}
-				continue;
-			} else if (!label->is_switch_label) {
-				continue;
-			}
-
-			/*
-			 * 08/22/07: This did usual arithmetic conversion
-			 * betwen condition and case, instead of converting
-			 * case to condition. Also, const_from_value was
-			 * called on the original case value, such that
-			 *
-			 *     case ((char)1):
-			 *
-			 * would instruct the backend to load an ``immediate
-			 * char'', which if bogus. Now the condition is
-			 * instead promoted, and then the case is converted
-			 * to it.
-			 *
-			 * Another problem with that:
-			 *
-			 *    switch (enum_type) {
-			 *    case value:
-			 *
-			 * ... would convert value to an enum type, which is
-			 * also not handled by the backends. Thus the TY_INT
-			 * workaround below.
-			 */
-			 
-			(void) promote(&vr_cond, NULL, 0, NULL, il, 1);
-			cross_do_conv(label->value->const_value,
-				vr_cond->type->code, 1);
-			label->value->const_value->type->code =
-				vr_cond->type->code == TY_ENUM? TY_INT:
-				vr_cond->type->code;
-			cond = const_from_value(
-					label->value->const_value->value,
-					label->value->const_value->type);
-			vr_case = vreg_alloc(NULL, cond, NULL, NULL); 
-			vreg_faultin_protected(vr_cond, NULL, NULL,
-				vr_case, il, 0); 
-			vreg_faultin_protected(vr_case, NULL, NULL,
-				vr_cond, il, 0); 
-#if 0
-			cond = const_from_value(
-					label->value->const_value->value,
-					label->value->const_value->type);
-			vr_case = vreg_alloc(NULL, cond, NULL, NULL); 
-			vreg_faultin(NULL, NULL, vr_case, il, 0); 
-			vreg_faultin_protected(vr_case, NULL, NULL,
-				vr_cond, il, 0); 
-			(void) promote(&vr_cond, &vr_case,
-				     TOK_OP_LEQU, NULL, il, 1);
-
-			/* XXX .... as promote may move stuff :( */
-			vreg_faultin(NULL, NULL, vr_case, il, 0); 
-			vreg_faultin_protected(vr_case, NULL, NULL,
-				vr_cond, il, 0); 
-#endif
-
-			ii = icode_make_cmp(vr_cond, vr_case);
-			append_icode_list(il, ii);
-			free_pregs_vreg(vr_case, il, 0, 0);
-			ii = icode_make_branch(label->instr, INSTR_BR_EQUAL,
-				vr_cond);
-			append_icode_list(il, ii);
-			if (vr_cond->is_multi_reg_obj) {
-				ii = icode_make_cmp(vr_cond, vr_case);
-				append_icode_list(il, ii);
-				ii = icode_make_branch(label->instr,
-					INSTR_BR_EQUAL, vr_cond);
-				append_icode_list(il, ii);
+			if (label->value == NULL && label->is_switch_label) {
+				default_case = label;
 			}
 		}
+		switch_to_icode(&vr_cond, ctrl, default_case != NULL?
+			default_case->instr: ctrl->endlabel, il);
 		free_pregs_vreg(vr_cond, il, 0, 0);
 		if (default_case != NULL) {
 			ii = icode_make_jump(default_case->instr);
@@ -4482,9 +4827,18 @@ ctrl_to_icode(struct control *ctrl) {
 		struct vreg		*vr = NULL;
 		struct type		*ret_type = NULL;
 		struct type_node	*rettn;
+		struct function		*func;
+
+		/*
+		 * 10/17/26: This may be the body of an inline function
+		 * which is expanded into curfunc
+		 */
+		if ((func = inline_current_function()) == NULL) {
+			func = curfunc;
+		}
 
 		if (ctrl->cond == NULL) {
-			for (rettn = curfunc->proto->dtype->tlist;
+			for (rettn = func->proto->dtype->tlist;
 				rettn != NULL;
 				rettn = rettn->next) {
 				if (rettn->type == TN_FUNCTION) {
@@ -4493,7 +4847,7 @@ ctrl_to_icode(struct control *ctrl) {
 				}
 			}	
 
-			if (curfunc->proto->dtype->code != TY_VOID
+			if (func->proto->dtype->code != TY_VOID
 				|| rettn != NULL) { 
 				warningfl(ctrl->tok,
 "Return statement without a value in function not returning `void'");
@@ -4513,7 +4867,7 @@ ctrl_to_icode(struct control *ctrl) {
 			ret_type->tlist = ret_type->tlist->next;
 #endif
 			/* 06/17/08: Stop the tlist kludgery for return type */
-			ret_type = curfunc->rettype;
+			ret_type = func->rettype;
 			if (check_types_assign(ctrl->tok, ret_type, vr, 1, 0)
 				!= 0) {
 				return NULL;
@@ -4544,13 +4898,19 @@ ctrl_to_icode(struct control *ctrl) {
 #endif
 		}
 
-		if (backend->icode_make_return(vr, il) != 0) {
+		if (func != curfunc) {
+			if (inline_return_to_icode(ctrl, vr, il) != 0) {
+				return NULL;
+			}
+		} else if (backend->icode_make_return(vr, il) != 0) {
 			return NULL;
 		}
 	} else if (ctrl->type == TOK_KEY_BREAK) {
+		dealloc_jump_vlas(ctrl, il);
 		ii = icode_make_jump(ctrl->endlabel);
 		append_icode_list(il, ii);
 	} else if (ctrl->type == TOK_KEY_CONTINUE) {
+		dealloc_jump_vlas(ctrl, il);
 		ii = icode_make_jump(ctrl->startlabel);
 		append_icode_list(il, ii);
 	} else if (ctrl->type == TOK_KEY_GOTO) {
@@ -4628,6 +4988,7 @@ varinit_to_icode(struct decl *dest,
 		switch (init->type) {
 		case INIT_EXPR:
 		case INIT_STRUCTEXPR:
+		case INIT_BYTES:
 			/* Nothing to do */
 			break;
 		case INIT_NESTED:
@@ -4780,6 +5141,8 @@ varinit_to_icode(struct decl *dest,
 				 * than the explicitly set 0 data size field
 				 */
 				type_size = *(size_t *)init->data;
+			} else if (init->type == INIT_BYTES) {
+				type_size = ((struct init_bytes *)init->data)->size;
 			} else {
 				type_size = backend->get_sizeof_type(init->left_type,
 					NULL);
@@ -4818,6 +5181,36 @@ varinit_to_icode(struct decl *dest,
 /*
  * Generate initializations for automatic variables
  */
+/*
+ * Converts the scalar value ``vr'' to the type of ``d'' and stores it
+ * there
+ * 10/17/26: Moved out of init_to_icode() for the inliner, which also
+ * assigns arguments and return values to declarations
+ */
+void
+icode_make_store_decl(struct decl *d, struct vreg *vr, struct icode_list *il) {
+	struct vreg	*decvr;
+
+	decvr = vreg_alloc(d, NULL, NULL, NULL);
+	vreg_set_new_type(decvr, d->dtype);
+
+	vr = backend->icode_make_cast(vr, d->dtype, il);
+	vreg_faultin_x87(NULL, NULL, vr, il, 0);
+	vreg_map_preg(/*d->vreg*/ decvr, vr->pregs[0]);
+	if (vr->is_multi_reg_obj) {
+		vreg_map_preg2(/*d->vreg*/ decvr, vr->pregs[1]);
+	}
+	icode_make_store(NULL,
+		/*d->vreg, d->vreg*/ decvr, decvr, il);
+	if (STUPID_X87(vr->pregs[0])) {
+#if 0
+		backend->free_preg(vr->pregs[0], il);
+#endif
+		vr->pregs[0]->vreg = NULL;
+		vr->pregs[0] = NULL;
+	}	
+}
+
 void
 init_to_icode(struct decl *d, struct icode_list *il) {
 	struct initializer	*init;
@@ -4874,21 +5267,7 @@ init_to_icode(struct decl *d, struct icode_list *il) {
 		}
 
 		if (init->type != INIT_STRUCTEXPR) {
-			vr = backend->icode_make_cast(vr, d->dtype, il);
-			vreg_faultin_x87(NULL, NULL, vr, il, 0);
-			vreg_map_preg(/*d->vreg*/ decvr, vr->pregs[0]);
-			if (vr->is_multi_reg_obj) {
-				vreg_map_preg2(/*d->vreg*/ decvr, vr->pregs[1]);
-			}
-			icode_make_store(NULL,
-				/*d->vreg, d->vreg*/ decvr, decvr, il);
-			if (STUPID_X87(vr->pregs[0])) {
-#if 0
-				backend->free_preg(vr->pregs[0], il);
-#endif
-				vr->pregs[0]->vreg = NULL;
-				vr->pregs[0] = NULL;
-			}	
+			icode_make_store_decl(d, vr, il);
 		} else {
 			/*
 			 * 08/16/07: This generated a bad struct copy if the
@@ -5114,13 +5493,19 @@ vla_decl_to_icode(struct type *ty, struct icode_list *il) {
 	 *        void *addr;
 	 *        unsigned long total_size;
 	 *        unsigned long var_dim_sizes[1];
+	 *        void *saved_sp;
 	 *    };
 	 *
+	 * 10/17/26: saved_sp is always the last slot. Backends which
+	 * allocate VLAs on the stack record the stack pointer from
+	 * before the allocation in it, such that the storage can be
+	 * released again when the declaring scope is left
+	 *
 	 * XXX for now we assume alignof(unsigned long)
 	 * = alignof(void *)
 	 */
 	sb = make_stack_block(0,
-		backend->get_ptr_size()
+		2 * backend->get_ptr_size()
 		+ (1 + total_vla_dims) *
 		backend->get_sizeof_type(
 			make_basic_type(TY_ULONG), NULL));	
@@ -5292,6 +5677,15 @@ xlate_func_to_icode(struct function *func) {
 	if (backend->icode_complete_func != NULL) {
 		backend->icode_complete_func(func, func->icode);
 	}
+
+	if (Oflag > 0) {
+		/*
+		 * 10/17/26: Propagate constants, then clean up the icode
+		 * before it is emitted
+		 */
+		constprop_optimize(func);
+		peephole_optimize(func);
+	}
 }
 
 void
@@ -5350,6 +5744,92 @@ xlate_decl(struct decl *d, struct icode_list *il) {
 	}
 }	
 
+static int
+is_scope_vla(struct statement *st) {
+	struct decl	*d;
+
+	if (st->type != ST_DECL) {
+		return 0;
+	}
+	d = st->data;
+	return IS_VLA(d->dtype->flags)
+		&& d->dtype->vla_addr != NULL
+		&& d->dtype->tlist != NULL
+		&& d->dtype->tlist->type == TN_VARARRAY_OF
+		&& d->dtype->storage != TOK_KEY_STATIC
+		&& d->dtype->storage != TOK_KEY_EXTERN;
+}
+
+/*
+ * 10/17/26: Release the storage of all VLAs declared directly in
+ * scope s. This is only done for backends which allocate VLAs on
+ * the stack; Everyone else keeps the malloc()ed blocks until the
+ * next execution of the declaration or the function return.
+ *
+ * Every release resets the stack pointer to the one saved by its
+ * VLA if that VLA is allocated, so they are emitted in reverse
+ * order and the one of the first VLA, which lies above all later
+ * ones, is restored last
+ */
+static void
+dealloc_scope_vlas(struct scope *s, struct icode_list *il) {
+	struct statement	*st;
+	struct statement	*end = NULL;
+	struct statement	*last;
+
+	if (!backend->stack_alloca) {
+		return;
+	}
+	do {
+		last = NULL;
+		for (st = s->code; st != end; st = st->next) {
+			if (is_scope_vla(st)) {
+				last = st;
+			}
+		}
+		if (last != NULL) {
+			icode_make_dealloc_vla(((struct decl *)last->data)
+				->dtype->vla_addr, il);
+			end = last;
+		}
+	} while (last != NULL);
+}
+
+/*
+ * 10/17/26: break and continue leave all scopes between themselves
+ * and their loop or switch statement without passing their ends, so
+ * the VLAs of those scopes are released before the jump, innermost
+ * scope first. VLAs declared after the jump have not been allocated
+ * in this iteration and are skipped by the release
+ */
+static void
+dealloc_jump_vlas(struct control *ctrl, struct icode_list *il) {
+	struct control	*loop;
+	struct scope	*s;
+
+	if (!backend->stack_alloca) {
+		return;
+	}
+	for (loop = ctrl->parent; loop != NULL; loop = loop->parent) {
+		if (loop->type == TOK_KEY_DO
+			|| loop->type == TOK_KEY_WHILE
+			|| loop->type == TOK_KEY_FOR) {
+			break;
+		} else if (ctrl->type == TOK_KEY_BREAK
+			&& loop->type == TOK_KEY_SWITCH) {
+			break;
+		}
+	}
+	if (loop == NULL) {
+		return;
+	}
+	for (s = ctrl->scope;
+		s != NULL && s != loop->scope && s != loop->dfscope;
+		s = s->parent) {
+		dealloc_scope_vlas(s, il);
+	}
+}
+
 struct icode_list *
 xlate_to_icode(struct statement *st, int inv_gprs_first) {
 	struct icode_list	*il;
@@ -5448,6 +5928,7 @@ xlate_to_icode(struct statement *st, int inv_gprs_first) {
 				free(il2);
 #endif
 			}
+			dealloc_scope_vlas(s, il);
 			if (st->type != ST_EXPRSTMT) {
 				il->res = NULL;
 			} else {
@@ -5515,3 +5996,21 @@ xlate_to_icode(struct statement *st, int inv_gprs_first) {
 	return il;
 }
 
+/*
+ * 10/17/26: Translate statements which occur in the middle of an
+ * expression, such as the body of an inlined function call. They must
+ * be translated like top-level statements; At a nested expression
+ * level, controlling expressions yield 0 or 1 instead of a comparison
+ * that do_cond() can branch on
+ */
+struct icode_list *
+xlate_nested_to_icode(struct statement *st) {
+	struct icode_list	*ret;
+	int			saved_level = expr_level;
+
+	expr_level = 0;
+	ret = xlate_to_icode(st, 0);
+	expr_level = saved_level;
+	return ret;
+}
+
@@ -52,6 +52,16 @@ struct copystruct {
 	struct reg	*dest_from_ptr_struct;
 	struct reg	*src_from_ptr_struct;
 	struct reg	*startreg;
+
+	/*
+	 * 10/17/26: Scratch registers requested by backends which copy
+	 * structs inline (see icode_make_structreloc). src_addr/dest_addr
+	 * receive addresses not already held in a pointer register
+	 */
+	struct reg	*src_addr;
+	struct reg	*dest_addr;
+	struct reg	*temp_reg;
+	struct reg	*fpr_temp;
 };
 
 struct putstructregs {
@@ -106,6 +116,40 @@ struct allocstack {
 	struct vreg	*patchme;
 };
 
+/*
+ * 10/17/26: Jump table for dense switch statements. targets[i] is the
+ * label to jump to for index i; Holes in the case value range are filled
+ * with the default label
+ */
+struct switch_table {
+	struct icode_instr	*label;
+	struct icode_instr	**targets;
+	size_t			nentries;
+};
+
+/*
+ * 10/17/26: Parent struct and pointer registers of the operands of memory
+ * access instructions (see append_icode_list()). Only a small fraction of
+ * all instructions need these, so they are kept out of line to make
+ * struct icode_instr smaller. Use the accessor macros below to read them
+ * and icode_instr_memref() to set them
+ */
+struct icode_memref {
+	struct vreg		*src_parent_struct;
+	struct vreg		*dest_parent_struct;
+	struct reg		*src_ptr_preg;
+	struct reg		*dest_ptr_preg;
+};
+
+#define ICODE_SRC_PARENT_STRUCT(ip) \
+	((ip)->memref? (ip)->memref->src_parent_struct: NULL)
+#define ICODE_DEST_PARENT_STRUCT(ip) \
+	((ip)->memref? (ip)->memref->dest_parent_struct: NULL)
+#define ICODE_SRC_PTR_PREG(ip) \
+	((ip)->memref? (ip)->memref->src_ptr_preg: NULL)
+#define ICODE_DEST_PTR_PREG(ip) \
+	((ip)->memref? (ip)->memref->dest_ptr_preg: NULL)
+
 struct icode_instr {
 	int			type;
 #define INSTR_SEQPOINT		1 /* pseudo */
@@ -121,6 +165,7 @@ struct icode_instr {
 #define INSTR_LOAD		30
 #define INSTR_LOAD_ADDRLABEL	31	/* 07/20/08 */
 #define INSTR_COMP_GOTO		32	/* 07/20/08 */
+#define INSTR_SWITCH_TABLE	33	/* 10/17/26 */
 #define INSTR_STORE		35
 #define INSTR_WRITEBACK		37
 #define INSTR_COPYINIT		40 /* pseudo */
@@ -258,20 +303,16 @@ struct icode_instr {
 	 * used in the backend because any vreg may have multiple pregs
 	 * associated with it during its lifetime
 	 *
-	 * XXX Some of these things are probably only needed for loads/
-	 * stores. By specializing more, we can save memory
+	 * 10/17/26: The parent struct and pointer registers which are
+	 * only needed for memory accesses now live in ``memref''
 	 */
 	struct reg		**dest_pregs;
 	struct vreg		*dest_vreg;
 	struct reg		**src_pregs;
 	struct vreg		*src_vreg;
-	struct vreg		*src_parent_struct;
-	struct vreg		*dest_parent_struct;
-	struct reg		*src_ptr_preg;
-	struct reg		*dest_ptr_preg;
+	struct icode_memref	*memref;
 	void			*dat;
 	struct icode_instr	*next;
-	unsigned long		seqno;
 
 	/*
 	 * 01/18/09: Append sequence number. This can give us a rough estimate
@@ -356,6 +397,14 @@ struct int_memcpy_data {
 	struct reg	*nbytes;
 	struct reg	*temp_reg;
 	int		type;  /* BUILTIN_MEMCPY or _MEMSET */
+	/*
+	 * 10/17/26: If nbytes is a constant, its value is recorded so
+	 * that the backend can unroll the copy. fpr_temp is an SSE
+	 * register for AMD64 to copy 16 bytes at a time (or NULL)
+	 */
+	int		has_const_nbytes;
+	size_t		const_nbytes;
+	struct reg	*fpr_temp;
 };
 
 void
@@ -376,6 +425,10 @@ void
 icode_make_alloc_vla(struct stack_block *vla,
 	struct icode_list *il);
 
+void
+icode_make_dealloc_vla(struct stack_block *vla,
+	struct icode_list *il);
+
 
 void
 icode_make_put_vla_size(struct reg *size, struct stack_block *sb, int idx,
@@ -411,6 +464,9 @@ icode_make_copyreg(struct reg *dest, struct reg *src,
 struct icode_instr *
 icode_make_setreg(struct reg *r, int value);
 
+struct reg **
+make_icode_pregs(struct vreg *vr, struct reg *r);
+
 struct icode_instr *
 icode_make_neg(struct vreg *vr);
 
@@ -599,6 +655,10 @@ struct fistdata {
 void
 icode_make_comp_goto(struct reg *addr, struct icode_list *il);
 
+void
+icode_make_switch_table(struct reg *idx, struct reg *tmp,
+	struct switch_table *tab, struct icode_list *il);
+
 struct stack_block *
 icode_alloc_reg_stack_block(struct function *, size_t bytes);
 
@@ -746,6 +806,9 @@ promote(struct vreg **left, struct vreg **right,
 
 void init_to_icode(struct decl *d, struct icode_list *il);
 
+void
+icode_make_store_decl(struct decl *d, struct vreg *vr, struct icode_list *il);
+
 int
 emul_conv_ldouble_to_double(struct vreg **temp_lres,
 	struct vreg **temp_rres,
@@ -806,12 +869,18 @@ ctrl_to_icode(struct control *);
 struct icode_list *
 xlate_to_icode(struct statement *slist, int inv_gprs_first);
 
+struct icode_list *
+xlate_nested_to_icode(struct statement *slist);
+
 void
 xlate_func_to_icode(struct function *func);
 
 struct icode_instr *
 copy_icode_instr(struct icode_instr *);
 
+struct icode_memref *
+icode_instr_memref(struct icode_instr *);
+
 struct vreg *
 promote_bitfield(struct vreg *vr, struct icode_list *il);
 
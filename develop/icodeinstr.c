@@ -57,24 +57,36 @@
 
 struct icode_instr *
 alloc_icode_instr(void) {
-	static unsigned long seq;
-
 #if USE_ZONE_ALLOCATOR
-	struct icode_instr	*ret = zalloc_buf(Z_ICODE_INSTR);
-
-	ret->seqno = ++seq;
-
-	return ret;
+	return zalloc_buf(Z_ICODE_INSTR);
 #else
 	struct icode_instr	*ret = n_xmalloc(sizeof *ret);
 	static struct icode_instr	nullinstr;
 
 	*ret = nullinstr;
-	ret->seqno = ++seq;
 	return ret;
 #endif
 }
 
+/*
+ * 10/17/26: Returns the out-of-line memory operand data of ``ii'', which
+ * is created if it does not exist yet
+ */
+struct icode_memref *
+icode_instr_memref(struct icode_instr *ii) {
+	if (ii->memref == NULL) {
+#if USE_ZONE_ALLOCATOR
+		ii->memref = zalloc_buf(Z_ICODE_MEMREF);
+#else
+		static struct icode_memref	nullmemref;
+
+		ii->memref = n_xmalloc(sizeof *ii->memref);
+		*ii->memref = nullmemref;
+#endif
+	}
+	return ii->memref;
+}
+
 struct icode_list *
 alloc_icode_list(void) {
 #if USE_ZONE_ALLOCATOR
@@ -91,6 +103,11 @@ struct icode_instr *
 copy_icode_instr(struct icode_instr *ii) {
 	struct icode_instr	*ret = alloc_icode_instr();
 	*ret = *ii;
+	if (ii->memref != NULL) {
+		/* Don't share it, append_icode_list() may change it */
+		ret->memref = NULL;
+		*icode_instr_memref(ret) = *ii->memref;
+	}
 	return ret;
 }	
 
@@ -110,13 +127,14 @@ append_icode_list(struct icode_list *list, struct icode_instr *instr) {
 	 * XXX stuff below is a kludge to ensure that pointer pregs are
 	 * always recorded properly
 	 */
-	if (instr->src_vreg && instr->src_ptr_preg == NULL) {
+	if (instr->src_vreg && ICODE_SRC_PTR_PREG(instr) == NULL) {
 		if (instr->src_vreg->from_ptr) {
-			instr->src_ptr_preg
+			icode_instr_memref(instr)->src_ptr_preg
 				= instr->src_vreg->from_ptr->pregs[0];
 		} else if (instr->src_vreg->parent) {
-			struct vreg	*vr2 =
+			struct vreg		*vr2 =
 				get_parent_struct(instr->src_vreg);
+			struct icode_memref	*mr = icode_instr_memref(instr);
 
 			/*
 			 * 25/12/07: Always save parent struct, not
@@ -124,23 +142,26 @@ append_icode_list(struct icode_list *list, struct icode_instr *instr) {
 			 * question of how reliable vr->parent is
 			 * guaranteed to be in the backend anyway?
 			 */
-			instr->src_parent_struct = vr2;
+			mr->src_parent_struct = vr2;
 			if (vr2->from_ptr) {
-				instr->src_ptr_preg
+				mr->src_ptr_preg
 					= vr2->from_ptr->pregs[0];
 			}	
 		}
 	}
-	if (instr->dest_vreg && instr->dest_ptr_preg == NULL) {
+	if (instr->dest_vreg && ICODE_DEST_PTR_PREG(instr) == NULL) {
 		if (instr->dest_vreg->from_ptr) {
-			instr->dest_ptr_preg
+			icode_instr_memref(instr)->dest_ptr_preg
 				= instr->dest_vreg->from_ptr->pregs[0];
 		} else if (instr->dest_vreg->parent) {
 			struct vreg	*vr2 =
 				get_parent_struct(instr->dest_vreg);
 			if (vr2->from_ptr) {
-				instr->dest_parent_struct = vr2;
-				instr->dest_ptr_preg
+				struct icode_memref	*mr =
+					icode_instr_memref(instr);
+
+				mr->dest_parent_struct = vr2;
+				mr->dest_ptr_preg
 					= vr2->from_ptr->pregs[0];
 			}	
 		}
@@ -148,22 +169,25 @@ append_icode_list(struct icode_list *list, struct icode_instr *instr) {
 	if (instr->type == INSTR_COPYSTRUCT) {
 		struct copystruct	*cs = instr->dat;
 		struct vreg		*structtop;
+		struct icode_memref	*mr;
 
 		if (cs->src_vreg && cs->src_vreg->parent) {
 			structtop = get_parent_struct(cs->src_vreg);
 
 			/* 12/25/07: Always save, not just for pointers */
-			instr->src_parent_struct = structtop;
+			mr = icode_instr_memref(instr);
+			mr->src_parent_struct = structtop;
 			if (structtop->from_ptr) {
-				instr->src_ptr_preg =
+				mr->src_ptr_preg =
 					structtop->from_ptr->pregs[0];
 			}
 		}
 		if (cs->dest_vreg && cs->dest_vreg->parent) {
 			structtop = get_parent_struct(cs->dest_vreg);
 			if (structtop->from_ptr) {
-				instr->dest_parent_struct = structtop;
-				instr->dest_ptr_preg =
+				mr = icode_instr_memref(instr);
+				mr->dest_parent_struct = structtop;
+				mr->dest_ptr_preg =
 					structtop->from_ptr->pregs[0];
 			}	
 		}
@@ -197,12 +221,20 @@ struct reg **
 make_icode_pregs(struct vreg *vr, struct reg *r) {
 	struct reg	**ret;
 
+	/*
+	 * 10/17/26: These arrays live exactly as long as the instructions
+	 * of the function, so they now come from the zone allocator too
+	 * instead of costing a malloc() (which was never freed) apiece
+	 */
+#if USE_ZONE_ALLOCATOR
+	ret = zalloc_buf(Z_ICODE_PREGS);
+#else
+	ret = n_xmalloc(2 * sizeof *ret);
+#endif
 	if (vr == NULL || !vr->is_multi_reg_obj) {
-		ret = n_xmalloc(2 * sizeof *ret);
 		ret[0] = vr? vr->pregs[0]: r;
 		ret[1] = NULL;
 	} else {
-		ret = n_xmalloc(vr->is_multi_reg_obj * sizeof *ret);
 		if (vr->is_multi_reg_obj != 2) abort();
 		/* XXX hardcoded x86 */
 		ret[0] = vr->pregs[0];
@@ -660,13 +692,14 @@ icode_make_load(struct reg *r, struct vreg *parent_struct,
 	 * from_ptr and parent set... Hmm.. why anyway?
 	 */
 	if (vr->from_ptr) {
-		ret->src_ptr_preg = vr->from_ptr->pregs[0];
+		icode_instr_memref(ret)->src_ptr_preg = vr->from_ptr->pregs[0];
 	} else if (vr->parent != NULL && parent_struct != NULL) {
+		struct icode_memref	*mr = icode_instr_memref(ret);
+
 		/* 12/25/07: Always save parent, not just for pointers */
-		ret->src_parent_struct = parent_struct;
+		mr->src_parent_struct = parent_struct;
 		if (parent_struct->from_ptr) {
-			ret->src_ptr_preg =
-				parent_struct->from_ptr->pregs[0];
+			mr->src_ptr_preg = parent_struct->from_ptr->pregs[0];
 		}
 	}	
 
@@ -731,6 +764,28 @@ icode_make_comp_goto(struct reg *addr, struct icode_list *il) {
 	append_icode_list(il, ii);
 }
 
+/*
+ * 10/17/26: Indirect jump through the switch table ``tab''. ``idx'' holds
+ * the (already range-checked) pointer-sized table index. ``tmp'' is a
+ * scratch register for emitters which need one to address the table, or
+ * a null pointer
+ */
+void
+icode_make_switch_table(struct reg *idx, struct reg *tmp,
+	struct switch_table *tab, struct icode_list *il) {
+
+	struct icode_instr	*ii;
+
+	ii = alloc_icode_instr();
+	ii->src_pregs = make_icode_pregs(NULL, idx);
+	if (tmp != NULL) {
+		ii->dest_pregs = make_icode_pregs(NULL, tmp);
+	}
+	ii->dat = tab;
+	ii->type = INSTR_SWITCH_TABLE;
+	append_icode_list(il, ii);
+}
+
 
 /*
  * 04/07/08: Ripped this out of icode_make_store()
@@ -785,11 +840,13 @@ icode_make_store(struct function *f,
 			 * 12/12/07: This preparation of parent vreg and
 			 * pointer was missing (but present in make_load!)
 			 */
-			ret->src_parent_struct = parent;
+			struct icode_memref	*mr = icode_instr_memref(ret);
+
+			mr->src_parent_struct = parent;
 			if (src->from_ptr) {
-				ret->src_ptr_preg = parent->pregs[0];
+				mr->src_ptr_preg = parent->pregs[0];
 			} else {
-				ret->src_ptr_preg = parent->from_ptr->pregs[0];	
+				mr->src_ptr_preg = parent->from_ptr->pregs[0];	
 			}
 		}
 	}
@@ -842,11 +899,13 @@ icode_make_store(struct function *f,
 	 * 12/10/07: Added
 	 */
 	if (src->from_ptr) {
-		ret->src_ptr_preg = src->from_ptr->pregs[0];
+		icode_instr_memref(ret)->src_ptr_preg = src->from_ptr->pregs[0];
 	} else if (src->parent != NULL && parent != NULL) {
-		ret->src_parent_struct = parent;
+		struct icode_memref	*mr = icode_instr_memref(ret);
+
+		mr->src_parent_struct = parent;
 		if (parent->from_ptr) {
-			ret->src_ptr_preg = parent->from_ptr->pregs[0];
+			mr->src_ptr_preg = parent->from_ptr->pregs[0];
 		}
 	}
 		
@@ -1877,6 +1936,25 @@ icode_make_intrinsic_memcpy_or_memset(int type,
 	ii->type = INSTR_INTRINSIC_MEMCPY;
 
 	imdata->type = type;
+	imdata->fpr_temp = NULL;
+	imdata->has_const_nbytes = 0;
+	imdata->const_nbytes = 0;
+
+	/*
+	 * 10/17/26: Record constant sizes so that the backend can
+	 * unroll the copy instead of looping
+	 */
+	if (nbytes->from_const != NULL
+		&& nbytes->from_const->type >= TY_MIN
+		&& nbytes->from_const->type <= TY_ULLONG) {
+		struct tyval	tv;
+
+		memset(&tv, 0, sizeof tv);
+		tv.type = make_basic_type(nbytes->from_const->type);
+		tv.value = nbytes->from_const->data;
+		imdata->const_nbytes = cross_to_host_size_t(&tv);
+		imdata->has_const_nbytes = 1;
+	}
 	if (src->type->tlist == NULL
 		|| src->type->tlist == NULL) {
 		/*
@@ -1946,6 +2024,18 @@ icode_make_intrinsic_memcpy_or_memset(int type,
 
 	reg_set_unallocatable(temp_reg);
 
+	/*
+	 * 10/17/26: The AMD64 emitter copies constant sizes of 4 bytes
+	 * and more through an SSE register
+	 */
+	if (backend->arch == ARCH_AMD64 && imdata->has_const_nbytes
+		&& imdata->const_nbytes >= 4) {
+		imdata->fpr_temp = backend->alloc_fpr(curfunc, 8, il, NULL);
+		if (imdata->fpr_temp != NULL) {
+			reg_set_unallocatable(imdata->fpr_temp);
+		}
+	}
+
 	vreg_faultin(NULL, NULL, nbytes, il, 0);
 	reg_set_unallocatable(nbytes->pregs[0]);
 
@@ -1966,6 +2056,10 @@ icode_make_intrinsic_memcpy_or_memset(int type,
 	reg_set_allocatable(src_reg);
 	reg_set_allocatable(nbytes->pregs[0]);
 	reg_set_allocatable(temp_reg);
+	if (imdata->fpr_temp != NULL) {
+		reg_set_allocatable(imdata->fpr_temp);
+		free_preg(imdata->fpr_temp, il, 1, 0);
+	}
 
 	imdata->dest_addr = dest_reg;
 	imdata->src_addr = src_reg;
@@ -2024,8 +2118,13 @@ icode_make_alloca(struct reg *r, struct vreg *size_vr,
 	 * XXX 08/09/07: This is completely wrong. Removed the
 	 * free, thus repeated allocas leak memory now. But better
 	 * than not having it work at all
+	 *
+	 * 10/17/26: Backends with stack_alloca set only touch the
+	 * size and result registers, so nothing needs saving there
 	 */
-	backend->invalidate_gprs(il, 1, INV_FOR_FCALL);
+	if (!backend->stack_alloca) {
+		backend->invalidate_gprs(il, 1, INV_FOR_FCALL);
+	}
 #if 0
 	icode_make_dealloca(sb, il);
 #endif
@@ -2047,7 +2146,9 @@ icode_make_alloca(struct reg *r, struct vreg *size_vr,
 	a->result_reg->used = 0;
 	a->size_reg->used = 0;
 	reg_set_allocatable(r);
-	backend->invalidate_gprs(il, 1, INV_FOR_FCALL);
+	if (!backend->stack_alloca) {
+		backend->invalidate_gprs(il, 1, INV_FOR_FCALL);
+	}
 	append_icode_list(il, ii);
 #if 0
 	store_reg_to_stack_block(a->result_reg, a->addr);
@@ -2092,8 +2193,15 @@ icode_make_alloc_vla(
 	 * saved pointer with a newly allocated one. This is OK
 	 * even at the first call because the save area is
 	 * initialized to all-null-pointers, and free(NULL) is ok
+	 *
+	 * 10/17/26: With stack_alloca the backend instead resets
+	 * the stack pointer to the one saved by the previous
+	 * allocation, if any. That uses no GPRs, so there is
+	 * nothing to save
 	 */
-	backend->invalidate_gprs(il, 1, INV_FOR_FCALL);
+	if (!backend->stack_alloca) {
+		backend->invalidate_gprs(il, 1, INV_FOR_FCALL);
+	}
 	icode_make_dealloc_vla(sb, il);
 
 	ii->dat = sb;
@@ -2104,7 +2212,9 @@ icode_make_alloc_vla(
 	 * using malloc() and free(), we have to save all
 	 * registers
 	 */
-	backend->invalidate_gprs(il, 1, INV_FOR_FCALL);
+	if (!backend->stack_alloca) {
+		backend->invalidate_gprs(il, 1, INV_FOR_FCALL);
+	}
 	append_icode_list(il, ii);
 }
 
@@ -67,7 +67,7 @@ get_char(char **code) {
 }
 
 static void
-unget_char(int ch, char **code) {
+asm_unget_char(int ch, char **code) {
 	(void) ch;
 	--*code;
 }
@@ -133,13 +133,13 @@ gas_errorfl(struct gas_token *gt, const char *fmt, ...) {
 
 	++gas_errors;
 	++errors;
-	fprintf(stderr, "%s:%d+%d: ", asm_tok->file, asm_tok->line, gt->lineno);
+	fprintf(stderr, "%s:%d+%d: ", token_file(asm_tok), asm_tok->line,
+		gt->lineno);
 	va_start(va, fmt);
 	vfprintf(stderr, fmt, va);
 	va_end(va);
 	fputc('\n', stderr);
-	print_source_line(asm_tok->line_ptr, asm_tok->tok_ptr, asm_tok->ascii,
-		1);
+	print_token_source_line(asm_tok, 1);
 }	
 
 static struct gas_token *
@@ -177,7 +177,7 @@ get_ident(int firstch, char **code) {
 		if (isalnum(ch) || ch == '_') {
 			store_char(&buf, ch);
 		} else {
-			unget_char(ch, code);
+			asm_unget_char(ch, code);
 			break;
 		}
 	}
@@ -207,7 +207,7 @@ get_number(int firstch, char **code, int sign) {
 			hexa = 1;
 		} else if (!isdigit(ch)) {
 			store_char(&buf, '0');
-			unget_char(ch, code);
+			asm_unget_char(ch, code);
 			goto out;
 		} else {
 			octal = 1;
@@ -237,7 +237,7 @@ get_number(int firstch, char **code, int sign) {
 			}
 #endif
 		} else {
-			unget_char(ch, code);
+			asm_unget_char(ch, code);
 			break;
 		}	
 	}
@@ -0,0 +1,773 @@
+/*
+ * Copyright (c) 2026, Nils R. Weller
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Inliner for static and extern inline functions
+ *
+ * 10/17/26: At -O, calls to small inline functions are expanded at
+ * the call site. There is no separate IR to clone, so the callee's
+ * statement tree is simply translated to icode again at every site:
+ *
+ *    - the arguments are evaluated and stored to the callee's
+ *      parameter declarations
+ *
+ *    - the parameters and local variables of the callee are linked
+ *      onto the automatic declarations of the caller, such that they
+ *      get stack slots (or registers) in the caller's frame
+ *
+ *    - every control structure of the body gets fresh labels,
+ *      because the label instructions created by the parser can only
+ *      be part of one icode list
+ *
+ *    - ``return'' stores the value to a temporary variable of the
+ *      call site and jumps to a label following the body
+ *
+ * Only functions which are known to survive this treatment are
+ * candidates; In particular, anything involving user labels, inline
+ * asm, VLAs, aggregate parameters or return values, and variable
+ * argument lists is left alone. Functions which are inlined at every
+ * call site are not generated at all, since their reference count
+ * drops to zero
+ */
+#include "inliner.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "atom.h"
+#include "attribute.h"
+#include "backend.h"
+#include "builtins.h"
+#include "cc1_main.h"
+#include "control.h"
+#include "decl.h"
+#include "expr.h"
+#include "functions.h"
+#include "icode.h"
+#include "scope.h"
+#include "subexpr.h"
+#include "symlist.h"
+#include "token.h"
+#include "type.h"
+#include "n_libc.h"
+
+/* Maximum nesting of inlined calls within inlined calls */
+#define INLINE_MAX_DEPTH	8
+
+struct inline_info {
+	int			checked;
+	int			eligible;
+	int			size;
+
+	/* Body is being expanded, or arguments are being evaluated */
+	int			active;
+	int			args_busy;
+
+	/* Body has been translated before; Labels must be renewed */
+	int			expanded;
+
+	/* Function into whose frame decls were linked last */
+	struct function		*prepared_for;
+
+	/* Parameters and automatic variables of the body */
+	struct decl		**decls;
+	int			ndecls;
+
+	/* Control structures of the body, outermost first */
+	struct control		**ctrls;
+	int			nctrls;
+	int			nctrl_slots;
+};
+
+/*
+ * Call site currently being expanded. Sites nest if an inlined body
+ * contains calls to other inline functions
+ */
+struct inline_site {
+	struct function		*f;
+	struct decl		*retdecl;
+	struct icode_instr	*endlabel;
+	struct inline_site	*prev;
+};
+
+static struct atom_map		inline_funcs;
+static struct inline_site	*cur_site;
+static int			cur_depth;
+
+
+void
+inline_register_function(struct function *f) {
+	static struct inline_info	nullinfo;
+
+	if (f->proto->dtype->name == NULL) {
+		return;
+	}
+	f->inline_info = n_xmalloc(sizeof *f->inline_info);
+	*f->inline_info = nullinfo;
+	atom_map_put(&inline_funcs, atom_intern_str(f->proto->dtype->name), f);
+}
+
+static int
+is_inlinable_type(struct type *ty) {
+	if (ty->tlist != NULL) {
+		return ty->tlist->type == TN_POINTER_TO
+			&& !IS_VLA(ty->flags);
+	}
+	return is_arithmetic_type(ty) && ty->code != TY_LDOUBLE;
+}
+
+static void
+record_ctrl(struct inline_info *info, struct control *ctrl) {
+	if (info->nctrls == info->nctrl_slots) {
+		info->nctrl_slots = info->nctrl_slots?
+			info->nctrl_slots * 2: 8;
+		info->ctrls = n_xrealloc(info->ctrls,
+			info->nctrl_slots * sizeof *info->ctrls);
+	}
+	info->ctrls[info->nctrls++] = ctrl;
+}
+
+static int	check_stmts(struct inline_info *, struct statement *, int *);
+static int	check_expr(struct inline_info *, struct expr *, int *);
+
+static int
+check_decl(struct inline_info *info, struct decl *d, int *size) {
+	if (IS_VLA(d->dtype->flags)) {
+		return -1;
+	}
+	if (d->init == NULL
+		|| d->dtype->storage == TOK_KEY_STATIC
+		|| d->dtype->storage == TOK_KEY_EXTERN) {
+		return 0;
+	}
+	/*
+	 * Aggregate initializers are emitted as anonymous static data
+	 * when translated, so they can only be translated once
+	 */
+	if (is_basic_agg_type(d->dtype)
+		|| d->init->next != NULL
+		|| d->init->type != INIT_EXPR) {
+		return -1;
+	}
+	return check_expr(info, d->init->data, size);
+}
+
+static int
+check_builtin(struct inline_info *info, struct fcall_data *fcall, int *size) {
+	int	nargs;
+	int	i;
+
+	switch (fcall->builtin->builtin->type) {
+	case BUILTIN_EXPECT:
+		nargs = 2;
+		break;
+	case BUILTIN_CONSTANT_P:
+		nargs = 1;
+		break;
+	case BUILTIN_MEMCPY:
+	case BUILTIN_MEMSET:
+		nargs = 3;
+		break;
+	case BUILTIN_OFFSETOF:
+		nargs = 0;
+		break;
+	default:
+		/*
+		 * The stdarg builtins, alloca() and frame_address() refer
+		 * to the frame of the function they appear in
+		 */
+		return -1;
+	}
+	for (i = 0; i < nargs; ++i) {
+		if (check_expr(info, fcall->builtin->args[i], size) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int
+check_s_expr(struct inline_info *info, struct s_expr *s, int *size) {
+	struct fcall_data	*fcall;
+	struct expr		*ex;
+	int			i;
+
+	if (s->is_expr != NULL) {
+		if (check_expr(info, s->is_expr, size) != 0) {
+			return -1;
+		}
+	} else if (s->meat != NULL
+		&& s->meat->type == TOK_COMP_LITERAL) {
+		/* Compound literals are initialized like aggregates */
+		return -1;
+	}
+
+	for (i = 0; s->operators[i] != NULL; ++i) {
+		++*size;
+		switch (s->operators[i]->type) {
+		case TOK_PAREN_OPEN:
+			fcall = s->operators[i]->data;
+			if (fcall->builtin != NULL) {
+				if (check_builtin(info, fcall, size) != 0) {
+					return -1;
+				}
+				break;
+			}
+			/* Calls cost more than they look */
+			*size += 2;
+			for (ex = fcall->args; ex != NULL; ex = ex->next) {
+				if (check_expr(info, ex, size) != 0) {
+					return -1;
+				}
+			}
+			break;
+		case TOK_ARRAY_OPEN:
+			if (check_expr(info, s->operators[i]->data, size)
+				!= 0) {
+				return -1;
+			}
+			break;
+		case TOK_SIZEOF_VLA_TYPE:
+		case TOK_SIZEOF_VLA_EXPR:
+		case TOK_OP_ADDRLABEL:
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int
+check_expr(struct inline_info *info, struct expr *ex, int *size) {
+	if (ex == NULL) {
+		return 0;
+	}
+	++*size;
+	if (ex->stmt_as_expr != NULL) {
+		return check_stmts(info, ex->stmt_as_expr->code, size);
+	}
+	if (ex->op != 0) {
+		if (check_expr(info, ex->left, size) != 0
+			|| check_expr(info, ex->right, size) != 0) {
+			return -1;
+		}
+		return 0;
+	}
+	if (ex->data != NULL) {
+		return check_s_expr(info, ex->data, size);
+	}
+	return 0;
+}
+
+static int
+check_ctrl(struct inline_info *info, struct control *ctrl, int *size) {
+	int	i;
+
+	if (ctrl->body_labels != NULL) {
+		return -1;
+	}
+
+	switch (ctrl->type) {
+	case TOK_KEY_GOTO:
+		return -1;
+	case TOK_KEY_CASE:
+	case TOK_KEY_DEFAULT:
+		/* The label belongs to the switch */
+		return 0;
+	}
+
+	record_ctrl(info, ctrl);
+	if (check_expr(info, ctrl->cond, size) != 0
+		|| check_expr(info, ctrl->finit, size) != 0
+		|| check_expr(info, ctrl->fcont, size) != 0) {
+		return -1;
+	}
+	if (ctrl->dfinit != NULL) {
+		for (i = 0; ctrl->dfinit[i] != NULL; ++i) {
+			if (check_decl(info, ctrl->dfinit[i], size) != 0) {
+				return -1;
+			}
+		}
+	}
+	if (check_stmts(info, ctrl->stmt, size) != 0) {
+		return -1;
+	}
+	if (ctrl->next != NULL) {
+		/* else branch */
+		if (ctrl->next->body_labels != NULL) {
+			return -1;
+		}
+		record_ctrl(info, ctrl->next);
+		if (check_stmts(info, ctrl->next->stmt, size) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Checks whether the statement list ``st'' can be inlined, adds its
+ * size to *size, and records its control structures. Returns 0 if
+ * the statements are OK, else -1
+ */
+static int
+check_stmts(struct inline_info *info, struct statement *st, int *size) {
+	for (; st != NULL; st = st->next) {
+		++*size;
+		switch (st->type) {
+		case ST_DECL:
+			if (check_decl(info, st->data, size) != 0) {
+				return -1;
+			}
+			break;
+		case ST_CODE:
+			if (check_expr(info, st->data, size) != 0) {
+				return -1;
+			}
+			break;
+		case ST_COMP:
+		case ST_EXPRSTMT:
+			if (check_stmts(info,
+				((struct scope *)st->data)->code, size) != 0) {
+				return -1;
+			}
+			break;
+		case ST_CTRL:
+			if (check_ctrl(info, st->data, size) != 0) {
+				return -1;
+			}
+			break;
+		case ST_LABEL:
+			if (!((struct label *)st->data)->is_switch_label) {
+				return -1;
+			}
+			break;
+		default:
+			/* Inline asm */
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static void
+add_decl(struct inline_info *info, struct decl *d, int *nslots) {
+	int	i;
+
+	for (i = 0; i < info->ndecls; ++i) {
+		if (info->decls[i] == d) {
+			return;
+		}
+	}
+	if (info->ndecls == *nslots) {
+		*nslots = *nslots? *nslots * 2: 8;
+		info->decls = n_xrealloc(info->decls,
+			*nslots * sizeof *info->decls);
+	}
+	info->decls[info->ndecls++] = d;
+}
+
+/*
+ * Collects the parameters and the automatic variables of all code
+ * scopes of the body (the same scopes the backends walk to allocate
+ * the stack frame)
+ */
+static void
+collect_decls(struct function *f) {
+	struct inline_info	*info = f->inline_info;
+	struct scope		*scope;
+	struct scope		*tmp;
+	struct sym_entry	*se;
+	int			nslots = 0;
+	int			i;
+
+	for (se = f->fty->scope->slist, i = 0;
+		se != NULL && i < f->fty->nargs;
+		se = se->next, ++i) {
+		add_decl(info, se->dec, &nslots);
+	}
+	for (scope = f->scope; scope != NULL; scope = scope->next) {
+		for (tmp = scope; tmp != NULL; tmp = tmp->parent) {
+			if (tmp == f->scope) {
+				break;
+			}
+		}
+		if (tmp == NULL) {
+			/* End of function reached */
+			break;
+		}
+		if (scope->type != SCOPE_CODE) {
+			continue;
+		}
+		for (i = 0; i < scope->automatic_decls.ndecls; ++i) {
+			add_decl(info, scope->automatic_decls.data[i], &nslots);
+		}
+	}
+}
+
+static int
+check_function(struct function *f) {
+	struct inline_info	*info = f->inline_info;
+	struct sym_entry	*se;
+	struct type		*ty = f->rettype;
+	int			limit;
+	int			i;
+
+	if (info->checked) {
+		return info->eligible;
+	}
+	info->checked = 1;
+
+	if (f->proto->dtype->fastattr & CATTR_NOINLINE) {
+		return 0;
+	}
+	if (f->fty->type == FDTYPE_KR
+		|| f->fty->variadic
+		|| f->fty->nargs < 0
+		|| f->labels_head != NULL) {
+		return 0;
+	}
+	if ((ty->code != TY_VOID || ty->tlist != NULL)
+		&& !is_inlinable_type(ty)) {
+		return 0;
+	}
+	for (se = f->fty->scope->slist, i = 0;
+		i < f->fty->nargs;
+		se = se->next, ++i) {
+		if (se == NULL || !is_inlinable_type(se->dec->dtype)) {
+			return 0;
+		}
+	}
+
+	if (check_stmts(info, f->scope->code, &info->size) != 0) {
+		return 0;
+	}
+	limit = finline_limit >= 0? finline_limit: INLINE_LIMIT_DEFAULT;
+	if (info->size > limit
+		&& !(f->proto->dtype->fastattr & CATTR_ALWAYS_INLINE)) {
+		return 0;
+	}
+
+	collect_decls(f);
+	info->eligible = 1;
+	return 1;
+}
+
+/*
+ * Returns the function to expand for the call ``fcall'', or a null
+ * pointer if it has to be called normally
+ */
+struct function *
+inline_get_candidate(struct fcall_data *fcall) {
+	struct function	*f;
+	struct decl	*dec = fcall->callto;
+	struct atom	*a;
+
+	if (Oflag <= 0 || gflag || fnoinline_flag || curfunc == NULL) {
+		return NULL;
+	}
+	if (fcall->builtin != NULL
+		|| dec == NULL
+		|| dec->dtype->name == NULL
+		|| dec->dtype->tlist == NULL
+		|| dec->dtype->tlist->type != TN_FUNCTION) {
+		return NULL;
+	}
+	if ((a = atom_find(dec->dtype->name)) == NULL
+		|| (f = atom_map_get(&inline_funcs, a)) == NULL) {
+		return NULL;
+	}
+	if (f == curfunc
+		|| f->inline_info->active
+		|| f->inline_info->args_busy
+		|| cur_depth >= INLINE_MAX_DEPTH) {
+		/* Recursion, or the parameters are in use */
+		return NULL;
+	}
+	if (!check_function(f) || fcall->nargs != f->fty->nargs) {
+		return NULL;
+	}
+	return f;
+}
+
+/*
+ * Renews the labels of all control structures of the body. break and
+ * continue take their labels from the enclosing loop or switch, which
+ * has already been renewed because the list is ordered outermost first
+ */
+static void
+relabel_body(struct inline_info *info) {
+	struct control	*ctrl;
+	struct control	*loop;
+	struct label	*l;
+	int		i;
+
+	for (i = 0; i < info->nctrls; ++i) {
+		ctrl = info->ctrls[i];
+		switch (ctrl->type) {
+		case TOK_KEY_DO:
+			ctrl->do_cond = icode_make_label(NULL);
+			/* FALLTHRU */
+		case TOK_KEY_WHILE:
+		case TOK_KEY_FOR:
+			ctrl->startlabel = icode_make_label(NULL);
+			if (ctrl->fcont_label != NULL) {
+				ctrl->fcont_label = icode_make_label(NULL);
+			}
+			if (ctrl->endlabel != NULL) {
+				ctrl->endlabel = icode_make_label(NULL);
+			}
+			break;
+		case TOK_KEY_IF:
+		case TOK_KEY_ELSE:
+			ctrl->endlabel = icode_make_label(NULL);
+			break;
+		case TOK_KEY_SWITCH:
+			ctrl->endlabel = icode_make_label(NULL);
+			for (l = ctrl->labels; l != NULL; l = l->next) {
+				l->instr = icode_make_label(NULL);
+			}
+			break;
+		case TOK_KEY_BREAK:
+		case TOK_KEY_CONTINUE:
+			for (loop = ctrl->parent;
+				loop != NULL;
+				loop = loop->parent) {
+				if (loop->type == TOK_KEY_DO
+					|| loop->type == TOK_KEY_WHILE
+					|| loop->type == TOK_KEY_FOR) {
+					break;
+				} else if (ctrl->type == TOK_KEY_BREAK
+					&& loop->type == TOK_KEY_SWITCH) {
+					break;
+				}
+			}
+			if (ctrl->type == TOK_KEY_BREAK) {
+				ctrl->endlabel = loop->endlabel;
+			} else if (loop->type == TOK_KEY_DO) {
+				ctrl->startlabel = loop->do_cond;
+			} else if (loop->fcont_label != NULL) {
+				ctrl->startlabel = loop->fcont_label;
+			} else {
+				ctrl->startlabel = loop->startlabel;
+			}
+			break;
+		}
+	}
+}
+
+/*
+ * Links the parameters and local variables of ``f'' onto the automatic
+ * declarations of the current function, so that its stack frame has
+ * room for them. Their stack addresses are still those of the last
+ * function they were allocated for, so they are reset
+ */
+static void
+prepare_decls(struct function *f) {
+	struct inline_info	*info = f->inline_info;
+	int			i;
+
+	for (i = 0; i < info->ndecls; ++i) {
+		info->decls[i]->stack_addr = NULL;
+		inline_store_frame_decl(info->decls[i]);
+	}
+	info->prepared_for = curfunc;
+}
+
+void
+inline_store_frame_decl(struct decl *d) {
+	struct dec_block	*db = &curfunc->scope->automatic_decls;
+
+	if (db->ndecls >= db->nslots) {
+		db->nslots = db->nslots? db->nslots * 2: 16;
+		db->data = n_xrealloc(db->data,
+			db->nslots * sizeof *db->data);
+	}
+	db->data[db->ndecls++] = d;
+}
+
+static struct decl *
+alloc_frame_decl(struct type *ty) {
+	struct decl	*d = alloc_decl();
+
+	d->dtype = n_xmemdup(ty, sizeof *ty);
+	d->dtype->is_func = 0;
+	d->dtype->storage = 0;
+	d->dtype->name = NULL;
+	d->is_unrequested_decl = 1;
+	inline_store_frame_decl(d);
+	return d;
+}
+
+struct vreg *
+inline_fcall_to_icode(struct function *f, struct fcall_data *fcall,
+	struct icode_list *il, struct token *t) {
+
+	struct inline_info	*info = f->inline_info;
+	struct inline_site	site;
+	struct icode_list	*il2;
+	struct scope		*oldscope = curscope;
+	struct sym_entry	*se;
+	struct expr		*ex;
+	struct vreg		*vr;
+
+	/* Like a call, the body may use any register */
+	backend->invalidate_gprs(il, 1, 0);
+
+	/*
+	 * Evaluate the arguments and assign them to the parameters. The
+	 * parameters must not be overwritten by a nested expansion of
+	 * the same function while this is in progress
+	 */
+	info->args_busy = 1;
+	se = f->fty->scope->slist;
+	for (ex = fcall->args; ex != NULL; ex = ex->next, se = se->next) {
+		if ((vr = expr_to_icode(ex, NULL, il, 0, 0, 1)) == NULL
+			|| check_types_assign(t, se->dec->dtype, vr, 1, 0)
+			!= 0) {
+			info->args_busy = 0;
+			return NULL;
+		}
+		icode_make_store_decl(se->dec, vr, il);
+	}
+	info->args_busy = 0;
+
+	if (info->prepared_for != curfunc) {
+		prepare_decls(f);
+	}
+	if (info->expanded) {
+		relabel_body(info);
+	}
+	info->expanded = 1;
+
+	site.f = f;
+	site.endlabel = icode_make_label(NULL);
+	if (f->rettype->code != TY_VOID || f->rettype->tlist != NULL) {
+		site.retdecl = alloc_frame_decl(f->rettype);
+	} else {
+		site.retdecl = NULL;
+	}
+	site.prev = cur_site;
+	cur_site = &site;
+	++cur_depth;
+	info->active = 1;
+
+	curscope = f->scope;
+	il2 = xlate_nested_to_icode(f->scope->code);
+	curscope = oldscope;
+
+	info->active = 0;
+	--cur_depth;
+	cur_site = site.prev;
+
+	if (il2 == NULL) {
+		return NULL;
+	}
+	merge_icode_lists(il, il2);
+#if ! USE_ZONE_ALLOCATOR
+	free(il2);
+#endif
+	/* The end label is reached from every return */
+	backend->invalidate_gprs(il, 1, 0);
+	append_icode_list(il, site.endlabel);
+
+	if (site.retdecl != NULL) {
+		vr = vreg_alloc(site.retdecl, NULL, NULL, NULL);
+		vreg_set_new_type(vr, site.retdecl->dtype);
+	} else {
+		vr = vreg_alloc(NULL, NULL, NULL, NULL);
+		vr->type = n_xmemdup(f->rettype, sizeof *f->rettype);
+		vr->size = 0;
+	}
+
+	/*
+	 * The call no longer refers to the function, so it need not be
+	 * generated if all calls are inlined
+	 */
+	if (f->proto->references > 0) {
+		--f->proto->references;
+	}
+	if (finlinereport_flag) {
+		(void) fprintf(stderr, "%s:%d: Note: Inlined call to `%s' "
+			"into `%s' (size %d)\n",
+			token_file(t), t->line,
+			f->proto->dtype->name,
+			curfunc->proto->dtype->name,
+			info->size);
+	}
+	return vr;
+}
+
+/*
+ * Returns the function whose body is currently being expanded, or a
+ * null pointer if we are translating an ordinary function body
+ */
+struct function *
+inline_current_function(void) {
+	return cur_site != NULL? cur_site->f: NULL;
+}
+
+/*
+ * Translates ``return vr;'' in an expanded body; The value (which has
+ * already been converted to the return type) is stored to the return
+ * value temporary of the call site
+ */
+int
+inline_return_to_icode(struct control *ctrl, struct vreg *vr,
+	struct icode_list *il) {
+
+	struct statement	*tail = cur_site->f->scope->code_tail;
+
+	if (vr != NULL && cur_site->retdecl != NULL) {
+		icode_make_store_decl(cur_site->retdecl, vr, il);
+	}
+	if (tail != NULL
+		&& tail->type == ST_CTRL
+		&& tail->data == ctrl) {
+		/* Last statement - the end label follows anyway */
+		return 0;
+	}
+	append_icode_list(il, icode_make_jump(cur_site->endlabel));
+	return 0;
+}
+
+/*
+ * Prepares the body of ``f'' for translation as an ordinary function
+ * after it has been inlined somewhere
+ */
+void
+inline_prepare_standalone(struct function *f) {
+	struct inline_info	*info = f->inline_info;
+	int			i;
+
+	if (info == NULL || !info->expanded) {
+		return;
+	}
+	relabel_body(info);
+	for (i = 0; i < info->ndecls; ++i) {
+		info->decls[i]->stack_addr = NULL;
+	}
+	info->prepared_for = f;
+}
+
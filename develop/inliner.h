@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2026, Nils R. Weller
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef INLINER_H
+#define INLINER_H
+
+struct function;
+struct fcall_data;
+struct icode_list;
+struct icode_instr;
+struct control;
+struct token;
+struct vreg;
+struct decl;
+
+/*
+ * 10/17/26: Default size budget for -finline-limit; The size of a
+ * function is the number of statements and expression nodes in its
+ * body
+ */
+#define INLINE_LIMIT_DEFAULT	50
+
+void		inline_register_function(struct function *f);
+struct function	*inline_get_candidate(struct fcall_data *fcall);
+struct vreg	*inline_fcall_to_icode(struct function *f,
+			struct fcall_data *fcall,
+			struct icode_list *il,
+			struct token *t);
+struct function	*inline_current_function(void);
+int		inline_return_to_icode(struct control *ctrl,
+			struct vreg *vr,
+			struct icode_list *il);
+void		inline_store_frame_decl(struct decl *d);
+void		inline_prepare_standalone(struct function *f);
+
+#endif
+
@@ -54,7 +54,49 @@ const char	*cur_inc;
 int		cur_inc_is_std;
 int		lineno;
 
-static int	lex_traditional_cpp(struct input_file *in);
+int		lex_streaming;
+int		lex_chunk_end;
+int		lex_done;
+int		lex_failed;
+
+/*
+ * 10/17/26: State of the traditional lexer; This is kept across calls
+ * for the translation unit when streaming
+ */
+struct lex_state {
+	struct input_file	*in;
+	int			compound;
+	int			array;
+	int			parentheses;
+	int			is_wide_char;
+	int			*dummyptr;
+};
+
+/*
+ * 10/17/26: The translation unit being streamed. The input position is
+ * saved when the lexer pauses, because the function catalog may lex
+ * declarations of its own (see fcat_get_dec()) before it is resumed
+ */
+static struct {
+	struct lex_state	lex;
+	struct token		*tail;
+	int			lineno;
+	size_t			chars_read;
+	char			*line_ptr;
+
+	/* Declaration boundary tracking; See lex_note_token() */
+	int			depth;
+	int			prev_type;
+	int			in_init;
+	int			su;
+	int			in_body;
+	int			knr;
+	int			decl_paren;
+	int			after_paren;
+} stream;
+
+static int	lex_traditional_cpp(struct lex_state *ls);
+static int	lex_stream_chunk(void);
 
 #if 0
 static void
@@ -127,34 +169,41 @@ int
 get_next_char(struct input_file *file) {
         int     ch;
 
-	if (file->fd != NULL) {
+	if (file->cur_buf_ptr != NULL) {
+		/*
+		 * 10/17/26: Reading from buffer; This is either the memory-
+		 * mapped input file (see lex_nwcc()) or a ucpp token text.
+		 * The FGETC() macro reads ordinary characters by itself and
+		 * only calls us at the end of the buffer and for newlines
+		 */
+		if (file->cur_buf_ptr == file->buf_end) {
+			return EOF;
+		}
+		ch = *(unsigned char *)file->cur_buf_ptr++;
+		if (ch == '\n' && file->fd != NULL) {
+			lex_line_ptr = file->cur_buf_ptr;
+		}
+	} else if (file->fd != NULL) {
 		/* Reading from file */
 		ch = getc(file->fd);
 
 		if (!doing_fcatalog) {
 			if (ch == '\n') {
 				lex_line_ptr = lex_file_map + lex_chars_read;
-		                err_setlineptr(lex_line_ptr);
        			}
 		}
 	} else {
-		/* Reading from buffer */
-		if (file->cur_buf_ptr == file->buf_end) {
-			return EOF;
-		} else {
-			ch = *file->cur_buf_ptr;
-			++file->cur_buf_ptr;
-		}
+		ch = EOF;
 	}
         return ch;
 }
 
 void
 unget_char(int ch, struct input_file *file) {
-	if (file->fd != NULL) {
-		/* Reading from file */
-		ungetc(ch, file->fd);
-	} else {
+	if (ch == EOF) {
+		/* Nothing was read */
+		;
+	} else if (file->cur_buf_ptr != NULL) {
 		/* Reading from buffer */
 		if (file->cur_buf_ptr == file->buf) {
 			/* Already at beginning (XXX Warning/error needed?) */
@@ -162,8 +211,11 @@ unget_char(int ch, struct input_file *file) {
 		} else {
 			/**file->cur_buf_ptr = ch;*/
 			--file->cur_buf_ptr;
-			assert(*file->cur_buf_ptr == ch);
+			assert(*(unsigned char *)file->cur_buf_ptr == ch);
 		}
+	} else if (file->fd != NULL) {
+		/* Reading from file */
+		ungetc(ch, file->fd);
 	}
 }
 
@@ -187,14 +239,6 @@ FGETS(char *buf, size_t bufsiz, struct input_file *in) {
 	return buf;
 }
 
-#if 0
-static int	nextch;
-
-#define get_next_char(fd) \
-	((nextch = getc(fd)) == '\n'? \
-	 	lex_line_ptr = lex_file_map + lex_chars_read, \
-		err_setlineptr(lex_line_ptr), nextch: nextch)
-#endif
 
 
 int
@@ -220,6 +264,15 @@ lex_nwcc(struct input_file *in) {
 #ifdef MADV_SEQUENTIAL
 		(void) madvise(lex_file_map, s.st_size, MADV_SEQUENTIAL);
 #endif
+		if (!using_ucpp) {
+			/*
+			 * 10/17/26: Tokenize straight from the mapping
+			 * rather than going through getc() for every
+			 * character
+			 */
+			in->buf = in->cur_buf_ptr = lex_file_map;
+			in->buf_end = lex_file_map_end;
+		}
 	}
 
 	/* Initialize error message module */
@@ -248,22 +301,194 @@ lex_nwcc(struct input_file *in) {
 	/*
 	 * We now invoke the lexical analyzer
 	 */
-	if (using_ucpp) {
+	if (lex_streaming && !doing_fcatalog) {
+		stream.lex.in = in;
+		return lex_stream_chunk();
+	} else if (using_ucpp && !doing_fcatalog) {
 		return lex_ucpp(in);
 	} else {
-		return lex_traditional_cpp(in);
+		/*
+		 * 10/17/26: Function catalog declarations are always read
+		 * by the traditional lexer, since they are already
+		 * preprocessed, and they may be looked up while ucpp is
+		 * still working on the translation unit
+		 */
+		static struct lex_state	nullstate;
+		struct lex_state	ls = nullstate;
+
+		ls.in = in;
+		return lex_traditional_cpp(&ls);
 	}
 }
 
+/*
+ * Tokenizes the next external declaration of the translation unit
+ * being streamed
+ */
 static int
-lex_traditional_cpp(struct input_file *in) {
+lex_stream_chunk(void) {
+	int	rc;
+
+	if (using_ucpp) {
+		rc = lex_ucpp(stream.lex.in);
+	} else {
+		rc = lex_traditional_cpp(&stream.lex);
+	}
+	stream.lineno = lineno;
+	stream.chars_read = lex_chars_read;
+	stream.line_ptr = lex_line_ptr;
+	return rc;
+}
+
+/*
+ * Returns the token following ``t'', reading the next external
+ * declaration from the input if ``t'' is the last token read so far.
+ * Lexical errors end the input, like they end the compilation if
+ * they are found by lex_nwcc()
+ */
+struct token *
+lex_next_token(struct token *t) {
+	if (t->next == NULL
+		&& t == stream.tail
+		&& lex_streaming
+		&& !lex_done) {
+		int	olderrors = errors;
+
+		lineno = stream.lineno;
+		lex_chars_read = stream.chars_read;
+		lex_line_ptr = stream.line_ptr;
+		err_setfile(token_setfile(token_file(t)));
+		store_token_set_tail(t);
+
+		(void) lex_stream_chunk();
+		if (errors != olderrors) {
+			lex_failed = lex_done = 1;
+			t->next = NULL;
+		}
+	}
+	return t->next;
+}
+
+/*
+ * Tells store_token() whether a token of type ``type'' which is about to
+ * be appended to the translation unit being streamed belongs to a
+ * function body, including its opening but not its closing brace (see
+ * token_release_body())
+ */
+int
+lex_in_body(int type) {
+	if (stream.depth == 0) {
+		return type == TOK_COMP_OPEN && !stream.su && !stream.in_init;
+	}
+	return stream.in_body
+		&& !(type == TOK_COMP_CLOSE && stream.depth == 1);
+}
+
+/*
+ * Called by store_token() for every token appended to the translation
+ * unit when streaming. This keeps track of bracket nesting to find the
+ * end of external declarations, i.e. a ``;'' or the closing ``}'' of a
+ * function body at file scope, and sets lex_chunk_end there to make
+ * the lexer pause. In the old-style definition
+ *
+ *     int f(a) int a; { ... }
+ *
+ * (or int (*f(a))() int a; ...) the ``;'' ends a parameter declaration
+ * instead. A ``{'' at file scope
+ * which does not follow struct/union/enum or an ``='' is assumed to
+ * open a function body. Missing a boundary only makes the next pause
+ * come later
+ */
+void
+lex_note_token(struct token *t) {
+	int	type = t->type;
+	int	after_paren = stream.after_paren;
+
+	if (doing_fcatalog) {
+		return;
+	}
+
+	stream.tail = t;
+	stream.after_paren = 0;
+
+	if (type == TOK_PAREN_OPEN
+		|| type == TOK_ARRAY_OPEN
+		|| type == TOK_COMP_OPEN) {
+		if (stream.depth == 0) {
+			if (type == TOK_PAREN_OPEN) {
+				/* Not __attribute__, __typeof__, etc */
+				stream.decl_paren =
+					!IS_KEYWORD(stream.prev_type);
+			} else if (type == TOK_COMP_OPEN) {
+				stream.in_body = !stream.su && !stream.in_init;
+				if (stream.in_body) {
+					stream.knr = 0;
+				}
+				stream.su = 0;
+			}
+		}
+		++stream.depth;
+	} else if (type == TOK_PAREN_CLOSE
+		|| type == TOK_ARRAY_CLOSE
+		|| type == TOK_COMP_CLOSE) {
+		if (stream.depth > 0 && --stream.depth == 0) {
+			if (type == TOK_PAREN_CLOSE) {
+				stream.after_paren = stream.decl_paren;
+			} else if (type == TOK_COMP_CLOSE && stream.in_body) {
+				stream.in_body = 0;
+				lex_chunk_end = 1;
+			}
+		}
+	} else if (stream.depth == 0) {
+		if (after_paren
+			&& !stream.in_init
+			&& (type == TOK_IDENTIFIER
+			|| (IS_KEYWORD(type)
+				&& type != TOK_KEY_ATTRIBUTE
+				&& type != TOK_KEY_ASM))) {
+			/* ``int f(a) int a;'' */
+			stream.knr = 1;
+		}
+
+		switch (type) {
+		case TOK_SEMICOLON:
+			stream.in_init = stream.su = 0;
+			if (!stream.knr) {
+				lex_chunk_end = 1;
+			}
+			break;
+		case TOK_OPERATOR:
+			if (*(int *)t->data == TOK_OP_ASSIGN) {
+				stream.in_init = 1;
+			} else if (*(int *)t->data == TOK_OP_COMMA) {
+				stream.in_init = 0;
+			}
+			stream.su = 0;
+			break;
+		case TOK_KEY_STRUCT:
+		case TOK_KEY_UNION:
+		case TOK_KEY_ENUM:
+			stream.su = 1;
+			break;
+		case TOK_IDENTIFIER:
+			/* Tag */
+			stream.su = stream.su == 1? 2: 0;
+			break;
+		case TOK_KEY_ATTRIBUTE:
+			break;
+		default:
+			stream.su = 0;
+		}
+	}
+	stream.prev_type = type;
+}
+
+static int
+lex_traditional_cpp(struct lex_state *ls) {
+	struct input_file	*in = ls->in;
 	int		ch;
 	int		tmpi;
-	int		compound	= 0;
-	int		array		= 0;
-	int		parentheses	= 0;
 	int		atline		= 0;
-	int		*dummyptr	= n_xmalloc(sizeof *dummyptr);
 	int		err;
 	char		buf[512];
 	char		buf2[256];
@@ -272,10 +497,12 @@ lex_traditional_cpp(struct input_file *in) {
 #if 0
 	int		curfileid = 0;
 #endif
-	int		is_wide_char = 0;
 
+	if (ls->dummyptr == NULL) {
+		ls->dummyptr = n_xmalloc(sizeof *ls->dummyptr);
+	}
 
-	while ((ch = FGETC(in)) != EOF) {
+	while (!lex_chunk_end && (ch = FGETC(in)) != EOF) {
 		if (!doing_fcatalog) {
 			lex_tok_ptr = lex_file_map + lex_chars_read;
 		} else {
@@ -339,8 +566,11 @@ lex_traditional_cpp(struct input_file *in) {
 			/*
 			 * Note that curfile is still referred to by tokens -
 			 * don't free
+			 *
+			 * 10/17/26: It now comes from the file name table
+			 * instead of being duplicated for every line marker
 			 */
-			curfile = strdup(buf2);
+			curfile = token_setfile(buf2);
 			if (gflag) {
 				unimpl();
 				/*curfileid = dwarf_put_file(curfile);*/
@@ -357,7 +587,6 @@ lex_traditional_cpp(struct input_file *in) {
 
 			/* Processing new file */
 			err_setfile(curfile);
-			token_setfile(curfile);
 
 #if 0
 			token_setfileid(curfileid);
@@ -394,7 +623,7 @@ lex_traditional_cpp(struct input_file *in) {
 				}
 				*tmpip = tmpi;
 
-				if (is_wide_char) {
+				if (ls->is_wide_char) {
 					char_type = backend->get_wchar_t()->code;
 
 					/*
@@ -409,65 +638,65 @@ lex_traditional_cpp(struct input_file *in) {
 				}
 				store_token(&toklist, tmpip, char_type, lineno, NULL);
 			}
-			is_wide_char = 0;
+			ls->is_wide_char = 0;
 			break;
 		case '"': {
 			struct ty_string	*tmpstr;
 
-			tmpstr = get_string_literal(in, is_wide_char);
+			tmpstr = get_string_literal(in, ls->is_wide_char);
 			if (tmpstr != NULL) {
 				store_token(&toklist, tmpstr,
 					TOK_STRING_LITERAL, lineno, NULL); 
 			}
-			is_wide_char = 0;
+			ls->is_wide_char = 0;
 			break;
 			}
 		case '(':
 		case ')':
 			if (ch == '(') {
-				++parentheses;
+				++ls->parentheses;
 			} else {
-				if (parentheses == 0) {
+				if (ls->parentheses == 0) {
 					lexerror("No matching opening "
 						"parentheses.");
 				}
-				--parentheses;
+				--ls->parentheses;
 			}
-			store_token(&toklist, dummyptr,
+			store_token(&toklist, ls->dummyptr,
 				ch == '(' ? TOK_PAREN_OPEN :
 					TOK_PAREN_CLOSE, lineno, NULL);
 			break;
 		case '{':
 		case '}':
 			if (ch == '{') {
-				++compound;
+				++ls->compound;
 			} else {
-				if (compound == 0) {
+				if (ls->compound == 0) {
 					lexerror("No matching opening brace.");
 				}
-				--compound;
+				--ls->compound;
 			}
-			store_token(&toklist, dummyptr,
+			store_token(&toklist, ls->dummyptr,
 				ch == '{'? TOK_COMP_OPEN: TOK_COMP_CLOSE,
 				lineno, NULL);
 			break;
 		case '[':
 		case ']':
 			if (ch == '[') {
-				++array;
+				++ls->array;
 			} else {
-				if (array == 0) {
+				if (ls->array == 0) {
 					lexerror("Not a valid subscript.");
-					++array;
+					++ls->array;
 				}
-				--array;
+				--ls->array;
 			}
-			store_token(&toklist, dummyptr,
+			store_token(&toklist, ls->dummyptr,
 				ch == '[' ? TOK_ARRAY_OPEN : TOK_ARRAY_CLOSE,
 				lineno, NULL);
 			break;
 		case ';':
-			store_token(&toklist, dummyptr, TOK_SEMICOLON, lineno, NULL);
+			store_token(&toklist, ls->dummyptr, TOK_SEMICOLON, lineno, NULL);
 			break;
 		case '.':
 			/*
@@ -525,7 +754,12 @@ lex_traditional_cpp(struct input_file *in) {
 			}
 					
 			if (LOOKUP_OP(ch)) {
-				int	*ptri = malloc(sizeof(int));
+				/*
+				 * 10/17/26: The value is copied into the
+				 * token by store_token()
+				 */
+				int	opval;
+				int	*ptri = &opval;
 				char	*ascii = NULL;
 				int	is_ellipsis = 0;
 
@@ -555,10 +789,6 @@ lex_traditional_cpp(struct input_file *in) {
 					store_token(&toklist, ptri,
 						TOK_ELLIPSIS, lineno, ascii);
 				} else {	
-					if (ptri == NULL) {
-						perror("malloc");
-						exit(EXIT_FAILURE);
-					}
 					tmpi = get_operator(ch, in, &ascii);
 					if (tmpi != -1) {
 						*ptri = tmpi;
@@ -591,7 +821,7 @@ lex_traditional_cpp(struct input_file *in) {
 							 * 07/24/09: Now we do
 							 * distinguish!
 							 */
-							is_wide_char = 1;
+							ls->is_wide_char = 1;
 							continue;
 						}
 					}
@@ -607,6 +837,14 @@ lex_traditional_cpp(struct input_file *in) {
 			}
 		}
 	}
+	if (lex_chunk_end) {
+		/* 10/17/26: End of declaration when streaming */
+		lex_chunk_end = 0;
+		return errors;
+	}
+	if (ls == &stream.lex) {
+		lex_done = 1;
+	}
 #if 0
 	store_token(&toklist, NULL, 0, lineno);
 #endif
@@ -618,7 +856,7 @@ lex_traditional_cpp(struct input_file *in) {
 void 
 print_token_list(struct token *list) {
 	(void)list;
-#if defined DEBUG || USE_UCPP
+#ifdef DEBUG
 	puts("-------------------------------------------------------------");
 	for (; list /*->data*/ != NULL; list = list->next) {
 		if (list->type == TOK_OPERATOR) {
@@ -45,5 +45,21 @@ struct input_file *create_input_file(FILE *fd);
 void	print_token_list(struct token *);
 int	lex_nwcc(struct input_file *in);
 
+/*
+ * 10/17/26: Streaming lexer. If lex_streaming is set, lex_nwcc() stops
+ * after the first external declaration, and the parser obtains further
+ * tokens with lex_next_token(). The lexers stop at the end of every
+ * declaration (lex_chunk_end, set by lex_note_token()) and set lex_done
+ * at the end of input
+ */
+extern int	lex_streaming;
+extern int	lex_chunk_end;
+extern int	lex_done;
+extern int	lex_failed;
+
+void		lex_note_token(struct token *t);
+int		lex_in_body(int type);
+struct token	*lex_next_token(struct token *t);
+
 #endif
 
@@ -52,18 +52,357 @@
 #include "type.h"
 #include "error.h"
 #include "fcatalog.h"
+#include "n_libc.h"
+#include "typemap.h"
+#include "standards.h"
+#include "archdefs.h"
+#include "sysdeps.h"
+#include "misc.h"
 
 #if !USE_UCPP
 
 int lex_ucpp(struct input_file *in) { return 1; }
+int ucpp_preprocess(const char *file, FILE *out, int dump_macros) { return 1; }
 
 #else
 
 #include "cpp.h"
 
+extern int	archflag;
+extern int	abiflag;
+
+/*
+ * 10/17/26: Multiarch include directories of Debian-style Linux systems,
+ * which hold bits/, sys/ and asm/ headers that /usr/include itself lacks
+ */
+static struct multiarch_dir {
+	int	arch;
+	int	abi;	/* 0 = any */
+	char	*path;
+} multiarch_dirs[] = {
+	{ ARCH_AMD64, 0, "/usr/include/x86_64-linux-gnu" },
+	{ ARCH_X86, 0, "/usr/include/i386-linux-gnu" },
+	{ ARCH_POWER, ABI_POWER64, "/usr/include/powerpc64-linux-gnu" },
+	{ ARCH_POWER, 0, "/usr/include/powerpc-linux-gnu" },
+	{ ARCH_MIPS, ABI_MIPS_N64, "/usr/include/mips64-linux-gnuabi64" },
+	{ ARCH_MIPS, ABI_MIPS_N32, "/usr/include/mips64-linux-gnuabin32" },
+	{ ARCH_MIPS, 0, "/usr/include/mips-linux-gnu" },
+	{ ARCH_SPARC, 0, "/usr/include/sparc64-linux-gnu" },
+	{ 0, 0, NULL }
+};
+
+static int
+is_dir(const char *path) {
+	struct stat	sbuf;
+
+	return stat(path, &sbuf) == 0 && S_ISDIR(sbuf.st_mode);
+}
+
+static char *
+get_multiarch_dir(int arch, int abi) {
+	int	i;
+
+	for (i = 0; multiarch_dirs[i].path != NULL; ++i) {
+		if (multiarch_dirs[i].arch == arch
+			&& (multiarch_dirs[i].abi == 0
+			|| multiarch_dirs[i].abi == abi)) {
+			if (is_dir(multiarch_dirs[i].path)) {
+				return multiarch_dirs[i].path;
+			}
+			break;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * 10/17/26: Sets up the include path: The -I directories come first,
+ * then nwcc's own headers (stddef.h, stdarg.h, limits.h, etc, which
+ * are otherwise provided by gcc), then the system directories. The
+ * private headers are taken from the build tree if nwcc has not been
+ * installed yet
+ */
+static void
+add_include_dirs(void) {
+	int	i;
+	int	nostdinc = 0;
+	char	*dir;
+
+	for (i = 0; cpp_args[i] != NULL; ++i) {
+		if (strncmp(cpp_args[i], "-I", 2) == 0) {
+			add_incpath(cpp_args[i]+2);
+		} else if (strcmp(cpp_args[i], "-nostdinc") == 0) {
+			nostdinc = 1;
+		}
+	}
+
+	if (is_dir(INSTALLDIR "/nwcc/include")) {
+		add_incpath(INSTALLDIR "/nwcc/include");
+#ifdef NWCC_BUILD_INCDIR
+	} else if (is_dir(NWCC_BUILD_INCDIR)) {
+		add_incpath(NWCC_BUILD_INCDIR);
+#endif
+	}
+	if (nostdinc) {
+		return;
+	}
+
+	add_incpath("/usr/local/include");
+	if (sysflag == OS_LINUX) {
+		int	host_arch;
+		int	host_abi;
+		int	host_sys;
+
+		/*
+		 * If there are no headers for the target, use those of
+		 * the host, like an external preprocessor would
+		 */
+		if ((dir = get_multiarch_dir(archflag, abiflag)) == NULL) {
+			get_host_arch(&host_arch, &host_abi, &host_sys);
+			dir = get_multiarch_dir(host_arch, host_abi);
+		}
+		if (dir != NULL) {
+			add_incpath(dir);
+		}
+	}
+	add_incpath("/usr/include");
+}
+
+static void
+define_macro_val(struct lexer_state *ls, const char *name, const char *val) {
+	char	buf[128];
+
+	sprintf(buf, "%s=%s", name, val);
+	define_macro(ls, buf);
+}
+
+static void
+define_macro_int(struct lexer_state *ls, const char *name, int val) {
+	char	buf[128];
+
+	sprintf(buf, "%s=%d", name, val);
+	define_macro(ls, buf);
+}
+
 static void
-initialize_ucpp(struct lexer_state *ls, FILE *in) {
+define_macro_list(struct lexer_state *ls, char **names) {
 	int	i;
+
+	for (i = 0; names[i] != NULL; ++i) {
+		define_macro(ls, names[i]);
+	}
+}
+
+/*
+ * 10/17/26: Predefines the macros which an external preprocessor
+ * would have defined for us. Unlike do_cpp(), this describes the
+ * target rather than the host, and the type macros come from the
+ * type map, so the private headers and the system headers (limits.h
+ * in particular) agree with the code we generate. -D and -U options
+ * are applied afterwards, in command line order
+ */
+static void
+define_target_macros(struct lexer_state *ls) {
+	static char	*x86_macros[] = {
+		"__i386__", "__i386", NULL
+	};
+	static char	*amd64_macros[] = {
+		"__x86_64__", "__x86_64", "__amd64__", "__amd64", NULL
+	};
+	static char	*ppc_macros[] = {
+		"__powerpc__", "__powerpc", "__PPC__", "__PPC", "_ARCH_PPC",
+		NULL
+	};
+	static char	*ppc64_macros[] = {
+		"__powerpc64__", "__PPC64__", "__ppc64__", "_ARCH_PPC64",
+		NULL
+	};
+	static char	*mips_macros[] = {
+		"__mips__", "__mips", "_MIPS_SZINT=32", NULL
+	};
+	static char	*sparc_macros[] = {
+		"__sparc__", "__sparc", NULL
+	};
+	static char	*linux_macros[] = {
+		"__linux__", "__linux", "__gnu_linux__", NULL
+	};
+	static struct {
+		char	*name;
+		int	code;
+	} sizes[] = {
+		{ "__SIZEOF_SHORT__", TY_SHORT },
+		{ "__SIZEOF_INT__", TY_INT },
+		{ "__SIZEOF_LONG__", TY_LONG },
+		{ "__SIZEOF_LONG_LONG__", TY_LLONG },
+		{ "__SIZEOF_FLOAT__", TY_FLOAT },
+		{ "__SIZEOF_DOUBLE__", TY_DOUBLE },
+		{ "__SIZEOF_LONG_DOUBLE__", TY_LDOUBLE },
+		{ NULL, 0 }
+	};
+	struct arch_properties	*arch = cross_get_target_arch_properties();
+	char			buf[128];
+	char			*size_type;
+	char			*ptrdiff_type;
+	int			strict = using_strict_iso_c();
+	int			host_sys = sysdep_get_host_system();
+	int			i;
+
+	define_macro(ls, "__NWCC__=1");
+	if (strict) {
+		define_macro(ls, "__STRICT_ANSI__=1");
+	}
+
+	/*
+	 * Same rules as in do_cpp(); See there for why we claim to be
+	 * GNU C 3
+	 */
+	if ((host_sys == OS_LINUX
+		&& gnuheadersflag && stdflag != ISTD_C89 && !notgnu_flag)
+		|| ((host_sys == OS_FREEBSD
+		|| host_sys == OS_DRAGONFLYBSD
+		|| host_sys == OS_OPENBSD
+		|| host_sys == OS_MIRBSD) && !notgnu_flag && !ansiflag)) {
+		const char	*envvar = getenv("NWCC_DEFINE_GNUC_MACRO");
+		int		version = 3;
+
+		if (envvar != NULL && isdigit((unsigned char)*envvar)) {
+			version = *envvar - '0';
+		}
+		define_macro_int(ls, "__GNUC__", version);
+		define_macro(ls, "__GNUC_MINOR__=0");
+		define_macro(ls, "__GNUC_PATCHLEVEL__=0");
+	}
+
+	switch (archflag) {
+	case ARCH_X86:
+		define_macro_list(ls, x86_macros);
+		if (!strict) {
+			define_macro(ls, "i386");
+		}
+		break;
+	case ARCH_AMD64:
+		define_macro_list(ls, amd64_macros);
+		break;
+	case ARCH_POWER:
+		define_macro_list(ls, ppc_macros);
+		if (abiflag == ABI_POWER64) {
+			define_macro_list(ls, ppc64_macros);
+		}
+		break;
+	case ARCH_MIPS:
+		define_macro_list(ls, mips_macros);
+		break;
+	case ARCH_SPARC:
+		define_macro_list(ls, sparc_macros);
+		if (abiflag == ABI_SPARC64) {
+			define_macro(ls, "__sparc64__");
+			define_macro(ls, "__arch64__");
+		}
+		break;
+	}
+	if (arch->data_ptr_size == 8) {
+		define_macro(ls, "__LP64__=1");
+		define_macro(ls, "_LP64=1");
+	}
+
+	switch (sysflag) {
+	case OS_LINUX:
+		define_macro_list(ls, linux_macros);
+		if (!strict) {
+			define_macro(ls, "linux");
+		}
+		break;
+	case OS_FREEBSD:
+		define_macro(ls, "__FreeBSD__");
+		break;
+	case OS_OPENBSD:
+	case OS_MIRBSD:
+		define_macro(ls, "__OpenBSD__");
+		break;
+	case OS_NETBSD:
+		define_macro(ls, "__NetBSD__");
+		break;
+	case OS_DRAGONFLYBSD:
+		define_macro(ls, "__DragonFly__");
+		break;
+	case OS_SOLARIS:
+		define_macro(ls, "__sun__");
+		define_macro(ls, "__sun");
+		define_macro(ls, "__svr4__");
+		break;
+	}
+	if (sysflag != OS_OSX && sysflag != OS_AIX) {
+		define_macro(ls, "__ELF__");
+	}
+	/* For glibc's __REDIRECT() asm labels */
+	define_macro_val(ls, "__USER_LABEL_PREFIX__",
+		sysflag == OS_OSX? "_": "");
+	if (sysflag != OS_OSX) {
+		define_macro(ls, "__unix__");
+		define_macro(ls, "__unix");
+		if (!strict) {
+			define_macro(ls, "unix");
+		}
+	}
+
+	for (i = 0; sizes[i].name != NULL; ++i) {
+		define_macro_int(ls, sizes[i].name,
+			cross_get_type_properties(sizes[i].code)->bytes);
+	}
+	define_macro_int(ls, "__SIZEOF_POINTER__", arch->data_ptr_size);
+	define_macro_int(ls, "__SIZEOF_WCHAR_T__", 4);
+
+	if (arch->data_ptr_size == 8) {
+		size_type = "unsigned long";
+		ptrdiff_type = "long";
+	} else {
+		size_type = "unsigned int";
+		ptrdiff_type = "int";
+	}
+	define_macro_val(ls, "__SIZE_TYPE__", size_type);
+	define_macro_val(ls, "__PTRDIFF_TYPE__", ptrdiff_type);
+	define_macro_val(ls, "__WCHAR_TYPE__", "int");
+	define_macro_val(ls, "__INTMAX_TYPE__", "long long");
+	define_macro_val(ls, "__UINTMAX_TYPE__", "unsigned long long");
+
+	define_macro(ls, "__CHAR_BIT__=8");
+	define_macro_val(ls, "__SCHAR_MAX__",
+		cross_get_type_properties(TY_SCHAR)->max_dec);
+	define_macro_val(ls, "__SHRT_MAX__",
+		cross_get_type_properties(TY_SHORT)->max_dec);
+	define_macro_val(ls, "__INT_MAX__",
+		cross_get_type_properties(TY_INT)->max_dec);
+	sprintf(buf, "%sL", cross_get_type_properties(TY_LONG)->max_dec);
+	define_macro_val(ls, "__LONG_MAX__", buf);
+	sprintf(buf, "%sLL", cross_get_type_properties(TY_LLONG)->max_dec);
+	define_macro_val(ls, "__LONG_LONG_MAX__", buf);
+	if (cross_get_char_signedness() == TOK_KEY_UNSIGNED) {
+		define_macro(ls, "__CHAR_UNSIGNED__");
+	}
+
+	define_macro(ls, "__ORDER_LITTLE_ENDIAN__=1234");
+	define_macro(ls, "__ORDER_BIG_ENDIAN__=4321");
+	define_macro_val(ls, "__BYTE_ORDER__",
+		arch->endianness == ENDIAN_LITTLE?
+		"__ORDER_LITTLE_ENDIAN__": "__ORDER_BIG_ENDIAN__");
+
+	for (i = 0; cpp_args[i] != NULL; ++i) {
+		if (strncmp(cpp_args[i], "-D", 2) == 0) {
+			define_macro(ls, cpp_args[i]+2);
+		} else if (strncmp(cpp_args[i], "-U", 2) == 0) {
+			undef_macro(ls, cpp_args[i]+2);
+		}
+	}
+}
+
+/*
+ * Prepares ucpp for reading ``file'' from ``in'', either as our lexer
+ * (out = NULL) or to write preprocessed text to ``out'' for -E. With
+ * -dM (dump_macros), no text is written
+ */
+static void
+initialize_ucpp(struct lexer_state *ls, FILE *in, const char *file,
+	FILE *out, int dump_macros) {
 	/*
 	 * This code is an adaption of ucpp's sample.c
 	 */
@@ -75,7 +414,12 @@ initialize_ucpp(struct lexer_state *ls, FILE *in) {
 	no_special_macros = 0;
 	emit_defines = emit_assertions = 0;
 
-	/* step 3 -- with assertions */
+	/*
+	 * step 3 -- with assertions. 10/17/26: __STDC__, __STDC_HOSTED__
+	 * and __STDC_VERSION__ are among ucpp's special macros
+	 */
+	c99_compliant = stdflag == ISTD_C99 || stdflag == ISTD_GNU99;
+	c99_hosted = 1;
 	init_tables(1);
 
 	/* step 4 -- no default include path */
@@ -84,32 +428,33 @@ initialize_ucpp(struct lexer_state *ls, FILE *in) {
 	/* step 5 -- no need to reset the two emit_* variables set in 2 */
 	emit_dependencies = 0;
 
-	/* step 6 -- we work with stdin, this is not a real filename */
-	set_init_filename("[stdin]", 0);
+	/*
+	 * step 6 -- 10/17/26: Use the real file name, so that it appears
+	 * in CONTEXT tokens and ucpp diagnostics, and quoted #includes
+	 * are found relative to its directory
+	 */
+	set_init_filename((char *)file, 1);
 
 	/* step 7 -- we make sure that assertions are on, and pragma are
 	   handled */
 	init_lexer_state(ls);
-	init_lexer_mode(ls);
-	ls->flags |= HANDLE_ASSERTIONS | HANDLE_PRAGMA | LINE_NUM;
+	if (out == NULL) {
+		init_lexer_mode(ls);
+		ls->flags |= HANDLE_ASSERTIONS | HANDLE_PRAGMA | LINE_NUM;
+	} else {
+		ls->flags = DEFAULT_CPP_FLAGS | GCC_LINE_NUM;
+		if (dump_macros) {
+			ls->flags &= ~(KEEP_OUTPUT | LINE_NUM);
+		}
+		emit_output = ls->output = out;
+	}
 
 	/* step 8 -- input is from specified FILE stream */
 	ls->input = in;
 
-	/* step 9 -- we do not have any macro to define, but we add any
-	  argument as an include path */
-/*	for (i = 1; i < argc; i ++) add_incpath(argv[i]);*/
-	add_incpath("/usr/local/nwcc/include");  /* XXXXXXXXXXXXXXXX */
-	add_incpath("/usr/include");  /* XXXXXXXXXXXXXXXX */
-	for (i = 0; cpp_args[i] != NULL; ++i ){
-		if (strncmp(cpp_args[i], "-I", 2) == 0) {
-			add_incpath(cpp_args[i]+2);
-		} else if (strncmp(cpp_args[i], "-D", 2) == 0) {
-			define_macro(ls, cpp_args[i]+2);
-		} else if (strncmp(cpp_args[i], "-U", 2) == 0) {
-			undef_macro(ls, cpp_args[i]+2);
-		}
-	}
+	/* step 9 -- include path and predefined macros */
+	add_include_dirs();
+	define_target_macros(ls);
 
 	/* step 10 -- we are a lexer and we want CONTEXT tokens */
 	enter_file(ls, ls->flags);
@@ -118,7 +463,8 @@ initialize_ucpp(struct lexer_state *ls, FILE *in) {
 
 static void
 process_ucpp_token(struct ucpp_token *tok) {
-	int           			*dummyptr       = n_xmalloc(sizeof *dummyptr);
+	static int			dummy;
+	int				*dummyptr = &dummy;
 	static struct input_file	infile;
 
 #if 0
@@ -199,7 +545,7 @@ process_ucpp_token(struct ucpp_token *tok) {
 		ident = get_identifier(*tok->name, &infile);
 		if (ident != NULL) {
 			store_token(&toklist, ident,
-				TOK_IDENTIFIER, lineno, n_xstrdup(tok->name));
+				TOK_IDENTIFIER, lineno, NULL);
 		}
 		break;
 		}
@@ -263,9 +609,9 @@ process_ucpp_token(struct ucpp_token *tok) {
 		break;
 		}
 	case MDOTS: {
-		int	*tmp = n_xmalloc(sizeof *tmp);
-		*tmp = 0; 
-		store_token(&toklist, tmp, TOK_ELLIPSIS, lineno, NULL);
+		int	zero = 0;
+
+		store_token(&toklist, &zero, TOK_ELLIPSIS, lineno, NULL);
 		break;
 		}
 	case SLASH:          /*      /       */
@@ -312,16 +658,20 @@ process_ucpp_token(struct ucpp_token *tok) {
         case UPLUS: /* unary + */
         case UMINUS:          /* unary - */
 		{
-		int	*opval = n_xmalloc(sizeof *opval);
+		int	opval;
 		char	*optext = operators_name[tok->type];
 
 		set_input_file_buffer(&infile, optext+1);
-		*opval = get_operator(*optext, &infile, &optext); /* XXX cross-comp */
-		if (*opval == -1) {
+		opval = get_operator(*optext, &infile, &optext); /* XXX cross-comp */
+		if (opval == -1) {
 			lexerror("Invalid operator `%s'", optext);
-			free(opval);
 		} else {
-			store_token(&toklist, opval, TOK_OPERATOR, lineno, tok->name);
+			/*
+			 * 10/17/26: Copied into the token. The name
+			 * of ucpp's token isn't set for operators, so
+			 * use that of the operator table
+			 */
+			store_token(&toklist, &opval, TOK_OPERATOR, lineno, optext);
 		}
 		break;
 		}
@@ -329,8 +679,113 @@ process_ucpp_token(struct ucpp_token *tok) {
 		printf("Unhandled token, type %d, value %s\n", tok->type, tok->name? tok->name: "?");
 		break;
 	}
+}
 
-	return NULL;
+/*
+ * 10/17/26: ucpp tokens only carry a line number. So that diagnostics
+ * can show the source line of a token, tokens of the main source file
+ * are looked up in its mapping (lex_file_map); src.line is the start
+ * of line src.lineno, and src.cur is the position behind the last
+ * token found on it. Tokens that cannot be found there (those resulting
+ * from macro expansion, or after #line) get no source position
+ */
+static struct {
+	const char	*line;
+	long		lineno;
+	const char	*cur;
+	int		in_main_file;
+} src;
+
+static int
+is_ident_char(int ch) {
+	return isalnum((unsigned char)ch) || ch == '_' || ch == '$';
+}
+
+static const char *
+skip_blanks_and_comments(const char *p) {
+	while (p < lex_file_map_end) {
+		if (*p == ' ' || *p == '\t' || *p == '\r'
+			|| *p == '\f' || *p == '\v') {
+			++p;
+		} else if (*p == '/' && p + 1 < lex_file_map_end
+			&& p[1] == '*') {
+			for (p += 2; p + 1 < lex_file_map_end; ++p) {
+				if (*p == '\n') {
+					/* Token is on another line */
+					return p;
+				}
+				if (*p == '*' && p[1] == '/') {
+					break;
+				}
+			}
+			p += 2;
+		} else {
+			break;
+		}
+	}
+	return p;
+}
+
+/*
+ * Sets lex_tok_ptr (for store_token()) and lex_line_ptr/lex_chars_read
+ * (for lexerror()) to the position of the token spelled ``spelling'' on
+ * line ``line'' of the main source file, or NULL if it isn't found
+ */
+static void
+locate_ucpp_token(long line, const char *spelling) {
+	const char	*p;
+	const char	*q;
+	size_t		len;
+
+	lex_tok_ptr = lex_line_ptr = NULL;
+	if (!src.in_main_file || lex_file_map == NULL || *spelling == 0) {
+		return;
+	}
+	if (src.line == NULL || line != src.lineno) {
+		if (src.line == NULL || line < src.lineno) {
+			src.line = lex_file_map;
+			src.lineno = 1;
+		}
+		while (src.lineno < line) {
+			p = memchr(src.line, '\n',
+				lex_file_map_end - src.line);
+			if (p == NULL) {
+				src.line = NULL;
+				return;
+			}
+			src.line = p + 1;
+			++src.lineno;
+		}
+		src.cur = src.line;
+	}
+
+	len = strlen(spelling);
+	p = skip_blanks_and_comments(src.cur);
+	for (q = p; q + len <= lex_file_map_end && *q != '\n'; ++q) {
+		if (memcmp(q, spelling, len) != 0) {
+			continue;
+		}
+		if (q == p) {
+			break;
+		}
+		/*
+		 * Not where the token should be, so it may not come from
+		 * the source. Only take it if it is a whole token
+		 */
+		if (!is_ident_char(*spelling)
+			|| (!is_ident_char(q[-1])
+			&& (q + len == lex_file_map_end
+			|| !is_ident_char(q[len])))) {
+			break;
+		}
+	}
+	if (q + len > lex_file_map_end || *q == '\n') {
+		return;
+	}
+	src.cur = q + len;
+	lex_tok_ptr = (char *)q + 1;
+	lex_line_ptr = (char *)src.line;
+	lex_chars_read = q + 1 - lex_file_map;
 }
 
 int
@@ -338,15 +793,30 @@ lex_ucpp(struct input_file *in) {
 	int				r;
 	char				*curfile = NULL;
 	static struct lexer_state	ls;
+	static int			started;
 
-	initialize_ucpp(&ls, in->fd);
+	/*
+	 * 10/17/26: When streaming, we are called again for every
+	 * declaration (see lex_next_token()) and continue where we
+	 * stopped
+	 */
+	if (!started) {
+		initialize_ucpp(&ls, in->fd, input_file, NULL, 0);
+		started = 1;
+		src.line = NULL;
+		src.in_main_file = 1;
+	}
 
 
-        /* read tokens until end-of-input is reached -- errors (non-zero
-           return values different from CPPERR_EOF) are ignored */
-        while ((r = lex(&ls)) < CPPERR_EOF) {
+        /* read tokens until end-of-input is reached */
+        while (!lex_chunk_end && (r = lex(&ls)) < CPPERR_EOF) {
                 if (r) {
-                        /* error condition -- no token was retrieved */
+                        /*
+			 * error condition -- no token was retrieved.
+			 * 10/17/26: ucpp has already printed the message,
+			 * but the compilation has to fail
+			 */
+			++errors;
                         continue;
                 }
                 /* we print each token: its numerical value, and its
@@ -386,7 +856,9 @@ lex_ucpp(struct input_file *in) {
 			 * Note that curfile is still referred to by tokens -
 			 * don't free
 			 */
-			curfile = strdup(ls.ctok->name);
+			curfile = token_setfile(ls.ctok->name);
+			src.in_main_file =
+				strcmp(ls.ctok->name, input_file) == 0;
 			if (*curfile
 				&& curfile[strlen(curfile) - 1] == 'c') {
 				cur_inc = NULL;
@@ -395,7 +867,6 @@ lex_ucpp(struct input_file *in) {
                      
 			/* Processing new file */
 			err_setfile(curfile);
-			token_setfile(curfile);
 			lineno = ls.ctok->line;
 
                 } else if (ls.ctok->type == NEWLINE) {
@@ -411,13 +882,33 @@ lex_ucpp(struct input_file *in) {
                                 : operators_name[ls.ctok->type]);
 #endif
 
+			/*
+			 * 10/17/26: Tokens of macro expansions spanning
+			 * multiple lines belong to the line of the
+			 * invocation
+			 */
+			lineno = ls.ctok->line;
+			locate_ucpp_token(ls.ctok->line,
+				STRING_TOKEN(ls.ctok->type)? ls.ctok->name
+				: operators_name[ls.ctok->type]);
 			process_ucpp_token(ls.ctok);
+			lex_tok_ptr = lex_line_ptr = NULL;
                 }
         }
 
+	if (lex_chunk_end) {
+		lex_chunk_end = 0;
+		return errors;
+	}
+
         /* give back memory and exit */
+	if (check_cpp_errors(&ls) != 0) {
+		++errors;
+	}
         wipeout();
         free_lexer_state(&ls);
+	started = 0;
+	lex_done = 1;
 
 
 #if 0
@@ -433,5 +924,35 @@ lex_ucpp(struct input_file *in) {
 	return errors;
 }
 
+/*
+ * 10/17/26: Writes the preprocessed text of ``file'' (-E), or the
+ * macros defined at its end (-dM), to ``out''. Returns nonzero if
+ * there were errors
+ */
+int
+ucpp_preprocess(const char *file, FILE *out, int dump_macros) {
+	struct lexer_state	ls;
+	FILE			*in;
+	int			r;
+	int			failed = 0;
+
+	if ((in = fopen(file, "r")) == NULL) {
+		perror(file);
+		return 1;
+	}
+	initialize_ucpp(&ls, in, file, out, dump_macros);
+
+	while ((r = cpp(&ls)) < CPPERR_EOF) {
+		failed = failed || r > 0;
+	}
+	failed = failed || check_cpp_errors(&ls);
+	if (dump_macros) {
+		print_defines();
+	}
+	free_lexer_state(&ls);
+	wipeout();
+	return failed;
+}
+
 #endif /* USE_UCPP */
 
@@ -32,6 +32,7 @@
 struct input_file;
 
 int lex_ucpp(struct input_file *in);
+int ucpp_preprocess(const char *file, FILE *out, int dump_macros);
 
 #endif
 
@@ -634,19 +634,13 @@ emit_strings(struct ty_string *list) {
 
 static void
 emit_comment(const char *fmt, ...) {
-	int		rc;
 	va_list	va;
 
 	va_start(va, fmt);
 	x_fprintf(out, "# ");
-	rc = vfprintf(out, fmt, va);
+	x_vfprintf(out, fmt, va);
 	va_end(va);
 	x_fputc('\n', out);
-
-	if (rc == EOF || fflush(out) == EOF) {
-		perror("vfprintf");
-		exit(EXIT_FAILURE);
-	}
 }
 
 static void
@@ -2599,6 +2593,7 @@ struct emitter mips_emit_as = {
 	emit_load,
 	emit_load_addrlabel,
 	emit_comp_goto,
+	NULL, /* switch_table */
 	emit_store,
 	emit_setsection,
 	emit_alloc,
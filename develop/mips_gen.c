@@ -2097,6 +2097,7 @@ struct backend mips_backend = {
 	1, /* need pic initialization? */
 	1, /* emulate long double?  As of 07/15/09: YES! */
 	0, /* relax alloc gpr order */
+	0, /* stack alloca */
 	32767, /* max displacement */
 	-32768, /* min displacement */
 	have_immediate_op,
@@ -2146,6 +2147,7 @@ struct backend mips_backend = {
 	do_ret,
 	get_abi_reg,
 	get_abi_ret_reg,
-	generic_same_representation
+	generic_same_representation,
+	NULL
 };
 
@@ -44,6 +44,12 @@
 
 static size_t	n_xmalloc_guard;
 
+/*
+ * 10/17/26: Allocation counters for -ftime-report
+ */
+unsigned long	n_alloc_calls;
+unsigned long	n_alloc_bytes;
+
 void
 n_xmalloc_set_guard(size_t nbytes) {
 	n_xmalloc_guard = nbytes;
@@ -53,6 +59,8 @@ void *
 (n_xmalloc)(size_t nbytes) {
 	void	*ret;
 
+	++n_alloc_calls;
+	n_alloc_bytes += nbytes;
 	if ((ret = malloc(nbytes+n_xmalloc_guard)) == NULL) {
 		perror("malloc");
 		exit(EXIT_FAILURE);
@@ -65,6 +73,8 @@ void *
 (n_xrealloc)(void *block, size_t nbytes) {
 	void	*ret;
 
+	++n_alloc_calls;
+	n_alloc_bytes += nbytes;
 	if ((ret = realloc(block, nbytes)) == NULL) {
 		perror("realloc");
 abort();
@@ -78,6 +88,8 @@ char *
 	char	*ret;
 	size_t	len = strlen(msg) + 1;
 
+	++n_alloc_calls;
+	n_alloc_bytes += len;
 	if ((ret = malloc(len)) == NULL) {
 		return NULL;
 	}
@@ -117,22 +129,124 @@ void *
 	return ret;
 }
 
+/*
+ * 10/17/26: Output buffer for the assembler file. Once x_setoutbuf()
+ * has been called for a file, everything written to it through the
+ * x_ functions below is collected in one growable buffer instead of
+ * going through stdio line by line, and is only passed to the kernel
+ * by x_flushoutbuf() or x_fflush() with a single write()
+ */
+static struct {
+	FILE	*fd;
+	char	*buf;
+	size_t	len;
+	size_t	size;
+} outbuf;
+
+#define OUTBUF_INIT_SIZE	(64 * 1024)
+
+#ifndef va_copy
+#  ifdef __va_copy
+#    define va_copy(dest, src) __va_copy(dest, src)
+#  else
+#    define va_copy(dest, src) memcpy(&(dest), &(src), sizeof(va_list))
+#  endif
+#endif
+
+static void
+outbuf_grow(size_t nbytes) {
+	while (outbuf.size - outbuf.len < nbytes) {
+		outbuf.size *= 2;
+	}
+	outbuf.buf = n_xrealloc(outbuf.buf, outbuf.size);
+}
+
 void
-(x_fprintf)(FILE *fd, const char *fmt, ...) {
-	va_list	va;
+x_setoutbuf(FILE *fd) {
+	x_flushoutbuf(0);
+	if (fd != NULL) {
+		x_fflush(fd);
+	}
+	outbuf.fd = fd;
+	if (outbuf.buf == NULL) {
+		outbuf.size = OUTBUF_INIT_SIZE;
+		outbuf.buf = n_xmalloc(outbuf.size);
+	}
+}
+
+/*
+ * Writes the buffer contents if there are at least minbytes
+ */
+void
+x_flushoutbuf(size_t minbytes) {
+	size_t	done = 0;
+	ssize_t	rc;
+
+	if (outbuf.fd == NULL || outbuf.len == 0 || outbuf.len < minbytes) {
+		return;
+	}
+	while (done < outbuf.len) {
+		rc = write(fileno(outbuf.fd), outbuf.buf + done,
+			outbuf.len - done);
+		if (rc == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			perror("write");
+			exit(EXIT_FAILURE);
+		}
+		done += rc;
+	}
+	outbuf.len = 0;
+}
+
+void
+(x_vfprintf)(FILE *fd, const char *fmt, va_list va) {
 	int	rc;
 
-	va_start(va, fmt);
-	rc = vfprintf(fd, fmt, va);
-	va_end(va);
+	if (fd == outbuf.fd && fd != NULL) {
+		va_list	va2;
+		size_t	avail;
+
+		if (outbuf.size - outbuf.len < 128) {
+			outbuf_grow(128);
+		}
+		avail = outbuf.size - outbuf.len;
+		va_copy(va2, va);
+		rc = vsnprintf(outbuf.buf + outbuf.len, avail, fmt, va2);
+		va_end(va2);
+		if (rc >= 0 && (size_t)rc >= avail) {
+			/* Did not fit - grow and try again */
+			outbuf_grow(rc + 1);
+			rc = vsnprintf(outbuf.buf + outbuf.len,
+				outbuf.size - outbuf.len, fmt, va);
+		}
+		if (rc >= 0) {
+			outbuf.len += rc;
+		}
+	} else {
+		rc = vfprintf(fd, fmt, va);
+	}
 	if (rc < 0) {
 		perror("vfprintf");
 		exit(EXIT_FAILURE);
 	}
 }
 
+void
+(x_fprintf)(FILE *fd, const char *fmt, ...) {
+	va_list	va;
+
+	va_start(va, fmt);
+	x_vfprintf(fd, fmt, va);
+	va_end(va);
+}
+
 void
 (x_fflush)(FILE *fd) {
+	if (fd == outbuf.fd) {
+		x_flushoutbuf(0);
+	}
 	if (fflush(fd) == EOF) {
 		perror("fflush");
 		exit(EXIT_FAILURE);
@@ -142,12 +256,65 @@ void
 
 void
 (x_fputc)(int ch, FILE *fd) {
+	if (fd == outbuf.fd && fd != NULL) {
+		if (outbuf.len == outbuf.size) {
+			outbuf_grow(1);
+		}
+		outbuf.buf[outbuf.len++] = (char)ch;
+		return;
+	}
 	if (fputc(ch, fd) == EOF) {
 		perror("x_fputc");
 		exit(EXIT_FAILURE);
 	}
 }
 
+/*
+ * 10/17/26: Formatters for the emitters, which write strings and
+ * numbers without going through printf() format parsing
+ */
+void
+x_fputs(const char *str, FILE *fd) {
+	size_t	len;
+
+	if (fd == outbuf.fd && fd != NULL) {
+		len = strlen(str);
+		if (outbuf.size - outbuf.len < len) {
+			outbuf_grow(len);
+		}
+		memcpy(outbuf.buf + outbuf.len, str, len);
+		outbuf.len += len;
+		return;
+	}
+	if (fputs(str, fd) == EOF) {
+		perror("x_fputs");
+		exit(EXIT_FAILURE);
+	}
+}
+
+void
+x_fputulong(unsigned long val, FILE *fd) {
+	char	buf[32];
+	char	*p = buf + sizeof buf;
+
+	*--p = 0;
+	do {
+		*--p = (char)('0' + val % 10);
+		val /= 10;
+	} while (val != 0);
+	x_fputs(p, fd);
+}
+
+void
+x_fputlong(long val, FILE *fd) {
+	if (val < 0) {
+		x_fputc('-', fd);
+		x_fputulong(-(unsigned long)val, fd);
+	} else {
+		x_fputulong(val, fd);
+	}
+}
+
 
 /*
  * If some data is modified unexpectedly by someone unknown, just
@@ -210,6 +377,8 @@ debug_make_writable(void *p, size_t size) {
 
 void
 (dounimpl)(const char *f, int line) {
+	/* 10/17/26: Keep the partial assembler output for debugging */
+	x_flushoutbuf(0);
 	printf("In function `%s', line %d:\n", f, line);
 	puts("WHOOPS! This code path should not have been executed");
 	puts("because it is unimplemented. Sorry about that. Rest");
@@ -235,6 +404,7 @@ void
 
 void
 (dobuggypath)(const char *f, int line) {
+	x_flushoutbuf(0);
 	printf("In function `%s', line %d:\n", f, line);
 	puts("BUG:  This code path is invalid (deactived) and should");
 	puts("      not have been executed! This means that the");
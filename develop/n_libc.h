@@ -41,10 +41,27 @@ void	*n_xmalloc(size_t nbytes);
 void	*n_xrealloc(void *block, size_t nbytes);
 char	*n_xstrdup(const char *msg);
 void	*n_xmemdup(const void *data, size_t len);
+
+/* 10/17/26: Calls and bytes of the allocation functions above */
+extern unsigned long	n_alloc_calls;
+extern unsigned long	n_alloc_bytes;
+
 void	make_room(char **p, size_t *size, size_t nbytes);
 void	x_fprintf(FILE *fd, const char *fmt, ...);
+void	x_vfprintf(FILE *fd, const char *fmt, va_list va);
 void	x_fputc(int ch, FILE *fd);
+void	x_fputs(const char *str, FILE *fd);
+void	x_fputlong(long val, FILE *fd);
+void	x_fputulong(unsigned long val, FILE *fd);
 void	x_fflush(FILE *fd);
+void	x_setoutbuf(FILE *fd);
+void	x_flushoutbuf(size_t minbytes);
+
+/*
+ * 10/17/26: Buffered assembler output is written at the end of a
+ * function once it has grown to this size, and at the end of the file
+ */
+#define X_OUTBUF_FLUSH_SIZE	(256 * 1024)
 void	*debug_malloc_pages(size_t nbytes);
 void	debug_make_unwritable(void *p, size_t size);
 void	debug_make_writable(void *p, size_t size);
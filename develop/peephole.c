@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) 2005 - 2010, Nils R. Weller
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * 10/17/26: Peephole optimizer which runs over the completed icode list of
+ * a function before the backend emits it.
+ *
+ * Since the code generator allocates registers and fetches variables on a
+ * per-expression basis, the icode is full of small redundancies at the
+ * boundaries between expressions; A variable is stored and immediately
+ * reloaded, control flow jumps to a jump, and so on. The generic rules
+ * below clean these up, while each backend may supply a table of further
+ * rules for target-specific idioms (e.g. test instead of cmp with zero on
+ * x86). Rules only ever look at two neighboring instructions, so they
+ * cannot change the meaning of code which is reachable by a branch
+ */
+#include "peephole.h"
+#include <stdlib.h>
+#include <string.h>
+#include "backend.h"
+#include "functions.h"
+#include "decl.h"
+#include "type.h"
+#include "icode.h"
+#include "reg.h"
+#include "n_libc.h"
+
+/*
+ * Labels which are actually part of the icode list of the function being
+ * optimized, sorted by address. Branches to any other label are left alone
+ */
+static struct icode_instr	**labels;
+static int			nlabels;
+
+static int
+is_transparent(struct icode_instr *ip) {
+	return ip->type == INSTR_SEQPOINT
+		|| ip->type == INSTR_DEBUG
+		|| ip->type == INSTR_DBGINFO_LINE;
+}
+
+struct icode_instr *
+peephole_next_instr(struct icode_instr *ip) {
+	for (ip = ip->next; ip != NULL; ip = ip->next) {
+		if (!is_transparent(ip)) {
+			break;
+		}
+	}
+	return ip;
+}
+
+static int
+compare_labels(const void *p1, const void *p2) {
+	struct icode_instr	*l1 = *(struct icode_instr * const *)p1;
+	struct icode_instr	*l2 = *(struct icode_instr * const *)p2;
+
+	if (l1 < l2) {
+		return -1;
+	} else if (l1 > l2) {
+		return 1;
+	}
+	return 0;
+}
+
+static int
+is_known_label(struct icode_instr *label) {
+	return bsearch(&label, labels, nlabels, sizeof *labels,
+		compare_labels) != NULL;
+}
+
+/*
+ * Returns 1 if ``vr'' is a plain scalar variable or anonymous stack slot
+ * which is accessed in a single register without any address computation
+ */
+static int
+is_plain_slot(struct vreg *vr, struct reg *r) {
+	if (vr == NULL
+		|| r == NULL
+		|| r->type != REG_GPR
+		|| vr->parent != NULL
+		|| vr->from_ptr != NULL
+		|| vr->from_const != NULL
+		|| vr->is_multi_reg_obj
+		|| IS_VOLATILE(vr->type->flags)) {
+		return 0;
+	}
+	if (vr->var_backed != NULL) {
+		if (IS_VOLATILE(vr->var_backed->dtype->flags)) {
+			return 0;
+		}
+	} else if (vr->stack_addr == NULL) {
+		return 0;
+	}
+
+	/*
+	 * On RISC targets, sub-word values live in full-word registers
+	 * and may carry garbage in the upper bits which only a load
+	 * cleans up, so the register has to be exactly as large as the
+	 * object
+	 */
+	return r->size == vr->size;
+}
+
+static int
+same_slot(struct vreg *vr1, struct vreg *vr2) {
+	if (vr1->size != vr2->size
+		|| vr1->addr_offset != vr2->addr_offset) {
+		return 0;
+	}
+	if (vr1->var_backed != NULL || vr2->var_backed != NULL) {
+		return vr1->var_backed == vr2->var_backed;
+	}
+	return vr1->stack_addr == vr2->stack_addr;
+}
+
+/*
+ * store reg -> x;  load x -> reg2
+ *
+ * The value is still in ``reg'', so the load becomes a register copy, or
+ * disappears if the registers are the same
+ */
+static int
+rule_store_load(struct icode_instr *prev, struct icode_instr *ip) {
+	struct reg	*stored;
+	struct reg	*loaded;
+	struct copyreg	*cr;
+
+	if (prev == NULL
+		|| prev->type != INSTR_STORE
+		|| ip->type != INSTR_LOAD
+		|| prev->dat != NULL
+		|| ip->dat != NULL
+		|| prev->dest_pregs == NULL
+		|| ip->src_pregs == NULL) {
+		return PEEP_KEEP;
+	}
+
+	/* XXX confusingly messed up order of store args */
+	stored = prev->dest_pregs[0];
+	loaded = ip->src_pregs[0];
+	if (!is_plain_slot(prev->src_vreg, stored)
+		|| !is_plain_slot(ip->src_vreg, loaded)
+		|| !same_slot(prev->src_vreg, ip->src_vreg)
+		|| stored->size != loaded->size) {
+		return PEEP_KEEP;
+	}
+	if (stored == loaded) {
+		return PEEP_DELETE;
+	}
+
+	cr = n_xmalloc(sizeof *cr);
+	cr->src_preg = stored;
+	cr->dest_preg = loaded;
+	cr->src_type = cr->dest_type = ip->src_vreg->type;
+	ip->type = INSTR_MOV;
+	ip->dat = cr;
+	ip->src_vreg = ip->dest_vreg = NULL;
+	ip->src_pregs = ip->dest_pregs = NULL;
+	ip->memref = NULL;
+	return PEEP_CHANGED;
+}
+
+/*
+ * load x -> reg;  store reg -> x
+ *
+ * The store writes back the value which is already there
+ */
+static int
+rule_load_store(struct icode_instr *prev, struct icode_instr *ip) {
+	if (prev == NULL
+		|| prev->type != INSTR_LOAD
+		|| ip->type != INSTR_STORE
+		|| prev->dat != NULL
+		|| ip->dat != NULL
+		|| prev->src_pregs == NULL
+		|| ip->dest_pregs == NULL) {
+		return PEEP_KEEP;
+	}
+	if (prev->src_pregs[0] == ip->dest_pregs[0]
+		&& is_plain_slot(prev->src_vreg, prev->src_pregs[0])
+		&& is_plain_slot(ip->src_vreg, ip->dest_pregs[0])
+		&& same_slot(prev->src_vreg, ip->src_vreg)) {
+		return PEEP_DELETE;
+	}
+	return PEEP_KEEP;
+}
+
+static int
+is_nop_mov(struct copyreg *cr) {
+	if (cr->src_preg != cr->dest_preg
+		|| cr->src_preg == NULL
+		|| cr->src_preg->type != REG_GPR) {
+		return 0;
+	}
+	if (backend->arch == ARCH_AMD64 && cr->dest_preg->size == 4) {
+		/* mov %eax, %eax clears the upper half of rax */
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * mov reg -> reg, and the second of   mov a -> b;  mov b -> a
+ */
+static int
+rule_dead_mov(struct icode_instr *prev, struct icode_instr *ip) {
+	struct copyreg	*cr;
+	struct copyreg	*prevcr;
+
+	if (ip->type != INSTR_MOV) {
+		return PEEP_KEEP;
+	}
+	cr = ip->dat;
+	if (is_nop_mov(cr)) {
+		return PEEP_DELETE;
+	}
+	if (prev == NULL || prev->type != INSTR_MOV) {
+		return PEEP_KEEP;
+	}
+	prevcr = prev->dat;
+	if (prevcr->src_preg == cr->dest_preg
+		&& prevcr->dest_preg == cr->src_preg
+		&& cr->src_preg != NULL
+		&& cr->src_preg->type == REG_GPR
+		&& cr->dest_preg->type == REG_GPR
+		&& cr->src_preg->size == cr->dest_preg->size
+		&& !(backend->arch == ARCH_AMD64 && cr->dest_preg->size == 4)) {
+		return PEEP_DELETE;
+	}
+	return PEEP_KEEP;
+}
+
+/*
+ * Follows a chain of labels which are immediately followed by unconditional
+ * jumps and returns the final target. The number of hops is limited so we
+ * don't get stuck in ``for (;;) ;''-style cycles
+ */
+static struct icode_instr *
+final_target(struct icode_instr *label) {
+	struct icode_instr	*next;
+	int			hops;
+
+	for (hops = 0; hops < 16; ++hops) {
+		for (next = peephole_next_instr(label);
+			next != NULL && next->type == INSTR_LABEL;
+			next = peephole_next_instr(next)) {
+			;
+		}
+		if (next == NULL
+			|| next->type != INSTR_JUMP
+			|| next->dat == label
+			|| !is_known_label(next->dat)) {
+			break;
+		}
+		label = next->dat;
+	}
+	return label;
+}
+
+/*
+ * jump L1; ... L1: jump L2   ->   jump L2
+ */
+static int
+rule_jump_chain(struct icode_instr *prev, struct icode_instr *ip) {
+	struct icode_instr	*target;
+
+	(void) prev;
+	if (ip->type != INSTR_JUMP
+		&& (ip->type < INSTR_BR_EQUAL || ip->type > INSTR_BR_SMALLEREQ)) {
+		return PEEP_KEEP;
+	}
+	if (!is_known_label(ip->dat)) {
+		return PEEP_KEEP;
+	}
+	target = final_target(ip->dat);
+	if (target == ip->dat) {
+		return PEEP_KEEP;
+	}
+	ip->dat = target;
+	return PEEP_CHANGED;
+}
+
+/*
+ * jump L1; L1:   ->   L1:
+ *
+ * Only unconditional jumps can go; A conditional branch belongs to the
+ * preceding cmp
+ */
+static int
+rule_jump_next(struct icode_instr *prev, struct icode_instr *ip) {
+	struct icode_instr	*next;
+
+	(void) prev;
+	if (ip->type != INSTR_JUMP) {
+		return PEEP_KEEP;
+	}
+	for (next = peephole_next_instr(ip);
+		next != NULL && next->type == INSTR_LABEL;
+		next = peephole_next_instr(next)) {
+		if (next == ip->dat) {
+			return PEEP_DELETE;
+		}
+	}
+	return PEEP_KEEP;
+}
+
+static struct peephole_rule	generic_rules[] = {
+	{ "store-load", rule_store_load },
+	{ "load-store", rule_load_store },
+	{ "dead-mov", rule_dead_mov },
+	{ "jump-chain", rule_jump_chain },
+	{ "jump-next", rule_jump_next },
+	{ NULL, NULL }
+};
+
+static int
+apply_rules(struct peephole_rule *rules,
+	struct icode_instr *prev, struct icode_instr *ip) {
+
+	int	changed = PEEP_KEEP;
+	int	rc;
+	int	i;
+
+	for (i = 0; rules[i].name != NULL; ++i) {
+		rc = rules[i].apply(prev, ip);
+		if (rc == PEEP_DELETE) {
+			return rc;
+		} else if (rc == PEEP_CHANGED) {
+			changed = rc;
+		}
+	}
+	return changed;
+}
+
+static int
+run_pass(struct icode_list *il) {
+	struct icode_instr	*ip;
+	struct icode_instr	*next;
+	struct icode_instr	*before = NULL; /* list predecessor of ip */
+	struct icode_instr	*prev = NULL;	/* last code generating one */
+	int			changed = 0;
+	int			rc;
+
+	for (ip = il->head; ip != NULL; ip = next) {
+		next = ip->next;
+		if (is_transparent(ip)) {
+			before = ip;
+			continue;
+		}
+
+		rc = apply_rules(generic_rules, prev, ip);
+		if (rc != PEEP_DELETE && backend->peephole_rules != NULL) {
+			int	rc2;
+
+			rc2 = apply_rules(backend->peephole_rules, prev, ip);
+			if (rc2 != PEEP_KEEP) {
+				rc = rc2;
+			}
+		}
+
+		if (rc == PEEP_DELETE) {
+			if (before != NULL) {
+				before->next = next;
+			} else {
+				il->head = next;
+			}
+			if (il->tail == ip) {
+				il->tail = before;
+			}
+			changed = 1;
+			continue;
+		} else if (rc == PEEP_CHANGED) {
+			changed = 1;
+		}
+		before = prev = ip;
+	}
+	return changed;
+}
+
+void
+peephole_optimize(struct function *f) {
+	struct icode_instr	*ip;
+	int			slots = 0;
+	int			passes;
+
+	if (f->icode == NULL) {
+		return;
+	}
+
+	nlabels = 0;
+	for (ip = f->icode->head; ip != NULL; ip = ip->next) {
+		if (ip->type == INSTR_LABEL) {
+			if (nlabels == slots) {
+				slots = slots? slots * 2: 32;
+				labels = n_xrealloc(labels,
+					slots * sizeof *labels);
+			}
+			labels[nlabels++] = ip;
+		}
+	}
+	if (nlabels > 0) {
+		qsort(labels, nlabels, sizeof *labels, compare_labels);
+	}
+
+	/*
+	 * Removing a jump may turn its neighbors into new candidates, so
+	 * repeat until nothing changes (but don't bother too hard)
+	 */
+	for (passes = 0; passes < 4; ++passes) {
+		if (!run_pass(f->icode)) {
+			break;
+		}
+	}
+
+	free(labels);
+	labels = NULL;
+}
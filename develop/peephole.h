@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2005 - 2010, Nils R. Weller
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+struct function;
+struct icode_list;
+struct icode_instr;
+
+/*
+ * 10/17/26: A peephole rule looks at the instruction ``ip'' and the closest
+ * preceding instruction ``prev'' which generates code (or NULL), and tells
+ * the driver what to do with ``ip''. Rules may rewrite ``ip'' in place, but
+ * must never unlink anything themselves
+ */
+#define PEEP_KEEP	0	/* Nothing done */
+#define PEEP_CHANGED	1	/* Instruction was rewritten in place */
+#define PEEP_DELETE	2	/* Instruction is redundant - remove it */
+
+typedef int	(*peephole_func_t)(struct icode_instr *prev,
+			struct icode_instr *ip);
+
+struct peephole_rule {
+	char		*name;
+	peephole_func_t	apply;
+};
+
+/*
+ * Runs the generic rules and the ``peephole_rules'' table of the backend
+ * (terminated by an entry with a null name) over the icode list of the
+ * function. Only called for -O1 and up
+ */
+void
+peephole_optimize(struct function *f);
+
+/*
+ * Returns the instruction following ``ip'', skipping pseudo instructions
+ * which do not generate code
+ */
+struct icode_instr *
+peephole_next_instr(struct icode_instr *ip);
+
+#endif
@@ -1247,19 +1247,13 @@ emit_strings(struct ty_string *list) {
 
 static void
 emit_comment(const char *fmt, ...) {
-	int		rc;
 	va_list	va;
 
 	va_start(va, fmt);
 	x_fprintf(out, "# ");
-	rc = vfprintf(out, fmt, va);
+	x_vfprintf(out, fmt, va);
 	va_end(va);
 	x_fputc('\n', out);
-
-	if (rc == EOF || fflush(out) == EOF) {
-		perror("vfprintf");
-		exit(EXIT_FAILURE);
-	}
 }
 
 static void
@@ -3907,6 +3901,7 @@ struct emitter power_emit_as = {
 	emit_load,
 	emit_load_addrlabel,
 	emit_comp_goto,
+	NULL, /* switch_table */
 	emit_store,
 	emit_setsect,
 	emit_alloc,
@@ -3339,6 +3339,7 @@ struct backend power_backend = {
 	0, /* need pic initialization? */
 	1, /* emulate long double. BEWARE changed in init()! */
 	0, /* relax alloc gpr order */
+	0, /* stack alloca */
 	32767, /* max displacement */
 	-32768, /* min displacement */
 	have_immediate_op,
@@ -3388,6 +3389,7 @@ struct backend power_backend = {
 	do_ret,
 	get_abi_reg,
 	get_abi_ret_reg,
-	generic_same_representation
+	generic_same_representation,
+	NULL
 };
 
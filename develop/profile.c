@@ -0,0 +1,460 @@
+/*
+ * Copyright (c) 2026, Nils R. Weller
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Compilation profile (-ftime-report, -ftime-report-json=file)
+ *
+ * 10/17/26: This collects the phase timers of do_ncc() along with the
+ * number of allocations made in every phase, the parse, icode and
+ * emission times of every function together with its icode length,
+ * register spills and symbol lookups, and the usage of the zone
+ * allocator. The report is meant for finding out what makes nwcc slow
+ * on a given source file
+ */
+#include "profile.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "decl.h"
+#include "functions.h"
+#include "icode.h"
+#include "type.h"
+#include "zalloc.h"
+#include "n_libc.h"
+
+/* Number of functions listed in the text report */
+#define PROF_TOP_FUNCS	10
+
+struct prof_counters	prof_counters;
+int			prof_enabled;
+
+static const char	*phase_names[PROF_NPHASES] = {
+	"Preprocessing", "Initialization", "Lexing", "Parsing+icode",
+	"Emission"
+};
+
+static const char	*phase_keys[PROF_NPHASES] = {
+	"preprocessing", "initialization", "lexing", "analysis", "emission"
+};
+
+static const char	*stage_names[PROF_FN_NSTAGES] = {
+	"Parsing", "Icode", "Emission"
+};
+
+static const char	*stage_keys[PROF_FN_NSTAGES] = {
+	"parse_us", "icode_us", "emit_us"
+};
+
+static const char	*zone_names[Z_MAX_ZONES] = {
+	NULL, "control", "label", "expr", "initializer", "statement",
+	"function", "icode_instr", "icode_list", "vreg", "icode_memref",
+	"stack_block", "s_expr", "fcall_data", "identifier", "fastsymhash",
+	"cexpr_buf", "icode_pregs"
+};
+
+struct prof_phase {
+	int		usecs;
+	unsigned long	allocs;
+	unsigned long	alloc_bytes;
+	unsigned long	zone_allocs;
+};
+
+static struct prof_phase	phases[PROF_NPHASES];
+static unsigned long		last_allocs;
+static unsigned long		last_alloc_bytes;
+static unsigned long		last_zone_allocs;
+
+struct prof_func {
+	char		*name;
+	long		usecs[PROF_FN_NSTAGES];
+	unsigned long	icode_instrs;
+	unsigned long	spills;
+	unsigned long	lookups;
+	unsigned long	allocs;
+
+	/* Currently running stage, or -1 */
+	int		stage;
+	struct timeval	tv;
+	unsigned long	start_spills;
+	unsigned long	start_lookups;
+	unsigned long	start_allocs;
+};
+
+static struct prof_func		*funcs;
+static int			nfuncs;
+static int			funcs_alloc;
+static char			*source_name;
+
+void
+prof_set_source(const char *name) {
+	source_name = n_xstrdup(name);
+}
+
+static unsigned long
+zone_allocs(void) {
+	struct zalloc_usage	zu;
+	unsigned long		total = 0;
+	int			i;
+
+	for (i = 0; i < Z_MAX_ZONES; ++i) {
+		if (zalloc_get_usage(i, &zu) == 0) {
+			total += zu.allocs;
+		}
+	}
+	return total;
+}
+
+static unsigned long
+lookups(void) {
+	return prof_counters.sym_lookups + prof_counters.typedef_lookups
+		+ prof_counters.tag_lookups;
+}
+
+/*
+ * Records the duration of a phase; The allocations made since the
+ * previous phase are attributed to it
+ */
+void
+prof_phase(int phase, int usecs) {
+	unsigned long	zallocs;
+
+	if (!prof_enabled) {
+		return;
+	}
+	zallocs = zone_allocs();
+	phases[phase].usecs += usecs;
+	phases[phase].allocs += n_alloc_calls - last_allocs;
+	phases[phase].alloc_bytes += n_alloc_bytes - last_alloc_bytes;
+	phases[phase].zone_allocs += zallocs - last_zone_allocs;
+	last_allocs = n_alloc_calls;
+	last_alloc_bytes = n_alloc_bytes;
+	last_zone_allocs = zallocs;
+}
+
+static struct prof_func *
+get_func(struct function *f) {
+	if (!prof_enabled || f->prof_slot == 0) {
+		return NULL;
+	}
+	return &funcs[f->prof_slot - 1];
+}
+
+static void
+start_stage(struct prof_func *pf, int stage) {
+	pf->stage = stage;
+	pf->start_spills = prof_counters.spills;
+	pf->start_lookups = lookups();
+	pf->start_allocs = n_alloc_calls + zone_allocs();
+	start_timer(&pf->tv);
+}
+
+static void
+stop_stage(struct prof_func *pf) {
+	if (pf->stage == -1) {
+		return;
+	}
+	pf->usecs[pf->stage] += stop_timer(&pf->tv);
+	pf->spills += prof_counters.spills - pf->start_spills;
+	pf->lookups += lookups() - pf->start_lookups;
+	pf->allocs += n_alloc_calls + zone_allocs() - pf->start_allocs;
+	pf->stage = -1;
+}
+
+/*
+ * Called when the body of function definition ``f'' is encountered;
+ * Starts the parse stage
+ */
+void
+prof_func_begin(struct function *f) {
+	struct prof_func	*pf;
+
+	if (!prof_enabled) {
+		return;
+	}
+	if (nfuncs == funcs_alloc) {
+		funcs_alloc = funcs_alloc? funcs_alloc * 2: 64;
+		funcs = n_xrealloc(funcs, funcs_alloc * sizeof *funcs);
+	}
+	pf = &funcs[nfuncs++];
+	memset(pf, 0, sizeof *pf);
+	pf->name = n_xstrdup(f->proto->dtype->name);
+	f->prof_slot = nfuncs;
+	start_stage(pf, PROF_FN_PARSE);
+}
+
+/*
+ * Ends the running stage of ``f'', if any, and starts ``stage''. The
+ * icode list is complete when emission starts, so it is measured here
+ */
+void
+prof_func_stage(struct function *f, int stage) {
+	struct prof_func	*pf;
+	struct icode_instr	*ii;
+
+	if ((pf = get_func(f)) == NULL) {
+		return;
+	}
+	stop_stage(pf);
+	if (stage == PROF_FN_EMIT && f->icode != NULL) {
+		for (ii = f->icode->head; ii != NULL; ii = ii->next) {
+			++pf->icode_instrs;
+		}
+	}
+	start_stage(pf, stage);
+}
+
+void
+prof_func_end(struct function *f) {
+	struct prof_func	*pf;
+
+	if ((pf = get_func(f)) != NULL) {
+		stop_stage(pf);
+	}
+}
+
+static long
+func_usecs(struct prof_func *pf) {
+	long	total = 0;
+	int	i;
+
+	for (i = 0; i < PROF_FN_NSTAGES; ++i) {
+		total += pf->usecs[i];
+	}
+	return total;
+}
+
+static int
+compare_funcs(const void *p1, const void *p2) {
+	long	t1 = func_usecs(*(struct prof_func * const *)p1);
+	long	t2 = func_usecs(*(struct prof_func * const *)p2);
+
+	return t1 < t2? 1: t1 > t2? -1: 0;
+}
+
+static long
+total_usecs(void) {
+	long	total = 0;
+	int	i;
+
+	for (i = 0; i < PROF_NPHASES; ++i) {
+		total += phases[i].usecs;
+	}
+	return total;
+}
+
+void
+prof_report(FILE *out) {
+	struct prof_func	**sorted;
+	struct zalloc_usage	zu;
+	long			total = total_usecs();
+	long			stages[PROF_FN_NSTAGES];
+	unsigned long		instrs = 0;
+	int			i;
+	int			j;
+
+	(void) fprintf(out, "=== nwcc1 time report for %s ===\n",
+		source_name? source_name: "<input>");
+	(void) fprintf(out, "  %-16s %12s %7s %10s %12s %11s\n",
+		"Phase", "Time (sec)", "%", "mallocs", "bytes", "zone allocs");
+	for (i = 0; i < PROF_NPHASES; ++i) {
+		(void) fprintf(out, "  %-16s %12f %6.1f%% %10lu %12lu %11lu\n",
+			phase_names[i],
+			phases[i].usecs / 1000000.0,
+			total? phases[i].usecs * 100.0 / total: 0.0,
+			phases[i].allocs,
+			phases[i].alloc_bytes,
+			phases[i].zone_allocs);
+	}
+	(void) fprintf(out, "  %-16s %12f\n", "Total", total / 1000000.0);
+
+	for (j = 0; j < PROF_FN_NSTAGES; ++j) {
+		stages[j] = 0;
+	}
+	for (i = 0; i < nfuncs; ++i) {
+		for (j = 0; j < PROF_FN_NSTAGES; ++j) {
+			stages[j] += funcs[i].usecs[j];
+		}
+		instrs += funcs[i].icode_instrs;
+	}
+	(void) fprintf(out, "\n  Function stages (%d functions)\n", nfuncs);
+	for (j = 0; j < PROF_FN_NSTAGES; ++j) {
+		(void) fprintf(out, "  %-16s %12f\n",
+			stage_names[j], stages[j] / 1000000.0);
+	}
+
+	if (nfuncs > 0) {
+		sorted = n_xmalloc(nfuncs * sizeof *sorted);
+		for (i = 0; i < nfuncs; ++i) {
+			sorted[i] = &funcs[i];
+		}
+		qsort(sorted, nfuncs, sizeof *sorted, compare_funcs);
+		(void) fprintf(out, "\n  %-24s %10s %10s %10s %10s %8s %7s "
+			"%8s %8s\n",
+			"Slowest functions", "Total", "Parse", "Icode", "Emit",
+			"Instrs", "Spills", "Lookups", "Allocs");
+		for (i = 0; i < nfuncs && i < PROF_TOP_FUNCS; ++i) {
+			struct prof_func	*pf = sorted[i];
+
+			(void) fprintf(out, "  %-24s %10f %10f %10f %10f %8lu "
+				"%7lu %8lu %8lu\n",
+				pf->name,
+				func_usecs(pf) / 1000000.0,
+				pf->usecs[PROF_FN_PARSE] / 1000000.0,
+				pf->usecs[PROF_FN_ICODE] / 1000000.0,
+				pf->usecs[PROF_FN_EMIT] / 1000000.0,
+				pf->icode_instrs, pf->spills,
+				pf->lookups, pf->allocs);
+		}
+		free(sorted);
+	}
+
+	(void) fprintf(out, "\n  Counters\n");
+	(void) fprintf(out, "  %-20s %12lu\n", "Symbol lookups",
+		prof_counters.sym_lookups);
+	(void) fprintf(out, "  %-20s %12lu\n", "Typedef lookups",
+		prof_counters.typedef_lookups);
+	(void) fprintf(out, "  %-20s %12lu\n", "Tag lookups",
+		prof_counters.tag_lookups);
+	(void) fprintf(out, "  %-20s %12lu\n", "Register spills",
+		prof_counters.spills);
+	(void) fprintf(out, "  %-20s %12lu\n", "Icode instructions", instrs);
+
+	(void) fprintf(out, "\n  %-16s %6s %10s %10s %10s %7s %10s %10s\n",
+		"Zone", "Size", "Allocs", "Reused", "mallocs", "Blocks",
+		"Reserved", "Peak");
+	for (i = 0; i < Z_MAX_ZONES; ++i) {
+		if (zalloc_get_usage(i, &zu) != 0) {
+			continue;
+		}
+		(void) fprintf(out, "  %-16s %6lu %10lu %10lu %10lu %7lu "
+			"%10lu %10lu\n",
+			zone_names[i], (unsigned long)zu.chunk_size,
+			zu.allocs, zu.reused, zu.malloced, zu.blocks,
+			(unsigned long)zu.reserved, (unsigned long)zu.peak);
+	}
+}
+
+static void
+json_string(FILE *out, const char *str) {
+	(void) fputc('"', out);
+	for (; *str != 0; ++str) {
+		if (*str == '"' || *str == '\\') {
+			(void) fprintf(out, "\\%c", *str);
+		} else if ((unsigned char)*str < 0x20) {
+			(void) fprintf(out, "\\u%04x", (unsigned char)*str);
+		} else {
+			(void) fputc(*str, out);
+		}
+	}
+	(void) fputc('"', out);
+}
+
+/*
+ * Writes the profile as a JSON object to ``path'' (``-'' for stdout).
+ * Functions are listed in the order in which they were defined
+ */
+int
+prof_write_json(const char *path) {
+	FILE			*out;
+	struct zalloc_usage	zu;
+	unsigned long		instrs = 0;
+	int			i;
+	int			j;
+	int			first;
+
+	if (strcmp(path, "-") == 0) {
+		out = stdout;
+	} else if ((out = fopen(path, "w")) == NULL) {
+		perror(path);
+		return -1;
+	}
+
+	(void) fprintf(out, "{\n  \"file\": ");
+	json_string(out, source_name? source_name: "");
+	(void) fprintf(out, ",\n  \"total_us\": %ld,\n  \"phases\": {\n",
+		total_usecs());
+	for (i = 0; i < PROF_NPHASES; ++i) {
+		(void) fprintf(out, "    \"%s\": { \"us\": %d, "
+			"\"mallocs\": %lu, \"malloc_bytes\": %lu, "
+			"\"zone_allocs\": %lu }%s\n",
+			phase_keys[i], phases[i].usecs, phases[i].allocs,
+			phases[i].alloc_bytes, phases[i].zone_allocs,
+			i + 1 < PROF_NPHASES? ",": "");
+	}
+	for (i = 0; i < nfuncs; ++i) {
+		instrs += funcs[i].icode_instrs;
+	}
+	(void) fprintf(out, "  },\n  \"counters\": {\n"
+		"    \"symbol_lookups\": %lu,\n"
+		"    \"typedef_lookups\": %lu,\n"
+		"    \"tag_lookups\": %lu,\n"
+		"    \"spills\": %lu,\n"
+		"    \"functions\": %d,\n"
+		"    \"icode_instrs\": %lu\n  },\n",
+		prof_counters.sym_lookups, prof_counters.typedef_lookups,
+		prof_counters.tag_lookups, prof_counters.spills,
+		nfuncs, instrs);
+
+	(void) fprintf(out, "  \"zones\": {");
+	first = 1;
+	for (i = 0; i < Z_MAX_ZONES; ++i) {
+		if (zalloc_get_usage(i, &zu) != 0) {
+			continue;
+		}
+		(void) fprintf(out, "%s\n    \"%s\": { \"size\": %lu, "
+			"\"allocs\": %lu, \"reused\": %lu, \"mallocs\": %lu, "
+			"\"blocks\": %lu, \"reserved\": %lu, \"peak\": %lu }",
+			first? "": ",",
+			zone_names[i], (unsigned long)zu.chunk_size,
+			zu.allocs, zu.reused, zu.malloced, zu.blocks,
+			(unsigned long)zu.reserved, (unsigned long)zu.peak);
+		first = 0;
+	}
+	(void) fprintf(out, "\n  },\n  \"functions\": [");
+	for (i = 0; i < nfuncs; ++i) {
+		struct prof_func	*pf = &funcs[i];
+
+		(void) fprintf(out, "%s\n    { \"name\": ", i? ",": "");
+		json_string(out, pf->name);
+		(void) fprintf(out, ", \"total_us\": %ld", func_usecs(pf));
+		for (j = 0; j < PROF_FN_NSTAGES; ++j) {
+			(void) fprintf(out, ", \"%s\": %ld",
+				stage_keys[j], pf->usecs[j]);
+		}
+		(void) fprintf(out, ", \"icode_instrs\": %lu, \"spills\": %lu, "
+			"\"lookups\": %lu, \"allocs\": %lu }",
+			pf->icode_instrs, pf->spills, pf->lookups, pf->allocs);
+	}
+	(void) fprintf(out, "\n  ]\n}\n");
+
+	if (out != stdout) {
+		if (fclose(out) == EOF) {
+			perror(path);
+			return -1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2026, Nils R. Weller
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+
+struct function;
+
+/*
+ * 10/17/26: Compilation profile for -ftime-report and -ftime-report-json.
+ * The phases correspond to the timers of do_ncc(); With XLATE_IMMEDIATELY,
+ * the analysis phase includes icode generation and emission, which are
+ * broken down per function
+ */
+#define PROF_CPP	0
+#define PROF_INIT	1
+#define PROF_LEX	2
+#define PROF_ANALYSIS	3
+#define PROF_GEN	4
+#define PROF_NPHASES	5
+
+/* Stages of a function */
+#define PROF_FN_PARSE	0
+#define PROF_FN_ICODE	1
+#define PROF_FN_EMIT	2
+#define PROF_FN_NSTAGES	3
+
+/*
+ * Event counters; These are always maintained because an increment is
+ * cheaper than checking whether profiling is enabled
+ */
+struct prof_counters {
+	unsigned long	sym_lookups;
+	unsigned long	typedef_lookups;
+	unsigned long	tag_lookups;
+	unsigned long	spills;
+};
+
+extern struct prof_counters	prof_counters;
+extern int			prof_enabled;
+
+void	prof_set_source(const char *name);
+void	prof_phase(int phase, int usecs);
+void	prof_func_begin(struct function *f);
+void	prof_func_stage(struct function *f, int stage);
+void	prof_func_end(struct function *f);
+void	prof_report(FILE *out);
+int	prof_write_json(const char *path);
+
+#endif
@@ -48,6 +48,7 @@
 #include "cc1_main.h"
 #include "features.h"
 #include "n_libc.h"
+#include "profile.h"
 
 int
 reg_unused(struct reg *r) {
@@ -1140,6 +1141,7 @@ do_free_preg(struct reg *r, struct icode_list *il,
 		 * a long long-associated register is freed
 		 * hence the workaround below
 		 */
+		++prof_counters.spills;
 		if (backend->arch == ARCH_X86
 			&& IS_LLONG(vr->type->code)
 			&& vr->type->tlist == NULL) {
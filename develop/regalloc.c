@@ -0,0 +1,596 @@
+/*
+ * Copyright (c) 2005 - 2010, Nils R. Weller
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * 10/17/26: Linear scan allocation of otherwise unused registers to
+ * automatic variables.
+ *
+ * The code generator allocates registers on the fly while it translates
+ * expressions, and every variable access becomes a load from or a store to
+ * the stack slot of the variable. Once the icode list of a function is
+ * complete, we can compute the live interval of every variable - the range
+ * of icode positions from its first to its last access, widened to cover
+ * all loops it is live in - and assign the registers which the on-the-fly
+ * allocator did not touch by linear scan. The loads and stores of variables
+ * which get a register are rewritten to register moves. Variables which
+ * lose out where intervals conflict simply stay in their stack slot, so
+ * we never have to generate spill code.
+ *
+ * Only variables whose storage is accessed exclusively through plain
+ * load/store/writeback instructions are considered; Anything else (address
+ * taken, x87 memory operands, initializer copies, etc) keeps the variable
+ * in memory
+ */
+#include "regalloc.h"
+#include <stdlib.h>
+#include <string.h>
+#include "backend.h"
+#include "functions.h"
+#include "scope.h"
+#include "decl.h"
+#include "type.h"
+#include "icode.h"
+#include "reg.h"
+#include "n_libc.h"
+
+struct ra_var {
+	struct decl	*dec;
+	size_t		size;
+	long		start;
+	long		end;
+	unsigned long	uses;
+	int		bad;
+	int		regidx;
+};
+
+struct ra_label {
+	struct icode_instr	*label;
+	long			pos;
+};
+
+struct ra_branch {
+	long			pos;
+	struct icode_instr	*target;
+};
+
+struct ra_loop {
+	long	start;
+	long	end;
+};
+
+static int
+is_candidate(struct decl *d) {
+	struct type	*ty = d->dtype;
+	size_t		size;
+
+	if (d->stack_addr != NULL
+		|| d->invalid
+		|| d->asmname != NULL
+		|| IS_VOLATILE(ty->flags)
+		|| IS_VLA(ty->flags)) {
+		/* Parameters have their stack address already */
+		return 0;
+	}
+	if (ty->tlist != NULL) {
+		if (ty->tlist->type != TN_POINTER_TO) {
+			return 0;
+		}
+	} else if (!is_integral_type(ty)) {
+		return 0;
+	}
+	size = backend->get_sizeof_decl(d, NULL);
+	return size == 1 || size == 2 || size == 4 || size == 8;
+}
+
+static int
+compare_vars_by_decl(const void *p1, const void *p2) {
+	const struct ra_var	*v1 = p1;
+	const struct ra_var	*v2 = p2;
+
+	if (v1->dec < v2->dec) {
+		return -1;
+	} else if (v1->dec > v2->dec) {
+		return 1;
+	}
+	return 0;
+}
+
+static int
+compare_vars_by_start(const void *p1, const void *p2) {
+	const struct ra_var	*v1 = *(struct ra_var * const *)p1;
+	const struct ra_var	*v2 = *(struct ra_var * const *)p2;
+
+	if (v1->start < v2->start) {
+		return -1;
+	} else if (v1->start > v2->start) {
+		return 1;
+	}
+	return 0;
+}
+
+static int
+compare_labels(const void *p1, const void *p2) {
+	const struct ra_label	*l1 = p1;
+	const struct ra_label	*l2 = p2;
+
+	if (l1->label < l2->label) {
+		return -1;
+	} else if (l1->label > l2->label) {
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Collects the candidate variables of all code scopes of the function,
+ * sorted by declaration for lookup_var()
+ */
+static struct ra_var *
+collect_vars(struct function *f, int *nvars) {
+	struct scope	*scope;
+	struct scope	*tmp;
+	struct ra_var	*vars = NULL;
+	int		n = 0;
+	int		nslots = 0;
+	int		i;
+
+	for (scope = f->scope; scope != NULL; scope = scope->next) {
+		struct decl	**dec;
+
+		for (tmp = scope; tmp != NULL; tmp = tmp->parent) {
+			if (tmp == f->scope) {
+				break;
+			}
+		}
+		if (tmp == NULL) {
+			/* End of function reached */
+			break;
+		}
+		if (scope->type != SCOPE_CODE) {
+			continue;
+		}
+
+		dec = scope->automatic_decls.data;
+		for (i = 0; i < scope->automatic_decls.ndecls; ++i) {
+			if (!is_candidate(dec[i])) {
+				continue;
+			}
+			if (n == nslots) {
+				nslots = nslots? nslots * 2: 16;
+				vars = n_xrealloc(vars, nslots * sizeof *vars);
+			}
+			vars[n].dec = dec[i];
+			vars[n].size = backend->get_sizeof_decl(dec[i], NULL);
+			vars[n].start = vars[n].end = -1;
+			vars[n].uses = 0;
+			vars[n].bad = 0;
+			vars[n].regidx = -1;
+			++n;
+		}
+	}
+	if (n > 0) {
+		qsort(vars, n, sizeof *vars, compare_vars_by_decl);
+	}
+	*nvars = n;
+	return vars;
+}
+
+static struct ra_var *
+lookup_var(struct ra_var *vars, int nvars, struct vreg *vr) {
+	struct ra_var	key;
+
+	if (vr == NULL || vr->var_backed == NULL || nvars == 0) {
+		return NULL;
+	}
+	key.dec = vr->var_backed;
+	return bsearch(&key, vars, nvars, sizeof *vars, compare_vars_by_decl);
+}
+
+static void
+mark_bad(struct ra_var *vars, int nvars, struct vreg *vr) {
+	struct ra_var	*v;
+
+	if ((v = lookup_var(vars, nvars, vr)) != NULL) {
+		v->bad = 1;
+	}
+}
+
+/*
+ * Records a load or store of the variable backing ``vr'' through
+ * register ``r'' at icode position ``pos''
+ */
+static void
+record_access(struct ra_var *vars, int nvars, struct vreg *vr,
+	struct reg *r, long pos) {
+
+	struct ra_var	*v;
+
+	if ((v = lookup_var(vars, nvars, vr)) == NULL) {
+		return;
+	}
+	if (vr->parent != NULL
+		|| vr->from_ptr != NULL
+		|| vr->from_const != NULL
+		|| vr->is_multi_reg_obj
+		|| r == NULL
+		|| r->type != REG_GPR
+		|| r->size != v->size) {
+		v->bad = 1;
+		return;
+	}
+	if (v->start == -1) {
+		v->start = pos;
+	}
+	v->end = pos;
+	++v->uses;
+}
+
+/*
+ * Instructions for which a variable-backed vreg can only be a register
+ * operand
+ */
+static int
+is_reg_operand_instr(int type) {
+	switch (type) {
+	case INSTR_ADD:
+	case INSTR_SUB:
+	case INSTR_MUL:
+	case INSTR_DIV:
+	case INSTR_MOD:
+	case INSTR_SHL:
+	case INSTR_SHR:
+	case INSTR_AND:
+	case INSTR_OR:
+	case INSTR_XOR:
+	case INSTR_NOT:
+	case INSTR_NEG:
+	case INSTR_CMP:
+	case INSTR_INC:
+	case INSTR_DEC:
+	case INSTR_RET:
+		return 1;
+	}
+	return 0;
+}
+
+static int
+is_branch_instr(int type) {
+	switch (type) {
+	case INSTR_JUMP:
+	case INSTR_BR_EQUAL:
+	case INSTR_BR_NEQUAL:
+	case INSTR_BR_GREATER:
+	case INSTR_BR_SMALLER:
+	case INSTR_BR_GREATEREQ:
+	case INSTR_BR_SMALLEREQ:
+		return 1;
+	}
+	return 0;
+}
+
+static struct reg *
+get_sub_reg(struct reg *r, size_t size) {
+	while (r != NULL && r->size != size) {
+		if (r->composed_of == NULL) {
+			return NULL;
+		}
+		r = r->composed_of[0];
+	}
+	return r;
+}
+
+static void
+make_mov(struct icode_instr *ip, struct reg *dest, struct reg *src,
+	struct type *ty) {
+
+	struct copyreg	*cr = n_xmalloc(sizeof *cr);
+
+	cr->src_preg = src;
+	cr->dest_preg = dest;
+	cr->src_type = ty;
+	cr->dest_type = ty;
+
+	ip->type = INSTR_MOV;
+	ip->dat = cr;
+	ip->src_vreg = ip->dest_vreg = NULL;
+	ip->src_pregs = ip->dest_pregs = NULL;
+	ip->memref = NULL;
+}
+
+unsigned
+regalloc_promote_vars(struct function *f, struct reg **regs, int nregs) {
+	struct icode_instr	*ip;
+	struct ra_var		*vars;
+	struct ra_var		**sorted = NULL;
+	struct ra_var		**active = NULL;
+	struct ra_var		*v;
+	struct ra_label		*labels = NULL;
+	struct ra_branch	*branches = NULL;
+	struct ra_loop		*loops = NULL;
+	int			nvars;
+	int			nsorted = 0;
+	int			nactive = 0;
+	int			nlabels = 0;
+	int			labslots = 0;
+	int			nbranches = 0;
+	int			branchslots = 0;
+	int			nloops = 0;
+	int			changed;
+	int			i;
+	int			j;
+	long			pos;
+	unsigned		used = 0;
+
+	if (nregs == 0 || f->icode == NULL) {
+		return 0;
+	}
+	vars = collect_vars(f, &nvars);
+	if (nvars == 0) {
+		return 0;
+	}
+
+	/*
+	 * Pass 1: Record variable accesses, labels and branches
+	 */
+	for (ip = f->icode->head, pos = 0; ip != NULL; ip = ip->next, ++pos) {
+		struct icode_instr	**targets = NULL;
+		int			ntargets = 0;
+
+		switch (ip->type) {
+		case INSTR_ASM:
+		case INSTR_COMP_GOTO:
+		case INSTR_LOAD_ADDRLABEL:
+			/*
+			 * Inline asm may use any register, and we
+			 * don't know where computed gotos lead
+			 */
+			goto out;
+		case INSTR_LOAD:
+			record_access(vars, nvars, ip->src_vreg,
+				ip->src_pregs? ip->src_pregs[0]: NULL, pos);
+			break;
+		case INSTR_STORE:
+			/* XXX confusingly messed up order of args */
+			record_access(vars, nvars, ip->src_vreg,
+				ip->dest_pregs? ip->dest_pregs[0]: NULL, pos);
+			break;
+		case INSTR_WRITEBACK:
+			record_access(vars, nvars, ip->src_vreg,
+				ip->src_pregs? ip->src_pregs[0]: NULL, pos);
+			break;
+		case INSTR_LABEL:
+			if (nlabels == labslots) {
+				labslots = labslots? labslots * 2: 32;
+				labels = n_xrealloc(labels,
+					labslots * sizeof *labels);
+			}
+			labels[nlabels].label = ip;
+			labels[nlabels++].pos = pos;
+			break;
+		case INSTR_SWITCH_TABLE:
+			targets = ((struct switch_table *)ip->dat)->targets;
+			ntargets = ((struct switch_table *)ip->dat)->nentries;
+			break;
+		case INSTR_X86_FILD:
+			mark_bad(vars, nvars, ((struct filddata *)ip->dat)->vr);
+			break;
+		case INSTR_X86_FIST:
+			mark_bad(vars, nvars, ((struct fistdata *)ip->dat)->vr);
+			break;
+		case INSTR_COPYINIT:
+			for (i = 0; i < nvars; ++i) {
+				if (vars[i].dec == ip->dat) {
+					vars[i].bad = 1;
+				}
+			}
+			break;
+		default:
+			if (is_branch_instr(ip->type)) {
+				/* dest_vreg only supplies the type */
+				targets = (struct icode_instr **)&ip->dat;
+				ntargets = 1;
+			} else if (is_reg_operand_instr(ip->type)) {
+				if (ip->src_pregs == NULL
+					|| ip->src_pregs[0] == NULL) {
+					mark_bad(vars, nvars, ip->src_vreg);
+				}
+				if (ip->dest_pregs == NULL
+					|| ip->dest_pregs[0] == NULL) {
+					mark_bad(vars, nvars, ip->dest_vreg);
+				}
+			} else {
+				mark_bad(vars, nvars, ip->src_vreg);
+				mark_bad(vars, nvars, ip->dest_vreg);
+			}
+		}
+
+		for (i = 0; i < ntargets; ++i) {
+			if (nbranches == branchslots) {
+				branchslots = branchslots? branchslots * 2: 32;
+				branches = n_xrealloc(branches,
+					branchslots * sizeof *branches);
+			}
+			branches[nbranches].pos = pos;
+			branches[nbranches++].target = targets[i];
+		}
+	}
+
+	/*
+	 * Resolve branch targets to positions and only keep backward
+	 * branches, i.e. loops
+	 */
+	if (nlabels > 0) {
+		qsort(labels, nlabels, sizeof *labels, compare_labels);
+	}
+	loops = n_xmalloc((nbranches + 1) * sizeof *loops);
+	for (i = 0; i < nbranches; ++i) {
+		struct ra_label	key;
+		struct ra_label	*l;
+
+		key.label = branches[i].target;
+		l = nlabels? bsearch(&key, labels, nlabels, sizeof *labels,
+			compare_labels): NULL;
+		if (l == NULL) {
+			/* Branch to unknown place - be safe */
+			goto out;
+		}
+		if (l->pos < branches[i].pos) {
+			loops[nloops].start = l->pos;
+			loops[nloops++].end = branches[i].pos;
+		}
+	}
+
+	/*
+	 * A variable which is live anywhere in a loop has to stay in its
+	 * register throughout the loop. Widening one interval may make it
+	 * overlap other loops, so iterate until nothing changes
+	 */
+	do {
+		changed = 0;
+		for (i = 0; i < nvars; ++i) {
+			v = &vars[i];
+			if (v->bad || v->start == -1) {
+				continue;
+			}
+			for (j = 0; j < nloops; ++j) {
+				if (v->start <= loops[j].end
+					&& v->end >= loops[j].start) {
+					if (loops[j].start < v->start) {
+						v->start = loops[j].start;
+						changed = 1;
+					}
+					if (loops[j].end > v->end) {
+						v->end = loops[j].end;
+						changed = 1;
+					}
+				}
+			}
+		}
+	} while (changed);
+
+	/*
+	 * Pass 2: Linear scan over the intervals in order of increasing
+	 * start point. If all registers are taken, the interval which ends
+	 * last stays in memory
+	 */
+	sorted = n_xmalloc(nvars * sizeof *sorted);
+	active = n_xmalloc(nregs * sizeof *active);
+	for (i = 0; i < nvars; ++i) {
+		/* Not worth a register if it isn't accessed repeatedly */
+		if (vars[i].bad || vars[i].uses < 2) {
+			continue;
+		}
+		for (j = 0; j < nregs; ++j) {
+			if (get_sub_reg(regs[j], vars[i].size) == NULL) {
+				break;
+			}
+		}
+		if (j == nregs) {
+			sorted[nsorted++] = &vars[i];
+		}
+	}
+	qsort(sorted, nsorted, sizeof *sorted, compare_vars_by_start);
+
+	for (i = 0; i < nsorted; ++i) {
+		int	regidx;
+
+		v = sorted[i];
+
+		/* Expire intervals which ended before this one */
+		for (j = 0; j < nactive;) {
+			if (active[j]->end < v->start) {
+				active[j] = active[--nactive];
+			} else {
+				++j;
+			}
+		}
+
+		if (nactive < nregs) {
+			/* Find free register */
+			for (regidx = 0; regidx < nregs; ++regidx) {
+				for (j = 0; j < nactive; ++j) {
+					if (active[j]->regidx == regidx) {
+						break;
+					}
+				}
+				if (j == nactive) {
+					break;
+				}
+			}
+			v->regidx = regidx;
+			active[nactive++] = v;
+		} else {
+			int	last = 0;
+
+			for (j = 1; j < nactive; ++j) {
+				if (active[j]->end > active[last]->end) {
+					last = j;
+				}
+			}
+			if (active[last]->end > v->end) {
+				v->regidx = active[last]->regidx;
+				active[last]->regidx = -1;
+				active[last] = v;
+			}
+		}
+	}
+
+	/*
+	 * Pass 3: Rewrite accesses of variables which got a register
+	 */
+	for (ip = f->icode->head; ip != NULL; ip = ip->next) {
+		struct reg	*r;
+
+		if (ip->type != INSTR_LOAD
+			&& ip->type != INSTR_STORE
+			&& ip->type != INSTR_WRITEBACK) {
+			continue;
+		}
+		if ((v = lookup_var(vars, nvars, ip->src_vreg)) == NULL
+			|| v->regidx == -1) {
+			continue;
+		}
+		r = get_sub_reg(regs[v->regidx], v->size);
+		if (ip->type == INSTR_LOAD) {
+			make_mov(ip, ip->src_pregs[0], r, v->dec->dtype);
+		} else if (ip->type == INSTR_STORE) {
+			make_mov(ip, r, ip->dest_pregs[0], v->dec->dtype);
+		} else {
+			make_mov(ip, r, ip->src_pregs[0], v->dec->dtype);
+		}
+		used |= 1 << v->regidx;
+	}
+
+out:
+	free(vars);
+	free(sorted);
+	free(active);
+	free(labels);
+	free(branches);
+	free(loops);
+	return used;
+}
+
@@ -49,6 +49,8 @@
 #include "cc1_main.h"
 #include "debug.h"
 #include "n_libc.h"
+#include "atom.h"
+#include "profile.h"
 
 struct scope global_scope = {
 	0,
@@ -57,6 +59,8 @@ struct scope global_scope = {
 	0,
 	{ NULL, NULL, 0, 0 },
 	{ 0, 0, 0 },
+	{ NULL, 0, 0 },
+	{ NULL, 0, 0 },
 	{ 0, 0, 0 },
 	{ 0, 0, 0 },
 	{ 0, 0, 0 },
@@ -66,7 +70,8 @@ struct scope global_scope = {
 	NULL, NULL,
 	{ NULL, NULL, 0, 0 },
 	{ NULL, NULL, 0, 0 },
-	NULL, NULL, NULL
+	NULL, NULL, NULL,
+	1, NULL
 };
 struct scope	*curscope;
 static struct scope	*scopelist_tail = &global_scope;
@@ -95,19 +100,26 @@ struct sym_entry	*extern_vars_tail;
  */
 struct ty_struct *
 lookup_struct(struct scope *s, const char *tag, int nested) {
+	struct atom	*a;
+
+	if ((a = atom_find(tag)) == NULL) {
+		return NULL;
+	}
+	return lookup_struct_atom(s, a, nested);
+}
+
+/*
+ * 10/17/26: Tags are kept in a hash table keyed on atoms (the tag of
+ * a structure without a tag is its dummytag)
+ */
+struct ty_struct *
+lookup_struct_atom(struct scope *s, struct atom *tag, int nested) {
+	++prof_counters.tag_lookups;
 	do {
 		struct ty_struct	*ts;
 
-		for (ts = s->struct_defs.head; ts != NULL; ts = ts->next) {
-			if (ts->tag != NULL) {
-				if (strcmp(ts->tag, tag) == 0) {
-					return ts;
-				}
-			} else if (ts->dummytag != NULL) {
-				if (strcmp(ts->dummytag, tag) == 0) {
-					return ts;
-				}
-			}	
+		if ((ts = atom_map_get(&s->struct_tags, tag)) != NULL) {
+			return ts;
 		}
 		if (nested == 0) {
 			break;
@@ -119,17 +131,22 @@ lookup_struct(struct scope *s, const char *tag, int nested) {
 
 struct ty_enum *
 lookup_enum(struct scope *s, const char *tag, int nested) {
-	int				i;
-	char			*p;
+	struct atom	*a;
+
+	if ((a = atom_find(tag)) == NULL) {
+		return NULL;
+	}
+	return lookup_enum_atom(s, a, nested);
+}
 
+struct ty_enum *
+lookup_enum_atom(struct scope *s, struct atom *tag, int nested) {
+	++prof_counters.tag_lookups;
 	do {
-		if (s->enum_defs.data) {
-			for (i = 0; i < s->enum_defs.ndecls; ++i) {
-				p = s->enum_defs.data[i]->tag;
-				if (p != NULL && strcmp(p, tag) == 0) {
-					return s->enum_defs.data[i];
-				}
-			}
+		struct ty_enum	*te;
+
+		if ((te = atom_map_get(&s->enum_tags, tag)) != NULL) {
+			return te;
 		}
 		if (nested == 0) {
 			break;
@@ -140,10 +157,40 @@ lookup_enum(struct scope *s, const char *tag, int nested) {
 
 struct type *
 lookup_typedef(struct scope *s, const char *name, int nested, int flags) {
-	struct decl	**d;
-	int		i;
-	size_t		namelen = strlen(name);
+	struct atom	*a;
+
+	if ((a = atom_find(name)) == NULL) {
+		return NULL;
+	}
+	return lookup_typedef_atom(s, a, nested, flags);
+}
+
+struct type *
+lookup_typedef_atom(struct scope *s, struct atom *name, int nested, int flags) {
+#if FAST_SYMBOL_LOOKUP
+	struct sym_entry	*se;
 
+	++prof_counters.typedef_lookups;
+
+	/*
+	 * 10/17/26: Structure scopes aren't in the symbol index, so their
+	 * members are checked here (see the comment below on why they may
+	 * hide typedefs)
+	 */
+	for (; s->type == SCOPE_STRUCT; s = s->parent) {
+		if ((flags & LTD_IGNORE_IDENT) == 0
+			&& lookup_symbol_atom(s, name, 0) != NULL) {
+			return NULL;
+		}
+		if (!nested) {
+			return NULL;
+		}
+	}
+	se = fast_lookup_symbol_se(s, name, nested, 1,
+		flags & LTD_IGNORE_IDENT);
+	return se? se->dec->dtype: NULL;
+#else
+	++prof_counters.typedef_lookups;
 	do {
 		/*
 		 * 03/03/09: If there's a non-typedef of the same name
@@ -170,7 +217,7 @@ lookup_typedef(struct scope *s, const char *name, int nested, int flags) {
 		 * up the typedef because the identifier wins.
 		 */
 		if ((flags & LTD_IGNORE_IDENT) == 0) {
-			if (lookup_symbol(s, name, 0) != NULL) {
+			if (lookup_symbol_atom(s, name, 0) != NULL) {
 				/*
 				 * This scope has a non-typedef declaration which
 				 * wins over potential outside typedefs
@@ -179,6 +226,10 @@ lookup_typedef(struct scope *s, const char *name, int nested, int flags) {
 			}
 		}
 
+		/*
+		 * 10/17/26: All scopes which have typedefs keep them in
+		 * a hash table now, not just the global scope
+		 */
 		if (s->typedef_hash.used) {
 			struct sym_entry	*se;
 
@@ -186,38 +237,17 @@ lookup_typedef(struct scope *s, const char *name, int nested, int flags) {
 			se = lookup_hash(s->typedef_hash, s->n_typedef_slots,
 				name, namelen);
 #endif
-			se = new_lookup_hash(&s->typedef_hash, name, namelen);
+			se = new_lookup_hash(&s->typedef_hash, name);
 			if (se != NULL) {
 				return se->dec->dtype;
 			}	
-		} else {	
-#if FAST_SYMBOL_LOOKUP
-			struct sym_entry	*se;
-
-			se = fast_lookup_symbol_se(s, name, nested, 1);
-			if (se != NULL) {
-				return se->dec->dtype;
-			} else {
-				return NULL;
-			}
-
-#else
-			if (s->typedef_decls.data) {
-				d = s->typedef_decls.data;
-				for (i = 0; i < s->typedef_decls.ndecls; ++i) {
-					if (strcmp(d[i]->dtype->name, name)
-						== 0) {
-						return d[i]->dtype;	
-					}
-				}
-			}
-#endif
 		}
 		if (!nested) {
 			break;
 		}
 	} while ((s = s->parent) != NULL);
 	return NULL;
+#endif
 }
 
 	
@@ -241,12 +271,20 @@ new_scope(int type) {
 	scopelist_tail->next = ret;
 	scopelist_tail = ret;
 	curscope = ret;
+#if FAST_SYMBOL_LOOKUP
+	if (type != SCOPE_STRUCT) {
+		fast_sym_open_scope(ret);
+	}
+#endif
 
 	return ret;
 }
 
 void
 close_scope(void) {
+#if FAST_SYMBOL_LOOKUP
+	fast_sym_close_scope(curscope);
+#endif
 #if defined(DEBUG) || defined(DEBUG2) || defined(DEBUG3)
 	if ((curscope = curscope->parent) == NULL) {
 		fprintf(stderr,
@@ -280,7 +318,20 @@ do_store_decl(struct scope *s, struct dec_block *destdec, struct decl *d) {
 	destdec->data[ destdec->ndecls++ ] = d;
 
 	if (s != NULL) {
-		st = alloc_statement();
+		if (s == &global_scope || curfunc == NULL) {
+			/*
+			 * 10/17/26: File scope declarations (including
+			 * members of file scope structures, which are
+			 * appended to later) outlive the function zones,
+			 * which are reset after every function
+			 */
+			static struct statement	nullstmt;
+
+			st = n_xmalloc(sizeof *st);
+			*st = nullstmt;
+		} else {
+			st = alloc_statement();
+		}
 		st->type = ST_DECL;
 		st->data = d;
 		append_statement(&s->code, &s->code_tail, st);
@@ -882,22 +933,24 @@ store_decl_scope(struct scope *s, struct decl **dec) {
 				return;
 			}
 
-#if FAST_SYMBOL_LOOKUP
-			if (1) {
-				destdec = &s->typedef_decls;
-				put_fast_sym_hash(s, make_sym_entry(dec[i]), 1);
-			} else 
-#endif
-			if (s != &global_scope) {
-				destdec = &s->typedef_decls;
-			} else {
+			{
+				struct sym_entry	*se;
+
+				if (s != &global_scope) {
+					destdec = &s->typedef_decls;
+				}
 				if (!s->typedef_hash.used) {
 					/* Global scope - need large table! */
 					new_make_hash_table(&s->typedef_hash,
-						SYM_HTAB_GLOBAL_SCOPE);	
+						s == &global_scope?
+						SYM_HTAB_GLOBAL_SCOPE:
+						SYM_HTAB_BLOCK);
 				}
-				new_put_hash_table(&s->typedef_hash,
-					make_sym_entry(dec[i]));	
+				se = make_sym_entry(dec[i]);
+				new_put_hash_table(&s->typedef_hash, se);
+#if FAST_SYMBOL_LOOKUP
+				fast_sym_put(s, se, 1);
+#endif
 			}	
 #ifdef DEBUG2
 			printf("storing typedef %s\n",
@@ -1453,7 +1506,7 @@ store_def_scope(struct scope *sc,
 		struct ty_enum *te,
 		struct token *tok) {
 	int		i;
-	char		*p;
+	struct atom	*tag = NULL;
 	struct sd	*s = NULL;
 	struct ed	*e = NULL;
 
@@ -1519,6 +1572,8 @@ store_def_scope(struct scope *sc,
 			s->tail = s->tail->next;
 		}	
 		++s->ndecls;
+		atom_map_put(&destscope->struct_tags,
+			atom_intern_str(ts->tag? ts->tag: ts->dummytag), ts);
 #ifdef DEBUG2
 		printf("stored structure with tag %s\n", ts->tag);
 #endif
@@ -1534,27 +1589,36 @@ store_def_scope(struct scope *sc,
 
 		e = & /*sc*/ destscope->enum_defs;
 		if (te->tag != NULL) {
+			struct ty_enum	*oldte;
+
 			/*
 			 * Check whether we have a multiple definition error.
 			 * 20141116: We now support enum forward declarations
 			 * as an extension to ISO C (this makes GNU bison compile)
 			 */
-			for (i = 0; i < e->ndecls; ++i) {
-				p = e->data[i]->tag;
-				if (p && strcmp(p, te->tag) == 0) {
-					if (e->data[i]->is_forward_decl) {
-						/*
-						 * We already have a slot in which to store
-						 * this definition because a forward
-						 * declaration has taken place
-						 */
-						e->data[i] = te;
-						return;
-					} else {
-						errorfl(tok,
-							"Multiple definitions of enum `%s'", p);
-						return;
+			tag = atom_intern_str(te->tag);
+			if ((oldte = atom_map_get(&destscope->enum_tags, tag))
+				!= NULL) {
+				if (oldte->is_forward_decl) {
+					/*
+					 * We already have a slot in which to store
+					 * this definition because a forward
+					 * declaration has taken place
+					 */
+					for (i = 0; i < e->ndecls; ++i) {
+						if (e->data[i] == oldte) {
+							e->data[i] = te;
+							break;
+						}
 					}
+					atom_map_put(&destscope->enum_tags,
+						tag, te);
+					return;
+				} else {
+					errorfl(tok,
+						"Multiple definitions of enum `%s'",
+						oldte->tag);
+					return;
 				}
 			}
 			if (lookup_struct(sc, te->tag, 0) != NULL) {
@@ -1573,6 +1637,9 @@ store_def_scope(struct scope *sc,
 					e->nslots * sizeof *e->data);
 		}
 		e->data[ e->ndecls++ ] = te;
+		if (tag != NULL) {
+			atom_map_put(&destscope->enum_tags, tag, te);
+		}
 	}
 }
 
@@ -1587,24 +1654,43 @@ lookup_symbol(struct scope *s, const char *name, int nested) {
 	return se->dec;
 }
 
+struct decl *
+lookup_symbol_atom(struct scope *s, struct atom *name, int nested) {
+	struct sym_entry	*se;
+
+	se = lookup_symbol_se_atom(s, name, nested);
+	if (se == NULL) {
+		return NULL;
+	}
+	return se->dec;
+}
+
 struct /*decl*/ sym_entry *
 lookup_symbol_se(struct scope *s, const char *name, int nested) {
-	size_t			len; 
-	
-	len = strlen(name);
-#if FAST_SYMBOL_LOOKUP
-	if (s->type != SCOPE_STRUCT) {
-		return fast_lookup_symbol_se(s, name, nested, 0);
+	struct atom	*a;
+
+	/*
+	 * 10/17/26: Every declared name is interned, so if there is no
+	 * atom for this name, there is no declaration either
+	 */
+	if ((a = atom_find(name)) == NULL) {
+		return NULL;
 	}
-#endif
+	return lookup_symbol_se_atom(s, a, nested);
+}
 
+struct /*decl*/ sym_entry *
+lookup_symbol_se_atom(struct scope *s, struct atom *name, int nested) {
+	++prof_counters.sym_lookups;
 	do {
 		struct sym_entry	*se;
 
-#if ! FAST_SYMBOL_LOOKUP
-		if (!s->sym_hash.used) 
+#if FAST_SYMBOL_LOOKUP
+		if (s->type != SCOPE_STRUCT) {
+			return fast_lookup_symbol_se(s, name, nested, 0, 0);
+		}
 #endif
-		{
+		if (!s->sym_hash.used) {
 			/* Linear scan */
 			for (se = s->slist; se != NULL; se = se->next) {
 				/* 04/08/08: Shadow declarations */
@@ -1612,29 +1698,30 @@ lookup_symbol_se(struct scope *s, const char *name, int nested) {
 					&& !is_shadow_decl(se->dec)) {
 					continue;
 				}
-				if (!se->inactive && se->namelen == len) {
-					if (se->name[0] == name[0]) {
-						if (strcmp(&se->name[1],
-							&name[1]) == 0) {
-							return se  /*->dec*/;
-						}
-					}
+				if (!se->inactive && se->atom == name) {
+					return se  /*->dec*/;
 				}
 			}
-		} 
-#if ! FAST_SYMBOL_LOOKUP
-		else {
-			/* Hash lookup (key is length) */
+		} else {
+			/* Hash lookup (key is atom) */
 #if 0 
 			se = lookup_hash(s->sym_hash,
 					s->n_hash_slots, name, len);
 #endif
-			se = new_lookup_hash(&s->sym_hash, name, len);
+			se = new_lookup_hash(&s->sym_hash, name);
 			if (se != NULL) {
 				return se /*->dec*/;
 			}
 		}
-#endif
+
+		/*
+		 * 10/17/26: A typedef hides identifiers of the same name
+		 * in enclosing scopes
+		 */
+		if (s->typedef_hash.used
+			&& new_lookup_hash(&s->typedef_hash, name) != NULL) {
+			return NULL;
+		}
 
 		if (nested == 0) {
 			break;
@@ -27,12 +27,15 @@
 #ifndef SCOPE_H
 #define SCOPE_H
 
+#include "atom.h"
+
 struct decl;
 struct token;
 struct ty_struct;
 struct ty_enum;
 struct sym_entry;
 struct statement;
+struct fast_sym;
 
 /*
  * The next member is only used for static variables;
@@ -103,6 +106,14 @@ struct scope {
 		int			nslots;
 	}	enum_defs;
 
+	/*
+	 * 10/17/26: Structure and enum tags, keyed on atoms, such that
+	 * lookup_struct() and lookup_enum() don't have to walk the
+	 * definition lists
+	 */
+	struct atom_map		struct_tags;
+	struct atom_map		enum_tags;
+
 	/* Function declarations */
 	struct {
 		struct ty_func	*data;
@@ -140,11 +151,20 @@ struct scope {
 	struct statement	*code;
 	struct statement	*code_tail;
 	struct scope		*next;
+
+	/*
+	 * 10/17/26: Position in the global symbol index scope stack (1 =
+	 * global scope, 0 = not in the index), and the index entries
+	 * made for this scope (see symlist.c)
+	 */
+	int			index_depth;
+	struct fast_sym		*fast_syms;
 };
 
 extern struct scope	*curscope;
 extern struct scope global_scope;
 extern struct sym_entry	*extern_vars;
+extern struct sym_entry	*extern_vars_tail;
 
 
 #define SCOPE_NESTED	1
@@ -152,9 +172,15 @@ extern struct sym_entry	*extern_vars;
 struct ty_struct *
 lookup_struct(struct scope *s, const char *tag, int nested);
 
+struct ty_struct *
+lookup_struct_atom(struct scope *s, struct atom *tag, int nested);
+
 struct ty_enum *
 lookup_enum(struct scope *s, const char *tag, int nested);
 
+struct ty_enum *
+lookup_enum_atom(struct scope *s, struct atom *tag, int nested);
+
 struct ty_enum *
 create_enum_forward_declaration(const char *tag);
 
@@ -163,6 +189,9 @@ create_enum_forward_declaration(const char *tag);
 struct type *
 lookup_typedef(struct scope *s, const char *name, int nested, int flags);
 
+struct type *
+lookup_typedef_atom(struct scope *s, struct atom *name, int nested, int flags);
+
 void
 complete_type(struct ty_struct *dest, struct ty_struct *src);
 
@@ -189,9 +218,15 @@ close_scope(void);
 struct decl *
 lookup_symbol(struct scope *s, const char *name, int nested);
 
+struct decl *
+lookup_symbol_atom(struct scope *s, struct atom *name, int nested);
+
 struct sym_entry *
 lookup_symbol_se(struct scope *s, const char *name, int nested);
 
+struct sym_entry *
+lookup_symbol_se_atom(struct scope *s, struct atom *name, int nested);
+
 struct decl *
 access_symbol(struct scope *s, const char *name, int nested);
 
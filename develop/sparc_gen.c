@@ -2717,6 +2717,7 @@ struct backend sparc_backend = {
 	1, /* need pic initialization? */
 	0, /* emulate long double? */
 	0, /* relax alloc gpr order? */
+	0, /* stack alloca */
 	4095, /* max displacement */
 	-4096, /* min displacement */
 	have_immediate_op,
@@ -2766,7 +2767,8 @@ struct backend sparc_backend = {
 	do_ret,
 	get_abi_reg,
 	get_abi_ret_reg,
-	generic_same_representation
+	generic_same_representation,
+	NULL
 };
 
 
@@ -2196,8 +2196,8 @@ get_sub_expr(struct token **tok, int delim, int delim2, int extype) {
 #ifndef PREPROCESSOR
 			if (IS_TYPE(t->next)
 				&& (t->next->type != TOK_IDENTIFIER
-				|| lookup_symbol(curscope, t->next->data, 1)
-				== NULL)) {
+				|| lookup_symbol_atom(curscope,
+					token_atom(t->next), 1) == NULL)) {
 				/* Is cast */
 				struct token	*casttok = t;
 				struct type	*ty;
@@ -2378,7 +2378,7 @@ get_sub_expr(struct token **tok, int delim, int delim2, int extype) {
 			 * 12/24/08: Use access_symbol() later only if it
 			 * turns out to be an evaluated expression.
 			 */
-			d = lookup_symbol(curscope, t->data, 1);
+			d = lookup_symbol_atom(curscope, token_atom(t), 1);
 			if (d == NULL && is_func_call) {
 				/*
 				 * 05/13/09: Whoops, we have to put implicit
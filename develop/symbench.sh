@@ -0,0 +1,87 @@
+#!/bin/sh
+#
+# 10/17/26: Stress test for symbol lookup. Generates a translation unit
+# with a huge global namespace (typedefs, variables and functions) and
+# functions with deeply nested blocks that shadow global typedefs and
+# identifiers, then compiles it and prints the time taken. If gcc is
+# available, the output of the program is compared with the output of
+# the gcc-compiled program.
+#
+# Usage: ./symbench.sh [globals [depth]]
+#
+# Set NWCC to the compiler to test (default: nwcc)
+#
+
+NWCC=${NWCC:-nwcc}
+GLOBALS=${1:-20000}
+DEPTH=${2:-200}
+
+if ! test -d symbench; then
+	if ! mkdir symbench; then
+		exit 1
+	fi
+fi
+cd symbench || exit 1
+
+awk -v globals="$GLOBALS" -v depth="$DEPTH" 'BEGIN {
+	print "#include <stdio.h>"
+	for (i = 0; i < globals; ++i) {
+		printf "typedef int t%d;\n", i
+		printf "static t%d v%d = %d;\n", i, i, i % 7
+		printf "static int f%d(t%d x) { return x + v%d; }\n", i, i, i
+	}
+
+	# Every level shadows a typedef by an identifier or vice versa
+	print "static long nested(void) {"
+	print "\tlong sum = 0;"
+	for (i = 0; i < depth; ++i) {
+		if (i % 2 == 0) {
+			printf "\t{ int t%d = %d; t%d += v%d; sum += t%d;\n", \
+				i, i, i, i, i
+		} else {
+			printf "\t{ typedef long v%d; v%d t%d = %d; ", \
+				i - 1, i - 1, i, i
+			printf "sum += t%d + (long)sizeof(v%d);\n", i, i - 1
+		}
+	}
+	for (i = 0; i < depth; ++i) {
+		printf "\t}"
+	}
+	print ""
+	print "\treturn sum;"
+	print "}"
+
+	# Many sibling blocks which all look up globals
+	print "static long siblings(void) {"
+	print "\tlong sum = 0;"
+	for (i = 0; i < globals; i += 4) {
+		printf "\t{ t%d a = v%d; int v%d = f%d(a); sum += v%d; }\n", \
+			i, i, i, i, i
+	}
+	print "\treturn sum;"
+	print "}"
+
+	print "int main(void) {"
+	print "\tprintf(\"%ld %ld\\n\", nested(), siblings());"
+	print "\treturn 0;"
+	print "}"
+}' >symbench.c
+
+start=`date +%s`
+if ! $NWCC symbench.c -o symbench >/dev/null 2>&1; then
+	echo "$NWCC: compilation failed"
+	exit 1
+fi
+end=`date +%s`
+echo "$GLOBALS globals, depth $DEPTH: `expr $end - $start` seconds"
+
+if gcc -w symbench.c -o symbench.gcc >/dev/null 2>&1; then
+	./symbench >nwcc.out
+	./symbench.gcc >gcc.out
+	if test "`diff nwcc.out gcc.out`" != ""; then
+		echo "Output differs from gcc:"
+		diff nwcc.out gcc.out
+		exit 1
+	fi
+	echo "Output matches gcc"
+fi
@@ -43,27 +43,15 @@
 #include "debug.h"
 #include "token.h"
 #include "n_libc.h"
+#include "atom.h"
 
 #define HASH_SYM_ENTRY	1
 
-static int
-hash_symbol(const char *name, int tabsize) {
-	int	key = 0;
-
-	for (; *name != 0; ++name) {
-		key = (33 * key + *name) & (tabsize - 1);
-	}
-	return key;
-}	
-
 
 void
 new_make_hash_table(struct sym_hash_table *tab, int size) {
 	int	nbytes = size * sizeof *tab->hash_slots_head;
 
-#if FAST_SYMBOL_LOOKUP
-	abort();
-#endif
 	tab->n_hash_slots = size;
 	
 	tab->hash_slots_head = n_xmalloc(nbytes);
@@ -96,11 +84,8 @@ dump_hash_table(struct sym_hash_table *htab) {
 
 void
 new_put_hash_table(struct sym_hash_table *htab, struct sym_entry *item) {
-	int	key = hash_symbol(item->name, htab->n_hash_slots);
+	int	key = item->atom->hash & (htab->n_hash_slots - 1);
 	
-#if FAST_SYMBOL_LOOKUP
-	abort();
-#endif
 	/*
 	 * CANOFWORMS 03/27/08: This was missing the prev assignments!
 	 * Seems too obvious to be missed, so maybe this breaks something?
@@ -117,16 +102,15 @@ new_put_hash_table(struct sym_hash_table *htab, struct sym_entry *item) {
 	}
 }
 
+/*
+ * 10/17/26: Symbol tables are keyed on atoms now, so there are no
+ * string comparisons anymore
+ */
 struct sym_entry *
-new_lookup_hash(struct sym_hash_table *htab, const char *name, size_t len) {
-	int			key = hash_symbol(name, htab->n_hash_slots);
+new_lookup_hash(struct sym_hash_table *htab, struct atom *atom) {
+	int			key = atom->hash & (htab->n_hash_slots - 1);
 	struct sym_entry	*hp;
 
-	(void) len;
-
-#if FAST_SYMBOL_LOOKUP
-	abort();
-#endif
 
 	for (hp = htab->hash_slots_head[key]; hp != NULL; hp = hp->next) {
 #if 0
@@ -137,7 +121,7 @@ new_lookup_hash(struct sym_hash_table *htab, const char *name, size_t len) {
 			|| (hp->dec->invalid && !is_shadow_decl(hp->dec))) {
 			continue;
 		}
-		if (strcmp(hp->name, name) == 0) {
+		if (hp->atom == atom) {
 			return hp;
 		}
 	}
@@ -154,7 +138,8 @@ make_sym_entry(struct decl *dec) {
 	s->name = dec->dtype->name;
 	s->inactive = 0;
 	if (s->name != NULL) {
-		s->namelen = strlen(dec->dtype->name);
+		s->atom = atom_intern_str(s->name);
+		s->namelen = s->atom->len;
 	} else {
 		s->namelen = 0;
 	}	
@@ -179,7 +164,6 @@ append_symlist(
 		/* XXX this stuff does not belong here! it should go to
 		 * new_scope() or something
 		 */
-#if ! FAST_SYMBOL_LOOKUP
 		if (!scope->sym_hash.used) {
 			if (scope == &global_scope) {
 #if 0
@@ -197,18 +181,14 @@ append_symlist(
 #endif
 			}
 		}
+#if FAST_SYMBOL_LOOKUP
+		if (s->name != NULL) {
+			fast_sym_put(scope, s, 0);
+		}
 #endif
 	}
 
-#if FAST_SYMBOL_LOOKUP
-	if (s->name != NULL) {
-		put_fast_sym_hash(scope, s, 0);
-	}
-#endif
 	if (scope && scope->sym_hash.used) {
-#if FAST_SYMBOL_LOOKUP
-		abort();
-#endif
 		if (s->name != NULL) {
 			new_put_hash_table(&scope->sym_hash, s);
 		}
@@ -225,6 +205,9 @@ append_symlist(
 
 void
 remove_symlist(struct scope *s, struct sym_entry *se) {
+#if FAST_SYMBOL_LOOKUP
+	fast_sym_remove(s, se);
+#endif
 	if (se->next == NULL) {
 		/*
 		 * 03/11/09: Removing tail. This missing assignment
@@ -254,8 +237,7 @@ remove_symlist(struct scope *s, struct sym_entry *se) {
 			 * takes place when se->dec->dtype->name has not been
 			 * updated with that name mangling stuff yet
 			 */
-			key = hash_symbol(se->name, 
-				htab->n_hash_slots);
+			key = se->atom->hash & (htab->n_hash_slots - 1);
 			if (se->prev != NULL) {
 				se->prev->next = se->next;
 			} else {
@@ -282,235 +264,379 @@ remove_symlist(struct scope *s, struct sym_entry *se) {
 
 #if FAST_SYMBOL_LOOKUP
 
-#define N_GLOBAL_FAST_TAB_ENTRIES	256
-#define N_LOCAL_FAST_TAB_ENTRIES	64
+/*
+ * 10/17/26: Global symbol index. Every scope keeps its own symbol list
+ * (or hash table) as before, but lookups go through one open addressing
+ * table keyed on atoms instead of visiting every enclosing scope. A
+ * table slot holds the chain of all indexed declarations of its name,
+ * ordered from the innermost to the outermost scope (declarations of
+ * the same scope are kept in declaration order).
+ *
+ * The index covers a stack of scopes, the innermost of which is usually
+ * curscope. When a scope is closed, its entries are simply unlinked from
+ * the chain tops, so nothing ever has to be searched for. Since curscope
+ * is sometimes set to a scope which has already been closed (function
+ * prototype scopes are reopened for the function body, and icode
+ * generation revisits all scopes), a lookup first synchronizes the stack
+ * with the scope it starts from; Scopes which are missing are re-entered
+ * from their own symbol lists. Structure member scopes are not indexed
+ * and are still searched linearly
+ */
+
+#define FAST_TAB_INIT	1024	/* must be power of 2 */
 
-static struct fast_sym_hash_entry	*global_fast_sym_hash_head[N_GLOBAL_FAST_TAB_ENTRIES];
-static struct fast_sym_hash_entry	*global_fast_sym_hash_tail[N_GLOBAL_FAST_TAB_ENTRIES];
-static struct fast_sym_hash_entry	*local_fast_sym_hash_head[N_LOCAL_FAST_TAB_ENTRIES];
-static struct fast_sym_hash_entry	*local_fast_sym_hash_tail[N_LOCAL_FAST_TAB_ENTRIES];
+struct fast_sym_slot {
+	struct atom	*atom;
+	struct fast_sym	*top;
+};
 
+static struct fast_sym_slot	*fast_tab;
+static int			fast_tab_size;
+static int			fast_tab_used;
 
-static unsigned
-hash_fast_sym_name_base(const char *name, int *len) {
-	const char	*origname = name;
-	unsigned	key = 0;
+static struct scope		**fast_stack;
+static int			fast_stack_depth;
+static int			fast_stack_alloc;
 
-	for (; *name != 0; ++name) {
-		key = key * 33 + *name;
-	}
-	*len = name - origname;
-	return key;
+static struct fast_sym		*fast_sym_freelist;
+
+
+static void
+init_fast_syms(void) {
+	fast_tab_size = FAST_TAB_INIT;
+	fast_tab = n_xmalloc(fast_tab_size * sizeof *fast_tab);
+	memset(fast_tab, 0, fast_tab_size * sizeof *fast_tab);
+
+	fast_stack_alloc = 64;
+	fast_stack = n_xmalloc(fast_stack_alloc * sizeof *fast_stack);
+	fast_stack[0] = &global_scope;
+	fast_stack_depth = 1;
+	global_scope.index_depth = 1;
 }
 
 
+static struct fast_sym_slot *
+get_fast_slot(struct atom *name, int create) {
+	struct fast_sym_slot	*slot;
+	unsigned		mask;
+	unsigned		idx;
 
-void
-put_fast_sym_hash(struct scope *s, struct sym_entry *se, int is_typedef) {
-	struct fast_sym_hash_entry	*ent;
-	unsigned			 idx;
-	int				namelen;
+	if (fast_tab == NULL) {
+		if (!create) {
+			return NULL;
+		}
+		init_fast_syms();
+	}
+	if (create && fast_tab_used * 2 >= fast_tab_size) {
+		/* Grow table and re-insert all names */
+		struct fast_sym_slot	*oldtab = fast_tab;
+		int			oldsize = fast_tab_size;
+		int			i;
+
+		fast_tab_size *= 2;
+		fast_tab = n_xmalloc(fast_tab_size * sizeof *fast_tab);
+		memset(fast_tab, 0, fast_tab_size * sizeof *fast_tab);
+		mask = fast_tab_size - 1;
+		for (i = 0; i < oldsize; ++i) {
+			if (oldtab[i].atom == NULL) {
+				continue;
+			}
+			idx = oldtab[i].atom->hash & mask;
+			while (fast_tab[idx].atom != NULL) {
+				idx = (idx + 1) & mask;
+			}
+			fast_tab[idx] = oldtab[i];
+		}
+		free(oldtab);
+	}
 
-	if (s == &global_scope) {
-		/* Global identifier - persistent */
-		ent = n_xmalloc(sizeof *ent);
-		idx = hash_fast_sym_name_base(se->dec->dtype->name, &namelen);
-		idx &= (N_GLOBAL_FAST_TAB_ENTRIES - 1);
-	} else {
-		/* Local identifier - can be cleared at end of function */
-		ent = zalloc_buf(Z_FASTSYMHASH);
-		idx = hash_fast_sym_name_base(se->dec->dtype->name, &namelen);
-		idx &= (N_LOCAL_FAST_TAB_ENTRIES - 1);
+	mask = fast_tab_size - 1;
+	for (idx = name->hash & mask;; idx = (idx + 1) & mask) {
+		slot = &fast_tab[idx];
+		if (slot->atom == name) {
+			return slot;
+		} else if (slot->atom == NULL) {
+			break;
+		}
+	}
+	if (!create) {
+		return NULL;
 	}
+	/*
+	 * Slots are never freed; Names are few compared to declarations,
+	 * and an empty chain is as good as a free slot
+	 */
+	slot->atom = name;
+	slot->top = NULL;
+	++fast_tab_used;
+	return slot;
+}
+
 
+static void
+link_fast_sym(struct scope *s, struct sym_entry *se, int is_typedef) {
+	struct fast_sym_slot	*slot;
+	struct fast_sym		*ent;
+	struct fast_sym		**prevp;
+
+	if (fast_sym_freelist != NULL) {
+		ent = fast_sym_freelist;
+		fast_sym_freelist = ent->scope_next;
+	} else {
+		ent = n_xmalloc(sizeof *ent);
+	}
 	ent->se = se;
-	ent->name = se->dec->dtype->name;
-	ent->namelen = namelen;
-	ent->scope = s;
+	ent->depth = s->index_depth;
 	ent->is_typedef = is_typedef;
-	ent->next = NULL;
-
+	ent->removed = 0;
+	ent->scope_next = s->fast_syms;
+	s->fast_syms = ent;
 
 	/*
-	 * XXX Currently this will get called twice for extern symbols - once for
-	 * the per-scope list, and once for the global extern list. Do we really
-	 * want that? Possibly we do if either of them is invalidated due to a
-	 * redeclaration so it may be better to keep both around
+	 * Usually the scope is the innermost one, so the entry goes to
+	 * the top of the chain, unless the name is already declared in
+	 * this scope. Otherwise (e.g. implicit function declarations are
+	 * put into the global scope) it goes behind all entries of inner
+	 * scopes
 	 */
-	if (s == &global_scope) {
-		if (global_fast_sym_hash_head[idx] == NULL) {
-			global_fast_sym_hash_head[idx]
-				= global_fast_sym_hash_tail[idx]
-				= ent;
-		} else {
-			global_fast_sym_hash_tail[idx]->next = ent;
-			global_fast_sym_hash_tail[idx] = ent;
-		}
-	} else {
-		if (local_fast_sym_hash_head[idx] == NULL) {
-			local_fast_sym_hash_head[idx]
-				= local_fast_sym_hash_tail[idx]
-				= ent;
-		} else {
-			local_fast_sym_hash_tail[idx]->next = ent;
-			local_fast_sym_hash_tail[idx] = ent;
+	slot = get_fast_slot(se->atom, 1);
+	for (prevp = &slot->top;
+		*prevp != NULL && (*prevp)->depth >= ent->depth;
+		prevp = &(*prevp)->shadowed)
+		;
+	ent->shadowed = *prevp;
+	*prevp = ent;
+}
+
+
+/*
+ * Removes the innermost scope from the index
+ */
+static void
+pop_fast_scope(void) {
+	struct scope	*s = fast_stack[--fast_stack_depth];
+	struct fast_sym	*ent;
+	struct fast_sym	*next;
+
+	for (ent = s->fast_syms; ent != NULL; ent = next) {
+		next = ent->scope_next;
+		if (!ent->removed) {
+			struct fast_sym_slot	*slot;
+
+			/*
+			 * All entries of this scope are at the top of
+			 * their chains since inner scopes are gone
+			 */
+			slot = get_fast_slot(ent->se->atom, 0);
+			while (slot->top != NULL
+				&& slot->top->depth >= s->index_depth) {
+				slot->top = slot->top->shadowed;
+			}
 		}
+		ent->scope_next = fast_sym_freelist;
+		fast_sym_freelist = ent;
 	}
+	s->fast_syms = NULL;
+	s->index_depth = 0;
 }
 
-void
-reset_fast_sym_hash(void) {
-	memset(local_fast_sym_hash_head, 0, sizeof local_fast_sym_hash_head);
-	memset(local_fast_sym_hash_tail, 0, sizeof local_fast_sym_hash_tail);
-}
 
+static void
+push_fast_scope(struct scope *s) {
+	struct sym_entry	*se;
 
-static int
-is_valid_match(struct sym_entry *se, int is_typedef, int want_typedef, int *err) {
-	if (err != NULL) {
-		*err = 0;
+	if (fast_stack_depth == fast_stack_alloc) {
+		fast_stack_alloc *= 2;
+		fast_stack = n_xrealloc(fast_stack,
+			fast_stack_alloc * sizeof *fast_stack);
 	}
-	if (se->dec->invalid && !is_shadow_decl(se->dec)) {
-		return 0;
+	fast_stack[fast_stack_depth++] = s;
+	s->index_depth = fast_stack_depth;
+	s->fast_syms = NULL;
+
+	/* Re-enter symbols of a scope which was closed before */
+	for (se = s->slist; se != NULL; se = se->next) {
+		if (se->name != NULL) {
+			link_fast_sym(s, se, 0);
+		}
 	}
-	if (se->inactive) {
-		return 0;
+	if (s->typedef_hash.used) {
+		int	i;
+
+		for (i = 0; i < s->typedef_hash.n_hash_slots; ++i) {
+			for (se = s->typedef_hash.hash_slots_head[i];
+				se != NULL;
+				se = se->next) {
+				link_fast_sym(s, se, 1);
+			}
+		}
 	}
+}
 
-	if (want_typedef != is_typedef) {
-		/*
-		 * We got a typedef but didn't
-		 * want it or the other way
-		 * around
-		 */
-		if (err != NULL) {
-			*err = 0;
+
+/*
+ * Makes the index stack consist of exactly the (non-structure) scopes
+ * enclosing ``s'', with ``s'' being the innermost one
+ */
+static void
+sync_fast_scope(struct scope *s) {
+	struct scope	*chain[64];
+	struct scope	**scopes = chain;
+	int		nscopes = 0;
+	int		alloc = 64;
+	struct scope	*outer;
+
+	if (fast_tab == NULL) {
+		init_fast_syms();
+	}
+	if (s->index_depth != 0) {
+		while (fast_stack_depth > s->index_depth) {
+			pop_fast_scope();
+		}
+		return;
+	}
+
+	/* Collect scopes which are missing from the index */
+	for (outer = s;
+		outer != NULL && outer->index_depth == 0;
+		outer = outer->parent) {
+		if (outer->type == SCOPE_STRUCT) {
+			continue;
+		}
+		if (nscopes == alloc) {
+			alloc *= 2;
+			if (scopes == chain) {
+				scopes = n_xmalloc(alloc * sizeof *scopes);
+				memcpy(scopes, chain, sizeof chain);
+			} else {
+				scopes = n_xrealloc(scopes,
+					alloc * sizeof *scopes);
+			}
 		}
-		return 0;
+		scopes[nscopes++] = outer;
+	}
+	if (outer == NULL) {
+		/* Scope chain not rooted at global scope (fcatalog) */
+		outer = &global_scope;
+	}
+	while (fast_stack_depth > outer->index_depth) {
+		pop_fast_scope();
+	}
+	while (nscopes > 0) {
+		push_fast_scope(scopes[--nscopes]);
+	}
+	if (scopes != chain) {
+		free(scopes);
 	}
-	return 1;
 }
 
 
-struct sym_entry *
-fast_lookup_symbol_se(struct scope *s, const char *name, int nested, int want_typedef) {
-	unsigned			idx;
-	unsigned			local_idx;
-	unsigned			global_idx;
-	int				len;
-	int				err;
-	struct scope			*tempscope;
-	struct fast_sym_hash_entry	*ent;
-
-	local_idx = global_idx = hash_fast_sym_name_base(name, &len);
-	local_idx &= (N_LOCAL_FAST_TAB_ENTRIES - 1);
-	global_idx &= (N_GLOBAL_FAST_TAB_ENTRIES - 1);
+void
+fast_sym_open_scope(struct scope *s) {
+	sync_fast_scope(s);
+}
 
+
+void
+fast_sym_close_scope(struct scope *s) {
+	int	depth = s->index_depth;
+
+	if (depth > 1) {
+		while (fast_stack_depth >= depth) {
+			pop_fast_scope();
+		}
+	}
+}
+
+
+void
+fast_sym_put(struct scope *s, struct sym_entry *se, int is_typedef) {
+	if (s->index_depth != 0) {
+		link_fast_sym(s, se, is_typedef);
+	}
 	/*
-	 * Try local list first - if we are looking up in a local scope
+	 * Else the scope is not in the index right now, and it will be
+	 * entered with its symbol list once it is used again
 	 */
-	if (s != &global_scope && local_fast_sym_hash_head[local_idx] != NULL) {
-		struct fast_sym_hash_entry	*matches[128];
-		int				matchidx = 0;
+}
 
-		/*
-		 * First do a linear search for the current scope and
-		 * record all matches of the same name. If we find a
-		 * match in the current scope, we are done. If we
-		 * don't, we only have to traverse the recorded
-		 * matches for all parent scopes in order to find the
-		 * first match
-		 */
-		for (ent = local_fast_sym_hash_head[local_idx];
-			ent != NULL;
-			ent = ent->next) {
-			if (ent->namelen == len
-				&& strcmp(ent->name, name) == 0) {
-				struct sym_entry	*se = ent->se;
-
-				if (ent->scope == s) {
-					/* Perfect match? */
-					if (!is_valid_match(se, 
-						ent->is_typedef,
-						want_typedef,
-						NULL)) {
-						return NULL;
-					}
-
-					/* Yes! */
-					return se;
-				} else {
-					/* Match in other scope */
-					matches[matchidx++] = ent;
-				}
-			}
-		}
 
-		if (nested == 0) {
-			/*
-			 * We are only interested in a match for the
-			 * current scope, and there's none
-			 */
-			return NULL;
-		} else if (matchidx > 0) {
-			/*
-			 * There are matches for parent scopes
-			 */
-			int	i;
-
-			while ((s = s->parent) != NULL /* XXX needed?!? */
-				&& s != &global_scope) {
-				for (i = 0; i < matchidx; ++i) {
-					if (matches[i]->scope == s) {
-						if (!is_valid_match(
-							matches[i]->se,
-							matches[i]->is_typedef,
-							want_typedef,
-							NULL)) {
-							return NULL;
-						} else {
-							return matches[i]->se;
-						}
-					}
-				}
-			}
+void
+fast_sym_remove(struct scope *s, struct sym_entry *se) {
+	struct fast_sym_slot	*slot;
+	struct fast_sym		**prevp;
+
+	if (s->index_depth == 0
+		|| se->atom == NULL
+		|| (slot = get_fast_slot(se->atom, 0)) == NULL) {
+		return;
+	}
+	for (prevp = &slot->top; *prevp != NULL; prevp = &(*prevp)->shadowed) {
+		if ((*prevp)->se == se) {
+			/* Stays on the scope list until the scope is closed */
+			(*prevp)->removed = 1;
+			*prevp = (*prevp)->shadowed;
+			break;
 		}
 	}
-	if (s != &global_scope && nested == 0) {
-		/*
-		 * We are only interested in a match for the
-		 * current scope, and there's none
-		 */
+}
+
+
+/*
+ * Looks up ``name'' starting at scope ``s'' (which must not be a
+ * structure scope). The innermost scope which declares the name
+ * decides: If it has an ordinary declaration, that is the result of
+ * an identifier lookup, and it hides outer typedefs unless
+ * ``ignore_ident'' is set. A typedef in turn hides outer identifiers
+ */
+struct sym_entry *
+fast_lookup_symbol_se(struct scope *s, struct atom *name, int nested,
+	int want_typedef, int ignore_ident) {
+
+	struct fast_sym_slot	*slot;
+	struct fast_sym		*ent;
+	struct fast_sym		*td = NULL;
+	int			level = 0;
+
+	sync_fast_scope(s);
+	if ((slot = get_fast_slot(name, 0)) == NULL) {
 		return NULL;
 	}
 
-	/* No match in local scopes - fall back to global */
-	if (global_fast_sym_hash_head[global_idx] != NULL) {
-		for (ent = global_fast_sym_hash_head[global_idx];
-			ent != NULL;
-			ent = ent->next) {
-			if (ent->namelen == len
-				&& strcmp(ent->name, name) == 0) {
-				struct sym_entry	*se = ent->se;
-
-				if (!is_valid_match(se,
-					ent->is_typedef,
-					want_typedef,
-					&err)) {
-					if (!err) {
-						/*
-						 * This may be an invalidated
-						 * declaration, i.e. overridden
-						 * by a subsequent tentative
-						 * declaration. So continue
-						 * searching
-						 */
-						continue;
-					}
-				}
-				return se;
+	for (ent = slot->top; ent != NULL; ent = ent->shadowed) {
+		if (ent->depth > s->index_depth) {
+			/* Declared in scope nested in s - not visible */
+			continue;
+		}
+		if (ent->depth != level) {
+			/* Done with previous scope */
+			if (td != NULL) {
+				break;
 			}
+			if (!nested && ent->depth != s->index_depth) {
+				break;
+			}
+			level = ent->depth;
+		}
+
+		/* 04/08/08: Shadow declarations */
+		if (ent->se->inactive
+			|| (ent->se->dec->invalid
+				&& !is_shadow_decl(ent->se->dec))) {
+			continue;
 		}
+		if (ent->is_typedef) {
+			if (td == NULL) {
+				td = ent;
+			}
+		} else if (!want_typedef) {
+			return ent->se;
+		} else if (!ignore_ident) {
+			return NULL;
+		}
+	}
+	if (td != NULL && want_typedef) {
+		return td->se;
 	}
 	return NULL;
 }
@@ -34,9 +34,12 @@ struct decl;
 struct ty_func;
 struct scope;
 
+struct atom;
+
 struct sym_entry {
 	const char		*name;
 	size_t			namelen;
+	struct atom		*atom; /* 10/17/26: Interned name */
 	int			inactive;
 	int			has_initializer;
 	struct decl		*dec;
@@ -63,28 +66,33 @@ struct sym_hash;
 
 void	new_make_hash_table(struct sym_hash_table *tab, int size);
 void	new_put_hash_table(struct sym_hash_table *tab, struct sym_entry *);
-struct sym_entry	*new_lookup_hash(struct sym_hash_table *, const char *,
-		size_t len);
+struct sym_entry	*new_lookup_hash(struct sym_hash_table *, struct atom *);
 
 void	remove_symlist(struct scope *s, struct sym_entry *se);
 
 #if FAST_SYMBOL_LOOKUP
 
-void	put_fast_sym_hash(struct scope *s, struct sym_entry *se, int is_typedef);
-void	reset_fast_sym_hash(void);
-
-struct fast_sym_hash_entry {
-	struct sym_entry        	*se;
-	char                   		*name;
-	int                  	 	namelen;
-	int				is_typedef;
-	struct scope            	*scope;
-	struct fast_sym_hash_entry	*next;
+/*
+ * 10/17/26: Entry of the global symbol index. All visible declarations
+ * of a name are chained from the innermost to the outermost scope
+ */
+struct fast_sym {
+	struct sym_entry	*se;
+	int			depth;
+	int			is_typedef;
+	int			removed;
+	struct fast_sym		*shadowed;	/* next outer declaration */
+	struct fast_sym		*scope_next;	/* next entry of same scope */
 };
-struct sym_entry	*fast_lookup_symbol_se(struct scope *s, const char *name,
-				int nested, int want_typedef);
+
+void	fast_sym_open_scope(struct scope *s);
+void	fast_sym_close_scope(struct scope *s);
+void	fast_sym_put(struct scope *s, struct sym_entry *se, int is_typedef);
+void	fast_sym_remove(struct scope *s, struct sym_entry *se);
+struct sym_entry	*fast_lookup_symbol_se(struct scope *s,
+				struct atom *name, int nested,
+				int want_typedef, int ignore_ident);
 
 #endif
 
 #endif
-	
@@ -180,6 +180,71 @@ for i in `ls *.c`; do
 	try_files
 done
 
+# 10/17/26: Every ``ASM-ABSENT function pattern'' line of a file names
+# an extended regular expression which must not occur in the generated
+# code of the function. The patterns are written for x86 gas syntax
+check_asm() {
+	ASM=`basename $i .c`.asm
+	rm -f $ASM
+	./nwcc $NWCC_CFLAGS -S $i >/dev/null 2>&1
+	if ! test -f $ASM; then
+		echo "NWCC ERROR"
+		return
+	fi
+	BADASM=`grep 'ASM-ABSENT' $i | sed 's/.*ASM-ABSENT //' | \
+	while read -r FUNC PATTERN; do
+		if sed -n "/^$FUNC:/,/^	ret/p" $ASM | \
+			grep -E "$PATTERN" >/dev/null; then
+			printf " $FUNC: $PATTERN"
+		fi
+	done`
+	if test "$BADASM" != ""; then
+		echo "BAD ASM ($BADASM )"
+	else
+		echo OK
+	fi
+}
+
+# 10/17/26: Files which say they are ``run at -O1 by test.sh'' test
+# optimizations, so they are compiled and checked at -O1 as well
+SAVED_CFLAGS="$NWCC_CFLAGS"
+for i in `grep -l 'run at -O1 by test\.sh' *.c`; do
+	printf "Trying $i at -O1 ... "
+
+	FILES="$i"
+	INPUT="some stuff for input"
+	NWCC_CFLAGS="$SAVED_CFLAGS -O1"
+	try_files
+
+	if grep 'ASM-ABSENT' $i >/dev/null && (test "$MACH" = "x86_64" \
+		|| test "$MACH" = "amd64" || test "$MACH" = "i386" \
+		|| test "$MACH" = "i686"); then
+		printf "Trying $i code at -O1 ... "
+		check_asm
+	fi
+done
+NWCC_CFLAGS="$SAVED_CFLAGS"
+
+# 10/17/26: The files in errors/ must not compile. Every line nwcc is
+# expected to report an error for carries an ERROR comment, and the
+# reported lines must match exactly (errors without a line give ``?'')
+for i in `ls errors/*.c`; do
+	printf "Trying $i ... "
+
+	EXPECTED=`grep -n '/\* ERROR \*/' $i | sed 's/:.*//'`
+	GOT=`./nwcc $NWCC_CFLAGS -c $i -o errors.o 2>&1 | sed -n \
+		-e 's/^[^ ]*:\([0-9]*\): Error: .*/\1/p' \
+		-e 's/^Error: .*/?/p'`
+	if test -f errors.o; then
+		echo "NO ERROR"
+	elif test "$EXPECTED" != "$GOT"; then
+		echo "BAD DIAGNOSTICS (expected lines" $EXPECTED, got $GOT")"
+	else
+		echo OK
+	fi
+	rm -f errors.o
+done
+
 rm a.out output output2 *.asm ; cd ..
 
 echo
@@ -0,0 +1,95 @@
+#include <stdio.h>
+
+/*
+ * __builtin_memcpy() and __builtin_memset() with constant sizes around
+ * the word and SSE move sizes and with variable sizes, plus automatic
+ * aggregate initializers which are copied inline
+ */
+static unsigned char	src[512];
+static unsigned char	dest[512];
+
+static int
+check(const char *what, int n, int fill) {
+	int	i;
+
+	for (i = 0; i < 512; ++i) {
+		int	want;
+
+		if (i < 8 || i >= 8 + n) {
+			want = 0xee;
+		} else if (fill != -1) {
+			want = fill;
+		} else {
+			want = src[i - 8];
+		}
+		if (dest[i] != want) {
+			printf("%s %d: bad byte %d\n", what, n, i);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+#define TEST_CONST(n) \
+	__builtin_memset(dest, 0xee, sizeof dest); \
+	__builtin_memcpy(dest + 8, src, n); \
+	bad += check("memcpy", n, -1); \
+	__builtin_memset(dest, 0xee, sizeof dest); \
+	__builtin_memset(dest + 8, 0x5a, n); \
+	bad += check("memset", n, 0x5a);
+
+struct small {
+	char	c[3];
+};
+
+struct medium {
+	int	i[5];
+	char	c;
+};
+
+struct large {
+	long	l[40];
+};
+
+int
+main(void) {
+	int		i;
+	int		bad = 0;
+	char		fill = 0x11;
+	struct small	s = { { 1, 2, 3 } };
+	struct medium	m = { { 1, 2, 3, 4, 5 }, 6 };
+	struct large	l = { { 1, 2, 3 } };
+
+	for (i = 0; i < 512; ++i) {
+		src[i] = (unsigned char)(i * 7 + 1);
+	}
+
+	TEST_CONST(0)
+	TEST_CONST(1)
+	TEST_CONST(3)
+	TEST_CONST(4)
+	TEST_CONST(7)
+	TEST_CONST(8)
+	TEST_CONST(13)
+	TEST_CONST(16)
+	TEST_CONST(31)
+	TEST_CONST(64)
+	TEST_CONST(100)
+	TEST_CONST(256)
+	TEST_CONST(300)
+
+	for (i = 0; i < 40; ++i) {
+		__builtin_memset(dest, 0xee, sizeof dest);
+		__builtin_memcpy(dest + 8, src, i);
+		bad += check("variable memcpy", i, -1);
+		__builtin_memset(dest, 0xee, sizeof dest);
+		__builtin_memset(dest + 8, fill, i);
+		bad += check("variable memset", i, fill);
+	}
+
+	printf("%d %d %d\n", s.c[0], s.c[1], s.c[2]);
+	printf("%d %d %d\n", m.i[0], m.i[4], m.c);
+	printf("%ld %ld %ld\n", l.l[0], l.l[2], l.l[39]);
+	printf("%d errors\n", bad);
+	return 0;
+}
@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * String literals and floating point constants, which are pooled per
+ * translation unit and emitted into mergeable sections
+ */
+static const char	*names[] = { "alpha", "beta", "gamma", "beta" };
+static char		buf[] = "tab\there \"quoted\" \\ \001\377";
+static char		embedded[] = "a\0b";
+static char		nonterm[3] = "xyz";
+static const double	dvals[] = { 1.5, 2.5, 1.5 };
+
+static const char *
+label(int i) {
+	return i? "beta": "alpha";
+}
+
+static double
+scale(double x) {
+	return x * 1.5 + 2.5;
+}
+
+static float
+fscale(float x) {
+	return x * 1.5f + 0.25f;
+}
+
+static long double
+lscale(long double x) {
+	return x * 1.5L - 0.5L;
+}
+
+int
+main(void) {
+	const char	*a = "alpha";
+	const char	*emb = "x\0y";
+	const char	*emb2 = "x\0z";
+	int		i;
+
+	printf("%d %d\n", a == names[0], label(1) == names[1]);
+	printf("%s %s %s %s\n", names[0], names[1], "alpha" + 2, names[2] + 3);
+	printf("%s %d %d\n", buf, (int)sizeof buf, (unsigned char)buf[22]);
+	printf("%d %d %d\n", (int)sizeof embedded, embedded[1], embedded[2]);
+	printf("%.3s %d\n", nonterm, (int)sizeof nonterm);
+	printf("%s %s %c %c %d\n", emb, emb2, emb[2], emb2[2],
+		(int)sizeof "x\0y");
+	printf("%d %s\n", (int)strlen("alpha" "beta"), "alpha" "beta");
+	printf("%ls %d\n", L"wide", (int)(sizeof L"wide" / sizeof L'w'));
+	for (i = 0; i < 3; ++i) {
+		printf("%g %g %g %Lg\n", dvals[i], scale(dvals[i]),
+			(double)fscale((float)dvals[i]),
+			lscale((long double)dvals[i]));
+	}
+	printf("%g %g %g\n", 1.5 + 2.5, 1.5 * 1.5, (double)(1.5f + 1.5f));
+	printf("%s %s\n", __func__, label(0));
+	return 0;
+}
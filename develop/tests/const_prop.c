@@ -0,0 +1,178 @@
+#include <stdio.h>
+
+/*
+ * Constants which only become known by following variables through the
+ * function, and branches which depend on them. Constant propagation is
+ * done at -O1, so this is also run at -O1 by test.sh.
+ *
+ * On x86 test.sh also checks that the generated code of these functions
+ * does not contain the following patterns: Multiplications and divisions
+ * by propagated powers of two are shifts, and the operands of folded
+ * compares are not loaded anymore
+ *
+ * ASM-ABSENT scaled imul
+ * ASM-ABSENT scaled cmp
+ * ASM-ABSENT scaled mov \$[0-9]+,
+ * ASM-ABSENT unsigned_ops div
+ */
+static const int	DEBUG_LEVEL = 1;
+static const long	big = 100000L;
+static int		calls;
+
+static int
+trace(const char *msg) {
+	++calls;
+	printf("trace: %s\n", msg);
+	return 1;
+}
+
+static int
+scaled(int x) {
+	const int	n = 16;
+	int		y = x * n;
+
+	if (DEBUG_LEVEL > 2) {
+		trace("scaled");
+	}
+	return y;
+}
+
+static unsigned
+unsigned_ops(unsigned x) {
+	unsigned	d = 8;
+	unsigned	m = 64;
+
+	return x / d + x % m * 1000;
+}
+
+static int
+folded(int x) {
+	int	k = 3;
+	int	m = k * 4 + 1;
+
+	if (m == 13) {
+		x += m;
+	} else {
+		x -= 100;
+	}
+	if (DEBUG_LEVEL >= 1) {
+		trace("folded");
+	}
+	return x;
+}
+
+static int
+loop(int n) {
+	int	i;
+	int	sum = 0;
+	int	step = 2;
+
+	/* i and sum change in the loop, step does not */
+	for (i = 0; i < n; ++i) {
+		sum += i * step;
+	}
+	return sum + step;
+}
+
+static int
+merged(int x) {
+	int	a;
+
+	if (x > 0) {
+		a = 5;
+	} else {
+		a = 5;
+	}
+	if (a != 5) {
+		return -1;
+	}
+	if (x > 10) {
+		a = 7;
+	}
+	return a * 10 + x;
+}
+
+static unsigned
+compares(void) {
+	unsigned	u = 0xffffffffu;
+	int		s = -1;
+	unsigned	res = 0;
+
+	if (u > 1u) {
+		res |= 1;
+	}
+	if (s < 1) {
+		res |= 2;
+	}
+	if ((unsigned)s > 1u) {
+		res |= 4;
+	}
+	if (s >= 0) {
+		res |= 8;
+	}
+	return res;
+}
+
+static long
+arith(void) {
+	int		a = -17;
+	int		b = 5;
+	unsigned	c = 0x80000000u;
+	int		zero = 0;
+	long		l = big;
+	long		res;
+
+	res = a / b;
+	res = res * 100 + a % b;
+	res = res * 100 + (a >> 2);
+	res = res * 100 + (int)(c >> 28);
+	res = res * 100 + (b << 3);
+	res = res * 100 + (~b & 0xff);
+	res = res * 100 + (-a ^ 3);
+	if (zero) {
+		res = res / zero;
+	}
+	return res + l;
+}
+
+static int
+switched(int which) {
+	int	v = 2;
+
+	switch (which + v) {
+	case 2:
+		return 20;
+	case 3:
+		return 30;
+	default:
+		return v;
+	}
+}
+
+static int
+dowhile(void) {
+	int	n = 0;
+	int	done = 0;
+
+	do {
+		++n;
+		if (n == 5) {
+			done = 1;
+		}
+	} while (!done);
+	return n;
+}
+
+int
+main(void) {
+	printf("%d %d %d\n", scaled(3), scaled(-5), folded(4));
+	printf("%u %u\n", unsigned_ops(1000), unsigned_ops(0xfffffff7u));
+	printf("%d %d\n", loop(10), loop(0));
+	printf("%d %d\n", merged(1), merged(20));
+	printf("%u\n", compares());
+	printf("%ld\n", arith());
+	printf("%d %d %d\n", switched(0), switched(1), switched(7));
+	printf("%d\n", dowhile());
+	printf("%d\n", calls);
+	return 0;
+}
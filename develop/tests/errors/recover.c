@@ -0,0 +1,36 @@
+/*
+ * Errors after the first one must still be reported, even when the
+ * parser has to skip tokens of declarations which follow the one the
+ * error is in. Every line with an error carries an ERROR comment
+ */
+int
+bad(void) {
+	return 1 }	/* ERROR */
+
+int
+bad2(void) {
+	int	y = ;	/* recovery of the error above skips to here */
+	return 0;
+}
+
+int
+good(int x) {
+	return x * 2;
+}
+
+int
+bad3(void) {
+	if (good(1)) {
+		undeclared_thing = 3;	/* ERROR */
+	}
+	return 0;
+}
+
+struct s {
+	int	a;
+};
+
+int
+bad4(struct s *p) {
+	return p->nonexistent;	/* ERROR */
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+
+/*
+ * Integer array initializers which are folded into byte images, mixed
+ * with elements, designators and types which are not
+ */
+static const unsigned char	uctab[] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	16, 17, 0x80, 0xff, 255, 200, 100, 50, 25, 12, 6, 3, 1
+};
+
+static signed char	sctab[] = { -1, -128, 127, 0, -5, 5 };
+
+static short	stab[10] = { -32768, 32767, -1, 0x1234, -300 };
+
+static unsigned short	ustab[] = { 65535, 0x8000, 1, 2 };
+
+static int	itab[] = {
+	-2147483647 - 1, 2147483647, -1, 0, 1, 0x12345678, -100000, 7
+};
+
+static unsigned	utab[] = { 4294967295u, 0x80000000u, 3 };
+
+static long	ltab[] = { -1L, 0x7fffffffL, -123456789L, 9, 10 };
+
+static unsigned long	ultab[] = { 0xffffffffUL, 1UL, 42 };
+
+static long long	lltab[] = {
+	-1LL, 0x123456789abcdefLL, -0x7fffffffffffffffLL - 1, 5, 6
+};
+
+static unsigned long long	ulltab[] = { 0xffffffffffffffffULL, 77 };
+
+static int	global_val = 33;
+
+/* Elements which are not plain constants in between */
+static int	mixed[] = { 1, 2, 3 + 4, sizeof(int), 5, 'x', 6, (int)7.9 };
+
+/* Designators after and before plain elements */
+static int	desig[12] = { 1, 2, 3, [6] = 60, 61, [2] = 20, 21, [10] = 100 };
+
+static char	desig2[] = { 'a', 'b', [5] = 'f', 'g' };
+
+struct rec {
+	char	tag;
+	short	vals[5];
+	int	after;
+	long	lvals[3];
+	char	pad;
+};
+
+static struct rec	recs[] = {
+	{ 'a', { 1, -2, 3 }, 4, { -5, 6, 7 }, 'z' },
+	{ 'b', { 10, 20, 30, 40, 50 }, -1, { 0 }, 'y' }
+};
+
+static int	twodim[3][4] = {
+	{ 1, 2, 3, 4 },
+	{ 5, 6 },
+	{ -7, -8, -9, -10 }
+};
+
+#define DUMP(ar, fmt, cast) do { \
+	unsigned	i_; \
+	printf("%s[%d]:", #ar, (int)(sizeof ar / sizeof ar[0])); \
+	for (i_ = 0; i_ < sizeof ar / sizeof ar[0]; ++i_) { \
+		printf(" " fmt, (cast)ar[i_]); \
+	} \
+	putchar('\n'); \
+} while (0)
+
+int
+main(void) {
+	int		autoarr[6] = { 9, -8, 7 };
+	short		autosh[] = { 1, -1, 300, global_val, 5 };
+	unsigned char	autouc[] = { 250, 251, 252, 253 };
+	int		i;
+
+	DUMP(uctab, "%d", int);
+	DUMP(sctab, "%d", int);
+	DUMP(stab, "%d", int);
+	DUMP(ustab, "%u", unsigned);
+	DUMP(itab, "%d", int);
+	DUMP(utab, "%u", unsigned);
+	DUMP(ltab, "%ld", long);
+	DUMP(ultab, "%lu", unsigned long);
+	DUMP(lltab, "%lld", long long);
+	DUMP(ulltab, "%llu", unsigned long long);
+	DUMP(mixed, "%d", int);
+	DUMP(desig, "%d", int);
+	DUMP(desig2, "%d", int);
+	DUMP(autoarr, "%d", int);
+	DUMP(autosh, "%d", int);
+	DUMP(autouc, "%d", int);
+	for (i = 0; i < 2; ++i) {
+		printf("%c %d %d %d %d %d %d %ld %ld %ld %c\n", recs[i].tag,
+			recs[i].vals[0], recs[i].vals[1], recs[i].vals[2],
+			recs[i].vals[3], recs[i].vals[4], recs[i].after,
+			recs[i].lvals[0], recs[i].lvals[1], recs[i].lvals[2],
+			recs[i].pad);
+	}
+	for (i = 0; i < 3; ++i) {
+		printf("%d %d %d %d\n", twodim[i][0], twodim[i][1],
+			twodim[i][2], twodim[i][3]);
+	}
+	printf("%d\n", (int)sizeof recs);
+	return 0;
+}
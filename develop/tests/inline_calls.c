@@ -0,0 +1,156 @@
+#include <stdio.h>
+
+/*
+ * Calls to static inline functions, which are expanded at the call
+ * site at -O. Also run at -O1 by test.sh
+ */
+struct point {
+	int	x;
+	int	y;
+};
+
+static int	counter;
+
+static inline int
+get_x(const struct point *p) {
+	return p->x;
+}
+
+static inline void
+set_y(struct point *p, int y) {
+	p->y = y;
+}
+
+static inline int
+max(int a, int b) {
+	if (a > b) {
+		return a;
+	}
+	return b;
+}
+
+static inline int
+sign(long v) {
+	if (v < 0) {
+		return -1;
+	} else if (v > 0) {
+		return 1;
+	} else {
+		return 0;
+	}
+}
+
+static inline int
+sum_to(int n) {
+	int	i;
+	int	sum = 0;
+
+	for (i = 0; i < n; ++i) {
+		if (i == 7) {
+			continue;
+		}
+		if (i > 20) {
+			break;
+		}
+		sum += i;
+	}
+	return sum;
+}
+
+static inline const char *
+name(int n) {
+	switch (n) {
+	case 0:
+		return "zero";
+	case 1:
+		return "one";
+	default:
+		break;
+	}
+	return "many";
+}
+
+static inline int
+max3(int a, int b, int c) {
+	return max(max(a, b), c);
+}
+
+static inline unsigned long
+fact(unsigned long n) {
+	return n < 2? n: n * fact(n - 1);
+}
+
+static inline double
+scale(double d, float f) {
+	return d * f;
+}
+
+static inline int
+next_id(void) {
+	static int	id;
+
+	return ++id;
+}
+
+static inline void
+bump(void) {
+	++counter;
+}
+
+static inline int
+by_ref(int v) {
+	int	*p = &v;
+
+	*p *= 2;
+	return v;
+}
+
+static inline char
+to_char(int v) {
+	return v;
+}
+
+static inline long long
+wide(long long a, int shift) {
+	do {
+		a <<= 1;
+	} while (--shift > 0);
+	return a;
+}
+
+static inline int (*pick(int which))(int, int) {
+	return which? max: NULL;
+}
+
+int
+main(void) {
+	struct point	pt = { 3, 4 };
+	int		i;
+	int		total = 0;
+
+	set_y(&pt, get_x(&pt) + 10);
+	printf("%d %d\n", pt.x, pt.y);
+	printf("%d %d %d\n", max(1, 2), max(get_x(&pt), -5), max(max(1, 9), 4));
+	printf("%d %d %d\n", sign(-5), sign(0), sign(123456789L));
+	printf("%d %d\n", sum_to(10), sum_to(100));
+	for (i = 0; i < 3; ++i) {
+		printf("%s ", name(i));
+	}
+	printf("\n");
+	printf("%d\n", max3(4, 12, 8));
+	printf("%lu\n", fact(10));
+	printf("%.2f\n", scale(1.5, 2.0f));
+	i = next_id();
+	i += next_id() * 10;
+	printf("%d %d\n", i, next_id());
+	for (i = 0; i < 5; ++i) {
+		bump();
+		total += max(i, 2) + sign(i - 2);
+	}
+	printf("%d %d\n", counter, total);
+	printf("%d %d\n", by_ref(21), to_char(0x141));
+	printf("%lld\n", wide(3, 40));
+	printf("%d\n", pick(1)(5, 6));
+	printf("%d\n", (int)sizeof max(1, 2));
+	return 0;
+}
@@ -0,0 +1,82 @@
+#include <stdio.h>
+
+/* Also run at -O1 by test.sh: exercises the icode peephole rules */
+static int
+chains(int n) {
+	int	r = 0;
+
+	if (n < 0) goto a;
+	if (n == 0) goto b;
+	r = n;
+	goto c;
+a:	goto b;
+b:	goto c;
+c:	return r;
+}
+
+static int
+loops(int n) {
+	int	i, j, r = 0;
+
+	for (i = 0; i < n; ++i) {
+		for (j = 0; j < n; ++j) {
+			if (j == i) {
+				continue;
+			} else if (j > i + 3) {
+				break;
+			}
+			r += i - j;
+		}
+	}
+	return r;
+}
+
+static long
+copies(long x) {
+	long	a, b, c;
+	int	i;
+
+	a = x;
+	b = a;
+	c = b;
+	a = a;
+	b = c + a;
+	for (i = 0; i < 4; ++i) {
+		c = b;
+		b = c;
+		b += i;
+	}
+	return a + b + c;
+}
+
+static int
+zero_tests(char c, short s, int i, long l, long long ll, char *p) {
+	int	r = 0;
+
+	if (c) r |= 1;
+	if (!s) r |= 2;
+	if (i) r |= 4;
+	if (!l) r |= 8;
+	if (ll) r |= 16;
+	if (!ll) r |= 32;
+	if (p) r |= 64;
+	while (i && l) {
+		--i;
+		l /= 2;
+		r += 128;
+	}
+	return r;
+}
+
+int
+main(void) {
+	char	buf[4];
+
+	printf("%d %d %d\n", chains(-1), chains(0), chains(5));
+	printf("%d\n", loops(10));
+	printf("%ld\n", copies(7));
+	printf("%d\n", zero_tests(0, 0, 0, 0, 0, NULL));
+	printf("%d\n", zero_tests(1, 2, 3, 4, 0x100000000LL, buf));
+	printf("%d\n", zero_tests(-1, -2, 5, 64, -1LL, buf));
+	return 0;
+}
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <string.h>
+
+/* Also run at -O1 by test.sh: exercises register promotion of locals */
+static int
+callee(int x) {
+	long	a = x, b = x * 2, c = x * 3, d = x * 4, e = x * 5;
+	int	i;
+
+	for (i = 0; i < 3; ++i) {
+		a += b; b += c; c += d; d += e; e += a;
+	}
+	return (int)(a + b + c + d + e);
+}
+
+long
+sum(long *p, int n) {
+	long	s = 0;
+	int	i;
+
+	for (i = 0; i < n; ++i) {
+		s += p[i];
+	}
+	return s;
+}
+
+int
+nested(int n) {
+	int	i, j, k, total = 0;
+
+	for (i = 0; i < n; ++i) {
+		for (j = i; j < n; ++j) {
+			k = i * j;
+			total += callee(k) % 7;
+		}
+	}
+	return total;
+}
+
+int
+backgoto(int n) {
+	int	count = 0;
+	int	acc = 1;
+	int	unused_late;
+
+again:
+	acc = acc * 3 + count;
+	if (++count < n) {
+		goto again;
+	}
+	unused_late = acc ^ 0x55;
+	return unused_late;
+}
+
+int
+addrtaken(int n) {
+	int	x = n;
+	int	*p = &x;
+	int	y = 0;
+
+	while (*p > 0) {
+		y += *p;
+		--x;
+	}
+	return y;
+}
+
+unsigned
+smalltypes(const char *s) {
+	unsigned short	h = 0;
+	unsigned char	c;
+	signed char	sc = -3;
+
+	while ((c = *s++) != 0) {
+		h = (unsigned short)(h * 31 + c);
+		sc += (signed char)c;
+	}
+	return h + sc;
+}
+
+int
+withswitch(int n) {
+	int	i, r = 0;
+
+	for (i = 0; i < n; ++i) {
+		switch (i % 6) {
+		case 0: r += 1; break;
+		case 1: r += 10; break;
+		case 2: r -= 3; break;
+		case 3: r *= 2; break;
+		case 4: r ^= 5; break;
+		default: r += i;
+		}
+	}
+	return r;
+}
+
+int
+main(void) {
+	long		arr[50];
+	char		buf[64];
+	int		i;
+	char		*p;
+
+	for (i = 0; i < 50; ++i) {
+		arr[i] = i * i - 7;
+	}
+	printf("%ld\n", sum(arr, 50));
+	printf("%d\n", nested(12));
+	printf("%d\n", backgoto(9));
+	printf("%d\n", addrtaken(10));
+	strcpy(buf, "register promotion");
+	for (p = buf; *p != 0; ++p) {
+		if (*p == ' ') {
+			*p = '_';
+		}
+	}
+	printf("%s %u\n", buf, smalltypes(buf));
+	printf("%d\n", withswitch(40));
+	return 0;
+}
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stddef.h>
+
+/*
+ * Name lookup through nested scopes: typedefs which are shadowed by
+ * ordinary identifiers and by other typedefs, structure and enum tags
+ * which are redefined in inner blocks, enum forward declarations and
+ * tagless structures
+ */
+typedef int	number;
+typedef char	letter;
+
+struct node {
+	number		value;
+	struct node	*next;
+};
+
+enum color;
+enum color { RED = 1, GREEN = 2, BLUE = 4 };
+
+static number	counter = 10;
+
+static int
+shadow_typedef(void) {
+	number	result = 0;
+
+	{
+		int	number = 5;
+
+		result += number;
+	}
+	{
+		typedef long	number;
+		number		big = 100;
+
+		result += (int)big + (int)sizeof(number);
+	}
+	{
+		typedef struct node	number;
+		number			n;
+
+		n.value = 7;
+		n.next = NULL;
+		result += n.value;
+	}
+	return result;
+}
+
+static int
+shadow_tags(void) {
+	struct node	outer = { 1, NULL };
+	int		sum = outer.value;
+
+	{
+		struct node {
+			char	name[16];
+			int	value;
+		};
+		struct node	inner = { "inner", 20 };
+
+		sum += inner.value + (int)sizeof inner.name;
+		{
+			enum color { RED = 100, CYAN };
+
+			sum += RED + CYAN;
+		}
+	}
+	sum += RED + GREEN + BLUE;
+	return sum;
+}
+
+static int
+tagless(void) {
+	struct { int a; char b; letter c; } s = { 1, 2, 3 };
+
+	return s.a + s.b + s.c
+		+ (int)__builtin_offsetof(struct { int x; int y; }, y);
+}
+
+static int
+uses_counter(int counter) {
+	return counter * 2;
+}
+
+int
+main(void) {
+	struct node	list[3];
+	struct node	*p;
+	int		total = 0;
+	int		i;
+
+	for (i = 0; i < 3; ++i) {
+		list[i].value = i + counter;
+		list[i].next = i < 2? &list[i + 1]: NULL;
+	}
+	for (p = list; p != NULL; p = p->next) {
+		total += p->value;
+	}
+	printf("%d\n", total);
+	printf("%d\n", shadow_typedef());
+	printf("%d\n", shadow_tags());
+	printf("%d\n", tagless());
+	printf("%d %d\n", uses_counter(3), counter);
+	return 0;
+}
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * File scope constructs which the streaming lexer has to read as a
+ * whole before the parser gets to see them, and function bodies which
+ * are or aren't released after they have been emitted
+ */
+__extension__ typedef long long	ll_t;
+
+struct pt {
+	int	x;
+	int	y;
+} origin = { 0, 0 }, unit = { 1, 1 };
+
+struct pt __attribute__((unused)) corners[] = {
+	{ 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }
+};
+
+enum color { RED, GREEN = 5, BLUE } paint = BLUE;
+
+typedef struct { char name[8]; int len; } label_t;
+
+static const char	*words[] = { "alpha", "beta" "gamma", "delta" };
+
+struct pt
+make_pt(int x, int y) {
+	struct pt	p;
+
+	p.x = x;
+	p.y = y;
+	return p;
+}
+
+int
+knr_add(a, b)
+	int	a;
+	long	b;
+{
+	return a + (int)b;
+}
+
+int
+(*knr_ptr(which))()
+	int	which;
+{
+	(void) which;
+	return (int (*)())knr_add;
+}
+
+static int
+counter(void) {
+	static int	calls;
+	static char	buf[] = "static";
+
+	return ++calls + (int)strlen(buf);
+}
+
+int
+use_extern(void) {
+	extern int	late_global;
+
+	return late_global * 2;
+}
+
+int	late_global = 21;
+
+static inline int
+twice(int x) {
+	return x * 2;
+}
+
+int
+control(int n) {
+	int	i;
+	int	sum = 0;
+
+	for (i = 0; i < n; ++i) {
+		if (i & 1) {
+			continue;
+		} else if (i == 6) {
+			break;
+		}
+		switch (i) {
+		case 2:
+			sum += twice(i);
+			break;
+		default:
+			sum += i;
+		}
+	}
+	do {
+		sum += ({ int t = n; t * 3; });
+	} while (--n > 0);
+	while (sum > 1000) {
+		sum -= 1000;
+	}
+	return sum;
+}
+
+label_t
+make_label(const char *s) {
+	label_t	l;
+
+	strncpy(l.name, s, sizeof l.name - 1);
+	l.name[sizeof l.name - 1] = 0;
+	l.len = (int)strlen(l.name);
+	return l;
+}
+
+int
+main(void) {
+	struct pt	p = make_pt(3, 4);
+	label_t		l = make_label(words[1]);
+	ll_t		big = (ll_t)1 << 40;
+	int		i;
+
+	printf("%d %d %d %d\n", p.x, p.y, unit.x, corners[3].y);
+	printf("%d %d\n", paint, GREEN);
+	printf("%s %d %s\n", l.name, l.len, words[1]);
+	printf("%d %d\n", knr_add(1, 2L), ((int (*)(int, long))knr_ptr(0))(3, 4L));
+	for (i = 0; i < 3; ++i) {
+		printf("%d\n", counter());
+	}
+	printf("%d %d\n", use_extern(), control(10));
+	printf("%lld\n", big);
+	return 0;
+}
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <limits.h>
+
+/*
+ * Multiplications, divisions and remainders by constants, which are
+ * done with shifts, lea and reciprocal multiplication at the default
+ * optimization level already (only -O-1 turns that off)
+ */
+struct rec12 {
+	int	a;
+	int	b;
+	int	c;
+};
+
+struct rec24 {
+	long	a;
+	int	b;
+	char	c[8];
+};
+
+static int	ivals[] = {
+	0, 1, -1, 2, -2, 7, -7, 99, -99, 123456, -123456,
+	INT_MAX, INT_MIN, INT_MAX - 1, INT_MIN + 1
+};
+
+static unsigned	uvals[] = {
+	0, 1, 2, 7, 99, 123456, UINT_MAX, UINT_MAX - 1,
+	0x80000000u, 0x7fffffffu, 4000000000u
+};
+
+static long	lvals[] = {
+	0, 1, -1, 7, -7, 1234567890L, -1234567890L,
+	LONG_MAX, LONG_MIN, LONG_MAX - 1, LONG_MIN + 1
+};
+
+static unsigned long	ulvals[] = {
+	0, 1, 7, 1234567890UL, ULONG_MAX, ULONG_MAX - 1, LONG_MAX
+};
+
+#define NELEM(ar) (sizeof ar / sizeof ar[0])
+
+int
+main(void) {
+	struct rec12	r12[4];
+	struct rec24	r24[4];
+	int		iar[5] = { 10, 20, 30, 40, 50 };
+	long		lar[5] = { 11, 22, 33, 44, 55 };
+	short		sar[5] = { 1, 2, 3, 4, 5 };
+	int		*ip = iar + 4;
+	long		*lp = lar + 4;
+	short		*sp = sar + 4;
+	unsigned	i;
+
+	for (i = 0; i < NELEM(ivals); ++i) {
+		int	x = ivals[i];
+		int	m = x % 100000;
+
+		printf("%d: %d %d %d %d %d %d %d %d\n", x,
+			x / 3, x % 3, x / 7, x % 7, x / 10, x % 10,
+			x / 1000, x % 1000);
+		printf("  %d %d %d %d %d %d\n",
+			x / -3, x % -3, x / -7, x % -7, x / 16, x % 16);
+		printf("  %d %d %d %d %d %d %d %d %d %d %d\n",
+			m * 3, m * 5, m * 6, m * 9, m * 10, m * 15,
+			m * 17, m * 31, m * -3, m * 100, m * 45);
+	}
+	for (i = 0; i < NELEM(uvals); ++i) {
+		unsigned	x = uvals[i];
+
+		printf("%u: %u %u %u %u %u %u %u %u\n", x,
+			x / 3, x % 3, x / 7, x % 7, x / 10, x % 10,
+			x / 16, x % 16);
+		printf("  %u %u %u %u\n", x * 3, x * 10, x * 17, x * 31);
+	}
+	for (i = 0; i < NELEM(lvals); ++i) {
+		long	x = lvals[i];
+		long	m = x % 1000000;
+
+		printf("%ld: %ld %ld %ld %ld %ld %ld\n", x,
+			x / 3, x % 3, x / 7, x % 7, x / -1000, x % -1000);
+		printf("  %ld %ld %ld\n", m * 5, m * 12, m * -9);
+	}
+	for (i = 0; i < NELEM(ulvals); ++i) {
+		unsigned long	x = ulvals[i];
+
+		printf("%lu: %lu %lu %lu %lu\n", x,
+			x / 7, x % 7, x / 10, x % 10);
+		printf("  %lu %lu\n", x * 3, x * 33);
+	}
+
+	for (i = 0; i < NELEM(ivals); ++i) {
+		int	x = ivals[i];
+		long	y = lvals[i % NELEM(lvals)];
+
+		x /= 10;
+		y %= 7;
+		x *= 9;
+		printf("%d %ld", x, y);
+		x = ivals[i];
+		x /= 16;
+		y = lvals[i % NELEM(lvals)];
+		y /= 64;
+		printf(" %d %ld\n", x, y);
+	}
+
+	for (i = 0; i < 4; ++i) {
+		r12[i].a = i;
+		r12[i].c = i * 2;
+		r24[i].b = i * 3;
+		r24[i].c[7] = (char)i;
+	}
+	for (i = 0; i < 4; ++i) {
+		printf("%d %d %d %d\n", r12[i].a, r12[3 - i].c,
+			r24[i].b, r24[3 - i].c[7]);
+	}
+	for (i = 0; i < 5; ++i) {
+		int	neg = -(int)i;
+
+		printf("%d %ld %d %d %ld %d\n", iar[i], lar[i], sar[i],
+			ip[neg], lp[neg], sp[neg]);
+	}
+	return 0;
+}
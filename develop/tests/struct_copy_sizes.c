@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Struct assignment, by-value arguments and return values for sizes
+ * around the inline copy move sizes, plus one struct which is large
+ * enough to be copied with memcpy(). Copies go between automatic,
+ * static and pointed-to structs and struct members
+ */
+#define DEFINE_STRUCT(n) \
+	struct s##n { unsigned char c[n]; }; \
+	static struct s##n \
+	pass##n(struct s##n a, int x, struct s##n b) { \
+		struct s##n	ret; \
+		int		i; \
+		for (i = 0; i < n; ++i) { \
+			ret.c[i] = a.c[i] + b.c[i] + x; \
+		} \
+		return ret; \
+	}
+
+DEFINE_STRUCT(1)
+DEFINE_STRUCT(3)
+DEFINE_STRUCT(4)
+DEFINE_STRUCT(7)
+DEFINE_STRUCT(8)
+DEFINE_STRUCT(13)
+DEFINE_STRUCT(16)
+DEFINE_STRUCT(31)
+DEFINE_STRUCT(64)
+DEFINE_STRUCT(65)
+DEFINE_STRUCT(200)
+
+struct outer {
+	int		pad;
+	struct s13	inner;
+	struct s65	big;
+};
+
+static unsigned
+checksum(const void *p, int n) {
+	const unsigned char	*cp = p;
+	unsigned		sum = 0;
+	int			i;
+
+	for (i = 0; i < n; ++i) {
+		sum = sum * 31 + cp[i];
+	}
+	return sum;
+}
+
+#define TEST(n) { \
+	struct s##n		a, b, c; \
+	static struct s##n	st; \
+	struct s##n		*p = &b; \
+	int			i; \
+	for (i = 0; i < n; ++i) { \
+		a.c[i] = (unsigned char)(i * 3 + n); \
+	} \
+	b = a; \
+	st = *p; \
+	c = pass##n(st, 1, *p); \
+	*p = c; \
+	printf("%d: %u %u %u\n", n, checksum(&st, n), \
+		checksum(&c, n), checksum(p, n)); \
+}
+
+int
+main(void) {
+	struct outer	o, o2;
+	struct outer	*op = &o2;
+	struct s13	t;
+	int		x = 5;
+	int		y = 7;
+
+	TEST(1)
+	TEST(3)
+	TEST(4)
+	TEST(7)
+	TEST(8)
+	TEST(13)
+	TEST(16)
+	TEST(31)
+	TEST(64)
+	TEST(65)
+	TEST(200)
+
+	memset(&o, 0, sizeof o);
+	memset(&o2, 0, sizeof o2);
+	strcpy((char *)o.inner.c, "hello world!");
+	memset(o.big.c, 'x', sizeof o.big.c);
+	op->inner = o.inner;
+	op->big = o.big;
+	t = op->inner;
+	o.inner = t;
+
+	/* Values held in registers must survive the copies */
+	x += y;
+	op->big = o.big;
+	y += x;
+	printf("%s %u %d %d\n", (char *)t.c, checksum(&op->big, 65), x, y);
+	return 0;
+}
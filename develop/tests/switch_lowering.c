@@ -0,0 +1,89 @@
+#include <stdio.h>
+enum color { RED = -3, GREEN, BLUE, CYAN, MAGENTA, YELLOW, BLACK, WHITE };
+int dense(int x) {
+	switch (x) {
+	case 1: return 10; case 2: return 20; case 3: return 30;
+	case 5: return 50; case 6: return 60; case 7: return 70; case 8: return 80;
+	case 9: x += 1; /* fallthrough */
+	case 10: return x * 3;
+	default: return -1;
+	}
+}
+int negdense(int x) {
+	switch (x) {
+	case -5: return 1; case -4: return 2; case -3: return 3; case -2: return 4;
+	case -1: return 5; case 0: return 6; case 1: return 7;
+	}
+	return 99;
+}
+long sparse(long x) {
+	switch (x) {
+	case -100000: return 1; case 7: return 2; case 300: return 3; case 4000: return 4;
+	case 50000: return 5; case 600000: return 6; case 7000000: return 7;
+	case 80000000: return 8; case -5: return 9; case 1L << 40: return 10;
+	default: return 0;
+	}
+}
+unsigned uns(unsigned x) {
+	switch (x) {
+	case 0xfffffff0u: return 1; case 0xfffffff1u: return 2; case 0xfffffff2u: return 3;
+	case 0xfffffff3u: return 4; case 0xfffffff5u: return 5; case 0xfffffff6u: return 6;
+	default: return 0;
+	}
+}
+unsigned long ulbig(unsigned long x) {
+	switch (x) {
+	case 0: return 1; case 1: return 2; case 2: return 3; case 3: return 4; case 4: return 5;
+	case 0xffffffffffffffffUL: return 6;
+	default: return 0;
+	}
+}
+int ch(char c) {
+	switch (c) {
+	case 'a': return 1; case 'b': return 2; case 'c': return 3; case 'd': return 4;
+	case 'e': return 5; case 'f': return 6; case -1: return 7;
+	}
+	return 0;
+}
+int col(enum color c) {
+	switch (c) {
+	case RED: return 1; case GREEN: return 2; case BLUE: return 3; case CYAN: return 4;
+	case MAGENTA: return 5; case YELLOW: return 6; case BLACK: return 7;
+	default: return 8;
+	}
+}
+int small(int x) { switch (x) { case 1: return 5; case 9: return 6; } return 0; }
+long long ll(long long x) {
+	switch (x) {
+	case 1: return 1; case 2: return 2; case 3: return 3; case 4: return 4; case 5: return 5;
+	case 6: return 6; case 0x100000000LL: return 7; case -1: return 8;
+	}
+	return 0;
+}
+int loopy(int n) {
+	int i, s = 0;
+	for (i = 0; i < n; ++i) {
+		switch (i % 13) {
+		case 0: s += 1; break; case 1: s += 3; break; case 2: s -= 2; break;
+		case 3: s *= 2; break; case 4: s += i; break; case 5: continue;
+		case 6: s ^= 5; break; case 7: s += 7; break; case 11: s -= i; break;
+		default: s++;
+		}
+		s += 1;
+	}
+	return s;
+}
+int main(void) {
+	int i;
+	long l;
+	for (i = -20; i < 20; ++i) printf("%d %d %d %d %d %d\n", i, dense(i), negdense(i), ch(i + 'a'), col(i), small(i));
+	{ long v[] = { -100000, 7, 300, 4000, 50000, 600000, 7000000, 80000000, -5, 1L << 40, 0, 8, -6, 1L<<41 };
+	  for (i = 0; i < (int)(sizeof v / sizeof v[0]); ++i) printf("%ld %ld\n", v[i], sparse(v[i])); }
+	for (l = 0; l < 20; ++l) printf("%u %u\n", 0xffffffe8u + (unsigned)l, uns(0xffffffe8u + (unsigned)l));
+	for (l = -3; l < 8; ++l) printf("%lu %lu\n", (unsigned long)l, ulbig((unsigned long)l));
+	for (l = -3; l < 8; ++l) printf("%lld\n", ll(l));
+	printf("%lld %lld\n", ll(0x100000000LL), ll(0x100000001LL));
+	printf("%d\n", ch(-1));
+	printf("%d\n", loopy(1000));
+	return 0;
+}
@@ -0,0 +1,62 @@
+#include <stdio.h>
+
+/*
+ * A typedef in an inner block hides an ordinary identifier of the same
+ * name in an enclosing block, and the identifier becomes visible again
+ * when the block is closed
+ */
+typedef int	count;
+
+static int
+nested(void) {
+	int	number = 3;
+	int	result = number;
+
+	{
+		typedef long	number;
+		number		big = 100;
+
+		result += (int)big + (int)sizeof(number);
+		{
+			int	number = 40;
+
+			result += number;
+			{
+				typedef short	number;
+				number		s = 2;
+
+				result += s + (int)sizeof(number);
+			}
+			result += number;
+		}
+	}
+	return result + number;
+}
+
+static int
+params(int count) {
+	{
+		typedef char	count;
+		count		c = 5;
+
+		return c + (int)sizeof(count);
+	}
+}
+
+int
+main(void) {
+	count	c = 7;
+	int	i;
+	int	sum = 0;
+
+	for (i = 0; i < 4; ++i) {
+		typedef int	i_type;
+		int		count = i;
+
+		sum += count + (int)sizeof(i_type);
+	}
+	printf("%d\n", nested());
+	printf("%d\n", params(9));
+	printf("%d %d\n", c, sum);
+	return 0;
+}
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * VLAs and alloca() are allocated on the stack. A VLA declared in a
+ * loop body must be released at the end of every iteration, so the
+ * stack pointer must not keep growing; alloca() storage must survive
+ * until the function returns
+ */
+static char *
+stack_pos(void) {
+	char	c;
+	char	*p = &c;
+
+	return p;
+}
+
+static int
+sum_vla(int n) {
+	int	arr[n];
+	int	i;
+	int	sum = 0;
+
+	for (i = 0; i < n; ++i) {
+		arr[i] = i;
+	}
+	for (i = 0; i < n; ++i) {
+		sum += arr[i];
+	}
+	return sum;
+}
+
+static int
+loop_vla(int iterations, long *growth) {
+	int	i;
+	int	sum = 0;
+	char	*first = NULL;
+	char	*last = NULL;
+
+	for (i = 0; i < iterations; ++i) {
+		char	buf[100 + i % 7];
+
+		memset(buf, i, sizeof buf);
+		sum += buf[sizeof buf - 1];
+		if (first == NULL) {
+			first = buf;
+		}
+		last = buf;
+		if (i == iterations - 1) {
+			break;
+		}
+		{
+			int	inner[i % 5 + 1];
+
+			inner[0] = 1;
+			sum += inner[0];
+		}
+	}
+	*growth = first - last;
+	return sum;
+}
+
+/*
+ * Several VLAs in one scope, left by the scope end and by continue.
+ * Without the stack pointer restored to the one from before the
+ * first VLA, every iteration leaks at least 4 KB, which exhausts an
+ * 8 MB stack well before the loop ends
+ */
+static long
+multi_vla(int iterations, long *growth) {
+	int	i;
+	long	sum = 0;
+	char	*first = NULL;
+	char	*last = NULL;
+
+	for (i = 1; i <= iterations; ++i) {
+		char	buf[i % 300 * 16 + 4096];
+		int	n = i % 7 + 1;
+		char	a[n];
+		int	b[n];
+
+		buf[0] = 1;
+		a[n - 1] = (char)(i & 63);
+		b[n - 1] = i % 1000;
+		if (first == NULL) {
+			first = buf;
+		}
+		last = buf;
+		if (i % 3 == 0) {
+			sum += a[n - 1];
+			continue;
+		}
+		{
+			char	c[n];
+			int	d[n + 1];
+
+			c[0] = buf[0];
+			d[n] = b[n - 1];
+			if (i % 5 == 0) {
+				sum += c[0];
+				continue;
+			}
+			sum += d[n];
+		}
+		sum += buf[0];
+	}
+	*growth = first - last;
+	return sum;
+}
+
+static int
+alloca_and_vla(int n) {
+	char	*saved[4];
+	int	i;
+	int	ok = 1;
+
+	for (i = 0; i < 4; ++i) {
+		int	vla[n];
+
+		vla[0] = i;
+		saved[i] = __builtin_alloca(32);
+		memset(saved[i], 'a' + i + vla[0] - i, 32);
+	}
+	for (i = 0; i < 4; ++i) {
+		if (saved[i][0] != 'a' + i || saved[i][31] != 'a' + i) {
+			ok = 0;
+		}
+	}
+	return ok;
+}
+
+static long
+alignment(int n) {
+	char	vla[n];
+	char	*p = __builtin_alloca((short)n);
+
+	return ((long)vla | (long)p) & 15;
+}
+
+int
+main(void) {
+	long	growth;
+	char	*before;
+	char	*after;
+	int	sum;
+	long	sum2;
+
+	printf("%d %d %d\n", sum_vla(1), sum_vla(10), sum_vla(1000));
+
+	before = stack_pos();
+	sum = loop_vla(100000, &growth);
+	after = stack_pos();
+	printf("%d %s %s\n", sum,
+		growth < 1024 && growth > -1024? "bounded": "growing",
+		before == after? "restored": "leaked");
+	before = stack_pos();
+	sum2 = multi_vla(1000000, &growth);
+	after = stack_pos();
+	printf("%ld %s %s\n", sum2,
+		growth < 8192 && growth > -8192? "bounded": "growing",
+		before == after? "restored": "leaked");
+	printf("%d\n", alloca_and_vla(3));
+	printf("%ld %ld\n", alignment(1), alignment(33));
+	return 0;
+}
@@ -0,0 +1,75 @@
+#include <stdio.h>
+
+/*
+ * Labels, statements and file scope structure members are allocated
+ * across several function definitions, which reset the function zones
+ */
+struct first {
+	int	a;
+};
+
+static int
+classify(int x) {
+	switch (x) {
+	case 0:
+		return 10;
+	case 1:
+		goto one;
+	case 2:
+		if (0) {
+	case 3:
+			x += 100;
+		}
+		return x;
+	default:
+		break;
+	}
+	return -1;
+one:
+	return 11;
+}
+
+struct second {
+	struct first	f;
+	long		b;
+	double		d;
+};
+
+static int
+loop(int n) {
+	int	i, total = 0;
+
+	for (i = 0; i < n; ++i) {
+		switch (i & 3) {
+		case 0: total += classify(i % 5); break;
+		case 1: total -= 2; continue;
+		default: total ^= i;
+		}
+	}
+	if (total > 1000) goto out;
+	total *= 2;
+out:
+	return total;
+}
+
+struct second	gs = { { 7 }, 8, 0.5 };
+
+static double
+fpzero(double d) {
+	if (d) {
+		return d * 2;
+	}
+	return -1.0;
+}
+
+int
+main(void) {
+	int	i;
+
+	for (i = 0; i < 6; ++i) {
+		printf("%d ", classify(i));
+	}
+	printf("\n%d %d %ld\n", loop(20), gs.f.a, gs.b);
+	printf("%f %f %f\n", fpzero(0.0), fpzero(gs.d), fpzero(0.0));
+	return 0;
+}
@@ -42,6 +42,7 @@
 #    include "decl.h"
 #    include "cc1_main.h"
 #    include "debug.h"
+#    include "atom.h"
 #else
 #    include "archdefs.h"
 #    include "cpp_main.h"
@@ -60,6 +61,8 @@
 
 #ifndef PREPROCESSOR
 #    include "features.h"
+#    include "lex.h"
+#    include "fcatalog.h"
 #endif
 #include "n_libc.h"
 
@@ -116,6 +119,10 @@ struct token *
 dup_token(struct token *tok) {
 	struct token	*ret = alloc_token();
 	*ret = *tok;
+	ret->flags &= ~(TOK_FLAG_ARENA | TOK_FLAG_FREED);
+	if (tok->data == &tok->u.op) {
+		ret->data = &ret->u.op;
+	}
 	return ret;
 }
 
@@ -147,6 +154,201 @@ free_tokens(struct token *from, struct token *to, int type) {
 	} while (from != NULL && from != to);
 }
 
+/*
+ * Last token appended by store_token(). 10/17/26: This was static in
+ * store_token(); It has to be restorable for the streaming lexer,
+ * since the token list being appended to may change between calls
+ */
+static struct token	*cur;
+
+/*
+ * 10/17/26: Set while the tokens of a function body are kept for
+ * release by the parser when the function has been emitted
+ */
+int	token_defer_free;
+
+/*
+ * Frees a single token which the parser has consumed and which is not
+ * referenced anymore. While a function body is being parsed, the token
+ * is only flagged, since the body is released as a whole later, and
+ * the token list must still be walkable until then
+ */
+void
+free_token(struct token *t) {
+	if (token_defer_free) {
+		t->flags |= TOK_FLAG_FREED;
+	} else if (!(t->flags & TOK_FLAG_ARENA)) {
+		free(t);
+	}
+}
+
+#ifndef PREPROCESSOR
+
+/*
+ * 10/17/26: Token arenas. The lexer carves the tokens of the translation
+ * unit out of large slabs instead of allocating every one of them with
+ * malloc(). Tokens which the lexer expects to belong to a function body
+ * (see lex_in_body()) come from an arena of their own, which is emptied
+ * in one go when the parser is done with the function, so its slabs can
+ * be reused for the next one. Everything else stays until the end
+ */
+#define TOKEN_SLAB_TOKENS	1024
+
+struct token_slab {
+	struct token_slab	*next;
+	int			used;
+	int			kept; /* Tokens of kept function bodies */
+	struct token		tokens[TOKEN_SLAB_TOKENS];
+};
+
+struct token_arena {
+	struct token_slab	*slabs; /* Slab being filled comes first */
+	struct token		*first;
+};
+
+static struct token_arena	decl_arena;
+static struct token_arena	body_arena;
+static struct token_slab	*spare_slabs;
+
+static struct token *
+arena_alloc_token(struct token_arena *a) {
+	static struct token	nulltok;
+	struct token_slab	*s = a->slabs;
+	struct token		*ret;
+
+	if (s == NULL || s->used == TOKEN_SLAB_TOKENS) {
+		if (spare_slabs != NULL) {
+			s = spare_slabs;
+			spare_slabs = s->next;
+		} else {
+			s = n_xmalloc(sizeof *s);
+		}
+		s->used = s->kept = 0;
+		s->next = a->slabs;
+		a->slabs = s;
+	}
+	ret = &s->tokens[s->used++];
+	*ret = nulltok;
+	ret->flags = TOK_FLAG_ARENA;
+	if (a->first == NULL) {
+		a->first = ret;
+	}
+	return ret;
+}
+
+/*
+ * Gives back the storage of ``t'' if it is the token allocated last
+ * from arena ``a''. Returns 0 if it isn't
+ */
+static int
+arena_unget_token(struct token_arena *a, struct token *t) {
+	if (a->slabs == NULL
+		|| a->slabs->used == 0
+		|| &a->slabs->tokens[a->slabs->used - 1] != t) {
+		return 0;
+	}
+	--a->slabs->used;
+	if (a->first == t) {
+		a->first = NULL;
+	}
+	return 1;
+}
+
+/*
+ * Called when the parser is done with the function body which begins
+ * with the token ``start'' and ends with ``end''. If ``keep'' is not
+ * set and the body arena holds nothing but the tokens between the two,
+ * it is emptied for reuse. Otherwise, e.g. if the lexer has mistaken
+ * an initializer for a function body or already read beyond ``end'',
+ * the tokens of the body arena are kept for good. The slab being filled
+ * stays with the body arena in either case, so kept bodies don't waste
+ * the rest of it
+ */
+void
+token_release_body(struct token *start, struct token *end, int keep) {
+	struct token_slab	*head = body_arena.slabs;
+	struct token_slab	*s;
+
+	if (head == NULL) {
+		return;
+	}
+	if (!keep && (body_arena.first != start || cur != end)) {
+		keep = 1;
+	}
+	while ((s = head->next) != NULL) {
+		head->next = s->next;
+		if (keep || s->kept > 0) {
+			/* Insert behind the slab being filled */
+			if (decl_arena.slabs == NULL) {
+				s->next = NULL;
+				decl_arena.slabs = s;
+			} else {
+				s->next = decl_arena.slabs->next;
+				decl_arena.slabs->next = s;
+			}
+		} else {
+			s->next = spare_slabs;
+			spare_slabs = s;
+		}
+	}
+	if (keep) {
+		head->kept = head->used;
+	} else {
+		head->used = head->kept;
+	}
+	body_arena.first = NULL;
+}
+
+#endif /* #ifndef PREPROCESSOR */
+
+
+/*
+ * 10/17/26: String constants are looked up in a hash table instead of
+ * comparing every new literal against all previous ones, which was
+ * quadratic in the number of literals per translation unit
+ */
+#define STR_CONST_TAB_INIT	1024	/* must be power of 2 */
+
+static struct ty_string	**str_const_tab;
+static int		str_const_tab_size;
+static int		str_const_tab_count;
+
+static unsigned
+hash_ty_string(struct ty_string *ts) {
+	unsigned	key = (unsigned)ts->size * 2 + (ts->is_wide_char != 0);
+	size_t		i;
+
+	for (i = 0; i < ts->size; ++i) {
+		key = 33 * key + (unsigned char)ts->str[i];
+	}
+	return key;
+}
+
+static void
+grow_str_const_tab(void) {
+	struct ty_string	**newtab;
+	struct ty_string	*ts;
+	struct ty_string	*next;
+	int			newsize;
+	int			i;
+
+	newsize = str_const_tab_size? str_const_tab_size * 2:
+		STR_CONST_TAB_INIT;
+	newtab = n_xmalloc(newsize * sizeof *newtab);
+	memset(newtab, 0, newsize * sizeof *newtab);
+	for (i = 0; i < str_const_tab_size; ++i) {
+		for (ts = str_const_tab[i]; ts != NULL; ts = next) {
+			int	key = ts->hash & (newsize - 1);
+
+			next = ts->hash_next;
+			ts->hash_next = newtab[key];
+			newtab[key] = ts;
+		}
+	}
+	free(str_const_tab);
+	str_const_tab = newtab;
+	str_const_tab_size = newsize;
+}
 
 static int
 append_ty_string(
@@ -154,9 +356,17 @@ append_ty_string(
 	struct ty_string **tail,
 	struct ty_string **str) {
 	struct ty_string	*tmp;
+	unsigned		hash;
+	int			key;
 
-	for (tmp = str_const; tmp != NULL; tmp = tmp->next) {
-		if (tmp->size == (*str)->size
+	if (str_const_tab_count >= str_const_tab_size) {
+		grow_str_const_tab();
+	}
+	hash = hash_ty_string(*str);
+	key = hash & (str_const_tab_size - 1);
+	for (tmp = str_const_tab[key]; tmp != NULL; tmp = tmp->hash_next) {
+		if (tmp->hash == hash
+			&& tmp->size == (*str)->size
 			&& tmp->is_wide_char == (*str)->is_wide_char) {
 			/*
 			 * 07/20/08: This used strcmp() instead of
@@ -172,6 +382,11 @@ append_ty_string(
 			}
 		}
 	}
+	(*str)->hash = hash;
+	(*str)->hash_next = str_const_tab[key];
+	str_const_tab[key] = *str;
+	++str_const_tab_count;
+
 	if (*head == NULL) {
 		*head = *tail = *str;
 	} else {
@@ -563,7 +778,30 @@ get_string_literal(struct input_file *f) {
 #ifdef PREPROCESSOR
 	store_char(&p, '"');
 #endif
-	while ((ch = FGETC(f)) != EOF) {
+	for (;;) {
+#ifndef PREPROCESSOR
+		if (f->cur_buf_ptr != NULL) {
+			/*
+			 * 10/17/26: Buffered input - copy the run of ordinary
+			 * characters up to the next one which needs a closer
+			 * look
+			 */
+			const char	*s;
+
+			for (s = f->cur_buf_ptr; s != f->buf_end; ++s) {
+				if (*s == '"' || *s == '\\' || *s == '?'
+					|| *s == '\n' || *s == '\r') {
+					break;
+				}
+				store_char(&p, *(unsigned char *)s);
+			}
+			lex_chars_read += s - f->cur_buf_ptr;
+			f->cur_buf_ptr = (char *)s;
+		}
+#endif
+		if ((ch = FGETC(f)) == EOF) {
+			break;
+		}
 		if (ch == '?') {
 			/* Might be trigraph */
 			if ((trig = get_trigraph(f)) == -1) {
@@ -1083,7 +1321,7 @@ complete_num_literal(char *p, char *bin_exp, int digits_read, int octal_flag, in
 	} else if (long_flag
 		&& backend->abi == ABI_POWER64) {
 		/* 64bit native long long/long! */
-		put_ppc_llong(rc);
+		put_ppc_llong(n_xmemdup(rc, sizeof *rc));
 #endif
 	}
 
@@ -1342,12 +1580,25 @@ get_num_literal(int firstch, struct input_file *f) {
 	return complete_num_literal(p, bin_exp, digits_read, octal_flag, hexa_flag, fp_flag, float_flag, hex_float, bin_exp_idx, long_flag, unsigned_flag);
 }
 
+#ifndef PREPROCESSOR
+static char *
+intern_identifier(char *p) {
+	char	*ret = atom_intern_str(p)->name;
+
+	free(p);
+	return ret;
+}
+#endif
+
 /*
  * Reads an identifier from stream f and returns a pointer to a 
  * dynamically allocated string containing the result. It will
  * append all characters until a character is encountered that
  * is neither alpha-numeric, nor ``_'', nor ``$''. On failure
  * (end of file), a null pointer is returned
+ *
+ * 10/17/26: The compiler (but not the preprocessor) returns the name
+ * of the identifier's atom instead, which must not be freed
  */
 char *
 #ifndef PREPROCESSOR
@@ -1368,6 +1619,35 @@ get_identifier(int ch, struct input_file *f, int *slen, int *hash_key) {
 	key = ch;
 #endif
 
+#ifndef PREPROCESSOR
+	if (f->cur_buf_ptr != NULL
+		&& f->cur_buf_ptr != f->buf
+		&& *(unsigned char *)(f->cur_buf_ptr - 1) == ch) {
+		/*
+		 * 10/17/26: Buffered input - find the end of the identifier
+		 * and intern it in one go
+		 */
+		const char	*start = f->cur_buf_ptr - 1;
+		const char	*end;
+
+		for (end = f->cur_buf_ptr; end != f->buf_end; ++end) {
+			if (*end == '$') {
+				/* Position error message at the ``$'' */
+				lex_chars_read += end + 1 - f->cur_buf_ptr;
+				f->cur_buf_ptr = (char *)end + 1;
+				lexerror("`$' characters are not allowed in "
+					"identifiers");
+			} else if (!isalnum((unsigned char)*end)
+				&& *end != '_') {
+				break;
+			}
+		}
+		lex_chars_read += end - f->cur_buf_ptr;
+		f->cur_buf_ptr = (char *)end;
+		return atom_intern(start, end - start)->name;
+	}
+#endif
+
 	store_char(&p, ch);
 	while ((ch = FGETC(f)) != EOF) {
 		if (isalnum((unsigned char)ch) || ch == '_' || ch == '$') {
@@ -1393,6 +1673,8 @@ get_identifier(int ch, struct input_file *f, int *slen, int *hash_key) {
 #ifdef PREPROCESSOR
 			*hash_key = key;
 			*slen = len;
+#else
+			return intern_identifier(p);
 #endif
 			return p;
 		}
@@ -1406,23 +1688,110 @@ get_identifier(int ch, struct input_file *f, int *slen, int *hash_key) {
 #ifdef PREPROCESSOR
 	*hash_key = key;
 	*slen = len;
+#else
+	return intern_identifier(p);
 #endif
 	return p;
 }
 
 
-static char 	*curfile;
+#ifndef PREPROCESSOR
+/*
+ * 10/17/26: Returns the atom of an identifier token. Tokens which were
+ * made up after lexing (or whose data was changed) don't necessarily
+ * carry the right atom, so it is only trusted if it still belongs to
+ * the token's name
+ */
+struct atom *
+token_atom(struct token *t) {
+	if (t->u.atom == NULL || t->u.atom->name != t->data) {
+		t->u.atom = atom_intern_str(t->data);
+	}
+	return t->u.atom;
+}
+#endif
+
+
+/*
+ * 10/17/26: Names of the files which tokens come from. Tokens only
+ * record the index of their file name, index 0 meaning ``unknown''
+ */
+static char		**token_files;
+static unsigned		token_files_count = 1;
+static unsigned		token_files_alloc;
+
+static unsigned short	curfile;
 /*static int	curfileid;*/
 
+/*
+ * Returns the index of file name ``file'', entering a copy of it into
+ * the table of file names if it isn't there yet. If the table is full,
+ * the name is dropped and 0 is returned
+ */
+unsigned short
+token_file_index(const char *file) {
+	unsigned	i;
+
+	if (file == NULL) {
+		return 0;
+	}
+	if (curfile != 0 && strcmp(token_files[curfile], file) == 0) {
+		return curfile;
+	}
+	for (i = 1; i < token_files_count; ++i) {
+		if (strcmp(token_files[i], file) == 0) {
+			return (unsigned short)i;
+		}
+	}
+	if (token_files_count > USHRT_MAX) {
+		return 0;
+	}
+	if (token_files_count >= token_files_alloc) {
+		token_files_alloc = token_files_alloc? token_files_alloc * 2: 64;
+		token_files = n_xrealloc(token_files,
+			token_files_alloc * sizeof *token_files);
+		token_files[0] = NULL;
+	}
+	token_files[token_files_count] = n_xstrdup(file);
+	return (unsigned short)token_files_count++;
+}
+
+/*
+ * Returns the name of the file containing token ``t'', or a null
+ * pointer if it is unknown
+ */
+char *
+token_file(struct token *t) {
+	return t->file_idx != 0? token_files[t->file_idx]: NULL;
+}
+
+/*
+ * Returns a pointer to the beginning of token ``t'' in the memory-mapped
+ * input file, or a null pointer if that isn't available
+ */
+char *
+token_src_ptr(struct token *t) {
+	return t->src_off != 0 && lex_file_map != NULL?
+		lex_file_map + t->src_off - 1: NULL;
+}
+
 /*
  * Set path of file currently processed. This will be used by
  * store_token(), which saves in each token which file it is
  * contained by
  * XXX This is sorta bogus??
+ *
+ * 10/17/26: Returns the file name as entered into the file name
+ * table, which is kept until the end
  */
-void
-token_setfile(char *file) {
-	curfile = file;
+char *
+token_setfile(const char *file) {
+	curfile = token_file_index(file);
+	if (curfile == 0) {
+		/* Too many files */
+		return file != NULL? n_xstrdup(file): NULL;
+	}
+	return token_files[curfile];
 }
 
 #if 0
@@ -1548,6 +1917,25 @@ check_ident(struct token *t, const char *ident) {
 
 
 
+/*
+ * 10/17/26: Allocates a token to be appended to list ``dest'' by
+ * store_token(). The translation unit being streamed by the lexer
+ * gets its tokens from the token arenas
+ */
+static struct token *
+new_list_token(struct token **dest, int type) {
+#ifndef PREPROCESSOR
+	if (lex_streaming && dest == &toklist && !doing_fcatalog) {
+		return arena_alloc_token(lex_in_body(type)?
+			&body_arena: &decl_arena);
+	}
+#else
+	(void) dest;
+	(void) type;
+#endif
+	return alloc_token();
+}
+
 /*
  * Appends the token specified by the data-type-linenum triple to
  * the token list pointed to by ``dest''. Exits with an error
@@ -1565,7 +1953,6 @@ store_token(struct token **dest,
 	void *data, int type, int linenum, char *ascii) {
 	struct token		*t;
 	struct token		*ret = NULL;
-	static struct token	*cur;
 
 #if 0
 printf("                                  line %d ... \r ", linenum);	
@@ -1575,7 +1962,7 @@ printf("                                  line %d ... \r ", linenum);
 #if 0
 		*dest = n_xmalloc(sizeof **dest);
 #endif
-		*dest = alloc_token();
+		*dest = new_list_token(dest, type);
 #ifdef PREPROCESSOR
 		*dest_tail = *dest;
 #endif
@@ -1665,7 +2052,7 @@ printf("                                  line %d ... \r ", linenum);
 #if 0
 		t->next = n_xmalloc(sizeof *t->next);
 #endif
-		t->next = alloc_token();
+		t->next = new_list_token(dest, type);
 		t->next->prev = t;
 		t = t->next;
 		t->next = NULL;
@@ -1684,7 +2071,7 @@ printf("                                  line %d ... \r ", linenum);
 		t->ascii = tok_to_ascii(type, data);
 	}
 
-	t->file = curfile; 
+	t->file_idx = curfile;
 /*	t->fileid = curfileid;*/
 
 #ifndef PREPROCESSOR
@@ -1715,12 +2102,37 @@ printf("                                  line %d ... \r ", linenum);
 		t->data = data;
 	}	
 
-	t->line_ptr = lex_line_ptr;
-	t->tok_ptr = lex_tok_ptr;
+	/*
+	 * 10/17/26: lex_tok_ptr points behind the first character of the
+	 * token, so the offset of the token plus one can be taken from it
+	 */
+	if (lex_tok_ptr != NULL
+		&& lex_file_map != NULL
+		&& lex_tok_ptr > lex_file_map
+		&& lex_tok_ptr <= lex_file_map_end
+		&& lex_tok_ptr - lex_file_map < UINT_MAX) {
+		t->src_off = lex_tok_ptr - lex_file_map;
+	}
+#ifndef PREPROCESSOR
+	if (type == TOK_OPERATOR || type == TOK_ELLIPSIS) {
+		/*
+		 * 10/17/26: The operator value is kept in the token, so
+		 * the caller's copy need not be allocated
+		 */
+		t->u.op = *(int *)data;
+		t->data = &t->u.op;
+	}
+#endif
 
 #ifndef PREPROCESSOR
 	if (type == TOK_IDENTIFIER) {
-		/* Let's try and see whether this identifier is a keyword */
+		/*
+		 * Let's try and see whether this identifier is a keyword
+		 *
+		 * 10/17/26: Identifiers read by the lexer are atom names
+		 * now (see get_identifier()) and must not be freed, and
+		 * every identifier token gets its atom here
+		 */
 		struct keyword	*kw;
 		
 #if 0
@@ -1747,8 +2159,12 @@ printf("                                  line %d ... \r ", linenum);
 					*dest = NULL;
 				}
 					
-				free(data);
-				free(t);
+				if (!(t->flags & TOK_FLAG_ARENA)) {
+					free(t);
+				} else if (!arena_unget_token(&body_arena, t)) {
+					(void) arena_unget_token(&decl_arena, t);
+				}
+				return NULL;
 			} else if ((stdflag == ISTD_C89 || stdflag == ISTD_GNU89)
 				&& /*keywords[i].*/ kw->std != C89
 				&& ((char *)data)[0] != '_') {
@@ -1762,12 +2178,11 @@ printf("                                  line %d ... \r ", linenum);
 				 */
 				t->type = /*keywords[i].*/  kw->value;
 #endif
-				t->data = t->ascii = /*keywords[i].*/ kw->name;
-				free(data);
+				t->u.atom = atom_intern_str(kw->name);
+				t->data = t->ascii = t->u.atom->name;
 			} else {
 				t->type = /*keywords[i].*/  kw->value;
 				t->data = t->ascii = /*keywords[i].*/ kw->name;
-				free(data);
 			}	
 		} else {
 #ifndef PREPROCESSOR
@@ -1781,10 +2196,10 @@ printf("                                  line %d ... \r ", linenum);
 				 * we now rename them to libc calls like bzero() to avoid
 				 * have to implement them
 				 */
-				t->data = n_xstrdup(data + strlen("__builtin_"));
-				t->ascii = t->data;
+				t->u.atom = atom_intern_str(
+					(char *)data + strlen("__builtin_"));
+				t->data = t->ascii = t->u.atom->name;
 				t->flags |= TOK_FLAG_WAS_BUILTIN;
-				free(data);
 			} else {
 				/* 
 				 * Check whether ident invades the implementation
@@ -1793,14 +2208,28 @@ printf("                                  line %d ... \r ", linenum);
 				if (/*strictansi*/1) {
 					check_ident(t, data);
 				}	
+				t->u.atom = atom_intern_str(data);
+				if (t->ascii == data) {
+					t->ascii = t->u.atom->name;
+				}
+				t->data = t->u.atom->name;
 			}
 #endif
 		}
 	}
+
+	if (lex_streaming && dest == &toklist) {
+		lex_note_token(t);
+	}
 #endif
 	return ret;
 }
 
+void
+store_token_set_tail(struct token *t) {
+	cur = t;
+}
+
 
 #ifdef TEST_STORE_TOKEN
 /*
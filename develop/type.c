@@ -900,7 +900,7 @@ const_from_value(void *value, struct type *ty) {
 struct token *
 fp_const_from_ascii(const char *value, int type) {
 	struct num	*n;
-	struct token	*ret = n_xmalloc(sizeof *ret);
+	struct token	*ret = alloc_token();
 
 	n = cross_scan_value(value, type, 0, 0, 1);
 	if (n == NULL) {
@@ -1356,7 +1356,12 @@ init_to_array_size(struct type *ty, struct initializer *init) {
 	struct tyval		*tv;
 
 	for (in = init; in; in = in->next) {
-		++nelem;
+		if (in->type == INIT_BYTES) {
+			/* 10/17/26: Byte image of many elements */
+			nelem += ((struct init_bytes *)in->data)->nelem;
+		} else {
+			++nelem;
+		}
 	}	
 	tv = n_xmalloc(sizeof *tv);
 	tv->str = NULL;
@@ -154,6 +154,8 @@ struct ty_string {
 	int			is_wide_char;
 	struct type		*ty;
 	struct ty_string	*next;
+	unsigned		hash; /* 10/17/26: For str_const lookup */
+	struct ty_string	*hash_next;
 };
 
 struct num;
@@ -3265,13 +3265,30 @@ cross_scan_value(const char *str, int type,
 	
 	char			fmt[8];
 	size_t			nbytes;
-	struct num		*ret = n_xmalloc(sizeof *ret);
+	struct num		*ret;
 
 	nbytes = 16; /* XXX */
 	get_fmt(fmt, type, 1, fp_flag, octal_flag, hexa_flag);
 
+#ifndef PREPROCESSOR
+	if (!fp_flag) {
+		/*
+		 * 10/17/26: Integer constants are only read by the lexer,
+		 * which just takes the value and type, so only the value
+		 * (which the constant expression evaluator may free) is
+		 * allocated
+		 */
+		static struct num	intnum;
+
+		ret = &intnum;
+		ret->value = n_xmalloc(nbytes);
+	} else
+#endif
+	{
+		ret = n_xmalloc(sizeof *ret);
+		ret->value = n_xmalloc(nbytes);
+	}
 	ret->type = type;
-	ret->value = n_xmalloc(nbytes);
 
 	if (sscanf(str, fmt, ret->value) != 1) {
 		return NULL;
@@ -3295,12 +3312,109 @@ cross_scan_value(const char *str, int type,
 
 #ifndef PREPROCESSOR
 
+#if XLATE_IMMEDIATELY
+
+/*
+ * 10/17/26: Floating point constants are pooled per translation unit,
+ * such that every use of e.g. 1.5 shares the same _Float label. This
+ * is only possible if constants are emitted immediately, since the
+ * list entry of a shared constant may be removed from float_const on
+ * behalf of one user while it is still referenced by another. The key
+ * is saved separately because constant expression evaluation may
+ * change the value of a constant in place
+ */
+#define FP_POOL_SIZE	1024	/* must be power of 2 */
+
+struct fp_pool_entry {
+	int			type;
+	unsigned char		bytes[16];
+	struct ty_float		*fc;
+	struct fp_pool_entry	*next;
+};
+
+static struct fp_pool_entry	*fp_pool[FP_POOL_SIZE];
+
+static int
+fp_pool_key_size(int type) {
+	if (type == TY_LDOUBLE
+		&& (backend->arch == ARCH_X86 || backend->arch == ARCH_AMD64)) {
+		/* Padding bytes of the 80bit format are unspecified */
+		return 10;
+	}
+	return backend->get_sizeof_type(make_basic_type(type), NULL);
+}
+
+static struct ty_float *
+lookup_fp_pool(struct num *n, int *keyp) {
+	struct fp_pool_entry	*ent;
+	int			size = fp_pool_key_size(n->type);
+	unsigned		hash = 0;
+	int			key;
+	int			i;
+
+	if (size > (int)sizeof ent->bytes) {
+		*keyp = -1;
+		return NULL;
+	}
+	for (i = 0; i < size; ++i) {
+		hash = 33 * hash + ((unsigned char *)n->value)[i];
+	}
+	*keyp = key = (int)((hash + n->type) & (FP_POOL_SIZE - 1));
+	for (ent = fp_pool[key]; ent != NULL; ent = ent->next) {
+		if (ent->type == n->type
+			&& memcmp(ent->bytes, n->value, size) == 0) {
+			return ent->fc;
+		}
+	}
+	return NULL;
+}
+
+static void
+put_fp_pool(int key, struct ty_float *fc) {
+	struct fp_pool_entry	*ent;
+
+	if (key == -1) {
+		return;
+	}
+	ent = n_xmalloc(sizeof *ent);
+	ent->type = fc->num->type;
+	memcpy(ent->bytes, fc->num->value, fp_pool_key_size(ent->type));
+	ent->fc = fc;
+	ent->next = fp_pool[key];
+	fp_pool[key] = ent;
+}
+
+#endif /* #if XLATE_IMMEDIATELY */
+
 struct ty_float *
 put_float_const_list(struct num *ret) {
 	/*if (backend->need_floatconst  ) {*/
 		struct ty_float		*fc;
 		static struct ty_float	null;
 		static unsigned long	count;
+#if XLATE_IMMEDIATELY
+		int			key;
+
+		if ((fc = lookup_fp_pool(ret, &key)) != NULL) {
+			/*
+			 * Already emitted. Callers expect the constant
+			 * at the head of the list, so move it there
+			 */
+			if (fc != float_const) {
+				if (!fc->inactive) {
+					remove_float_const_from_list(fc);
+				}
+				fc->prev = NULL;
+				fc->next = float_const;
+				if (float_const != NULL) {
+					float_const->prev = fc;
+				}
+				float_const = fc;
+			}
+			fc->inactive = 0;
+			return fc;
+		}
+#endif
 
 		fc = n_xmalloc(sizeof *fc);
 		*fc = null;
@@ -3308,6 +3422,7 @@ put_float_const_list(struct num *ret) {
 		fc->num = ret;
 
 #if XLATE_IMMEDIATELY
+		put_fp_pool(key, fc);
 		fc->next = NULL;
 		emit->fp_constants(fc);
 #endif
@@ -3793,6 +3908,35 @@ cross_to_type_from_host_long_long(void *value, int type, long long src) {
 	}
 }
 
+/*
+ * 10/17/26: Stores the integral value ``src'' as target type ``type'' at
+ * ``dest'', in target byte order. This is used for byte images of
+ * initializers. Returns the size of the type
+ */
+int
+cross_put_target_bytes(unsigned char *dest, int type, unsigned long long src) {
+	struct type_mapping	*mapping;
+	int			bytes;
+	int			i;
+
+	mapping = type_map[ type_to_index(type) ];
+	if (mapping == NULL) {
+		unimpl();
+	}
+	bytes = mapping->properties.bytes;
+	for (i = 0; i < bytes; ++i) {
+		unsigned char	uc = (unsigned char)(src & 0xff);
+
+		if (target_info->arch_info->endianness == ENDIAN_LITTLE) {
+			dest[i] = uc;
+		} else {
+			dest[bytes - i - 1] = uc;
+		}
+		src >>= 8;
+	}
+	return bytes;
+}
+
 struct type *
 cross_get_nearest_integer_type(int bytes, int base_bytes, int is_signed) {
 	struct type_mapping	*mapping;
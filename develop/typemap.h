@@ -91,6 +91,8 @@ void	cross_from_host_long(void *dest, long val, int type);
 
 /* 04/13/08: To target value from host long long */
 void	cross_to_type_from_host_long_long(void *value, int type, long long src);
+int	cross_put_target_bytes(unsigned char *dest, int type,
+	unsigned long long src);
 
 void	cross_conv_host_to_target(void *src, int destty, int srcty);
 void	cross_conv_value_to_target_size_t(void *buf, unsigned long value);
@@ -708,7 +708,13 @@ static FILE *find_file(char *name, int localdir)
 			ff = HTT_get(&found_files, s);
 		} else ff = HTT_get(&found_files, name);
 	}
-	if (!ff) {
+	/*
+	 * 10/17/26 (nwcc): The system include cache is only consulted
+	 * after the file has not been found in the current directory, or
+	 * e.g. a local "features.h" would be taken for a <features.h>
+	 * included by a system header before
+	 */
+	if (!ff && !localdir) {
 		struct found_file_sys *ffs = HTT_get(&found_files_sys, name);
 
 		if (ffs) {
@@ -747,6 +753,18 @@ static FILE *find_file(char *name, int localdir)
 		freemem(s);
 		s = 0;
 	}
+	if (localdir) {
+		struct found_file_sys *ffs = HTT_get(&found_files_sys, name);
+
+		if (ffs) {
+			ff = ffs->rff;
+			incdir = ffs->incdir;
+			del_found_file(protect_detect.ff);
+			protect_detect.ff = 0;
+			nffa = 0;
+			goto found_file_cache;
+		}
+	}
 	for (i = 0; (size_t)i < include_path_nb; i ++) {
 		size_t ni = strlen(include_path[i]);
 
@@ -1437,7 +1455,8 @@ do_include_next:
 /*
  * for #line directives
  */
-static int handle_line(struct lexer_state *ls, unsigned long flags)
+static int handle_line(struct lexer_state *ls, unsigned long flags,
+	struct ucpp_token *marker)
 {
 	char *fname;
 	long l = ls->line;
@@ -1446,6 +1465,19 @@ static int handle_line(struct lexer_state *ls, unsigned long flags)
 	unsigned long z;
 
 	tf.art = tf.nt = 0;
+	if (marker) {
+		/*
+		 * 10/17/26 (nwcc): The line number of a GNU line marker
+		 * has already been read
+		 */
+		struct ucpp_token t;
+
+		t.type = marker->type;
+		t.line = l;
+		t.name = sdup(marker->name);
+		throw_away(ls->gf, t.name);
+		aol(tf.t, tf.nt, t, TOKEN_LIST_MEMG);
+	}
 	while (!next_token(ls) && ls->ctok->type != NEWLINE) {
 		if (!ttMWS(ls->ctok->type)) {
 			struct ucpp_token t;
@@ -1532,7 +1564,8 @@ static int handle_line(struct lexer_state *ls, unsigned long flags)
 			current_filename = fname;
 		}
 		for (i ++; i < tf2.nt && ttMWS(tf2.t[i].type); i ++);
-		if (i < tf2.nt && (ls->flags & WARN_STANDARD)) {
+		/* GNU line markers are followed by flags */
+		if (i < tf2.nt && !marker && (ls->flags & WARN_STANDARD)) {
 			warning(l, "trailing garbage in #line");
 		}
 	}
@@ -1721,6 +1754,15 @@ static int handle_cpp(struct lexer_state *ls, int sharp_type)
 			goto handle_exit2;
 		case NAME:
 			break;
+		case NUMBER:
+			/*
+			 * 10/17/26 (nwcc): Accept GNU line markers, as in
+			 * preprocessor output (# 20 "/usr/include/stdio.h" 3),
+			 * like gcc does
+			 */
+			if (!ls->condcomp) goto handle_warp_ign;
+			ret = handle_line(ls, save_flags, ls->ctok);
+			goto handle_exit;
 		default:
 			if (ls->flags & FAIL_SHARP) {
                                 /* LPS 20050602 - ignores '#!' if on the first line */
@@ -1882,7 +1924,7 @@ static int handle_cpp(struct lexer_state *ls, int sharp_type)
 				handle_error(ls);
 				goto handle_exit;
 			} else if (!strcmp(ls->ctok->name, "line")) {
-				ret = handle_line(ls, save_flags);
+				ret = handle_line(ls, save_flags, 0);
 				goto handle_exit;
 			} else if ((ls->flags & HANDLE_ASSERTIONS)
 				&& !strcmp(ls->ctok->name, "assert")) {
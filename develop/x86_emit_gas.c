@@ -59,7 +59,7 @@ static size_t	bss_segment_offset;
 static size_t	data_thread_segment_offset;
 static size_t	bss_thread_segment_offset;
 
-void    as_print_string_init(FILE *, size_t howmany, struct ty_string *str);
+void    as_print_ascii_string(FILE *, size_t howmany, struct ty_string *str);
 
 static void
 emit_setsection(int value);
@@ -419,7 +419,7 @@ print_init_expr(struct type *dt, struct expr *ex) {
 
 			cv = ex->const_value;
 			arrsize = dt->tlist->arrarg_const;
-			as_print_string_init(out, arrsize, cv->str);
+			as_print_ascii_string(out, arrsize, cv->str);
 
 			if (arrsize >= cv->str->size) {
 				if (arrsize > cv->str->size) {
@@ -532,6 +532,8 @@ print_init_list(struct decl *dec, struct initializer *init) {
 					continue;
 				}
 			}
+		} else if (init->type == INIT_BYTES) {
+			as_print_init_bytes(out, init->data, 1);
 		} else if (init->type == INIT_NULL) {
 			if (init->varinit && init->left_type->tbit != NULL) {
 #if 0
@@ -1195,31 +1197,28 @@ emit_fp_constants(struct ty_float *list) {
 	if (list != NULL) {
 		struct ty_float	*tf;
 
-		emit_setsection(SECTION_INIT);
 		for (tf = list; tf != NULL; tf = tf->next) {
 			/* XXX cross-compilation */
-			/* XXX VERY mips-like */
-			int	size = 0;
-
+			/*
+			 * 10/17/26: Constants are pooled by
+			 * put_float_const_list() and go to mergeable
+			 * sections by size (long double is padded to
+			 * 16 bytes)
+			 */
 			switch (tf->num->type) {
 			case TY_FLOAT:	
+				emit_setsection(SECTION_RODATA_CST4);
 				x_fprintf(out, "\t.align 4\n");
-				size = 4;
 				break;
 			case TY_DOUBLE:
-			case TY_LDOUBLE:
+				emit_setsection(SECTION_RODATA_CST8);
 				x_fprintf(out, "\t.align 8\n");
-				if (tf->num->type == TY_DOUBLE) {
-					size = 8;
-				} else {
-					size = 10;
-				}
+				break;
+			case TY_LDOUBLE:
+				emit_setsection(SECTION_RODATA_CST16);
+				x_fprintf(out, "\t.align 16\n");
 			}
 
-			if (sysflag != OS_OSX) {
-				x_fprintf(out, "\t.type _Float%lu, @object\n", tf->count);
-				x_fprintf(out, "\t.size _Float%lu, %d\n", tf->count, size);
-			}
 			x_fprintf(out, "_Float%lu:\n", tf->count);
 
 			switch (tf->num->type) {
@@ -1251,6 +1250,8 @@ emit_fp_constants(struct ty_float *list) {
 				cross_print_value_chunk(out,
 					tf->num->value,
 					TY_DOUBLE, TY_UINT, TY_USHORT, 2);
+				x_fprintf(out, sysflag == OS_OSX?
+					"\n\t.space 6": "\n\t.zero 6");
 				break;
 			default:
 				printf("bad floating point constant - "
@@ -1318,10 +1319,21 @@ emit_strings(struct ty_string *list) {
 	if (list != NULL) {
 		struct ty_string	*str;
 
-		emit_setsection(SECTION_RODATA);
 		for (str = list; str != NULL; str = str->next) {
+			/*
+			 * 10/17/26: Strings go to a mergeable section
+			 * unless they contain a null character, which
+			 * would make the linker split them up, or wide
+			 * characters
+			 */
+			if (str->is_wide_char
+				|| memchr(str->str, 0, str->size - 1) != NULL) {
+				emit_setsection(SECTION_RODATA);
+			} else {
+				emit_setsection(SECTION_RODATA_STR);
+			}
 			x_fprintf(out, "._Str%lu:\n", str->count);
-			as_print_string_init(out, str->size, str);
+			as_print_ascii_string(out, str->size, str);
 		}
 	}
 
@@ -1336,19 +1348,13 @@ emit_strings(struct ty_string *list) {
 
 static void
 emit_comment(const char *fmt, ...) {
-	int		rc;
 	va_list	va;
 
 	va_start(va, fmt);
 	x_fprintf(out, "# ");
-	rc = vfprintf(out, fmt, va);
+	x_vfprintf(out, fmt, va);
 	va_end(va);
 	x_fputc('\n', out);
-
-	if (rc == EOF || fflush(out) == EOF) {
-		perror("vfprintf");
-		exit(EXIT_FAILURE);
-	}
 }
 
 static void
@@ -1585,7 +1591,10 @@ static void
 emit_freestack(struct function *f, size_t *nbytes) {
 	if (nbytes == NULL) {
 		/* Procedure outro */
-		if (f->total_allocated != 0) {
+		if (f->alloca_head != NULL || f->vla_head != NULL) {
+			/* 10/17/26: Also drops alloca() and VLA storage */
+			x_fprintf(out, "\tmovl %%ebp, %%esp\n");
+		} else if (f->total_allocated != 0) {
 			x_fprintf(out, "\taddl $%lu, %%esp\n",
 				(unsigned long)f->total_allocated);
 		}	
@@ -1622,6 +1631,14 @@ emit_setsection(int value) {
 	if (p != NULL) {
 		if (sysflag == OS_OSX) {
 			x_fprintf(out, ".%s\n", p);
+		} else if (value == SECTION_RODATA_STR) {
+			x_fprintf(out, ".section .%s,\"aMS\",@progbits,1\n", p);
+		} else if (value == SECTION_RODATA_CST4
+			|| value == SECTION_RODATA_CST8
+			|| value == SECTION_RODATA_CST16) {
+			x_fprintf(out, ".section .%s,\"aM\",@progbits,%d\n", p,
+				value == SECTION_RODATA_CST4? 4:
+				value == SECTION_RODATA_CST8? 8: 16);
 		} else {
 			x_fprintf(out, ".section .%s\n", p);
 		}
@@ -1647,13 +1664,14 @@ print_mem_or_reg(struct reg *r, struct vreg *vr) {
 		struct decl	*d = vr->var_backed;
 
 		if (d->stack_addr) {
-			x_fprintf(out, "-%ld(%%ebp)",
-				d->stack_addr->offset);
+			print_mem_gas_x86(out, "-", d->stack_addr->offset,
+				"ebp");
+			x_fputc(')', out);
 		} else {
-			x_fprintf(out, "%s", d->dtype->name);
+			x_fputs(d->dtype->name, out);
 		}
 	} else if (r != NULL) {	
-		x_fprintf(out, "%%%s", r->name);
+		print_reg_gas_x86(out, r->name);
 	} else if (vr->from_const) {
 		if (backend->arch == ARCH_AMD64) {
 			amd64_print_mem_operand_gas(vr, NULL);
@@ -1748,7 +1766,8 @@ emit_load(struct reg *r, struct vreg *vr) {
 		print_mem_operand(vr, NULL);
 	}
 	if (r->type != REG_FPR || !STUPID_X87(r)) {
-		x_fprintf(out, ", %%%s", r->name);
+		x_fputs(", ", out);
+		print_reg_gas_x86(out, r->name);
 	}	
 
 	x_fputc('\n', out);
@@ -1764,6 +1783,25 @@ emit_comp_goto(struct reg *r) {
 	x_fprintf(out, "\tjmp *%%%s\n", r->name);
 }
 
+static void
+emit_switch_table(struct reg *idx, struct reg *tmp, struct switch_table *tab) {
+	char	*name = tab->label->dat;
+	size_t	i;
+
+	(void) tmp;
+	x_fprintf(out, "\tjmp *.%s(,%%%s,4)\n", name, idx->name);
+
+	if (sysflag != OS_OSX) {
+		emit_setsection(SECTION_RODATA);
+	}
+	x_fprintf(out, "\t.align 4\n");
+	x_fprintf(out, ".%s:\n", name);
+	for (i = 0; i < tab->nentries; ++i) {
+		x_fprintf(out, "\t.long .%s\n", (char *)tab->targets[i]->dat);
+	}
+	emit_setsection(SECTION_TEXT);
+}
+
 
 /*
  * Takes vreg source arg - not preg - so that it can be either a preg
@@ -1893,6 +1931,13 @@ emit_sub(struct reg **dest, struct icode_instr *src) {
 
 static void
 emit_add(struct reg **dest, struct icode_instr *src) {
+	if (src->dat != NULL) {
+		/* 10/17/26: Pointer plus scaled index (see ptrarit()) */
+		x_fprintf(out, "\tlea (%%%s,%%%s,%d), %%%s\n",
+			dest[0]->name, src->src_pregs[0]->name,
+			*(int *)src->dat, dest[0]->name);
+		return;
+	}
 	if (dest[0]->type == REG_FPR) {
 		if (STUPID_X87(dest[0])) {
 			x_fprintf(out, "\tfaddp ");
@@ -1987,6 +2032,9 @@ emit_div(struct reg **dest, struct icode_instr *src, int formod) {
 	struct type	*ty = src->src_vreg->type;
 
 	(void) dest;
+	if (!formod && emit_const_muldiv_gas_x86(out, dest, src, INSTR_DIV)) {
+		return;
+	}
 	if (IS_LLONG(ty->code)) {
 		char	*func;
 
@@ -2041,6 +2089,9 @@ emit_div(struct reg **dest, struct icode_instr *src, int formod) {
 
 static void
 emit_mod(struct reg **dest, struct icode_instr *src) {
+	if (emit_const_muldiv_gas_x86(out, dest, src, INSTR_MOD)) {
+		return;
+	}
 	emit_div(dest, src, 1);
 	if (!IS_LLONG(src->dest_vreg->type->code)) {
 		x_fprintf(out, "\tmov %%edx, %%%s\n", dest[0]->name);
@@ -2054,6 +2105,9 @@ emit_mul(struct reg **dest, struct icode_instr *src) {
 
 	(void) dest;
 
+	if (emit_const_muldiv_gas_x86(out, dest, src, INSTR_MUL)) {
+		return;
+	}
 	if (IS_LLONG(ty->code)) {
 		char	*func;
 
@@ -2297,7 +2351,13 @@ emit_cmp(struct reg **dest, struct icode_instr *src) {
 				reg_idx = 0;
 			}
 		}
-		fprintf(out, "\tcmp ");
+		if (src->hints & HINT_INSTR_GENERIC_MODIFIER) {
+			/* 10/17/26: Set by x86_rule_cmp_zero() at -O1 */
+			x_fprintf(out, "\ttest %%%s, %%%s\n",
+				dest[reg_idx]->name, dest[reg_idx]->name);
+			return;
+		}
+		x_fprintf(out, "\tcmp ");
 	}	
 	if (src->src_pregs == NULL || src->src_vreg == NULL) {
 		x_fprintf(out, "$0");
@@ -2345,7 +2405,7 @@ emit_branch(struct icode_instr *ii) {
 		int	is_sse = 0;
 		
 		if (is_x87_trash(ii->dest_vreg)) {
-			fprintf(out, "\tfucomip %%st(1), %%st(0)\n");
+			x_fprintf(out, "\tfucomip %%st(1), %%st(0)\n");
 		} else {
 			/*
 			 * Since this is fp but not x87, it must be SSE.
@@ -2571,7 +2631,11 @@ emit_mov(struct copyreg *cr) {
 				src->name, dest->name);
 		}	
 	} else if (dest->size == src->size) {
-		x_fprintf(out, "\tmov %%%s, %%%s\n", src->name, dest->name);
+		x_fputs("\tmov ", out);
+		print_reg_gas_x86(out, src->name);
+		x_fputs(", ", out);
+		print_reg_gas_x86(out, dest->name);
+		x_fputc('\n', out);
 	} else if (dest->size > src->size) {
 		print_reg_assign(dest, src, src->size, src_type);
 		/*x_fprintf(out, "%s\n", src->name);*/
@@ -2585,7 +2649,11 @@ emit_mov(struct copyreg *cr) {
 
 static void
 emit_setreg(struct reg *dest, int *value) {
-	x_fprintf(out, "\tmov $%d, %%%s\n", *(int *)value, dest->name);
+	x_fputs("\tmov ", out);
+	print_imm_gas_x86(out, *value);
+	x_fputs(", ", out);
+	print_reg_gas_x86(out, dest->name);
+	x_fputc('\n', out);
 }
 
 static void
@@ -2945,6 +3013,20 @@ get_symbol_value_representation(const char *symname, int is_func) {
  */
 static void
 emit_copyinit(struct decl *d) {
+	size_t	size = backend->get_sizeof_type(d->dtype, NULL);
+
+	if (size <= X86_MAX_UNROLLED_COPY) {
+		/*
+		 * 10/17/26: Copy small initializers inline. The GPRs have
+		 * been invalidated for the memcpy() call anyway
+		 */
+		x_fprintf(out, "\tmovl %s, %%ecx\n",
+			get_symbol_value_representation(d->init_name->name, 0));
+		emit_unrolled_copy_gas_x86(out, "%ebp",
+			-(long)d->stack_addr->offset, "%ecx", 0, size,
+			NULL, "%eax", "%al");
+		return;
+	}
 	if (sysflag == OS_OSX) {
 		/*
 		 * Ensure 16-byte alignment (we pass 12, and need to
@@ -2953,8 +3035,7 @@ emit_copyinit(struct decl *d) {
 		 */
 		x_fprintf(out, "\tsubl $12, %%esp\n");
 	}
-	x_fprintf(out, "\tpushl $%lu\n",
-		(unsigned long)backend->get_sizeof_type(d->dtype, NULL)  /*d->vreg->size*/);
+	x_fprintf(out, "\tpushl $%lu\n", (unsigned long)size);
 
 	/*
 	 * 07/26/12: This was missing support for position independence?!!?
@@ -3082,37 +3163,622 @@ emit_copystruct(struct copystruct *cs) {
 	}
 }
 
+/*
+ * 10/17/26: Operand formatters for the hot emitter paths, which write
+ * directly to the output buffer without printf() format parsing
+ */
+void
+print_reg_gas_x86(FILE *out, const char *name) {
+	x_fputc('%', out);
+	x_fputs(name, out);
+}
+
+void
+print_imm_gas_x86(FILE *out, long value) {
+	x_fputc('$', out);
+	x_fputlong(value, out);
+}
+
+/*
+ * Prints sign offset(%base - the closing parenthesis is left to the
+ * caller, since print_mem_operand() may still have to add an index
+ */
+void
+print_mem_gas_x86(FILE *out, const char *sign, unsigned long offset,
+	const char *base) {
+
+	x_fputs(sign, out);
+	x_fputulong(offset, out);
+	x_fputs("(%", out);
+	x_fputs(base, out);
+}
+
+/*
+ * 10/17/26: Emits a copy of a constant number of bytes from srcoff(src)
+ * to destoff(dest) as a sequence of moves. If src is NULL, the
+ * destination is filled instead, using the byte pattern which the
+ * caller has put into xmm, word and byte (or immediate zeros).
+ *
+ * With an SSE register 16 byte moves are used, otherwise 4 byte moves
+ * through word. The remaining bytes are handled by one more move which
+ * overlaps the previous one, so only copies of less than 4 bytes go
+ * through byte
+ */
+void
+emit_unrolled_copy_gas_x86(FILE *out, const char *dest, long destoff,
+	const char *src, long srcoff, unsigned long nbytes,
+	const char *xmm, const char *word, const char *byte) {
+
+	unsigned long	chunk;
+	unsigned long	i;
+	const char	*mov;
+	const char	*reg;
+
+	if (nbytes >= 16 && xmm != NULL) {
+		chunk = 16;
+		mov = "movdqu";
+		reg = xmm;
+	} else if (nbytes >= 8 && xmm != NULL) {
+		chunk = 8;
+		mov = "movq";
+		reg = xmm;
+	} else if (nbytes >= 4) {
+		chunk = 4;
+		mov = xmm != NULL? "movd": "movl";
+		reg = xmm != NULL? xmm: word;
+	} else {
+		chunk = 1;
+		mov = "movb";
+		reg = byte;
+	}
+
+	for (i = 0; i < nbytes; i += chunk) {
+		if (i + chunk > nbytes) {
+			i = nbytes - chunk;
+		}
+		if (src != NULL) {
+			x_fprintf(out, "\t%s %ld(%s), %s\n",
+				mov, srcoff + (long)i, src, reg);
+		}
+		x_fprintf(out, "\t%s %s, %ld(%s)\n",
+			mov, reg, destoff + (long)i, dest);
+	}
+}
+
+/*
+ * 10/17/26: Magic numbers for division by a constant through
+ * multiplication, as in Hacker's Delight (chapter 10). All arithmetic
+ * is done modulo 2^w
+ */
+static void
+magic_signed(long long d, int w, unsigned long long *m, int *s) {
+	unsigned long long	mask = w == 64? ~0ULL: (1ULL << w) - 1;
+	unsigned long long	two = 1ULL << (w - 1);
+	unsigned long long	ad, anc, t, q1, r1, q2, r2, delta;
+	int			p = w - 1;
+
+	ad = d < 0? -(unsigned long long)d: (unsigned long long)d;
+	t = two + (d < 0);
+	anc = t - 1 - t % ad;
+	q1 = two / anc;
+	r1 = two - q1 * anc;
+	q2 = two / ad;
+	r2 = two - q2 * ad;
+	do {
+		++p;
+		q1 = (q1 << 1) & mask;
+		r1 = (r1 << 1) & mask;
+		if (r1 >= anc) {
+			++q1;
+			r1 -= anc;
+		}
+		q2 = (q2 << 1) & mask;
+		r2 = (r2 << 1) & mask;
+		if (r2 >= ad) {
+			++q2;
+			r2 -= ad;
+		}
+		delta = ad - r2;
+	} while (q1 < delta || (q1 == delta && r1 == 0));
+	*m = (q2 + 1) & mask;
+	if (d < 0) {
+		*m = -*m & mask;
+	}
+	*s = p - w;
+}
+
+static void
+magic_unsigned(unsigned long long d, int w,
+	unsigned long long *m, int *add, int *s) {
+
+	unsigned long long	mask = w == 64? ~0ULL: (1ULL << w) - 1;
+	unsigned long long	two = 1ULL << (w - 1);
+	unsigned long long	nc, q1, r1, q2, r2, delta;
+	int			p = w - 1;
+
+	*add = 0;
+	nc = mask - (-d & mask) % d;
+	q1 = two / nc;
+	r1 = two - q1 * nc;
+	q2 = (two - 1) / d;
+	r2 = (two - 1) - q2 * d;
+	do {
+		++p;
+		if (r1 >= nc - r1) {
+			q1 = ((q1 << 1) + 1) & mask;
+			r1 = ((r1 << 1) - nc) & mask;
+		} else {
+			q1 = (q1 << 1) & mask;
+			r1 = (r1 << 1) & mask;
+		}
+		if (r2 + 1 >= d - r2) {
+			if (q2 >= two - 1) {
+				*add = 1;
+			}
+			q2 = ((q2 << 1) + 1) & mask;
+			r2 = ((r2 << 1) + 1 - d) & mask;
+		} else {
+			if (q2 >= two) {
+				*add = 1;
+			}
+			q2 = (q2 << 1) & mask;
+			r2 = ((r2 << 1) + 1) & mask;
+		}
+		delta = d - 1 - r2;
+	} while (p < 2 * w && (q1 < delta || (q1 == delta && r1 == 0)));
+	*m = (q2 + 1) & mask;
+	*s = p - w;
+}
+
+static int
+log2_exact(unsigned long long val) {
+	int	i;
+
+	for (i = 0; i < 64; ++i) {
+		if (val == (1ULL << i)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*
+ * 10/17/26: Checks whether emit_const_muldiv_gas_x86() can handle the
+ * multiplication, division or remainder (op is INSTR_MUL, INSTR_DIV or
+ * INSTR_MOD) of a size byte value by the constant vr, and stores the
+ * value of the constant in *val. Returns -1 if it cannot, 1 if it needs
+ * a scratch register and 0 if it does not
+ */
+int
+check_const_muldiv_gas_x86(struct vreg *vr, int size, int op,
+	long long *val) {
+
+	struct token		*tok = vr->from_const;
+	struct tyval		tv;
+	unsigned long long	mask;
+	unsigned long long	m;
+	unsigned long long	f;
+	int			w = size * 8;
+	int			n = 0;
+
+	if (tok == NULL
+		|| vr->is_multi_reg_obj
+		|| vr->type->tlist != NULL
+		|| !is_integral_type(vr->type)
+		|| tok->data2 != NULL
+		|| !(IS_INT(tok->type) || IS_LONG(tok->type)
+			|| IS_LLONG(tok->type))
+		|| (size != 4 && size != 8)) {
+		return -1;
+	}
+	mask = w == 64? ~0ULL: (1ULL << w) - 1;
+
+	memset(&tv, 0, sizeof tv);
+	tv.type = make_basic_type(tok->type);
+	tv.value = tok->data;
+	if (tv.type->sign == TOK_KEY_UNSIGNED) {
+		m = cross_to_host_unsigned_long_long(&tv) & mask;
+	} else {
+		m = (unsigned long long)cross_to_host_long_long(&tv) & mask;
+	}
+	if (m & (1ULL << (w - 1))) {
+		/* Negative as signed w-bit value */
+		if (vr->type->sign == TOK_KEY_UNSIGNED && op != INSTR_MUL) {
+			return -1;
+		}
+		*val = -(long long)((-m) & mask);
+	} else {
+		*val = (long long)m;
+	}
+	if (*val < -0x7fffffffLL || *val > 0x7fffffffLL) {
+		return -1;
+	}
+
+	if (op == INSTR_MUL) {
+		if (*val >= -1 && *val <= 1) {
+			return 0;
+		}
+		for (f = *val < 0? -*val: *val; (f & 1) == 0; f >>= 1) {
+			;
+		}
+		for (; f % 9 == 0; f /= 9) {
+			++n;
+		}
+		for (; f % 5 == 0; f /= 5) {
+			++n;
+		}
+		for (; f % 3 == 0; f /= 3) {
+			++n;
+		}
+		if (f == 1 && n <= 2) {
+			/* lea and shifts only */
+			return 0;
+		}
+		for (f = *val < 0? -*val: *val; (f & 1) == 0; f >>= 1) {
+			;
+		}
+		if (log2_exact(f - 1) > 0 || log2_exact(f + 1) > 0) {
+			return 1;
+		}
+		return -1;
+	}
+
+	if (*val >= -1 && *val <= 1) {
+		return -1;
+	}
+	if (vr->type->sign == TOK_KEY_UNSIGNED && log2_exact(*val) > 0) {
+		return 0;
+	}
+	return 1;
+}
+
+/*
+ * 10/17/26: Emits a multiplication, division or remainder (op is
+ * INSTR_MUL, INSTR_DIV or INSTR_MOD) of eax/rax by a constant operand
+ * without mul/div instructions where possible. icode_prepare_op() has
+ * put the dividend into eax/rax and has saved edx/rdx. The constant is
+ * not loaded; if check_const_muldiv_gas_x86() asks for a scratch
+ * register, icode_prepare_op() has mapped one to the constant instead.
+ * Returns 0 if the caller has to emit the ordinary instruction
+ */
+int
+emit_const_muldiv_gas_x86(FILE *out, struct reg **dest,
+	struct icode_instr *src, int op) {
+
+	struct vreg		*vr = src->src_vreg;
+	struct reg		*tmp = src->src_pregs? src->src_pregs[0]: NULL;
+	const char		*a = dest[0]->name;
+	const char		*d;
+	const char		*t;
+	const char		*q;
+	unsigned long long	mask;
+	unsigned long long	m;
+	long long		val;
+	int			w;
+	int			is_signed;
+	int			add = 0;
+	int			s;
+	int			k;
+
+	if ((strcmp(a, "eax") != 0 && strcmp(a, "rax") != 0)
+		|| (k = check_const_muldiv_gas_x86(vr, dest[0]->size, op,
+			&val)) == -1
+		|| (k == 1 && (tmp == NULL || tmp->size != dest[0]->size))) {
+		return 0;
+	}
+	w = dest[0]->size * 8;
+	mask = w == 64? ~0ULL: (1ULL << w) - 1;
+	d = w == 64? "rdx": "edx";
+	t = k == 1? tmp->name: NULL;
+	is_signed = vr->type->sign != TOK_KEY_UNSIGNED;
+
+	if (op == INSTR_MUL) {
+		unsigned long long	f;
+		const char		*base = a;
+		int			n3 = 0, n5 = 0, n9 = 0;
+		int			j;
+
+		if (backend->arch == ARCH_AMD64) {
+			/* Addresses are always 64bit */
+			base = "rax";
+		}
+
+		if (val == 0) {
+			x_fprintf(out, "\tmov $0, %%%s\n", a);
+			return 1;
+		} else if (val == 1) {
+			return 1;
+		} else if (val == -1) {
+			x_fprintf(out, "\tneg %%%s\n", a);
+			return 1;
+		}
+		f = val < 0? -val: val;
+		for (k = 0; (f & 1) == 0; ++k) {
+			f >>= 1;
+		}
+		for (; f % 9 == 0; f /= 9) {
+			++n9;
+		}
+		for (; f % 5 == 0; f /= 5) {
+			++n5;
+		}
+		for (; f % 3 == 0; f /= 3) {
+			++n3;
+		}
+		if (f == 1 && n3 + n5 + n9 <= 2) {
+			for (; n9 > 0; --n9) {
+				x_fprintf(out, "\tlea (%%%s,%%%s,8), %%%s\n",
+					base, base, a);
+			}
+			for (; n5 > 0; --n5) {
+				x_fprintf(out, "\tlea (%%%s,%%%s,4), %%%s\n",
+					base, base, a);
+			}
+			for (; n3 > 0; --n3) {
+				x_fprintf(out, "\tlea (%%%s,%%%s,2), %%%s\n",
+					base, base, a);
+			}
+		} else {
+			f = (val < 0? -val: val) >> k;
+			if ((j = log2_exact(f - 1)) > 0) {
+				x_fprintf(out, "\tmov %%%s, %%%s\n", a, t);
+				x_fprintf(out, "\tshl $%d, %%%s\n", j, a);
+				x_fprintf(out, "\tadd %%%s, %%%s\n", t, a);
+			} else if ((j = log2_exact(f + 1)) > 0) {
+				x_fprintf(out, "\tmov %%%s, %%%s\n", a, t);
+				x_fprintf(out, "\tshl $%d, %%%s\n", j, a);
+				x_fprintf(out, "\tsub %%%s, %%%s\n", t, a);
+			} else {
+				return 0;
+			}
+		}
+		if (k > 0) {
+			x_fprintf(out, "\tshl $%d, %%%s\n", k, a);
+		}
+		if (val < 0) {
+			x_fprintf(out, "\tneg %%%s\n", a);
+		}
+		return 1;
+	}
+
+	if (!is_signed && (k = log2_exact(val)) > 0) {
+		if (op == INSTR_DIV) {
+			x_fprintf(out, "\tshr $%d, %%%s\n", k, a);
+		} else {
+			x_fprintf(out, "\tand $%lld, %%%s\n", val - 1, a);
+		}
+		return 1;
+	}
+
+	/* Quotient goes to q, dividend is kept in t */
+	x_fprintf(out, "\tmov %%%s, %%%s\n", a, t);
+	if (is_signed) {
+		magic_signed(val, w, &m, &s);
+	} else {
+		magic_unsigned(val, w, &m, &add, &s);
+	}
+	if (m & (1ULL << (w - 1))) {
+		/* Print as negative number */
+		x_fprintf(out, "\tmov%s $%lld, %%%s\n",
+			w == 64? "abs": "",
+			-(long long)((-m) & mask), d);
+	} else {
+		x_fprintf(out, "\tmov%s $%lld, %%%s\n",
+			w == 64? "abs": "", (long long)m, d);
+	}
+	if (is_signed) {
+		x_fprintf(out, "\timul %%%s\n", d);
+		if (val > 0 && (m & (1ULL << (w - 1)))) {
+			x_fprintf(out, "\tadd %%%s, %%%s\n", t, d);
+		} else if (val < 0 && !(m & (1ULL << (w - 1)))) {
+			x_fprintf(out, "\tsub %%%s, %%%s\n", t, d);
+		}
+		if (s > 0) {
+			x_fprintf(out, "\tsar $%d, %%%s\n", s, d);
+		}
+		x_fprintf(out, "\tmov %%%s, %%%s\n", d, a);
+		x_fprintf(out, "\tshr $%d, %%%s\n", w - 1, a);
+		x_fprintf(out, "\tadd %%%s, %%%s\n", a, d);
+		q = d;
+	} else {
+		x_fprintf(out, "\tmul %%%s\n", d);
+		if (add) {
+			/* Magic number needs w+1 bits */
+			x_fprintf(out, "\tmov %%%s, %%%s\n", t, a);
+			x_fprintf(out, "\tsub %%%s, %%%s\n", d, a);
+			x_fprintf(out, "\tshr $1, %%%s\n", a);
+			x_fprintf(out, "\tadd %%%s, %%%s\n", d, a);
+			if (s > 1) {
+				x_fprintf(out, "\tshr $%d, %%%s\n", s - 1, a);
+			}
+			q = a;
+		} else {
+			if (s > 0) {
+				x_fprintf(out, "\tshr $%d, %%%s\n", s, d);
+			}
+			q = d;
+		}
+	}
+	if (op == INSTR_DIV) {
+		if (q != a) {
+			x_fprintf(out, "\tmov %%%s, %%%s\n", q, a);
+		}
+	} else {
+		x_fprintf(out, "\timul $%lld, %%%s, %%%s\n", val, q, q);
+		x_fprintf(out, "\tsub %%%s, %%%s\n", q, t);
+		x_fprintf(out, "\tmov %%%s, %%%s\n", t, a);
+	}
+	return 1;
+}
+
+/*
+ * 10/17/26: Copies or fills an unknown number of bytes using rep movs
+ * or rep stos, a word at a time followed by the remaining bytes. The
+ * string instructions need fixed registers, so those are saved, and
+ * the operands are passed to them through the stack because they may
+ * live in any of them
+ */
+static void
+emit_string_memcpy(struct int_memcpy_data *data) {
+	int		is_amd64 = backend->arch == ARCH_AMD64;
+	int		wordsize = is_amd64? 8: 4;
+	const char	*di = is_amd64? "rdi": "edi";
+	const char	*si = is_amd64? "rsi": "esi";
+	const char	*ax = is_amd64? "rax": "eax";
+	const char	*cx = is_amd64? "rcx": "ecx";
+	const char	*sp = is_amd64? "rsp": "esp";
+	const char	*sreg = data->type == BUILTIN_MEMCPY? si: ax;
+
+	x_fprintf(out, "\tpush %%%s\n", di);
+	x_fprintf(out, "\tpush %%%s\n", sreg);
+	x_fprintf(out, "\tpush %%%s\n", cx);
+	x_fprintf(out, "\tsub $%d, %%%s\n", 3 * wordsize, sp);
+	x_fprintf(out, "\tmov %%%s, (%%%s)\n", data->dest_addr->name, sp);
+	x_fprintf(out, "\tmov %%%s, %d(%%%s)\n",
+		data->src_addr->name, wordsize, sp);
+	x_fprintf(out, "\tmov %%%s, %d(%%%s)\n",
+		data->nbytes->name, 2 * wordsize, sp);
+
+	x_fprintf(out, "\tmov (%%%s), %%%s\n", sp, di);
+	if (data->type == BUILTIN_MEMCPY) {
+		x_fprintf(out, "\tmov %d(%%%s), %%%s\n", wordsize, sp, si);
+	} else {
+		/* Replicate fill byte across the word */
+		x_fprintf(out, "\tmovzbl %d(%%%s), %%eax\n", wordsize, sp);
+		if (is_amd64) {
+			x_fprintf(out, "\tmov $0x0101010101010101, %%rcx\n");
+			x_fprintf(out, "\timul %%rcx, %%rax\n");
+		} else {
+			x_fprintf(out, "\timul $0x01010101, %%eax, %%eax\n");
+		}
+	}
+	if (data->nbytes->size == (size_t)wordsize) {
+		x_fprintf(out, "\tmov %d(%%%s), %%%s\n", 2 * wordsize, sp, cx);
+	} else if (data->nbytes->size == 4) {
+		/* Zero-extends into rcx */
+		x_fprintf(out, "\tmov %d(%%%s), %%ecx\n", 2 * wordsize, sp);
+	} else {
+		x_fprintf(out, "\tmovz%cl %d(%%%s), %%ecx\n",
+			data->nbytes->size == 2? 'w': 'b', 2 * wordsize, sp);
+	}
+	x_fprintf(out, "\tadd $%d, %%%s\n", 3 * wordsize, sp);
+
+	x_fprintf(out, "\tpush %%%s\n", cx);
+	x_fprintf(out, "\tshr $%d, %%%s\n", is_amd64? 3: 2, cx);
+	x_fprintf(out, "\trep %s%c\n",
+		data->type == BUILTIN_MEMCPY? "movs": "stos",
+		is_amd64? 'q': 'l');
+	x_fprintf(out, "\tpop %%%s\n", cx);
+	x_fprintf(out, "\tand $%d, %%%s\n", wordsize - 1, cx);
+	x_fprintf(out, "\trep %sb\n",
+		data->type == BUILTIN_MEMCPY? "movs": "stos");
+
+	x_fprintf(out, "\tpop %%%s\n", cx);
+	x_fprintf(out, "\tpop %%%s\n", sreg);
+	x_fprintf(out, "\tpop %%%s\n", di);
+}
+
+/*
+ * 10/17/26: This used to copy one byte per loop iteration. Now constant
+ * sizes are unrolled into word (or on AMD64, 16 byte SSE) moves, and
+ * everything else uses the string instructions
+ */
 static void
 emit_intrinsic_memcpy(struct int_memcpy_data *data) {
 	struct reg	*dest = data->dest_addr;
 	struct reg	*src = data->src_addr;
-	struct reg	*nbytes = data->nbytes;
 	struct reg	*temp = data->temp_reg;
-	static int	labelcount;
-	
-	if (data->type == BUILTIN_MEMSET && src != temp) {
-		x_fprintf(out, "\tmov %%%s, %%%s\n", src->name, temp->name);
-	}
-	x_fprintf(out, "\tcmp $0, %%%s\n", nbytes->name);
-	x_fprintf(out, "\tje .Memcpy_done%d\n", labelcount);
-	x_fprintf(out, ".Memcpy_start%d:\n", labelcount);
-	if (data->type == BUILTIN_MEMCPY) {
-		x_fprintf(out, "\tmov (%%%s), %%%s\n", src->name, temp->name);
+	size_t		nbytes = data->const_nbytes;
+	int		is_memset = data->type == BUILTIN_MEMSET;
+	char		destname[16];
+	char		srcname[16];
+	char		xmmname[16];
+	char		wordname[16];
+	char		bytename[16];
+	struct reg	*word;
+	int		i;
+
+	if (!data->has_const_nbytes) {
+		emit_string_memcpy(data);
+		return;
 	}
-	x_fprintf(out, "\tmov %%%s, (%%%s)\n", temp->name, dest->name);
-	x_fprintf(out, "\tinc %%%s\n", dest->name);
-	if (data->type == BUILTIN_MEMCPY) {
-		x_fprintf(out, "\tinc %%%s\n", src->name);
+
+	sprintf(destname, "%%%s", dest->name);
+	sprintf(srcname, "%%%s", src->name);
+	if (nbytes < 4) {
+		/* Bytewise, through the temp register or the fill byte */
+		sprintf(bytename, "%%%s", is_memset? src->name: temp->name);
+		emit_unrolled_copy_gas_x86(out, destname, 0,
+			is_memset? NULL: srcname, 0, nbytes,
+			NULL, NULL, bytename);
+	} else if (backend->arch == ARCH_AMD64) {
+		if (data->fpr_temp == NULL
+			|| nbytes > AMD64_MAX_UNROLLED_COPY) {
+			emit_string_memcpy(data);
+			return;
+		}
+		sprintf(xmmname, "%%%s", data->fpr_temp->name);
+		if (is_memset) {
+			/*
+			 * The whole register containing the temp byte
+			 * register is ours, since ah & co are never
+			 * allocated on AMD64
+			 */
+			word = find_top_reg(temp)->composed_of[0];
+			x_fprintf(out, "\tmovzbl %s, %%%s\n",
+				srcname, word->name);
+			x_fprintf(out, "\timul $0x01010101, %%%s, %%%s\n",
+				word->name, word->name);
+			x_fprintf(out, "\tmovd %%%s, %s\n", word->name, xmmname);
+			x_fprintf(out, "\tpunpckldq %s, %s\n", xmmname, xmmname);
+			x_fprintf(out, "\tpunpcklqdq %s, %s\n", xmmname, xmmname);
+		}
+		emit_unrolled_copy_gas_x86(out, destname, 0,
+			is_memset? NULL: srcname, 0, nbytes,
+			xmmname, NULL, NULL);
+	} else {
+		if (nbytes > X86_MAX_UNROLLED_COPY) {
+			emit_string_memcpy(data);
+			return;
+		}
+
+		/*
+		 * Save any register not involved in the copy; the temp
+		 * byte register may share its word register with an
+		 * unrelated value (al and ah)
+		 */
+		word = NULL;
+		for (i = 0; i < 6; ++i) {
+			word = &x86_gprs[i];
+			if (!is_member_of_reg(word, dest)
+				&& !is_member_of_reg(word, src)
+				&& !is_member_of_reg(word, data->nbytes)
+				&& !is_member_of_reg(word, temp)) {
+				break;
+			}
+		}
+		sprintf(wordname, "%%%s", word->name);
+		x_fprintf(out, "\tpush %s\n", wordname);
+		if (is_memset) {
+			x_fprintf(out, "\tmovzbl %s, %s\n", srcname, wordname);
+			x_fprintf(out, "\timul $0x01010101, %s, %s\n",
+				wordname, wordname);
+		}
+		emit_unrolled_copy_gas_x86(out, destname, 0,
+			is_memset? NULL: srcname, 0, nbytes,
+			NULL, wordname, NULL);
+		x_fprintf(out, "\tpop %s\n", wordname);
 	}
-	x_fprintf(out, "\tdec %%%s\n", nbytes->name);
-	x_fprintf(out, "\tcmp $0, %%%s\n", nbytes->name);
-	x_fprintf(out, "\tjne .Memcpy_start%d\n", labelcount);
-	x_fprintf(out, ".Memcpy_done%d:\n", labelcount);
-	++labelcount;
 }
 
 static void
 emit_zerostack(struct stack_block *sb, size_t nbytes) {
+	if (nbytes <= X86_MAX_UNROLLED_COPY) {
+		/* 10/17/26: Store zeros directly */
+		emit_unrolled_copy_gas_x86(out, "%ebp", -(long)sb->offset,
+			NULL, 0, nbytes, NULL, "$0", "$0");
+		return;
+	}
 	if (sysflag == OS_OSX) {
 		/*
 		 * 16-byte alignment (we pass 12, callee uses
@@ -3136,107 +3802,54 @@ emit_zerostack(struct stack_block *sb, size_t nbytes) {
 	}
 }	
 
+/*
+ * 10/17/26: alloca() and VLA storage now comes from the stack rather
+ * than from malloc(); See amd64_emit_gas.c. cmov is not available on
+ * all x86 CPUs, so the VLA release uses a branch instead
+ */
 static void
 emit_alloca(struct allocadata *ad) {
-	if (sysflag == OS_OSX) {
-		/*
-		 * 16-byte alignment (we pass 4, callee uses
-		 * 8 for ret addr and ebp, so we need 4 to
-		 * get to a multiple of 16)
-		 */
-		x_fprintf(out, "\tsub $4, %%esp\n");
-	}
-	x_fprintf(out, "\tpush %%%s\n", ad->size_reg->name);
-	if (sysflag == OS_OSX) {
-		add_osx_fcall("malloc", NULL, 0);
-		x_fprintf(out, "\tcall L_malloc$stub\n");
-		x_fprintf(out, "\taddl $8, %%esp\n");
-	} else {
-		x_fprintf(out, "\tcall malloc\n");
-		x_fprintf(out, "\taddl $4, %%esp\n");
-	}
-	if (ad->result_reg != &x86_gprs[0]) {
-		x_fprintf(out, "\tmov %%eax, %%%s\n",
-			ad->result_reg->name);
-	}
+	x_fprintf(out, "\tsubl %%%s, %%esp\n", ad->size_reg->name);
+	x_fprintf(out, "\tandl $-16, %%esp\n");
+	x_fprintf(out, "\tmovl %%esp, %%%s\n", ad->result_reg->name);
 }
 
 static void
 emit_dealloca(struct stack_block *sb, struct reg *r) {
-	char	*regname = r? r->name: "ecx";
-
-	if (sysflag == OS_OSX) {
-		/*
-		 * 16-byte alignment (we pass 4, callee uses
-		 * 8 for ret addr and ebp, so we need 4 to
-		 * get to a multiple of 16)
-		 */
-		x_fprintf(out, "\tsub $4, %%esp\n");
-	}
+	/* Released by the function outro */
+	(void) sb; (void) r;
+}	
 
-	x_fprintf(out, "\tmov -%lu(%%ebp), %%%s\n",
-		(unsigned long)sb->offset,
-		regname);
-	x_fprintf(out, "\tpush %%%s\n", regname);
-	if (sysflag == OS_OSX) {
-		add_osx_fcall("free", NULL, 0);
-		x_fprintf(out, "\tcall L_free$stub\n");
-		x_fprintf(out, "\taddl $8, %%esp\n");
-	} else {
-		x_fprintf(out, "\tcall free\n");
-		x_fprintf(out, "\taddl $4, %%esp\n");
-	}
+static unsigned long
+vla_saved_sp_offset(struct stack_block *sb) {
+	return (unsigned long)sb->offset - sb->nbytes
+		+ backend->get_ptr_size();
 }	
 
 static void
 emit_alloc_vla(struct stack_block *sb) {
-	if (sysflag == OS_OSX) {
-		/*
-		 * 16-byte alignment (we pass 4, callee uses
-		 * 8 for ret addr and ebp, so we need 4 to
-		 * get to a multiple of 16)
-		 */
-		x_fprintf(out, "\tsub $4, %%esp\n");
-	}
-	x_fprintf(out, "\tmov -%lu(%%ebp), %%ecx\n",
+	x_fprintf(out, "\tmovl %%esp, -%lu(%%ebp)\n", vla_saved_sp_offset(sb));
+	x_fprintf(out, "\tsubl -%lu(%%ebp), %%esp\n",
 		(unsigned long)sb->offset - backend->get_ptr_size());	
-	x_fprintf(out, "\tpush %%ecx\n");
-	if (sysflag == OS_OSX) {
-		add_osx_fcall("malloc", NULL, 0);
-		x_fprintf(out, "\tcall L_malloc$stub\n");
-		x_fprintf(out, "\taddl $8, %%esp\n");
-	} else {
-		x_fprintf(out, "\tcall malloc\n");
-		x_fprintf(out, "\taddl $4, %%esp\n");
-	}
-	x_fprintf(out, "\tmov %%eax, -%lu(%%ebp)\n",
+	x_fprintf(out, "\tandl $-16, %%esp\n");
+	x_fprintf(out, "\tmovl %%esp, -%lu(%%ebp)\n",
 		(unsigned long)sb->offset);	
 }
 
 static void
 emit_dealloc_vla(struct stack_block *sb, struct reg *r) {
-	char	*regname = r? r->name: "ecx";
-
-	if (sysflag == OS_OSX) {
-		/*
-		 * 16-byte alignment (we pass 4, callee uses
-		 * 8 for ret addr and ebp, so we need 4 to
-		 * get to a multiple of 16)
-		 */
-		x_fprintf(out, "\tsub $4, %%esp\n");
-	}
-	x_fprintf(out, "\tmov -%lu(%%ebp), %%%s\n",
-		(unsigned long)sb->offset,
-		regname);
-	x_fprintf(out, "\tpush %%%s\n", regname);
-	if (sysflag == OS_OSX) {
-		add_osx_fcall("free", NULL, 0);
-		x_fprintf(out, "\tcall L_free$stub\n");
-		x_fprintf(out, "\taddl $8, %%esp\n");
-	} else {
-		x_fprintf(out, "\tcall free\n");
-		x_fprintf(out, "\taddl $4, %%esp\n");
+	static unsigned long	count;
+	unsigned long		saved = vla_saved_sp_offset(sb);
+
+	(void) r;
+	if (curfunc->alloca_head == NULL) {
+		/* alloca() storage below the VLA must survive */
+		x_fprintf(out, "\tcmpl $0, -%lu(%%ebp)\n", saved);
+		x_fprintf(out, "\tje .vlakeep%lu\n", count);
+		x_fprintf(out, "\tmovl -%lu(%%ebp), %%esp\n", saved);
+		x_fprintf(out, ".vlakeep%lu:\n", count++);
 	}
+	x_fprintf(out, "\tmovl $0, -%lu(%%ebp)\n", saved);
 }	
 
 static void
@@ -3352,8 +3965,8 @@ do_stack(FILE *out, struct decl *d, int was_llong) {
 			was_llong = -4; /* XXX hmm... */
 		}	
 	}
-	x_fprintf(out, "%s%lu(%%ebp",
-		sign, d->stack_addr->offset+/*EXTRA_LLONG(was_llong)*/was_llong);
+	print_mem_gas_x86(out, sign,
+		d->stack_addr->offset+/*EXTRA_LLONG(was_llong)*/was_llong, "ebp");
 }
 
 
@@ -3504,17 +4117,20 @@ print_mem_operand(struct vreg *vr, struct token *constant) {
 		  * 07/26/12: Honor use_frame_pointer
 		  */
 		if (vr->stack_addr->use_frame_pointer) {
-			x_fprintf(out, "-%lu(%%ebp",
-				vr->stack_addr->offset - EXTRA_LLONG(was_llong));
+			print_mem_gas_x86(out, "-",
+				vr->stack_addr->offset - EXTRA_LLONG(was_llong),
+				"ebp");
 		} else {
-			x_fprintf(out, "%lu(%%esp",
-				vr->stack_addr->offset + EXTRA_LLONG(was_llong));
+			print_mem_gas_x86(out, "",
+				vr->stack_addr->offset + EXTRA_LLONG(was_llong),
+				"esp");
 		}
 	} else if (vr->from_ptr) {
 		if (was_llong) {
 			x_fputc('4', out);
 		}	
-		x_fprintf(out, "(%%%s", vr->from_ptr->pregs[0]->name);
+		x_fputs("(%", out);
+		x_fputs(vr->from_ptr->pregs[0]->name, out);
 	} else {
 		abort();
 	}
@@ -3582,6 +4198,7 @@ struct emitter x86_emit_gas = {
 	emit_load,
 	emit_load_addrlabel,
 	emit_comp_goto,
+	emit_switch_table,
 	emit_store,
 	emit_setsection,
 	emit_alloc,
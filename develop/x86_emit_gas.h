@@ -35,6 +35,25 @@
 extern struct emitter		x86_emit_gas;
 extern struct emitter_x86	x86_emit_x86_gas;
 void	print_item_gas_x86(FILE *out, void *item, int item_type, int postfix);
+void	emit_unrolled_copy_gas_x86(FILE *out, const char *dest, long destoff,
+		const char *src, long srcoff, unsigned long nbytes,
+		const char *xmm, const char *word, const char *byte);
+int	check_const_muldiv_gas_x86(struct vreg *vr, int size, int op,
+		long long *val);
+int	emit_const_muldiv_gas_x86(FILE *out, struct reg **dest,
+		struct icode_instr *src, int op);
+void	print_reg_gas_x86(FILE *out, const char *name);
+void	print_imm_gas_x86(FILE *out, long value);
+void	print_mem_gas_x86(FILE *out, const char *sign, unsigned long offset,
+		const char *base);
+
+/*
+ * 10/17/26: Largest constant memcpy()/memset() size that is expanded
+ * into individual moves rather than a string instruction or library
+ * call
+ */
+#define X86_MAX_UNROLLED_COPY	64
+#define AMD64_MAX_UNROLLED_COPY	256
 
 #endif
 
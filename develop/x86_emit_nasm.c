@@ -381,6 +381,25 @@ print_init_expr(struct type *dt, struct expr *ex) {
 	x_fputc('\n', out);
 }
 
+/*
+ * 10/17/26: Prints the byte image of an INIT_BYTES initializer
+ */
+static void
+print_init_bytes(struct init_bytes *ib) {
+	size_t	i;
+
+	for (i = 0; i < ib->size; ++i) {
+		if (i % 16 == 0) {
+			x_fprintf(out, "\tdb 0x%x", ib->data[i]);
+		} else {
+			x_fprintf(out, ",0x%x", ib->data[i]);
+		}
+		if (i % 16 == 15 || i + 1 == ib->size) {
+			x_fputc('\n', out);
+		}
+	}
+}
+
 /* XXX may be adaptable for different platforms */
 /* XXX duplicates gas print_init_list() :-( */
 static void
@@ -477,6 +496,8 @@ print_init_list(struct decl *dec, struct initializer *init) {
 					continue;
 				}
 			}
+		} else if (init->type == INIT_BYTES) {
+			print_init_bytes(init->data);
 		} else if (init->type == INIT_NULL) {
 			if (init->varinit != NULL && init->left_type->tbit != NULL) {
 				continue;
@@ -1082,55 +1103,55 @@ print_nasm_string_init(size_t howmany, struct ty_string *str) {
 	size_t	i;
 
 	if (str->is_wide_char) {
-		(void) fprintf(out, "dd ");
+		x_fprintf(out, "dd ");
 	} else {
-		(void) fprintf(out, "db ");
+		x_fprintf(out, "db ");
 	}
 
 	for (i = 0, p = str->str; i < str->size-1; ++p, ++i) {
 		if (str->is_wide_char) {
 			x_fprintf(out, "0x%x", (unsigned char)*p);
 			if (/*p[1] != 0*/i+1 < str->size-1) {
-				(void) fprintf(out, ", ");
+				x_fprintf(out, ", ");
 			}	
 		} else if (isprint((unsigned char)*p)) {
 			if (!wasprint) {
 				if (*p == '\'') {
 					goto printval;
 				} else {
-					(void) fprintf(out, "'%c", *p);
+					x_fprintf(out, "'%c", *p);
 				}
 				wasprint = 1;
 			} else {
 				if (*p == '\'') {
 					goto printval;
 				} else {
-					(void) fputc(*p, out);
+					x_fputc(*p, out);
 				}
 			}
 		} else {
 printval:
 			if (wasprint) {
-				(void) fputc('\'', out);
-				(void) fputc(',', out);
+				x_fputc('\'', out);
+				x_fputc(',', out);
 				wasprint = 0;
 			}	
-			(void) fprintf(out, " %d", *p);
+			x_fprintf(out, " %d", *p);
 			if (/*p[1] != 0*/i+1 < str->size-1) {
-				(void) fprintf(out, ", ");
+				x_fprintf(out, ", ");
 			}	
 		}
 	}
 
 	if (wasprint) {
-		(void) fprintf(out, "'");
+		x_fprintf(out, "'");
 	}
 
 	if (howmany >= str->size) {
 		if (str->size > 1) {
-			(void) fprintf(out, ", ");
+			x_fprintf(out, ", ");
 		}	
-		(void) fprintf(out, "0\n");
+		x_fprintf(out, "0\n");
 	}	
 }
 
@@ -1237,19 +1258,13 @@ emit_strings(struct ty_string *list) {
 
 static void
 emit_comment(const char *fmt, ...) {
-	int		rc;
 	va_list	va;
 
 	va_start(va, fmt);
 	x_fprintf(out, "; ");
-	rc = vfprintf(out, fmt, va);
+	x_vfprintf(out, fmt, va);
 	va_end(va);
 	x_fputc('\n', out);
-
-	if (rc == EOF || fflush(out) == EOF) {
-		perror("vfprintf");
-		exit(EXIT_FAILURE);
-	}
 }
 
 static void
@@ -1525,7 +1540,10 @@ static void
 emit_freestack(struct function *f, size_t *nbytes) {
 	if (nbytes == NULL) {
 		/* Procedure outro */
-		if (f->total_allocated != 0) {
+		if (f->alloca_head != NULL || f->vla_head != NULL) {
+			/* 10/17/26: Also drops alloca() and VLA storage */
+			x_fprintf(out, "\tmov esp, ebp\n");
+		} else if (f->total_allocated != 0) {
 			x_fprintf(out, "\tadd esp, %lu\n",
 				(unsigned long)f->total_allocated);
 		}	
@@ -1683,6 +1701,23 @@ emit_comp_goto(struct reg *r) {
 	x_fprintf(out, "\tjmp %s\n", r->name);
 }
 
+static void
+emit_switch_table(struct reg *idx, struct reg *tmp, struct switch_table *tab) {
+	char	*name = tab->label->dat;
+	size_t	i;
+
+	(void) tmp;
+	x_fprintf(out, "\tjmp [.%s + %s * 4]\n", name, idx->name);
+
+	emit_setsection(SECTION_RODATA);
+	x_fprintf(out, "\talign 4\n");
+	x_fprintf(out, ".%s:\n", name);
+	for (i = 0; i < tab->nentries; ++i) {
+		x_fprintf(out, "\tdd .%s\n", (char *)tab->targets[i]->dat);
+	}
+	emit_setsection(SECTION_TEXT);
+}
+
 
 /*
  * Takes vreg source arg - not preg - so that it can be either a preg
@@ -1779,6 +1814,13 @@ emit_sub(struct reg **dest, struct icode_instr *src) {
 
 static void
 emit_add(struct reg **dest, struct icode_instr *src) {
+	if (src->dat != NULL) {
+		/* 10/17/26: Pointer plus scaled index (see ptrarit()) */
+		x_fprintf(out, "\tlea %s, [%s + %s * %d]\n",
+			dest[0]->name, dest[0]->name,
+			src->src_pregs[0]->name, *(int *)src->dat);
+		return;
+	}
 	if (dest[0]->type == REG_FPR) {
 		x_fprintf(out, "\tfaddp %s, ", dest[0]->name);
 	} else {	
@@ -2129,10 +2171,16 @@ emit_cmp(struct reg **dest, struct icode_instr *src) {
 				reg_idx = 0;
 			}
 		}
-		fprintf(out, "\tcmp %s, ", dest[reg_idx]->name);
+		if (src->hints & HINT_INSTR_GENERIC_MODIFIER) {
+			/* 10/17/26: Set by x86_rule_cmp_zero() at -O1 */
+			x_fprintf(out, "\ttest %s, %s\n",
+				dest[reg_idx]->name, dest[reg_idx]->name);
+			return;
+		}
+		x_fprintf(out, "\tcmp %s, ", dest[reg_idx]->name);
 	}	
 	if (src->src_pregs == NULL || src->src_vreg == NULL) {
-		fputc('0', out);
+		x_fputc('0', out);
 	} else {
 		print_mem_or_reg(src->src_pregs[/*0*/reg_idx], src->src_vreg);
 	}
@@ -2171,7 +2219,7 @@ emit_branch(struct icode_instr *ii) {
 		int	is_sse = 0;
 		
 		if (is_x87_trash(ii->dest_vreg)) {
-			fprintf(out, "\tfucomip st1\n");
+			x_fprintf(out, "\tfucomip st1\n");
 		} else {
 			/*
 			 * Since this is fp but not x87, it must be SSE.
@@ -2762,52 +2810,55 @@ emit_zerostack(struct stack_block *sb, size_t nbytes) {
 	x_fprintf(out, "\tadd esp, 12\n");
 }
 
+/*
+ * 10/17/26: alloca() and VLA storage now comes from the stack rather
+ * than from malloc(); See amd64_emit_gas.c
+ */
 static void
 emit_alloca(struct allocadata *ad) {
-	x_fprintf(out, "\tpush dword %s\n", ad->size_reg->name);
-	x_fprintf(out, "\tcall malloc\n");
-	x_fprintf(out, "\tadd esp, 4\n");
-	if (ad->result_reg != &x86_gprs[0]) {
-		x_fprintf(out, "\tmov %s, eax\n",
-			ad->result_reg->name);
-	}
+	x_fprintf(out, "\tsub esp, %s\n", ad->size_reg->name);
+	x_fprintf(out, "\tand esp, -16\n");
+	x_fprintf(out, "\tmov %s, esp\n", ad->result_reg->name);
 }
 
 
 static void
 emit_dealloca(struct stack_block *sb, struct reg *r) {
-	char	*regname = r? r->name: "ecx";
-
-	x_fprintf(out, "\tmov %s, [ebp - %lu]\n",
-		regname,	
-		(unsigned long)sb->offset);
-	x_fprintf(out, "\tpush dword %s\n", regname);
-	x_fprintf(out, "\tcall free\n");
-	x_fprintf(out, "\tadd esp, 4\n");
+	/* Released by the function outro */
+	(void) sb; (void) r;
 }
 
+static unsigned long
+vla_saved_sp_offset(struct stack_block *sb) {
+	return (unsigned long)sb->offset - sb->nbytes
+		+ backend->get_ptr_size();
+}	
+
 static void
 emit_alloc_vla(struct stack_block *sb) {
-	x_fprintf(out, "\tmov ecx, [ebp - %lu]\n",
+	x_fprintf(out, "\tmov [ebp - %lu], esp\n", vla_saved_sp_offset(sb));
+	x_fprintf(out, "\tsub esp, [ebp - %lu]\n",
 		(unsigned long)sb->offset - backend->get_ptr_size());
-	x_fprintf(out, "\tpush dword ecx\n");
-	x_fprintf(out, "\tcall malloc\n");
-	x_fprintf(out, "\tadd esp, 4\n");
-	x_fprintf(out, "\tmov [ebp - %lu], eax\n",
+	x_fprintf(out, "\tand esp, -16\n");
+	x_fprintf(out, "\tmov [ebp - %lu], esp\n",
 		(unsigned long)sb->offset);
 }
 
 
 static void
 emit_dealloc_vla(struct stack_block *sb, struct reg *r) {
-	char	*regname = r? r->name: "ecx";
+	static unsigned long	count;
+	unsigned long		saved = vla_saved_sp_offset(sb);
 
-	x_fprintf(out, "\tmov %s, [ebp - %lu]\n",
-		regname,	
-		(unsigned long)sb->offset);
-	x_fprintf(out, "\tpush dword %s\n", regname);
-	x_fprintf(out, "\tcall free\n");
-	x_fprintf(out, "\tadd esp, 4\n");
+	(void) r;
+	if (curfunc->alloca_head == NULL) {
+		/* alloca() storage below the VLA must survive */
+		x_fprintf(out, "\tcmp dword [ebp - %lu], 0\n", saved);
+		x_fprintf(out, "\tje .vlakeep%lu\n", count);
+		x_fprintf(out, "\tmov esp, [ebp - %lu]\n", saved);
+		x_fprintf(out, ".vlakeep%lu:\n", count++);
+	}
+	x_fprintf(out, "\tmov dword [ebp - %lu], 0\n", saved);
 }
 
 static void
@@ -3110,6 +3161,7 @@ struct emitter x86_emit_nasm = {
 	emit_load,
 	emit_load_addrlabel,
 	emit_comp_goto,
+	emit_switch_table,
 	emit_store,
 	emit_setsection,
 	emit_alloc,
@@ -63,6 +63,7 @@
 #include "amd64_gen.h"
 #include "amd64_emit_gas.h"  /* XXX for SSE */
 #include "cc1_main.h"
+#include "peephole.h"
 #include "n_libc.h"
 
 static FILE			*out;
@@ -962,68 +963,6 @@ do_ret(struct function *f, struct icode_instr *ip) {
 	if (saved_ret_addr) {
 		emit->check_ret_addr(f, saved_ret_addr);
 	}	
-	if (f->alloca_head != NULL) {
-		struct stack_block	*sb;
-		static struct vreg	rvr;
-
-		rvr.stack_addr = f->alloca_regs;
-		rvr.size = 4;
-		backend_vreg_map_preg(&rvr, &x86_gprs[0]);
-		emit->store(&rvr, &rvr);
-		backend_vreg_unmap_preg(&x86_gprs[0]);
-		if (ip && ip->src_vreg && ip->src_vreg->is_multi_reg_obj) {
-			rvr.stack_addr = f->alloca_regs->next;
-			backend_vreg_map_preg(&rvr, &x86_gprs[3]);
-			emit->store(&rvr, &rvr);
-			backend_vreg_unmap_preg(&x86_gprs[3]);
-		}
-
-		for (sb = f->alloca_head; sb != NULL; sb = sb->next) {
-			emit->dealloca(sb, NULL);
-		}
-
-		rvr.stack_addr = f->alloca_regs;
-		backend_vreg_map_preg(&rvr, &x86_gprs[0]);
-		emit->load(&x86_gprs[0], &rvr);
-		backend_vreg_unmap_preg(&x86_gprs[0]);
-		if (ip && ip->src_vreg && ip->src_vreg->is_multi_reg_obj) {
-			rvr.stack_addr = f->alloca_regs->next;
-			backend_vreg_map_preg(&rvr, &x86_gprs[3]);
-			emit->load(&x86_gprs[3], &rvr);
-			backend_vreg_unmap_preg(&x86_gprs[3]);
-		}
-	}
-	if (f->vla_head != NULL) {
-		struct stack_block	*sb;
-		static struct vreg	rvr;
-
-		rvr.stack_addr = f->alloca_regs;
-		rvr.size = 4;
-		backend_vreg_map_preg(&rvr, &x86_gprs[0]);
-		emit->store(&rvr, &rvr);
-		backend_vreg_unmap_preg(&x86_gprs[0]);
-		if (ip && ip->src_vreg && ip->src_vreg->is_multi_reg_obj) {
-			rvr.stack_addr = f->alloca_regs->next;
-			backend_vreg_map_preg(&rvr, &x86_gprs[3]);
-			emit->store(&rvr, &rvr);
-			backend_vreg_unmap_preg(&x86_gprs[3]);
-		}
-
-		for (sb = f->alloca_head; sb != NULL; sb = sb->next) {
-			emit->dealloc_vla(sb, NULL);
-		}
-
-		rvr.stack_addr = f->alloca_regs;
-		backend_vreg_map_preg(&rvr, &x86_gprs[0]);
-		emit->load(&x86_gprs[0], &rvr);
-		backend_vreg_unmap_preg(&x86_gprs[0]);
-		if (ip && ip->src_vreg && ip->src_vreg->is_multi_reg_obj) {
-			rvr.stack_addr = f->alloca_regs->next;
-			backend_vreg_map_preg(&rvr, &x86_gprs[3]);
-			emit->load(&x86_gprs[3], &rvr);
-			backend_vreg_unmap_preg(&x86_gprs[3]);
-		}
-	}
 	emit->freestack(f, NULL);
 	emit->ret(ip);
 }
@@ -1053,7 +992,6 @@ gen_function(struct function *f) {
 	struct icode_instr	*lastret = NULL;
 	struct stack_block	*sb;
 	size_t			size;
-	size_t			alloca_bytes = 0;
 	size_t			vla_bytes = 0;
 	int			i;
 	struct stupidtrace_entry	*traceentry = NULL;
@@ -1239,26 +1177,10 @@ gen_function(struct function *f) {
 		sb->offset = f->total_allocated;
 	}
 	/*
-	 * Allocate storage for saving alloca() pointers, and initialize
-	 * it to zero
+	 * 10/17/26: alloca() storage now lives on the stack below the
+	 * frame and is released by the outro, so the alloca() blocks
+	 * need no frame slots anymore
 	 */
-	for (sb = f->alloca_head; sb != NULL; sb = sb->next) {
-		f->total_allocated += sb->nbytes;
-		alloca_bytes += sb->nbytes;
-		sb->offset = f->total_allocated;
-	}
-	if (f->alloca_head != NULL || f->vla_head != NULL) {
-		/*
-		 * Get stack for saving return value registers before
-		 * performing free() and alloca()ted blocks
-		 */
-		f->alloca_regs = make_stack_block(0, 4);
-		f->total_allocated += 4;
-		f->alloca_regs->offset = f->total_allocated; 
-		f->alloca_regs->next = make_stack_block(0, 4);
-		f->total_allocated += 4;
-		f->alloca_regs->next->offset = f->total_allocated; 
-	}
 
 	/*
 	 * Allocate storage for saving VLA data, and initialize
@@ -1299,10 +1221,6 @@ gen_function(struct function *f) {
 	if (stackprotectflag) {
 		emit->save_ret_addr(f, saved_ret_addr);
 	}
-	if (f->alloca_head) {
-		/* 08/19/07: This wrongly used alloca_head! */
-		emit->zerostack(f->alloca_tail, alloca_bytes);
-	}
 	if (f->vla_head) {
 		/* 08/19/07: This wrongly used vla_head! */
 		emit->zerostack(f->vla_tail, vla_bytes);
@@ -1995,6 +1913,62 @@ icode_make_return(struct vreg *vr, struct icode_list *il) {
 	return 0;
 }
 
+/*
+ * 10/17/26: Returns -1 if the constant operand src of a multiplication,
+ * division or remainder has to be loaded into a register, or else
+ * whether emit_const_muldiv_gas_x86() needs a scratch register (1) or
+ * not (0) to do without mul and div
+ */
+static int
+const_muldiv_scratch(struct vreg *dest, struct vreg *src, int op) {
+	long long	val;
+
+	if (emit_x86 != &x86_emit_x86_gas
+		|| dest->is_multi_reg_obj
+		|| !is_integral_type(dest->type)) {
+		return -1;
+	}
+	if (op == TOK_OP_MULTI) {
+		op = INSTR_MUL;
+	} else if (op == TOK_OP_DIVIDE) {
+		op = INSTR_DIV;
+	} else if (op == TOK_OP_MOD) {
+		op = INSTR_MOD;
+	} else {
+		return -1;
+	}
+	return check_const_muldiv_gas_x86(src, dest->size, op, &val);
+}
+
+/*
+ * 10/17/26: Maps a scratch register for emit_const_muldiv_gas_x86() to
+ * the constant operand src without loading it. ecx is preferred because
+ * ebx, esi and edi would have to be saved by the function. Returns -1
+ * if no register is available, such that the constant has to be loaded
+ * after all
+ */
+static int
+map_const_muldiv_scratch(struct vreg *src, int size, struct icode_list *il) {
+	struct reg	*r;
+	struct reg	*ecx;
+
+	ecx = backend->arch == ARCH_AMD64? &amd64_x86_gprs[2]: &x86_gprs[2];
+	if (size == 4 && reg_unused(ecx) && reg_allocatable(ecx)) {
+		r = &x86_gprs[2];
+	} else {
+		reg_set_unallocatable(&x86_gprs[0]);
+		reg_set_unallocatable(&x86_gprs[3]);
+		r = ALLOC_GPR(curfunc, size, il, NULL);
+		reg_set_allocatable(&x86_gprs[3]);
+		reg_set_allocatable(&x86_gprs[0]);
+		if (r == NULL) {
+			return -1;
+		}
+	}
+	vreg_map_preg(src, r);
+	return 1;
+}
+
 /*
  * Deal with preparations necessary to make things work with the terrible
  * x86 design
@@ -2008,6 +1982,7 @@ icode_prepare_op(
 
 	struct vreg	*dest = *dest0;
 	struct vreg	*src = *src0;
+	int		scratch = const_muldiv_scratch(dest, src, op);
 
 	/*
 	 * 05/30/11: This was missing! This function implicitly assumed both
@@ -2018,7 +1993,17 @@ icode_prepare_op(
 	 * generation in other cases as well
 	 */
 	if (!is_floating_type(dest->type)) {
-		vreg_faultin_protected(dest, NULL, NULL, src, il, 0);
+		/*
+		 * 10/17/26: Constants which are used as immediate shift
+		 * counts, or which the emitter multiplies or divides by
+		 * without mul and div, are not loaded
+		 */
+		if (scratch == -1
+			&& ((op != TOK_OP_BSHL && op != TOK_OP_BSHR)
+			|| src->from_const == NULL
+			|| !backend->have_immediate_op(dest->type, op))) {
+			vreg_faultin_protected(dest, NULL, NULL, src, il, 0);
+		}
 		vreg_faultin_protected(src, NULL, NULL, dest, il, 0);
 	}
 
@@ -2057,10 +2042,15 @@ icode_prepare_op(
 				vreg_faultin(&amd64_x86_gprs[0], NULL, dest, il,
 					0);
 			}
-			reg_set_unallocatable(&amd64_x86_gprs[3]);
-			vreg_faultin_protected(dest, /*NULL*/
-				NULL, NULL, src, il, 0);
-			reg_set_allocatable(&amd64_x86_gprs[3]);
+			if (scratch == 1) {
+				scratch = map_const_muldiv_scratch(src, 8, il);
+			}
+			if (scratch == -1) {
+				reg_set_unallocatable(&amd64_x86_gprs[3]);
+				vreg_faultin_protected(dest, /*NULL*/
+					NULL, NULL, src, il, 0);
+				reg_set_allocatable(&amd64_x86_gprs[3]);
+			}
 			return;
 		}
 		if (dest->pregs[0] != &x86_gprs[0]) {
@@ -2079,12 +2069,17 @@ icode_prepare_op(
 			vreg_faultin(&x86_gprs[0], NULL, dest, il, 0);
 		}
 
+		if (scratch == 1) {
+			scratch = map_const_muldiv_scratch(src, dest->size, il);
+		}
+
 		/*
 		 * 04/13/08: Only load immediate value if there is no
 		 * immediate instruction available!
 		 */
-		if (src->from_const == NULL
-			|| !backend->have_immediate_op(dest->type, op)) {
+		if (scratch == -1
+			&& (src->from_const == NULL
+			|| !backend->have_immediate_op(dest->type, op))) {
 			/* may not be edx for div */
 			struct reg	*srcreg = NULL;
 
@@ -3982,6 +3977,33 @@ x86_have_immediate_op(struct type *ty, int op) {
 	return 0;
 }
 
+/*
+ * 10/17/26: -O rule: cmp $0, %reg   ->   test %reg, %reg
+ *
+ * The flags come out the same (test clears CF and OF just like a
+ * subtraction of zero), but test has no immediate operand. The emitters
+ * recognize the rewritten instruction by HINT_INSTR_GENERIC_MODIFIER
+ */
+static int
+x86_rule_cmp_zero(struct icode_instr *prev, struct icode_instr *ip) {
+	(void) prev;
+	if (ip->type != INSTR_CMP
+		|| (ip->hints & HINT_INSTR_GENERIC_MODIFIER)
+		|| (ip->src_vreg != NULL && ip->src_pregs != NULL)
+		|| ip->dest_pregs == NULL
+		|| ip->dest_pregs[0] == NULL
+		|| ip->dest_pregs[0]->type != REG_GPR) {
+		return PEEP_KEEP;
+	}
+	ip->hints |= HINT_INSTR_GENERIC_MODIFIER;
+	return PEEP_CHANGED;
+}
+
+struct peephole_rule	x86_peephole_rules[] = {
+	{ "cmp-zero", x86_rule_cmp_zero },
+	{ NULL, NULL }
+};
+
 struct backend x86_backend = {
 	ARCH_X86,
 	0, /* ABI */
@@ -3990,6 +4012,7 @@ struct backend x86_backend = {
 	1, /* need pic initialization (ebx) */
 	0, /* emulate long double */
 	0, /* relax alloc gpr order */
+	1, /* stack alloca */
 	0, /* max displacement */
 	0, /* min displacement */
 	x86_have_immediate_op,
@@ -4039,6 +4062,7 @@ struct backend x86_backend = {
 	do_ret,
 	get_abi_reg,
 	get_abi_ret_reg,
-	generic_same_representation
+	generic_same_representation,
+	x86_peephole_rules
 };
 
@@ -66,6 +66,7 @@ struct reg *dontwipe);
 #endif
 
 #include "reg.h"
+#include "peephole.h"
 
 struct filddata;
 struct fistdata;
@@ -91,6 +92,7 @@ struct emitter_x86 {
 };	
 
 extern struct backend		x86_backend;
+extern struct peephole_rule	x86_peephole_rules[];
 extern struct reg		x86_gprs[7];
 extern struct reg		x86_fprs[8];
 extern struct reg		x86_sse_regs[8];
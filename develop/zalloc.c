@@ -35,11 +35,18 @@ struct zone {
 static struct zone	*zones_head;
 static struct zone	**zones_free;
 static struct zone	**zones_tail;
-static void		*free_list[Z_MAX_ZONES][128];
+static void		**free_list[Z_MAX_ZONES];
 static int		free_list_idx[Z_MAX_ZONES];
+static int		free_list_size[Z_MAX_ZONES];
+
+/* 10/17/26: Allocation counters and high water marks per type */
+static struct zalloc_usage	zone_usage[Z_MAX_ZONES];
 
 static long	page_size;
 
+/* Largest block size a zone grows to */
+#define ZONE_MAX_BLOCK	(256 * 1024)
+
 void
 zalloc_create(void) {
 	int	i;
@@ -126,6 +133,16 @@ zalloc_reset_identbuf(void) {
 	identbuf_curpos = 0;
 }	
 
+static size_t
+zone_bytes_used(struct zone *z) {
+	size_t	used = 0;
+
+	for (; z != NULL; z = z->next) {
+		used += (char *)z->curptr - (char *)z->base;
+	}
+	return used;
+}
+
 static void
 reset_all_zones(struct zone *z) {
 	for (; z != NULL; z = z->next) {
@@ -175,10 +192,12 @@ zalloc_buf(int type) {
 
 #endif
 
-
+	++zone_usage[type].allocs;
 
 	if (z->usemalloc || malloc_override) {
 		void	*ret = n_xmalloc(z->chunk_size);
+
+		++zone_usage[type].malloced;
 		memset(ret, 0, z->chunk_size);
 
 #define DUMP_INITIALIZERS 0 
@@ -198,6 +217,7 @@ zalloc_buf(int type) {
 	}	
 
 	if ((ret = zalloc_from_freelist(type)) != NULL) {
+		++zone_usage[type].reused;
 #if DUMP_STATS
 		freelist_success[type] += z->chunk_size;
 #endif
@@ -243,7 +263,15 @@ zalloc_buf(int type) {
 			 */
 			struct zone	*newz = n_xmalloc(sizeof *newz);
 	
+			/*
+			 * 10/17/26: Grow the block size geometrically. A
+			 * large function used to cost thousands of page
+			 * sized malloc() calls per type
+			 */
 			newz->n_alloc = z->n_alloc; 
+			if (newz->n_alloc < ZONE_MAX_BLOCK) {
+				newz->n_alloc *= 2;
+			}
 			newz->base = n_xmalloc(newz->n_alloc);
 			memset(newz->base, 0, newz->n_alloc);
 			zones_tail[type]->next = newz;
@@ -275,6 +303,7 @@ zalloc_buf(int type) {
 void
 zalloc_reset(void) {
 	int	i;
+	size_t	used;
 
 	zalloc_reset_identbuf();
 	for (i = 0; i < Z_MAX_ZONES; ++i) {
@@ -289,6 +318,10 @@ zalloc_reset(void) {
 #if 0
 		reset_zone(&zones_head[i]);
 #endif
+		used = zone_bytes_used(&zones_head[i]);
+		if (used > zone_usage[i].peak) {
+			zone_usage[i].peak = used;
+		}
 		reset_all_zones(&zones_head[i]);
 		zones_free[i] = &zones_head[i];
 
@@ -339,10 +372,19 @@ zalloc_free(void *buf, int type) {
 		return;
 	}
 
-	if (free_list_idx[type] >=
-		(int)(sizeof free_list[type] / sizeof free_list[type][0])) {
-		/* Free list ``full'' - ignore (XXX maybe change this) */
-		return;
+	if (free_list_idx[type] >= free_list_size[type]) {
+		/*
+		 * 10/17/26: The free list used to be capped at 128 entries
+		 * per type, so everything beyond that was leaked until the
+		 * next reset. Grow it instead
+		 */
+		if (free_list_size[type] == 0) {
+			free_list_size[type] = 128;
+		} else {
+			free_list_size[type] *= 2;
+		}
+		free_list[type] = n_xrealloc(free_list[type],
+			free_list_size[type] * sizeof *free_list[type]);
 	}
 
 #if 0
@@ -394,3 +436,31 @@ zalloc_free_expr(struct expr *ex) {
 	zalloc_free(ex, Z_EXPR);
 }
 
+/*
+ * 10/17/26: Returns the usage statistics of zone ``type'', or -1 if
+ * the type is not in use. The peak is the largest number of bytes
+ * handed out from the zone between two resets, including the current
+ * period
+ */
+int
+zalloc_get_usage(int type, struct zalloc_usage *zu) {
+	struct zone	*z;
+	size_t		used;
+
+	if (zones_head == NULL || !zones_head[type].initialized) {
+		return -1;
+	}
+	*zu = zone_usage[type];
+	zu->chunk_size = zones_head[type].chunk_size;
+	zu->blocks = 0;
+	zu->reserved = 0;
+	for (z = &zones_head[type]; z != NULL; z = z->next) {
+		++zu->blocks;
+		zu->reserved += z->n_alloc;
+	}
+	used = zone_bytes_used(&zones_head[type]);
+	if (used > zu->peak) {
+		zu->peak = used;
+	}
+	return 0;
+}
@@ -24,14 +24,16 @@
 #define Z_ICODE_INSTR	7
 #define Z_ICODE_LIST	8
 #define Z_VREG		9
+#define Z_ICODE_MEMREF	10
 #define Z_STACK_BLOCK	11
 #define Z_S_EXPR	12
 #define Z_FCALL_DATA	13
 #define Z_IDENTIFIER	14 /* unused right now */
-#define Z_FASTSYMHASH	15
+#define Z_FASTSYMHASH	15 /* unused right now */
 #define Z_CEXPR_BUF	16
+#define Z_ICODE_PREGS	17
 
-#define Z_MAX_ZONES	17
+#define Z_MAX_ZONES	18
 
 #include <stddef.h>
 
@@ -52,5 +54,20 @@ struct expr;
 void	zalloc_free(void *buf, int type);
 void	zalloc_free_expr(struct expr *ex);
 
+/*
+ * 10/17/26: Usage statistics of a zone, for -ftime-report
+ */
+struct zalloc_usage {
+	size_t		chunk_size;
+	unsigned long	allocs;		/* zalloc_buf() calls */
+	unsigned long	reused;		/* ... served from the free list */
+	unsigned long	malloced;	/* ... served by malloc() */
+	unsigned long	blocks;		/* blocks in the zone */
+	size_t		reserved;	/* bytes in those blocks */
+	size_t		peak;		/* most bytes in use between resets */
+};
+
+int	zalloc_get_usage(int type, struct zalloc_usage *zu);
+
 #endif
 